@@ -0,0 +1,102 @@
+#ifndef BUFFER_IO_HPP_INCLUDED_
+#define BUFFER_IO_HPP_INCLUDED_
+
+
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include <cstddef>
+#include <string>
+
+
+/**
+   @brief Writing buffers to files without copying them first
+   @details
+   These functions write any buffer with a segments() member straight from
+   its storage.  The contiguous blocks of its runs are gathered into arrays of
+   iovecs and written with writev(), so that the before and after halves of a
+   gap_buffer, the chunks of a rope_buffer, or the pieces of a
+   piece_table_buffer, reach the file without being joined into one string.
+   Runs are contiguous when they are held behind pointers, in std::vector or
+   std::basic_string, or in the blocks of a std::deque, with libstdc++.
+   Elements of other runs are copied through a small, fixed-size staging
+   area, so memory use never grows with the size of the buffer.
+
+   Elements are written as their object representation, so they must be
+   PODs, and are usually characters.  Failures throw
+   boost::system::system_error.  These use the POSIX file interface.
+
+   @tparam TSegmented Any type with a segments() member and a size() member,
+                      such as gap_buffer, contiguous_gap_buffer, rope_buffer,
+                      multi_gap_buffer or piece_table_buffer
+*/
+namespace buffer_io
+{
+  /// How save() replaces the file at its path
+  enum save_mode
+  {
+    /// Truncate and rewrite the file in place.  A reader, or a crash, may
+    /// see it half written.
+    save_in_place,
+    /// Write a new file beside it, flush it to disk, and rename it over the
+    /// old one, so that the path always names either the old contents or the
+    /// new.  The new file takes the old one's permissions.  If the path is a
+    /// symbolic link, the file it links to is replaced, and the link kept.  A
+    /// piece_table_buffer mapping the old file stays valid, since the old
+    /// file lives on until it is unmapped.
+    save_atomically
+  };
+
+  /// @brief Write every element of buffer to the file descriptor fd, at its
+  ///        current offset, and return the number of bytes written
+  /// @note \b Complexity: O(n) bytes, written with about one system call per
+  ///       IOV_MAX contiguous blocks
+  template<class TSegmented>
+  std::size_t write_to(TSegmented const & buffer, int fd);
+
+  /// @brief Write every element of buffer to the file at path, creating it if
+  ///        it does not exist
+  /// @note A piece_table_buffer must not be saved in place over the file it
+  ///       maps, since truncating that file pulls its elements out from under
+  ///       it.  Save it atomically instead.
+  /// @note \b Complexity: The same as write_to()
+  template<class TSegmented>
+  void save(TSegmented const & buffer, std::string const & path,
+            save_mode mode = save_in_place);
+}
+
+
+#include "buffer_io.ipp"
+#endif
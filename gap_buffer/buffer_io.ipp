@@ -0,0 +1,323 @@
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include "detail/byte_runs.hpp"
+
+#include <boost/atomic.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/range/begin.hpp>
+#include <boost/range/end.hpp>
+#include <boost/range/iterator.hpp>
+#include <boost/range/value_type.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/system/error_code.hpp>
+#include <boost/system/system_error.hpp>
+#include <boost/type_traits/is_pod.hpp>
+#include <boost/utility/enable_if.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+
+namespace buffer_io
+{
+namespace detail
+{
+  // Throw the error in errno, naming what failed
+  inline void fail(std::string const & what)
+  {
+    throw boost::system::system_error(errno, boost::system::system_category(),
+                                      what);
+  }
+
+  // Close a file descriptor, keeping whatever error is in errno
+  inline void close_quietly(int fd)
+  {
+    int const error = errno;
+    ::close(fd);
+    errno = error;
+  }
+
+  // Collects blocks of memory and writes them out with writev() whenever it
+  // holds as many as one call may take
+  class gather_writer
+  {
+  public:
+    explicit gather_writer(int fd)
+      : fd(fd)
+      , written(0)
+      , staged(0)
+    {
+      blocks.reserve(max_blocks);
+    }
+
+    // Queue [data, data + length), which must stay put until flush()
+    void add(void const * data, std::size_t length)
+    {
+      if(length == 0)
+        return;
+      if(blocks.size() == max_blocks)
+        flush();
+      iovec const block = { const_cast<void *>(data), length };
+      blocks.push_back(block);
+    }
+
+    // Copy [data, data + length) into the staging area and queue the copy
+    void stage(void const * data, std::size_t length)
+    {
+      char const * bytes = static_cast<char const *>(data);
+      while(length > 0){
+        if(staging.empty())
+          staging.resize(staging_size);
+        // Flush first, rather than in add(), so the copy is not overwritten
+        if(staged == staging.size() || blocks.size() == max_blocks)
+          flush();
+        std::size_t const taken = std::min(length, staging.size() - staged);
+        std::memcpy(&staging[staged], bytes, taken);
+        // Grow the last block when it already ends at the copy
+        if(!blocks.empty() &&
+           static_cast<char *>(blocks.back().iov_base) +
+           blocks.back().iov_len == &staging[staged])
+          blocks.back().iov_len += taken;
+        else
+          add(&staging[staged], taken);
+        staged += taken;
+        bytes += taken;
+        length -= taken;
+      }
+    }
+
+    // Write every queued block, retrying after short writes and signals
+    void flush()
+    {
+      iovec * next = blocks.empty() ? 0 : &blocks[0];
+      int left = static_cast<int>(blocks.size());
+      while(left > 0){
+        ssize_t done = ::writev(fd, next, left);
+        if(done < 0){
+          if(errno == EINTR)
+            continue;
+          fail("writev");
+        }
+        written += done;
+        while(left > 0 && static_cast<std::size_t>(done) >= next->iov_len){
+          done -= next->iov_len;
+          ++next;
+          --left;
+        }
+        if(left > 0){
+          next->iov_base = static_cast<char *>(next->iov_base) + done;
+          next->iov_len -= done;
+        }
+      }
+      blocks.clear();
+      staged = 0;
+    }
+
+    std::size_t total() const
+    {
+      return written;
+    }
+
+  private:
+#if defined(IOV_MAX)
+    static std::size_t const max_blocks = IOV_MAX;
+#else
+    static std::size_t const max_blocks = 1024;
+#endif
+    static std::size_t const staging_size = 64 * 1024;
+
+    int                 fd;
+    std::size_t         written;
+    std::vector<iovec>  blocks;
+    std::vector<char>   staging;
+    std::size_t         staged;
+  };
+
+  // Queue [first, last) a contiguous block at a time
+  template<class Iterator>
+  typename boost::enable_if<segmented::detail::byte_runs<Iterator> >::type
+  gather(gather_writer & out, Iterator first, Iterator last)
+  {
+    typedef segmented::detail::byte_runs<Iterator> runs;
+    while(first != last){
+      segmented::detail::byte_block const block = runs::block(first, last);
+      out.add(block.first, block.second);
+      std::advance(first, block.second);
+    }
+  }
+
+  // Or, when the blocks cannot be found, an element at a time
+  template<class Iterator>
+  typename boost::disable_if<segmented::detail::byte_runs<Iterator> >::type
+  gather(gather_writer & out, Iterator first, Iterator last)
+  {
+    for(; first != last; ++first)
+      out.stage(&*first, sizeof(*first));
+  }
+
+  // Give the file descriptor fd the permissions of the file at path, if there
+  // is one
+  inline void copy_permissions(std::string const & path, int fd)
+  {
+    struct stat status;
+    if(::stat(path.c_str(), &status) == 0 &&
+       ::fchmod(fd, status.st_mode & 07777) != 0)
+      fail("fchmod " + path);
+  }
+
+  // Flush the directory holding path, so that a rename within it lasts
+  inline void sync_directory(std::string const & path)
+  {
+    std::string::size_type const slash = path.rfind('/');
+    std::string const directory =
+      slash == std::string::npos ? std::string(".") :
+      slash == 0 ? std::string("/") : path.substr(0, slash);
+    int const fd = ::open(directory.c_str(), O_RDONLY);
+    if(fd < 0)
+      fail("open " + directory);
+    // Some file systems cannot sync a directory, and do not need to
+    if(::fsync(fd) != 0 && errno != EINVAL){
+      close_quietly(fd);
+      fail("fsync " + directory);
+    }
+    ::close(fd);
+  }
+
+  // Return the file path names once every symbolic link is followed, so that
+  // a file renamed over it replaces the link's target rather than the link.
+  // A path which does not exist yet is returned as it is.
+  inline std::string resolve_links(std::string const & path)
+  {
+    char * const resolved = ::realpath(path.c_str(), 0);
+    if(resolved == 0){
+      if(errno == ENOENT)
+        return path;
+      fail("realpath " + path);
+    }
+    std::string const rtn(resolved);
+    std::free(resolved);
+    return rtn;
+  }
+
+  // Create a new file next to path, which nothing else has opened, and set
+  // name to its name.  Threads saving at once each take their own attempts.
+  inline int create_beside(std::string const & path, std::string & name)
+  {
+    static boost::atomic<unsigned> attempts(0);
+    for(;;){
+      unsigned const attempt =
+        attempts.fetch_add(1, boost::memory_order_relaxed);
+      name = path + ".tmp." + boost::lexical_cast<std::string>(::getpid()) +
+        "." + boost::lexical_cast<std::string>(attempt);
+      int const fd = ::open(name.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666);
+      if(fd >= 0 || errno != EEXIST)
+        return fd;
+    }
+  }
+}
+
+template<class TSegmented>
+std::size_t write_to(TSegmented const & buffer, int fd)
+{
+  typedef typename TSegmented::const_segment_list segment_list;
+  typedef typename boost::range_iterator<segment_list const>::type segment;
+  BOOST_STATIC_ASSERT((boost::is_pod<typename TSegmented::value_type>::value));
+
+  detail::gather_writer out(fd);
+  segment_list const runs = buffer.segments();
+  for(segment run = boost::begin(runs); run != boost::end(runs); ++run)
+    detail::gather(out, boost::begin(*run), boost::end(*run));
+  out.flush();
+  return out.total();
+}
+
+template<class TSegmented>
+void save(TSegmented const & buffer, std::string const & path,
+          save_mode mode)
+{
+  if(mode == save_in_place){
+    int const fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if(fd < 0)
+      detail::fail("open " + path);
+    try{
+      write_to(buffer, fd);
+    }catch(...){
+      ::close(fd);
+      throw;
+    }
+    if(::close(fd) != 0)
+      detail::fail("close " + path);
+    return;
+  }
+
+  std::string const target = detail::resolve_links(path);
+  std::string name;
+  int const fd = detail::create_beside(target, name);
+  if(fd < 0)
+    detail::fail("open " + name);
+  try{
+    detail::copy_permissions(target, fd);
+    write_to(buffer, fd);
+    if(::fsync(fd) != 0)
+      detail::fail("fsync " + name);
+  }catch(...){
+    ::close(fd);
+    ::unlink(name.c_str());
+    throw;
+  }
+  if(::close(fd) != 0){
+    int const error = errno;
+    ::unlink(name.c_str());
+    errno = error;
+    detail::fail("close " + name);
+  }
+  if(::rename(name.c_str(), target.c_str()) != 0){
+    int const error = errno;
+    ::unlink(name.c_str());
+    errno = error;
+    detail::fail("rename " + name);
+  }
+  detail::sync_directory(target);
+}
+}
@@ -0,0 +1,101 @@
+#ifndef BUFFER_SNAPSHOT_HPP_INCLUDED_
+#define BUFFER_SNAPSHOT_HPP_INCLUDED_
+
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include "gap_buffer.hpp"
+
+#include <cstddef>
+#include <iosfwd>
+
+
+/**
+   @brief Saving gap_buffers in a compact binary form which loads in bulk
+   @details
+   serialize() writes a snapshot of a gap_buffer: a header, the elements of
+   each half of the gap as they are stored, and a CRC-32 of everything before
+   it.  deserialize() reads one back into halves built directly in storage,
+   with a few large reads, and hands them to the buffer with swap_halves(), so
+   that no element is parsed or inserted on its own, and the gap and the
+   cursor are where they were.  A snapshot may be loaded into a gap_buffer over
+   another container, as long as the elements are the same size.
+
+   A snapshot is laid out as:
+   - the four bytes "gbsn", and the version of the format, 1, as a 32-bit
+     little-endian integer;
+   - 0x01020304 as a 32-bit integer in the byte order of the machine which
+     wrote it, which must match the machine reading it;
+   - sizeof(value_type), as a 32-bit little-endian integer;
+   - the lengths of the halves before and after the gap, and the position of
+     the cursor, as 64-bit little-endian integers;
+   - the elements of the half before the gap, then of the half after it, as
+     their object representation;
+   - the CRC-32 of all of the above, as a 32-bit little-endian integer.
+
+   Elements are written as their object representation, so they must be
+   trivially copyable, and are usually characters.  Snapshots which are
+   malformed, truncated or fail their checksum throw std::invalid_argument,
+   and leave the buffer untouched.
+
+   @tparam TContainer, TObserver, TStats Those of the gap_buffer
+*/
+namespace buffer_snapshot
+{
+  /// @brief Write a snapshot of buffer to out
+  /// @details Whether writing succeeded is left in the state of out.
+  /// @note \b Complexity: O(n)
+  template<class TContainer, class TObserver, class TStats>
+  void serialize(gap_buffer<TContainer, TObserver, TStats> const & buffer,
+                 std::ostream & out);
+
+  /// @brief Replace the elements and cursor of buffer with those of the
+  ///        snapshot read from in
+  /// @note \b Complexity: O(n), reading in blocks of up to 16MiB
+  template<class TContainer, class TObserver, class TStats>
+  void deserialize(std::istream & in,
+                   gap_buffer<TContainer, TObserver, TStats> & buffer);
+
+  /// @brief Replace the elements and cursor of buffer with those of the
+  ///        snapshot in the size bytes at data, such as a mapped_file
+  /// @note \b Complexity: O(n)
+  template<class TContainer, class TObserver, class TStats>
+  void deserialize(void const * data, std::size_t size,
+                   gap_buffer<TContainer, TObserver, TStats> & buffer);
+}
+
+
+#include "buffer_snapshot.ipp"
+#endif
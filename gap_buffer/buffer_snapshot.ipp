@@ -0,0 +1,286 @@
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <boost/crc.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/next_prior.hpp>
+#include <boost/range/begin.hpp>
+#include <boost/range/end.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_trivially_copyable.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <iterator>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+
+namespace buffer_snapshot
+{
+namespace detail
+{
+  char const            magic[4] = { 'g', 'b', 's', 'n' };
+  boost::uint32_t const version = 1;
+  boost::uint32_t const byte_order = 0x01020304;
+  std::size_t const     header_size = 40;
+  // The most bytes written from, or read into, a staging area at once
+  std::size_t const     staging_bytes = 64 * 1024;
+  // The most bytes read straight into a contiguous half at once, so that a
+  // corrupt length fails at the end of the input rather than by exhausting
+  // memory
+  std::size_t const     block_bytes = 16 * 1024 * 1024;
+
+  inline void malformed()
+  {
+    throw std::invalid_argument("buffer_snapshot::deserialize");
+  }
+
+  // Store value in the size bytes at out, least significant first
+  inline void put_le(unsigned char * out, boost::uint64_t value,
+                     std::size_t size)
+  {
+    for(std::size_t i = 0; i != size; ++i, value >>= 8)
+      out[i] = static_cast<unsigned char>(value & 0xff);
+  }
+
+  // Load the size bytes at in, least significant first
+  inline boost::uint64_t get_le(unsigned char const * in, std::size_t size)
+  {
+    boost::uint64_t value = 0;
+    for(std::size_t i = size; i != 0; --i)
+      value = (value << 8) | in[i - 1];
+    return value;
+  }
+
+  // Reads a snapshot from a stream, keeping the CRC-32 of what it has read
+  class stream_source
+  {
+  public:
+    explicit stream_source(std::istream & in)
+      : in(in)
+    {}
+    void read(void * to, std::size_t n)
+    {
+      in.read(static_cast<char *>(to), n);
+      if(static_cast<std::size_t>(in.gcount()) != n)
+        malformed();
+      crc.process_bytes(to, n);
+    }
+    // If the input may still hold n more bytes
+    bool may_hold(boost::uint64_t) const
+    {
+      return true;
+    }
+    boost::uint32_t checksum() const
+    {
+      return crc.checksum();
+    }
+  private:
+    std::istream &     in;
+    boost::crc_32_type crc;
+  };
+
+  // Reads a snapshot from memory, keeping the CRC-32 of what it has read
+  class memory_source
+  {
+  public:
+    memory_source(void const * data, std::size_t size)
+      : at(static_cast<unsigned char const *>(data))
+      , left(size)
+    {}
+    void read(void * to, std::size_t n)
+    {
+      if(n > left)
+        malformed();
+      std::memcpy(to, at, n);
+      crc.process_bytes(at, n);
+      at += n;
+      left -= n;
+    }
+    bool may_hold(boost::uint64_t n) const
+    {
+      return n <= left;
+    }
+    boost::uint32_t checksum() const
+    {
+      return crc.checksum();
+    }
+  private:
+    unsigned char const * at;
+    std::size_t           left;
+    boost::crc_32_type    crc;
+  };
+
+  // Write the n elements of [first, first + n) through a staging area
+  template<class Iterator>
+  void write_run(std::ostream & out, boost::crc_32_type & crc,
+                 Iterator first, std::size_t n)
+  {
+    typedef typename std::iterator_traits<Iterator>::value_type element;
+    std::vector<element> staging(
+      std::min(n, std::max<std::size_t>(staging_bytes / sizeof(element), 1)));
+    while(n != 0){
+      std::size_t const taken = std::min(n, staging.size());
+      Iterator const stop = boost::next(first, taken);
+      std::copy(first, stop, staging.begin());
+      crc.process_bytes(&staging[0], taken * sizeof(element));
+      out.write(reinterpret_cast<char const *>(&staging[0]),
+                taken * sizeof(element));
+      first = stop;
+      n -= taken;
+    }
+  }
+
+  // Append n elements read from source to half, through a staging area
+  template<class TSource, class TContainer>
+  void read_half(TSource & source, TContainer & half, std::size_t n)
+  {
+    typedef typename TContainer::value_type element;
+    std::vector<element> staging(
+      std::min(n, std::max<std::size_t>(staging_bytes / sizeof(element), 1)));
+    while(n != 0){
+      std::size_t const taken = std::min(n, staging.size());
+      source.read(&staging[0], taken * sizeof(element));
+      half.insert(half.end(), staging.begin(), staging.begin() + taken);
+      n -= taken;
+    }
+  }
+
+  // A std::vector is read straight into its storage
+  template<class TSource, class T, class TAllocator>
+  void read_half(TSource & source, std::vector<T, TAllocator> & half,
+                 std::size_t n)
+  {
+    std::size_t const most = std::max<std::size_t>(block_bytes / sizeof(T), 1);
+    while(n != 0){
+      std::size_t const taken = std::min(n, most);
+      std::size_t const old_size = half.size();
+      half.resize(old_size + taken);
+      source.read(&half[old_size], taken * sizeof(T));
+      n -= taken;
+    }
+  }
+
+  template<class TSource, class TContainer, class TObserver, class TStats>
+  void load(TSource & source,
+            gap_buffer<TContainer, TObserver, TStats> & buffer)
+  {
+    typedef typename TContainer::value_type element;
+    unsigned char header[header_size];
+    source.read(header, header_size);
+    if(std::memcmp(header, magic, 4) != 0 || get_le(header + 4, 4) != version
+       || std::memcmp(header + 8, &byte_order, 4) != 0
+       || get_le(header + 12, 4) != sizeof(element))
+      malformed();
+    boost::uint64_t const before = get_le(header + 16, 8);
+    boost::uint64_t const after = get_le(header + 24, 8);
+    boost::uint64_t const cursor = get_le(header + 32, 8);
+    boost::uint64_t const most =
+      std::numeric_limits<std::ptrdiff_t>::max() / sizeof(element);
+    if(before > most || after > most - before || cursor > before + after ||
+       !source.may_hold((before + after) * sizeof(element)))
+      malformed();
+
+    // Build the halves aside, so that a failure leaves buffer as it was
+    TContainer front(buffer.get_allocator()), back(buffer.get_allocator());
+    read_half(source, front, static_cast<std::size_t>(before));
+    read_half(source, back, static_cast<std::size_t>(after));
+    boost::uint32_t const expected = source.checksum();
+    unsigned char trailer[4];
+    source.read(trailer, 4);
+    if(get_le(trailer, 4) != expected)
+      malformed();
+
+    buffer.swap_halves(front, back);
+    buffer.advance(static_cast<std::ptrdiff_t>(cursor) -
+                   static_cast<std::ptrdiff_t>(before));
+  }
+}
+
+
+template<class TContainer, class TObserver, class TStats>
+void serialize(gap_buffer<TContainer, TObserver, TStats> const & buffer,
+               std::ostream & out)
+{
+  typedef typename TContainer::value_type element;
+  BOOST_STATIC_ASSERT(boost::is_trivially_copyable<element>::value);
+  typedef typename gap_buffer<TContainer, TObserver, TStats>::
+    const_segment_list segment_list;
+  segment_list const halves = buffer.segments();
+  std::size_t const before =
+    std::distance(boost::begin(halves[0]), boost::end(halves[0]));
+  std::size_t const after =
+    std::distance(boost::begin(halves[1]), boost::end(halves[1]));
+
+  unsigned char header[detail::header_size];
+  std::memcpy(header, detail::magic, 4);
+  detail::put_le(header + 4, detail::version, 4);
+  std::memcpy(header + 8, &detail::byte_order, 4);
+  detail::put_le(header + 12, sizeof(element), 4);
+  detail::put_le(header + 16, before, 8);
+  detail::put_le(header + 24, after, 8);
+  detail::put_le(header + 32, buffer.position(), 8);
+  boost::crc_32_type crc;
+  crc.process_bytes(header, detail::header_size);
+  out.write(reinterpret_cast<char const *>(header), detail::header_size);
+
+  detail::write_run(out, crc, boost::begin(halves[0]), before);
+  detail::write_run(out, crc, boost::begin(halves[1]), after);
+  unsigned char trailer[4];
+  detail::put_le(trailer, crc.checksum(), 4);
+  out.write(reinterpret_cast<char const *>(trailer), 4);
+}
+
+template<class TContainer, class TObserver, class TStats>
+void deserialize(std::istream & in,
+                 gap_buffer<TContainer, TObserver, TStats> & buffer)
+{
+  BOOST_STATIC_ASSERT(boost::is_trivially_copyable<
+                        typename TContainer::value_type>::value);
+  detail::stream_source source(in);
+  detail::load(source, buffer);
+}
+
+template<class TContainer, class TObserver, class TStats>
+void deserialize(void const * data, std::size_t size,
+                 gap_buffer<TContainer, TObserver, TStats> & buffer)
+{
+  BOOST_STATIC_ASSERT(boost::is_trivially_copyable<
+                        typename TContainer::value_type>::value);
+  detail::memory_source source(data, size);
+  detail::load(source, buffer);
+}
+}
@@ -0,0 +1,147 @@
+#ifndef BUFFER_STATS_HPP_INCLUDED_
+#define BUFFER_STATS_HPP_INCLUDED_
+
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include "container_traits.hpp"
+#include "gap_buffer.hpp"
+
+#include <cstddef>
+
+
+/// The halves of a gap_buffer, either side of its gap
+enum gap_half
+{
+  /// The half before the gap
+  before_half,
+  /// The half after the gap
+  after_half
+};
+
+/**
+   @brief A gap_buffer stats policy which counts what its edits cost
+   @details
+   Attach a buffer_stats to a gap_buffer by naming it as the buffer's TStats.
+   It counts how often the gap is moved for each kind of insert, and how many
+   elements that relocates, and the largest size the buffer has reached.
+
+   It also counts the allocations each half makes, and their bytes.  These are
+   inferred after each edit from how the storage_footprint of each half has
+   grown: new blocks are counted as allocations, and a half which holds more
+   bytes in as many blocks as before is counted as having reallocated all of
+   them.  A half whose footprint is not measured, as storage_traits tells, is
+   counted as allocating nothing at all, rather than guessed at.  The counts
+   are therefore a lower bound, not a record of every call to the allocator:
+   an edit which frees storage and then allocates as much again is not seen,
+   nor is a swap of a half for a fresh one of the same capacity, as apply()
+   makes, nor any storage footprint() leaves out, such as the map of a
+   std::deque.  Moving the gap of a container whose nodes are spliced between
+   the halves counts no allocations.
+
+   Counting costs a call to storage_traits::footprint() for each half after
+   every edit, so it is meant for profiling rather than for production.
+*/
+class buffer_stats
+{
+public:
+  /// The size_type of these counts
+  typedef std::size_t size_type;
+
+  /// Tell gap_buffer that this policy needs to hear about every edit
+  static bool const enabled = true;
+
+  /// Construct with every count zero
+  buffer_stats();
+
+  /// @name Stats Policy Requirements
+  //@{
+  /// Count moving the gap for op, which relocated moved elements
+  /// @note \b Complexity: O(1), plus that of storage_traits::footprint()
+  template<class TBuffer>
+  void on_resolve(TBuffer const & buffer, gap_operation op, size_type moved);
+  /// Count the allocations of an edit, and the size it left buffer at
+  /// @note \b Complexity: O(1), plus that of storage_traits::footprint()
+  template<class TBuffer>
+  void on_edit(TBuffer const & buffer);
+  /// Operations are not timed
+  /// @note \b Complexity: O(1)
+  template<class TBuffer>
+  void on_begin(TBuffer const & buffer, gap_operation op);
+  /// Operations are not timed
+  /// @note \b Complexity: O(1)
+  template<class TBuffer>
+  void on_end(TBuffer const & buffer, gap_operation op);
+  //@}
+
+  /// @name Counts
+  //@{
+  /// Return how often the gap was moved for op
+  /// @note \b Complexity: O(1)
+  size_type resolves(gap_operation op) const;
+  /// Return how many elements were relocated by moving the gap for op
+  /// @note \b Complexity: O(1)
+  size_type elements_moved(gap_operation op) const;
+  /// Return at least how many allocations half made
+  /// @note \b Complexity: O(1)
+  size_type allocations(gap_half half) const;
+  /// Return at least the bytes of the allocations half made
+  /// @note \b Complexity: O(1)
+  size_type bytes_allocated(gap_half half) const;
+  /// Return the largest number of elements the buffer has held
+  /// @note \b Complexity: O(1)
+  size_type peak_size() const;
+
+  /// Set every count to zero, so that only edits made from now on are counted
+  /// @note \b Complexity: O(1)
+  void reset();
+  //@}
+
+private:
+  size_type resolve_counts[gap_operation_count];
+  size_type moved_counts[gap_operation_count];
+  size_type allocation_counts[2];
+  size_type allocated_bytes[2];
+  size_type peak;
+  // The storage each half held after the last edit counted
+  storage_footprint held[2];
+
+  // Count the growth of half from held[half] to now, and remember now
+  void account(gap_half half, storage_footprint const & now, bool counted);
+};
+
+
+#include "buffer_stats.ipp"
+#endif
@@ -0,0 +1,177 @@
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <boost/type_traits/integral_constant.hpp>
+#include <boost/type_traits/is_same.hpp>
+
+#include <algorithm>
+
+
+namespace stats_detail
+{
+  // If moving the gap of a TBuffer splices nodes, rather than allocating
+  template<class TBuffer>
+  struct splices
+    : boost::is_same<typename container_traits<
+                       typename TBuffer::container_type>::relocation_category,
+                     splice_relocation_tag>
+  {};
+
+  // If the storage_footprint of a TBuffer's halves is measured, so that its
+  // growth shows what they allocate
+  template<class TBuffer>
+  struct measured
+    : boost::integral_constant<
+        bool,
+        storage_traits<typename TBuffer::container_type>::measured>
+  {};
+}
+
+
+inline
+buffer_stats::buffer_stats()
+{
+  reset();
+  held[before_half].blocks = held[after_half].blocks = 0;
+  held[before_half].bytes = held[after_half].bytes = 0;
+}
+
+template<class TBuffer>
+void
+buffer_stats::
+on_resolve(TBuffer const & buffer, gap_operation const op,
+           size_type const moved)
+{
+  ++resolve_counts[op];
+  moved_counts[op] += moved;
+  buffer_memory const memory = buffer.memory_usage();
+  bool const counted = stats_detail::measured<TBuffer>::value &&
+    !stats_detail::splices<TBuffer>::value;
+  account(before_half, memory.before, counted);
+  account(after_half, memory.after, counted);
+}
+
+template<class TBuffer>
+void
+buffer_stats::
+on_edit(TBuffer const & buffer)
+{
+  buffer_memory const memory = buffer.memory_usage();
+  bool const counted = stats_detail::measured<TBuffer>::value;
+  account(before_half, memory.before, counted);
+  account(after_half, memory.after, counted);
+  peak = std::max<size_type>(peak, buffer.size());
+}
+
+template<class TBuffer>
+void
+buffer_stats::
+on_begin(TBuffer const &, gap_operation)
+{}
+
+template<class TBuffer>
+void
+buffer_stats::
+on_end(TBuffer const &, gap_operation)
+{}
+
+inline
+void
+buffer_stats::
+account(gap_half const half, storage_footprint const & now,
+        bool const counted)
+{
+  storage_footprint & then = held[half];
+  if(counted){
+    if(now.blocks > then.blocks){
+      allocation_counts[half] += now.blocks - then.blocks;
+      if(now.bytes > then.bytes)
+        allocated_bytes[half] += now.bytes - then.bytes;
+    }else if(now.blocks == then.blocks && now.bytes > then.bytes){
+      ++allocation_counts[half];
+      allocated_bytes[half] += now.bytes;
+    }
+  }
+  then = now;
+}
+
+inline
+buffer_stats::size_type
+buffer_stats::
+resolves(gap_operation const op) const
+{
+  return resolve_counts[op];
+}
+
+inline
+buffer_stats::size_type
+buffer_stats::
+elements_moved(gap_operation const op) const
+{
+  return moved_counts[op];
+}
+
+inline
+buffer_stats::size_type
+buffer_stats::
+allocations(gap_half const half) const
+{
+  return allocation_counts[half];
+}
+
+inline
+buffer_stats::size_type
+buffer_stats::
+bytes_allocated(gap_half const half) const
+{
+  return allocated_bytes[half];
+}
+
+inline
+buffer_stats::size_type
+buffer_stats::
+peak_size() const
+{
+  return peak;
+}
+
+inline
+void
+buffer_stats::
+reset()
+{
+  std::fill(resolve_counts, resolve_counts + gap_operation_count, 0);
+  std::fill(moved_counts, moved_counts + gap_operation_count, 0);
+  std::fill(allocation_counts, allocation_counts + 2, 0);
+  std::fill(allocated_bytes, allocated_bytes + 2, 0);
+  peak = 0;
+}
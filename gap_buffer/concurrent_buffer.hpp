@@ -0,0 +1,208 @@
+#ifndef CONCURRENT_BUFFER_HPP_INCLUDED_
+#define CONCURRENT_BUFFER_HPP_INCLUDED_
+
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_array.hpp>
+#include <cstddef>
+#include <vector>
+
+#include "rope_buffer.hpp"
+
+
+/**
+   @brief A rope_buffer edited by one thread and read by any number of others
+   @details
+   One thread, the writer, edits the buffer returned by writer() as it would
+   any rope_buffer, and calls publish() whenever readers should see its
+   edits.  Publishing takes an O(1) snapshot of the buffer, which shares every
+   node with it, and makes that the version readers see.
+
+   Each reading thread claims a reader once, and reads through a view of it.
+   Constructing a view pins the latest published version, which stays
+   unchanged and alive until the view is destroyed, so it can be iterated,
+   and its size() and position() read, consistently.  Pinning is wait-free:
+   it is one store and two loads, whatever the other threads are doing.
+
+   The writer never waits for readers.  A version which has been replaced is
+   retired, and freed by a later publish() or reclaim() once no view can
+   still see it.  This is epoch-based reclamation: every publish() advances an
+   epoch, each view records the epoch it was made in, and a version is freed
+   when every view was made after it was retired.
+
+   @tparam T            The element type
+   @tparam LeafCapacity The maximum number of elements in one chunk of the rope
+   @tparam Fanout       The maximum number of children of an inner node
+*/
+template<class T, std::size_t LeafCapacity = 512, std::size_t Fanout = 16>
+class concurrent_buffer
+  : private boost::noncopyable
+{
+private:
+  // A published snapshot, and when it was replaced
+  struct version;
+  // The epoch a reader is pinned in, padded onto its own cache line
+  struct slot;
+
+public:
+  /// The buffer the writer edits, and readers see versions of
+  typedef rope_buffer<T, LeafCapacity, Fanout> buffer_type;
+
+  class reader;
+  class view;
+
+  /// @brief Construct an empty buffer which at most max_readers readers may
+  ///        read at once
+  /// @note \b Complexity: O(max_readers)
+  explicit concurrent_buffer(std::size_t max_readers = 64);
+
+  /// @brief Construct a buffer whose contents are the range [i, j), with the
+  ///        cursor at the end, and publish it
+  /// @note \b Complexity: O(std::distance(i, j) + max_readers)
+  template<class InputIterator>
+  concurrent_buffer(InputIterator const & i, InputIterator const & j,
+                    std::size_t max_readers = 64);
+
+  /// Free every version.  No reader may remain.
+  ~concurrent_buffer();
+
+  /// @name Writing
+  //@{
+  /// @brief The buffer to edit.  Only the writer thread may use it, and
+  ///        readers do not see its edits until publish() is called.
+  /// @note \b Complexity: O(1)
+  buffer_type &       writer();
+  /// The buffer to edit, for the writer thread only
+  /// @note \b Complexity: O(1)
+  buffer_type const & writer() const;
+
+  /// @brief Make the writer's buffer, as it is now, the version new views
+  ///        see, and free whatever retired versions no view can still see
+  /// @note \b Complexity: O(max_readers + the number of retired versions)
+  void publish();
+
+  /// @brief Free whatever retired versions no view can still see, without
+  ///        publishing
+  /// @note \b Complexity: O(max_readers + the number of retired versions)
+  void reclaim();
+
+  /// Return the number of retired versions which are not yet freed
+  /// @note \b Complexity: O(1)
+  std::size_t retired() const;
+  //@}
+
+  /// @name Reading
+  //@{
+  /// Return the number of readers which may exist at once
+  /// @note \b Complexity: O(1)
+  std::size_t max_readers() const;
+  //@}
+
+private:
+  // Free the retired versions retired before epoch oldest
+  void free_retired(std::size_t oldest);
+
+  buffer_type                contents;
+  boost::atomic<version *>   current;
+  boost::atomic<std::size_t> epoch;
+  boost::scoped_array<slot>  slots;
+  std::size_t                slot_count;
+  std::vector<version *>     retired_versions;
+};
+
+
+/**
+   @brief A reading thread's claim on one of the slots of a concurrent_buffer
+   @details A reader should be claimed once by each reading thread and kept,
+   since claiming one searches the slots.  It may only be used by one thread
+   at a time, and must not outlive its buffer.
+*/
+template<class T, std::size_t LeafCapacity, std::size_t Fanout>
+class concurrent_buffer<T, LeafCapacity, Fanout>::reader
+  : private boost::noncopyable
+{
+public:
+  /// @brief Claim a slot of buffer, throwing std::length_error if all
+  ///        max_readers() are already claimed
+  /// @note \b Complexity: O(max_readers)
+  explicit reader(concurrent_buffer const & buffer);
+
+  /// Give the slot back
+  ~reader();
+
+private:
+  friend class view;
+
+  concurrent_buffer const & owner;
+  slot *                    mine;
+};
+
+
+/**
+   @brief The latest published version of a concurrent_buffer, pinned for as
+          long as this exists
+   @details Only one view of a reader may exist at a time.  The version may be
+   read for as long as the view exists, whatever the writer does meanwhile.
+*/
+template<class T, std::size_t LeafCapacity, std::size_t Fanout>
+class concurrent_buffer<T, LeafCapacity, Fanout>::view
+  : private boost::noncopyable
+{
+public:
+  /// Pin the latest published version
+  /// @note \b Complexity: O(1), and wait-free
+  explicit view(reader & r);
+
+  /// Unpin the version, so that the writer may free it once it is retired
+  /// @note \b Complexity: O(1), and wait-free
+  ~view();
+
+  /// Access the pinned version
+  /// @note \b Complexity: O(1)
+  buffer_type const & operator*() const;
+  /// Access the pinned version
+  /// @note \b Complexity: O(1)
+  buffer_type const * operator->() const;
+
+private:
+  slot *          pinned;
+  version const * seen;
+};
+
+
+#include "concurrent_buffer.ipp"
+#endif
@@ -0,0 +1,222 @@
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include <algorithm>
+#include <stdexcept>
+
+
+template<class T, std::size_t L, std::size_t F>
+struct concurrent_buffer<T, L, F>::version
+{
+  explicit version(buffer_type const & b)
+    : contents(b)
+    , retired_at(0)
+  {}
+
+  buffer_type const contents;
+  // The epoch in which a newer version replaced this one
+  std::size_t       retired_at;
+};
+
+template<class T, std::size_t L, std::size_t F>
+struct concurrent_buffer<T, L, F>::slot
+{
+  // The epoch the view of this slot's reader was made in, or idle
+  boost::atomic<std::size_t> pinned;
+  // If a reader holds this slot
+  boost::atomic<bool>        claimed;
+  // Keep each slot on its own cache line, so that readers don't contend
+  char                       padding[64];
+
+  static std::size_t const idle = static_cast<std::size_t>(-1);
+};
+
+
+template<class T, std::size_t L, std::size_t F>
+concurrent_buffer<T, L, F>::concurrent_buffer(std::size_t max_readers)
+  : current(new version(contents))
+  , epoch(1)
+  , slots(new slot[max_readers])
+  , slot_count(max_readers)
+{
+  for(std::size_t k = 0; k < slot_count; ++k){
+    slots[k].pinned.store(slot::idle, boost::memory_order_relaxed);
+    slots[k].claimed.store(false, boost::memory_order_relaxed);
+  }
+}
+
+template<class T, std::size_t L, std::size_t F>
+template<class InputIterator>
+concurrent_buffer<T, L, F>::concurrent_buffer(InputIterator const & i,
+                                              InputIterator const & j,
+                                              std::size_t max_readers)
+  : contents(i, j)
+  , current(new version(contents))
+  , epoch(1)
+  , slots(new slot[max_readers])
+  , slot_count(max_readers)
+{
+  for(std::size_t k = 0; k < slot_count; ++k){
+    slots[k].pinned.store(slot::idle, boost::memory_order_relaxed);
+    slots[k].claimed.store(false, boost::memory_order_relaxed);
+  }
+}
+
+template<class T, std::size_t L, std::size_t F>
+concurrent_buffer<T, L, F>::~concurrent_buffer()
+{
+  free_retired(slot::idle);
+  delete current.load(boost::memory_order_relaxed);
+}
+
+
+template<class T, std::size_t L, std::size_t F>
+typename concurrent_buffer<T, L, F>::buffer_type &
+concurrent_buffer<T, L, F>::writer()
+{
+  return contents;
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename concurrent_buffer<T, L, F>::buffer_type const &
+concurrent_buffer<T, L, F>::writer() const
+{
+  return contents;
+}
+
+template<class T, std::size_t L, std::size_t F>
+void
+concurrent_buffer<T, L, F>::publish()
+{
+  // The new version must be visible before the epoch moves on, so that a
+  // view which sees the new epoch also sees the new version, and so can't be
+  // pinning the old one
+  version * const old = current.exchange(new version(contents));
+  old->retired_at = epoch.fetch_add(1);
+  retired_versions.push_back(old);
+  reclaim();
+}
+
+template<class T, std::size_t L, std::size_t F>
+void
+concurrent_buffer<T, L, F>::reclaim()
+{
+  // A view pinned in epoch e may hold any version retired in e or later
+  std::size_t oldest = slot::idle;
+  for(std::size_t k = 0; k < slot_count; ++k)
+    oldest = std::min(oldest, slots[k].pinned.load());
+  free_retired(oldest);
+}
+
+template<class T, std::size_t L, std::size_t F>
+void
+concurrent_buffer<T, L, F>::free_retired(std::size_t oldest)
+{
+  typename std::vector<version *>::iterator kept = retired_versions.begin();
+  for(typename std::vector<version *>::iterator v = retired_versions.begin();
+      v != retired_versions.end(); ++v){
+    if((*v)->retired_at < oldest)
+      delete *v;
+    else
+      *kept++ = *v;
+  }
+  retired_versions.erase(kept, retired_versions.end());
+}
+
+template<class T, std::size_t L, std::size_t F>
+std::size_t
+concurrent_buffer<T, L, F>::retired() const
+{
+  return retired_versions.size();
+}
+
+template<class T, std::size_t L, std::size_t F>
+std::size_t
+concurrent_buffer<T, L, F>::max_readers() const
+{
+  return slot_count;
+}
+
+
+template<class T, std::size_t L, std::size_t F>
+concurrent_buffer<T, L, F>::reader::reader(concurrent_buffer const & buffer)
+  : owner(buffer)
+  , mine(0)
+{
+  for(std::size_t k = 0; k < owner.slot_count; ++k){
+    bool expected = false;
+    if(owner.slots[k].claimed.compare_exchange_strong(expected, true)){
+      mine = &owner.slots[k];
+      return;
+    }
+  }
+  throw std::length_error("concurrent_buffer::reader");
+}
+
+template<class T, std::size_t L, std::size_t F>
+concurrent_buffer<T, L, F>::reader::~reader()
+{
+  mine->claimed.store(false, boost::memory_order_release);
+}
+
+
+template<class T, std::size_t L, std::size_t F>
+concurrent_buffer<T, L, F>::view::view(reader & r)
+  : pinned(r.mine)
+{
+  // Pin before looking at the version, so that the writer either sees the
+  // pin, or replaced the version before it was looked at.  Every step must be
+  // sequentially consistent for that to hold.
+  pinned->pinned.store(r.owner.epoch.load());
+  seen = r.owner.current.load();
+}
+
+template<class T, std::size_t L, std::size_t F>
+concurrent_buffer<T, L, F>::view::~view()
+{
+  pinned->pinned.store(slot::idle, boost::memory_order_release);
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename concurrent_buffer<T, L, F>::buffer_type const &
+concurrent_buffer<T, L, F>::view::operator*() const
+{
+  return seen->contents;
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename concurrent_buffer<T, L, F>::buffer_type const *
+concurrent_buffer<T, L, F>::view::operator->() const
+{
+  return &seen->contents;
+}
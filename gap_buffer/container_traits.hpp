@@ -0,0 +1,396 @@
+#ifndef CONTAINER_TRAITS_HPP_INCLUDED_
+#define CONTAINER_TRAITS_HPP_INCLUDED_
+
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <boost/container/container_fwd.hpp>
+#include <boost/move/iterator.hpp>
+#include <boost/mpl/if.hpp>
+#include <boost/range/iterator.hpp>
+#include <boost/type_traits/is_trivially_copyable.hpp>
+#include <cstddef>
+#include <deque>
+#include <list>
+#include <vector>
+
+
+/// @brief Relocate elements by splicing their nodes from one container to the
+///        other, which neither allocates nor touches the elements
+struct splice_relocation_tag {};
+/// @brief Relocate elements with the container's own range insert, from plain
+///        iterators, so that trivially copyable elements are copied in bulk
+struct bulk_relocation_tag {};
+/// @brief Relocate elements by moving them one at a time
+struct move_relocation_tag {};
+
+/**
+   @brief Describes how the buffers built on a container move elements from
+          one of its instances to another
+   @details gap_buffer and multi_gap_buffer move elements between the halves
+   of a gap with relocate_head() and relocate_tail(), which pick their method
+   by relocation_category.  By default it is bulk_relocation_tag for trivially
+   copyable elements and move_relocation_tag otherwise; std::list and
+   boost::container::list splice.  Specialize this template to choose the
+   method for another container.
+*/
+template<class TContainer>
+struct container_traits
+{
+  /// How elements are moved between instances of TContainer
+  typedef typename boost::mpl::if_<
+    boost::is_trivially_copyable<typename TContainer::value_type>,
+    bulk_relocation_tag,
+    move_relocation_tag>::type relocation_category;
+};
+
+template<class T, class TAllocator>
+struct container_traits<std::list<T, TAllocator> >
+{
+  typedef splice_relocation_tag relocation_category;
+};
+
+template<class T, class TAllocator>
+struct container_traits<boost::container::list<T, TAllocator> >
+{
+  typedef splice_relocation_tag relocation_category;
+};
+
+
+namespace relocation_detail
+{
+  template<class TContainer>
+  void relocate_tail(TContainer & from, typename TContainer::iterator first,
+                     TContainer & to, move_relocation_tag)
+  {
+    to.insert(to.begin(), boost::make_move_iterator(first),
+              boost::make_move_iterator(from.end()));
+    from.erase(first, from.end());
+  }
+
+  template<class TContainer>
+  void relocate_tail(TContainer & from, typename TContainer::iterator first,
+                     TContainer & to, bulk_relocation_tag)
+  {
+    to.insert(to.begin(), first, from.end());
+    from.erase(first, from.end());
+  }
+
+  template<class TContainer>
+  void relocate_tail(TContainer & from, typename TContainer::iterator first,
+                     TContainer & to, splice_relocation_tag)
+  {
+    // Nodes can only change hands between containers which share a heap
+    if(from.get_allocator() == to.get_allocator())
+      to.splice(to.begin(), from, first, from.end());
+    else
+      relocate_tail(from, first, to, move_relocation_tag());
+  }
+
+  template<class TContainer>
+  void relocate_head(TContainer & from, typename TContainer::iterator last,
+                     TContainer & to, move_relocation_tag)
+  {
+    to.insert(to.end(), boost::make_move_iterator(from.begin()),
+              boost::make_move_iterator(last));
+    from.erase(from.begin(), last);
+  }
+
+  template<class TContainer>
+  void relocate_head(TContainer & from, typename TContainer::iterator last,
+                     TContainer & to, bulk_relocation_tag)
+  {
+    to.insert(to.end(), from.begin(), last);
+    from.erase(from.begin(), last);
+  }
+
+  template<class TContainer>
+  void relocate_head(TContainer & from, typename TContainer::iterator last,
+                     TContainer & to, splice_relocation_tag)
+  {
+    if(from.get_allocator() == to.get_allocator())
+      to.splice(to.end(), from, from.begin(), last);
+    else
+      relocate_head(from, last, to, move_relocation_tag());
+  }
+}
+
+/// @brief Move the elements [first, from.end()) to the front of to, in order,
+///        and erase them from from
+/// @note \b Complexity: O(the number of elements moved) for
+///       splice_relocation_tag, otherwise that of TContainer::insert at the
+///       front of to
+template<class TContainer>
+void relocate_tail(TContainer & from, typename TContainer::iterator first,
+                   TContainer & to)
+{
+  relocation_detail::relocate_tail(
+    from, first, to,
+    typename container_traits<TContainer>::relocation_category());
+}
+
+/// @brief Move the elements [from.begin(), last) to the back of to, in order,
+///        and erase them from from
+/// @note \b Complexity: O(the number of elements moved) for
+///       splice_relocation_tag, otherwise that of TContainer::erase at the
+///       front of from
+template<class TContainer>
+void relocate_head(TContainer & from, typename TContainer::iterator last,
+                   TContainer & to)
+{
+  relocation_detail::relocate_head(
+    from, last, to,
+    typename container_traits<TContainer>::relocation_category());
+}
+
+
+
+/// The storage a container holds from its allocator
+struct storage_footprint
+{
+  /// The number of separate allocations holding elements
+  std::size_t blocks;
+  /// The bytes of those allocations
+  std::size_t bytes;
+};
+
+/**
+   @brief Describes how much storage an instance of a container holds
+   @details footprint() estimates the storage which holds the elements, not
+   counting the container object itself, any bookkeeping its allocator adds, or
+   storage which does not hold elements, such as the map of a std::deque.
+   By default that is a single block just large enough for the elements, a
+   guess which \a measured marks as such.  std::vector and
+   boost::container::vector report their capacity, std::list and
+   boost::container::list a node per element, and boost::container::deque
+   and, with libstdc++, std::deque the blocks they hold.  Specialize this
+   template to describe another container.
+*/
+template<class TContainer>
+struct storage_traits
+{
+  /// If footprint() follows the storage c really holds, rather than guessing
+  static bool const measured = false;
+
+  /// The storage c holds from its allocator
+  static storage_footprint footprint(TContainer const & c)
+  {
+    storage_footprint const rtn = {
+      c.empty() ? 0u : 1u, c.size() * sizeof(typename TContainer::value_type)
+    };
+    return rtn;
+  }
+};
+
+namespace storage_detail
+{
+  template<class TVector>
+  storage_footprint vector_footprint(TVector const & v)
+  {
+    storage_footprint const rtn = {
+      v.capacity() == 0 ? 0u : 1u,
+      v.capacity() * sizeof(typename TVector::value_type)
+    };
+    return rtn;
+  }
+
+  template<class TList>
+  storage_footprint list_footprint(TList const & l)
+  {
+    // Each node holds its element and the links to its neighbours
+    storage_footprint const rtn = {
+      l.size(),
+      l.size() * (sizeof(typename TList::value_type) + 2 * sizeof(void *))
+    };
+    return rtn;
+  }
+}
+
+template<class T, class TAllocator>
+struct storage_traits<std::vector<T, TAllocator> >
+{
+  static bool const measured = true;
+  static storage_footprint footprint(std::vector<T, TAllocator> const & v)
+  {
+    return storage_detail::vector_footprint(v);
+  }
+};
+
+template<class T, class TAllocator, class TOptions>
+struct storage_traits<boost::container::vector<T, TAllocator, TOptions> >
+{
+  static bool const measured = true;
+  static storage_footprint
+  footprint(boost::container::vector<T, TAllocator, TOptions> const & v)
+  {
+    return storage_detail::vector_footprint(v);
+  }
+};
+
+template<class T, class TAllocator>
+struct storage_traits<std::list<T, TAllocator> >
+{
+  static bool const measured = true;
+  static storage_footprint footprint(std::list<T, TAllocator> const & l)
+  {
+    return storage_detail::list_footprint(l);
+  }
+};
+
+template<class T, class TAllocator>
+struct storage_traits<boost::container::list<T, TAllocator> >
+{
+  static bool const measured = true;
+  static storage_footprint
+  footprint(boost::container::list<T, TAllocator> const & l)
+  {
+    return storage_detail::list_footprint(l);
+  }
+};
+
+
+// A boost::container::deque holds every block from the one its first element
+// is in to the one its end is in, once it has allocated any
+template<class T, class TAllocator, class TOptions>
+struct storage_traits<boost::container::deque<T, TAllocator, TOptions> >
+{
+  static bool const measured = true;
+  static storage_footprint
+  footprint(boost::container::deque<T, TAllocator, TOptions> const & d)
+  {
+    typedef boost::container::deque<T, TAllocator, TOptions> deque_type;
+    typename deque_type::const_iterator const first = d.begin(), last = d.end();
+    std::size_t const blocks =
+      first.get_node() ? last.get_node() - first.get_node() + 1 : 0;
+    storage_footprint const rtn = {
+      blocks, blocks * deque_type::get_block_size() * sizeof(T)
+    };
+    return rtn;
+  }
+};
+
+
+/**
+   @brief Describes how cheaply a container finds the element at an index
+   @details When its halves have random access, gap_buffer can make its
+   iterators just the buffer and an index, but then every dereference indexes
+   one of the halves.  That is as cheap as an iterator for std::vector, whose
+   elements are contiguous, and cheap_index says so.  std::deque must find the
+   block each index is in, which would make a walk several times slower than
+   one with iterators into the halves, so blocked says that block() can find
+   the contiguous block of memory holding an element, which an iterator may
+   keep and walk until it leaves it.  gap_buffer uses compact iterators for
+   random access containers which are either, and iterators into the halves
+   otherwise.  std::vector has cheap_index, and boost::container::deque and,
+   with libstdc++, std::deque are blocked.  Specialize this template to
+   describe another container.
+*/
+template<class TContainer>
+struct indexing_traits
+{
+  /// If indexing TContainer is as cheap as dereferencing one of its iterators
+  static bool const cheap_index = false;
+  /// If TContainer provides block(c, i, first, last), which sets [first, last)
+  /// to the contiguous elements of c around c[i], and returns the index of
+  /// *first.  c may be const.
+  static bool const blocked = false;
+};
+
+template<class T, class TAllocator>
+struct indexing_traits<std::vector<T, TAllocator> >
+{
+  static bool const cheap_index = true;
+  static bool const blocked = false;
+};
+
+template<class T, class TAllocator, class TOptions>
+struct indexing_traits<boost::container::deque<T, TAllocator, TOptions> >
+{
+  static bool const cheap_index = false;
+  static bool const blocked = true;
+
+  template<class TDeque, class TPointer>
+  static std::size_t block(TDeque & d, std::size_t i,
+                           TPointer & first, TPointer & last)
+  {
+    typedef typename boost::range_iterator<TDeque>::type iterator;
+    iterator const begin = d.begin(), end = d.end(), at = begin + i;
+    first = at.get_node() == begin.get_node() ?
+      begin.get_cur() : at.get_first();
+    last = at.get_node() == end.get_node() ? end.get_cur() : at.get_last();
+    return i - (at.get_cur() - first);
+  }
+};
+
+
+#if defined(__GLIBCXX__)
+// A std::deque holds every block from the one its first element is in to the
+// one its end is in, and its iterators know where theirs start and end
+template<class T, class TAllocator>
+struct storage_traits<std::deque<T, TAllocator> >
+{
+  static bool const measured = true;
+  static storage_footprint footprint(std::deque<T, TAllocator> const & d)
+  {
+    typename std::deque<T, TAllocator>::const_iterator const
+      first = d.begin(), last = d.end();
+    std::size_t const blocks = last._M_node - first._M_node + 1;
+    storage_footprint const rtn = {
+      blocks, blocks * (first._M_last - first._M_first) * sizeof(T)
+    };
+    return rtn;
+  }
+};
+
+// The iterators of a std::deque know the block they are in
+template<class T, class TAllocator>
+struct indexing_traits<std::deque<T, TAllocator> >
+{
+  static bool const cheap_index = false;
+  static bool const blocked = true;
+
+  template<class TDeque, class TPointer>
+  static std::size_t block(TDeque & d, std::size_t i,
+                           TPointer & first, TPointer & last)
+  {
+    typedef typename boost::range_iterator<TDeque>::type iterator;
+    iterator const begin = d.begin(), end = d.end(), at = begin + i;
+    first = at._M_node == begin._M_node ? begin._M_cur : at._M_first;
+    last = at._M_node == end._M_node ? end._M_cur : at._M_last;
+    return i - (at._M_cur - first);
+  }
+};
+#endif
+
+
+#endif
@@ -0,0 +1,589 @@
+#ifndef CONTIGUOUS_GAP_BUFFER_HPP_INCLUDED_
+#define CONTIGUOUS_GAP_BUFFER_HPP_INCLUDED_
+
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include <boost/array.hpp>
+#include <boost/concept/assert.hpp>
+#include <boost/concept_check.hpp>
+#include <boost/config.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/move/move.hpp>
+#include <boost/range/iterator_range.hpp>
+#include <boost/type_traits/aligned_storage.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include <boost/type_traits/is_convertible.hpp>
+#include <boost/utility/enable_if.hpp>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+
+#include "detail/concepts.hpp"
+#include "edit_batch.hpp"
+
+
+/**
+   @brief Growth policy which scales the storage geometrically
+   @details When an insertion does not fit in the gap, the storage is grown to
+   Numerator/Denominator times its old capacity, but never to less than the
+   required size plus MinGap free elements.
+*/
+template<std::size_t Numerator = 3, std::size_t Denominator = 2,
+         std::size_t MinGap = 64>
+struct geometric_gap_growth
+{
+  /// Return the new capacity for storage of @p capacity elements that must now
+  /// hold @p required elements
+  static std::size_t grow(std::size_t capacity, std::size_t required)
+  {
+    std::size_t const scaled = capacity / Denominator * Numerator;
+    return (scaled > required + MinGap) ? scaled : required + MinGap;
+  }
+};
+
+/**
+   @brief Shrink policy which releases storage once the buffer is sparse
+   @details The storage is shrunk once fewer than 1/Divisor of its elements are
+   in use, and is then reallocated to twice the live size plus MinGap.
+*/
+template<std::size_t Divisor = 4, std::size_t MinGap = 64>
+struct fractional_gap_shrink
+{
+  /// Return if storage of @p capacity elements holding @p size should shrink
+  static bool should_shrink(std::size_t size, std::size_t capacity)
+  {
+    return (size * Divisor < capacity) && (shrink_to(size) < capacity);
+  }
+
+  /// Return the capacity to shrink to for a buffer holding @p size elements
+  static std::size_t shrink_to(std::size_t size)
+  {
+    return 2 * size + MinGap;
+  }
+};
+
+/// Shrink policy which never releases storage until destruction
+struct no_gap_shrink
+{
+  /// Always false
+  static bool should_shrink(std::size_t, std::size_t) { return false; }
+  /// Never used, but provided for completeness
+  static std::size_t shrink_to(std::size_t size) { return size; }
+};
+
+
+namespace contiguous_detail
+{
+  // Raw storage for N elements kept inside the buffer object itself
+  template<class T, std::size_t N>
+  class inline_storage
+  {
+  public:
+    T *       local()       { return static_cast<T *>(space.address()); }
+    T const * local() const
+    {
+      return static_cast<T const *>(space.address());
+    }
+  private:
+    typename boost::aligned_storage<N * sizeof(T),
+                                    boost::alignment_of<T>::value>::type space;
+  };
+
+  // Without inline storage, "local" storage is the null pointer an empty
+  // buffer has always had, and the base takes up no space
+  template<class T>
+  class inline_storage<T, 0>
+  {
+  public:
+    T *       local()       { return 0; }
+    T const * local() const { return 0; }
+  };
+}
+
+
+/**
+   @brief A gap buffer stored in a single contiguous allocation
+   @details
+   This class template provides the same interface as gap_buffer, but rather
+   than adapting two containers it owns a single block of storage with a hole
+   (the gap) in it.  Elements logically before the gap are stored at the front
+   of the block, and elements logically after it at the back.  Moving the gap
+   relocates only the elements between its old and new location, using memmove
+   when value_type is trivially copyable.
+
+   The cursor is tracked separately from the gap, so advance() never moves any
+   data.  The gap is only moved to the point of an edit when that edit happens.
+
+   With a non-zero InlineCapacity, up to that many elements are kept inside
+   the contiguous_gap_buffer object itself, and storage is only allocated once
+   the buffer outgrows it.  When a buffer shrinks back to fit, it returns to
+   the inline storage.  Buffers holding their elements inline must move them
+   one by one to move or swap.  See also small_gap_buffer.
+
+   A contiguous_gap_buffer is an STL container.  It models the STL concepts
+   Container, Forward Container, Reversible Container and Random Access
+   Container.
+
+   @tparam T       The element type
+   @tparam TGrowth The policy deciding how far to grow the storage when the gap
+                   is exhausted.  See geometric_gap_growth.
+   @tparam TShrink The policy deciding when to give storage back after
+                   erasures.  See fractional_gap_shrink and no_gap_shrink.
+   @tparam InlineCapacity The number of elements to store without allocating
+*/
+template<class T,
+         class TGrowth = geometric_gap_growth<>,
+         class TShrink = fractional_gap_shrink<>,
+         std::size_t InlineCapacity = 0>
+class contiguous_gap_buffer
+  : private contiguous_detail::inline_storage<T, InlineCapacity>
+{
+private:
+  // Enable Boost.Move move-emulation (or actual move on C++11)
+  BOOST_COPYABLE_AND_MOVABLE(contiguous_gap_buffer)
+
+  // This iterator template uses Boost.Iterator to produce the iterator types
+  // for contiguous_gap_buffer.  It stores only the buffer and a logical index,
+  // so it remains valid across movements of the gap.
+  template<class TValue, class TBuffer>
+  class iterator_impl;
+
+  typedef std::allocator<T> allocator_type;
+
+  T *         storage;
+  std::size_t allocated;
+  std::size_t gap_begin;
+  std::size_t gap_end;
+  std::size_t cursor;
+public:
+  /// @name Other Container requirements
+  //@{
+  /// The value_type of this container
+  typedef T                 value_type;
+  /// value_type *
+  typedef T *               pointer;
+  /// value_type const *
+  typedef T const *         const_pointer;
+  /// value_type &
+  typedef T &               reference;
+  /// value_type const &
+  typedef T const &         const_reference;
+  /// The size_type of this container
+  typedef std::size_t       size_type;
+  /// The difference_type of this container
+  typedef std::ptrdiff_t    difference_type;
+
+  /// Return the number of elements in the contiguous_gap_buffer
+  /// @note \b Complexity: O(1)
+  size_type size() const;
+
+  /// Return the maximum number of elements a contiguous_gap_buffer might hold
+  /// @note \b Complexity: O(1)
+  size_type max_size() const;
+
+  /// Return if the contiguous_gap_buffer is empty
+  /// @note \b Complexity: O(1)
+  bool empty() const;
+
+  /// Swap this contiguous_gap_buffer with another
+  /// @note \b Complexity: O(1), or O(InlineCapacity) if either buffer holds
+  ///       its elements inline
+  void swap(contiguous_gap_buffer & other);
+  //@}
+
+  ///@name Iterator access
+  //@{
+  typedef iterator_impl<T, contiguous_gap_buffer>                   iterator;
+  typedef iterator_impl<T const, contiguous_gap_buffer const> const_iterator;
+  typedef std::reverse_iterator<iterator>                   reverse_iterator;
+  typedef std::reverse_iterator<const_iterator>       const_reverse_iterator;
+
+  /// Return the cursor position as an iterator
+  /// @note \b Complexity: O(1)
+  iterator here();
+  /// Return the cursor position as an iterator
+  /// @note \b Complexity: O(1)
+  const_iterator here() const;
+  /// Return the cursor position as a reverse iterator
+  /// @note \b Complexity: O(1)
+  reverse_iterator rhere();
+  /// Return the cursor position as a reverse iterator
+  /// @note \b Complexity: O(1)
+  const_reverse_iterator rhere() const;
+
+  /// Get an iterator to the beginning of the contiguous_gap_buffer
+  /// @note \b Complexity: O(1)
+  iterator begin();
+  /// Get an iterator to one element past the end of the contiguous_gap_buffer
+  /// @note \b Complexity: O(1)
+  iterator end();
+  /// Get a const iterator to the beginning of the contiguous_gap_buffer
+  /// @note \b Complexity: O(1)
+  const_iterator begin() const;
+  /// @brief Get a const iterator to one element past the end of the
+  /// contiguous_gap_buffer
+  /// @note \b Complexity: O(1)
+  const_iterator end() const;
+
+  /// @brief Get a reverse iterator to the beginning of the reversed
+  /// contiguous_gap_buffer
+  /// @note \b Complexity: O(1)
+  reverse_iterator rbegin();
+  /// @brief Get a reverse iterator to one element past the end of the reversed
+  /// contiguous_gap_buffer
+  /// @note \b Complexity: O(1)
+  reverse_iterator rend();
+  /// @brief Get a const reverse iterator to the beginning of the reversed
+  /// contiguous_gap_buffer
+  /// @note \b Complexity: O(1)
+  const_reverse_iterator rbegin() const;
+  /// @brief Get a reverse const iterator to one element past the end of the
+  /// reversed contiguous_gap_buffer
+  /// @note \b Complexity: O(1)
+  const_reverse_iterator rend() const;
+  //@}
+
+  /// @name Segments
+  //@{
+  /// @brief A range of the contiguous runs of a contiguous_gap_buffer, in
+  ///        order
+  /// @details These are the elements before and after the gap, either of
+  ///          which may be empty.
+  typedef boost::array<boost::iterator_range<T const *>, 2> const_segment_list;
+
+  /// @brief Return the runs of elements in this contiguous_gap_buffer, for use
+  ///        by the algorithms in segmented_algorithms.hpp
+  /// @note The runs are invalidated by any edit or cursor movement
+  /// @note \b Complexity: O(1)
+  const_segment_list segments() const;
+  //@}
+
+  /// @name Sequence Requirements
+  //@{
+  /// Default-construct an empty contiguous_gap_buffer without allocating
+  contiguous_gap_buffer();
+
+  /// Copy-construct a contiguous_gap_buffer
+  /// @note \b Complexity: O(other.size())
+  contiguous_gap_buffer(contiguous_gap_buffer const & other);
+
+  /// Move-construct a contiguous_gap_buffer
+  /// @note \b Complexity: O(1), or O(other.size()) if other holds its elements
+  ///       inline
+  contiguous_gap_buffer(BOOST_RV_REF(contiguous_gap_buffer) other);
+
+  /// @brief Fill-construct a contiguous_gap_buffer with n copies of e and the
+  ///        cursor at the end
+  /// @note \b Complexity: O(n)
+  contiguous_gap_buffer(size_type n, value_type e = value_type());
+
+  /// @brief Construct a contiguous_gap_buffer whose contents are the range
+  ///        [i, j) with the cursor at the end
+  /// @tparam InputIterator A model of Input Iterator whose value_type is
+  ///                       convertible to value_type
+  /// @note \b Complexity: O(std::distance(i, j))
+  template<class InputIterator>
+  contiguous_gap_buffer(InputIterator const & i, InputIterator const & j);
+
+  /// Destroy the elements and release the storage
+  ~contiguous_gap_buffer();
+
+  /// Retrieve the first element of the contiguous_gap_buffer
+  /// @note \b Complexity: O(1)
+  reference       front();
+  /// Retrieve the first element of the contiguous_gap_buffer
+  /// @note \b Complexity: O(1)
+  const_reference front() const;
+
+  /// Insert element immediately before position.  If position is at or
+  /// before the cursor, advance the cursor one position.
+  /// @note \b Complexity: O(distance from the gap to position), amortized
+  iterator insert(iterator position, const_reference element);
+
+  /// Insert element immediately before position by moving it, as the insert
+  /// above does.  This also inserts elements which cannot be copied.
+  /// @note \b Complexity: O(distance from the gap to position), amortized
+  iterator insert(iterator position, BOOST_RV_REF(value_type) element);
+
+  /// Insert n copies of element immediately before position.  If position
+  /// is at or before the cursor, advance the cursor n positions.
+  /// @note \b Complexity: O(n + distance from the gap to position), amortized
+  void insert(iterator position, size_type n, const_reference element);
+
+  /// Insert the range of elements [i,j) immediately before position. If
+  /// position is at or before the cursor, advance the cursor n positions.
+  /// @note \b Complexity: O(n + distance from the gap to position), amortized
+  template<class InputIterator>
+  void insert(iterator position,
+              InputIterator const & i, InputIterator const & j);
+
+  /// Erase the element at position.  If position was before the cursor, move
+  /// the cursor one spot earlier.
+  /// @note \b Complexity: O(distance from the gap to position)
+  iterator erase(iterator position);
+
+  /// Erase the elements in [start,end).  If the cursor was within this range,
+  /// move it to immediately before the range.
+  /// @note \b Complexity: O(distance from the gap to the range)
+  iterator erase(iterator start, iterator end);
+
+  /// Remove all the elements in this and move the cursor to the beginning
+  /// @note \b Complexity: O(n)
+  void clear();
+
+  /// @brief Resize the contiguous_gap_buffer.  If the buffer is growing, pad
+  /// the end with copies of e.  If the buffer is shrinking, discard elements
+  /// from the end.
+  /// @note \b Complexity: O(n)
+  void resize(size_type n, value_type const & e = value_type());
+
+  /// Assign one contiguous_gap_buffer to another
+  /// @note \b Complexity: O(n)
+  contiguous_gap_buffer &
+  operator=(BOOST_COPY_ASSIGN_REF(contiguous_gap_buffer) other);
+
+  /// Move assign one contiguous_gap_buffer to another
+  /// @note \b Complexity: O(1), or O(InlineCapacity) if either buffer holds
+  ///       its elements inline
+  contiguous_gap_buffer &
+  operator=(BOOST_RV_REF(contiguous_gap_buffer) other);
+  //@}
+
+
+  /// @name Cursor Handling
+  //@{
+  /// Return the cursor position of the contiguous_gap_buffer
+  /// @note \b Complexity: O(1)
+  size_type position() const;
+
+  /// Move the cursor position.  No data is moved until the next edit.
+  /// @note \b Complexity: O(1)
+  void advance(difference_type const dist);
+
+  /// @brief Remove data from this position.
+  /// @details A positive value erases the given number of values from ahead of
+  /// the cursor.  A negative value erases the absolute value of the given
+  /// number of cursors from behind the cursor.
+  /// @note \b Complexity: O(abs(dist) + distance from the gap to the cursor)
+  void erase(difference_type const dist);
+
+  /// Insert a copy of element at the cursor
+  /// @note \b Complexity: O(distance from the gap to the cursor), amortized
+  size_type insert(value_type const & element);
+
+  /// Insert element at the cursor by moving it
+  /// @note \b Complexity: O(distance from the gap to the cursor), amortized
+  size_type insert(BOOST_RV_REF(value_type) element);
+
+  /// @brief Insert a range of elements at the cursor
+  /// @param range Any range of elements Boost.Range recognizes as a Single Pass
+  ///              Range.
+  /// @note \b Complexity: O(boost::size(range) + distance from the gap to the
+  ///       cursor), amortized
+  template<class TSinglePassRange>
+  size_type insert(TSinglePassRange const & range);
+  //@}
+
+  /// @name Emplacement
+  //@{
+#if !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES) && \
+    !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+  /// @brief Construct an element from args and insert it at the cursor
+  /// @details The element is constructed before anything in the buffer moves,
+  ///          so args may refer to elements of this buffer.
+  /// @note \b Complexity: O(distance from the gap to the cursor), amortized
+  template<class... Args>
+  size_type emplace(Args &&... args);
+
+  /// @brief Construct an element from args and insert it immediately before
+  ///        position, as insert(position, element) does
+  /// @note \b Complexity: O(distance from the gap to position), amortized
+  template<class... Args>
+  iterator emplace(iterator position, Args &&... args);
+#else
+  // Without variadic templates, up to three arguments are forwarded
+  size_type emplace();
+  template<class A1>
+  size_type emplace(BOOST_FWD_REF(A1) a1);
+  template<class A1, class A2>
+  size_type emplace(BOOST_FWD_REF(A1) a1, BOOST_FWD_REF(A2) a2);
+  template<class A1, class A2, class A3>
+  size_type emplace(BOOST_FWD_REF(A1) a1, BOOST_FWD_REF(A2) a2,
+                    BOOST_FWD_REF(A3) a3);
+  iterator emplace(iterator position);
+  template<class A1>
+  iterator emplace(iterator position, BOOST_FWD_REF(A1) a1);
+  template<class A1, class A2>
+  iterator emplace(iterator position,
+                   BOOST_FWD_REF(A1) a1, BOOST_FWD_REF(A2) a2);
+  template<class A1, class A2, class A3>
+  iterator emplace(iterator position, BOOST_FWD_REF(A1) a1,
+                   BOOST_FWD_REF(A2) a2, BOOST_FWD_REF(A3) a3);
+#endif
+  //@}
+
+  /// @name Batches
+  //@{
+  /// @brief Make every edit of batch, whose positions refer to this buffer as
+  ///        it is now, leaving the cursor where batch.map() puts it
+  /// @details The elements are relocated into new storage in one pass, with
+  ///          the gap at the new cursor.  If batch.validate() throws, or
+  ///          copying an inserted element does, the buffer is unchanged.
+  /// @note \b Complexity: O(n + the number of elements batch inserts)
+  void apply(edit_batch<value_type> const & batch);
+  //@}
+
+  /// @name Storage
+  //@{
+  /// Return the number of elements the current storage can hold
+  /// @note \b Complexity: O(1)
+  size_type capacity() const;
+
+  /// Return if the elements are held in the inline storage
+  /// @note \b Complexity: O(1)
+  bool is_inline() const;
+  //@}
+
+private:
+  // The physical address of the element at logical index i
+  T *       element(size_type i);
+  T const * element(size_type i) const;
+
+  // Relocate the gap so that it begins at logical index i
+  void move_gap(size_type i);
+  // Relocate the gap to logical index i, growing it to hold n more elements
+  void open_gap(size_type i, size_type n);
+  // Move everything into storage of new_capacity with the gap at index i
+  void reallocate(size_type new_capacity, size_type i);
+  // Give back storage if the shrink policy asks for it
+  void maybe_shrink();
+  // Release the storage, unless it is the inline storage
+  void deallocate();
+  // Take the elements of other, leaving it empty.  This must be empty and
+  // using its inline storage.
+  void steal(contiguous_gap_buffer & other);
+  // Remove the elements in logical [start, finish) and fix up the cursor
+  void erase_range(size_type start, size_type finish);
+
+  // Relocate [first, last) so that it ends at d_last.  The destination is
+  // uninitialized storage except where it overlaps the source.
+  static void relocate_backward(T * first, T * last, T * d_last);
+  // Relocate [first, last) so that it begins at d_first.  The destination is
+  // uninitialized storage except where it overlaps the source.
+  static void relocate_forward(T * first, T * last, T * d_first);
+  // Move the logical range [start, finish) into uninitialized storage at dest
+  void relocate_out(size_type start, size_type finish, T * dest);
+  // Destroy the elements in [first, last)
+  static void destroy(T * first, T * last);
+  // Destroy the elements in the logical range [start, finish)
+  void destroy_range(size_type start, size_type finish);
+
+  // Make the edits of batch one at a time, from last to first
+  void apply_each(edit_batch<value_type> const & batch);
+  // Copy the n elements from first into fresh storage, at index out of a
+  // buffer whose gap of the given size begins at index split
+  template<class ForwardIterator>
+  static void copy_into(ForwardIterator first, size_type n, T * fresh,
+                        size_type out, size_type split, size_type gap);
+  // Move the logical range [start, finish) into fresh storage likewise
+  void relocate_into(size_type start, size_type finish, T * fresh,
+                     size_type out, size_type split, size_type gap);
+
+  // Dispatch the range insertions on integral arguments and iterator category
+  template<class TInteger>
+  void insert_dispatch(size_type i, TInteger n, TInteger e,
+                       boost::true_type);
+  template<class InputIterator>
+  void insert_dispatch(size_type i, InputIterator first, InputIterator last,
+                       boost::false_type);
+  template<class InputIterator>
+  void insert_range(size_type i, InputIterator first, InputIterator last,
+                    std::input_iterator_tag);
+  template<class ForwardIterator>
+  void insert_range(size_type i, ForwardIterator first, ForwardIterator last,
+                    std::forward_iterator_tag);
+  void insert_fill(size_type i, size_type n, const_reference e);
+  // Insert e at logical index i by moving from it.  e must not be in this
+  // buffer.
+  void insert_one(size_type i, value_type & e);
+
+  // Check our iterator's concepts
+  BOOST_CONCEPT_ASSERT(( typename concept_detail::if_copyable<T,
+    boost::Mutable_RandomAccessIterator<iterator> >::type ));
+  BOOST_CONCEPT_ASSERT(( typename concept_detail::if_copyable<T,
+    boost::Mutable_RandomAccessIterator<reverse_iterator> >::type ));
+  BOOST_CONCEPT_ASSERT((boost::RandomAccessIterator<          const_iterator>));
+  BOOST_CONCEPT_ASSERT((boost::RandomAccessIterator<  const_reverse_iterator>));
+};
+
+///@name Comparisons
+//@{
+/// Test two contiguous_gap_buffers for equality
+/// @note \b Complexity: O(n)
+template<class T, class G, class S, std::size_t I>
+bool operator==(contiguous_gap_buffer<T, G, S, I> const &,
+                contiguous_gap_buffer<T, G, S, I> const &);
+/// Test two contiguous_gap_buffers for inequality
+/// @note \b Complexity: O(n)
+template<class T, class G, class S, std::size_t I>
+bool operator!=(contiguous_gap_buffer<T, G, S, I> const &,
+                contiguous_gap_buffer<T, G, S, I> const &);
+/// Test if one contiguous_gap_buffer is less than another
+/// @note \b Complexity: O(n)
+template<class T, class G, class S, std::size_t I>
+bool operator<(contiguous_gap_buffer<T, G, S, I> const &,
+               contiguous_gap_buffer<T, G, S, I> const &);
+/// Test if one contiguous_gap_buffer is greater than another
+/// @note \b Complexity: O(n)
+template<class T, class G, class S, std::size_t I>
+bool operator>(contiguous_gap_buffer<T, G, S, I> const &,
+               contiguous_gap_buffer<T, G, S, I> const &);
+/// Test if one contiguous_gap_buffer is less than or equal to another
+/// @note \b Complexity: O(n)
+template<class T, class G, class S, std::size_t I>
+bool operator<=(contiguous_gap_buffer<T, G, S, I> const &,
+                contiguous_gap_buffer<T, G, S, I> const &);
+/// Test if one contiguous_gap_buffer is greater than or equal to another
+/// @note \b Complexity: O(n)
+template<class T, class G, class S, std::size_t I>
+bool operator>=(contiguous_gap_buffer<T, G, S, I> const &,
+                contiguous_gap_buffer<T, G, S, I> const &);
+//@}
+
+
+#include "segmented_algorithms.hpp"
+#include "contiguous_gap_buffer.ipp"
+#endif
@@ -0,0 +1,1136 @@
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <boost/next_prior.hpp>
+#include <boost/range/begin.hpp>
+#include <boost/range/end.hpp>
+#include <boost/type_traits/has_trivial_destructor.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/is_trivially_copyable.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+
+/**
+   @invariant buf == 0 || idx <= buf->size()
+*/
+template<class T, class TGrowth, class TShrink, std::size_t I>
+template<class TValue, class TBuffer>
+class contiguous_gap_buffer<T, TGrowth, TShrink, I>::iterator_impl
+  : public boost::iterator_facade<iterator_impl<TValue, TBuffer>,
+                                  TValue,
+                                  std::random_access_iterator_tag>
+{
+  struct enabler {};
+public:
+  iterator_impl()
+    : buf(0)
+    , idx(0)
+  {}
+
+  iterator_impl(TBuffer * buffer, std::size_t index)
+    : buf(buffer)
+    , idx(index)
+  {}
+
+  // Allow iterator to convert to const_iterator, but not the other way around
+  template<class UValue, class UBuffer>
+  iterator_impl(iterator_impl<UValue, UBuffer> const & other,
+                typename boost::enable_if<
+                  boost::is_convertible<UValue *, TValue *>,
+                  enabler>::type = enabler())
+    : buf(other.buf)
+    , idx(other.idx)
+  {}
+
+private:
+  // Grant access to Boost.Iterator
+  friend class boost::iterator_core_access;
+  friend class contiguous_gap_buffer<T, TGrowth, TShrink, I>;
+  template<class, class> friend class iterator_impl;
+
+  // The buffer this iterator walks over
+  TBuffer *   buf;
+  // The logical index of the element this iterator refers to
+  std::size_t idx;
+
+  TValue & dereference() const
+  {
+    return *buf->element(idx);
+  }
+  // Compare the iterator for equality, as a callback to Boost.Iterator
+  template<class UValue, class UBuffer>
+  bool equal(iterator_impl<UValue, UBuffer> const & other) const
+  {
+    return idx == other.idx;
+  }
+  // Increment the iterator, as a callback to Boost.Iterator
+  void increment()
+  {
+    ++idx;
+  }
+  // Decrement the iterator, as a callback to Boost.Iterator
+  void decrement()
+  {
+    --idx;
+  }
+  // Advance the iterator, as a callback to Boost.Iterator
+  void advance(std::ptrdiff_t n)
+  {
+    idx += n;
+  }
+  // Measure distance between to iterators as callback to Boost.Iterator
+  template<class UValue, class UBuffer>
+  std::ptrdiff_t distance_to(iterator_impl<UValue, UBuffer> const & other) const
+  {
+    return static_cast<std::ptrdiff_t>(other.idx) -
+      static_cast<std::ptrdiff_t>(idx);
+  }
+};
+
+
+template<class T, class G, class S, std::size_t I>
+T *
+contiguous_gap_buffer<T, G, S, I>::
+element(size_type i)
+{
+  return storage + (i < gap_begin ? i : i + (gap_end - gap_begin));
+}
+
+template<class T, class G, class S, std::size_t I>
+T const *
+contiguous_gap_buffer<T, G, S, I>::
+element(size_type i) const
+{
+  return storage + (i < gap_begin ? i : i + (gap_end - gap_begin));
+}
+
+
+template<class T, class G, class S, std::size_t I>
+void
+contiguous_gap_buffer<T, G, S, I>::
+destroy(T * first, T * last)
+{
+  if(boost::has_trivial_destructor<T>::value)
+    return;
+  for(; first != last; ++first)
+    first->~T();
+}
+
+template<class T, class G, class S, std::size_t I>
+void
+contiguous_gap_buffer<T, G, S, I>::
+relocate_backward(T * first, T * last, T * d_last)
+{
+  std::size_t const n = last - first;
+  if(boost::is_trivially_copyable<T>::value){
+    std::memmove(static_cast<void *>(d_last - n), first, n * sizeof(T));
+    return;
+  }
+
+  // Walk backwards so that overlapping sources are consumed before they are
+  // overwritten.  Anything at or past last is raw storage.
+  T * src = last;
+  T * dst = d_last;
+  while(src != first){
+    --src;
+    --dst;
+    if(dst >= last)
+      ::new(static_cast<void *>(dst)) T(::boost::move(*src));
+    else
+      *dst = ::boost::move(*src);
+  }
+  destroy(first, std::min(last, d_last - n));
+}
+
+template<class T, class G, class S, std::size_t I>
+void
+contiguous_gap_buffer<T, G, S, I>::
+relocate_forward(T * first, T * last, T * d_first)
+{
+  std::size_t const n = last - first;
+  if(boost::is_trivially_copyable<T>::value){
+    std::memmove(static_cast<void *>(d_first), first, n * sizeof(T));
+    return;
+  }
+
+  // Walk forwards so that overlapping sources are consumed before they are
+  // overwritten.  Anything before first is raw storage.
+  T * dst = d_first;
+  for(T * src = first; src != last; ++src, ++dst){
+    if(dst < first)
+      ::new(static_cast<void *>(dst)) T(::boost::move(*src));
+    else
+      *dst = ::boost::move(*src);
+  }
+  destroy(std::max(first, d_first + n), last);
+}
+
+template<class T, class G, class S, std::size_t I>
+void
+contiguous_gap_buffer<T, G, S, I>::
+relocate_out(size_type start, size_type finish, T * dest)
+{
+  // The logical range is at most two physical runs, one on each side of the
+  // gap.
+  size_type const gap = gap_end - gap_begin;
+  size_type const split = std::max(start, std::min(finish, gap_begin));
+  T * const runs[2][2] = {
+    { storage + start,       storage + split },
+    { storage + split + gap, storage + finish + gap }
+  };
+
+  for(int r = 0; r < 2; ++r){
+    T * first = runs[r][0];
+    T * const last = runs[r][1];
+    if(boost::is_trivially_copyable<T>::value){
+      if(last != first)
+        std::memcpy(static_cast<void *>(dest), first,
+                    (last - first) * sizeof(T));
+      dest += last - first;
+    }else{
+      for(; first != last; ++first, ++dest){
+        ::new(static_cast<void *>(dest)) T(::boost::move(*first));
+        first->~T();
+      }
+    }
+  }
+}
+
+template<class T, class G, class S, std::size_t I>
+void
+contiguous_gap_buffer<T, G, S, I>::
+destroy_range(size_type start, size_type finish)
+{
+  size_type const gap = gap_end - gap_begin;
+  size_type const split = std::max(start, std::min(finish, gap_begin));
+  destroy(storage + start, storage + split);
+  destroy(storage + split + gap, storage + finish + gap);
+}
+
+template<class T, class G, class S, std::size_t I>
+template<class ForwardIterator>
+void
+contiguous_gap_buffer<T, G, S, I>::
+copy_into(ForwardIterator first, size_type n, T * fresh,
+          size_type out, size_type split, size_type gap)
+{
+  size_type const head = (out < split) ? std::min(n, split - out) : 0;
+  ForwardIterator const middle = boost::next(first, head);
+  std::uninitialized_copy(first, middle, fresh + out);
+  try{
+    std::uninitialized_copy(middle, boost::next(middle, n - head),
+                            fresh + out + head + gap);
+  }catch(...){
+    destroy(fresh + out, fresh + out + head);
+    throw;
+  }
+}
+
+template<class T, class G, class S, std::size_t I>
+void
+contiguous_gap_buffer<T, G, S, I>::
+relocate_into(size_type start, size_type finish, T * fresh,
+              size_type out, size_type split, size_type gap)
+{
+  size_type const head =
+    (out < split) ? std::min(finish - start, split - out) : 0;
+  relocate_out(start, start + head, fresh + out);
+  relocate_out(start + head, finish, fresh + out + head + gap);
+}
+
+
+template<class T, class G, class S, std::size_t I>
+void
+contiguous_gap_buffer<T, G, S, I>::
+move_gap(size_type i)
+{
+  if(i == gap_begin)
+    return;
+
+  size_type const gap = gap_end - gap_begin;
+  if(gap != 0){
+    if(i < gap_begin)
+      relocate_backward(storage + i, storage + gap_begin, storage + gap_end);
+    else
+      relocate_forward(storage + gap_end, storage + i + gap,
+                       storage + gap_begin);
+  }
+  gap_begin = i;
+  gap_end = i + gap;
+}
+
+template<class T, class G, class S, std::size_t I>
+void
+contiguous_gap_buffer<T, G, S, I>::
+reallocate(size_type new_capacity, size_type i)
+{
+  size_type const n = size();
+  T * fresh = this->local();
+  if(new_capacity <= I)
+    new_capacity = I;
+  else
+    fresh = allocator_type().allocate(new_capacity);
+
+  // Laying the elements out in the new storage moves the gap for free
+  relocate_out(0, i, fresh);
+  relocate_out(i, n, fresh + new_capacity - (n - i));
+
+  deallocate();
+  storage = fresh;
+  allocated = new_capacity;
+  gap_begin = i;
+  gap_end = new_capacity - (n - i);
+}
+
+template<class T, class G, class S, std::size_t I>
+void
+contiguous_gap_buffer<T, G, S, I>::
+open_gap(size_type i, size_type n)
+{
+  if(gap_end - gap_begin >= n)
+    move_gap(i);
+  else
+    reallocate(std::max<size_type>(G::grow(allocated, size() + n),
+                                   size() + n),
+               i);
+}
+
+template<class T, class G, class S, std::size_t I>
+void
+contiguous_gap_buffer<T, G, S, I>::
+maybe_shrink()
+{
+  if(!storage || is_inline() || !S::should_shrink(size(), allocated))
+    return;
+  // Inline storage costs nothing, so return to it whenever the elements fit
+  if(size() <= I)
+    reallocate(I, gap_begin);
+  else
+    reallocate(std::max<size_type>(S::shrink_to(size()), size()), gap_begin);
+}
+
+template<class T, class G, class S, std::size_t I>
+void
+contiguous_gap_buffer<T, G, S, I>::
+deallocate()
+{
+  if(storage && !is_inline())
+    allocator_type().deallocate(storage, allocated);
+}
+
+template<class T, class G, class S, std::size_t I>
+void
+contiguous_gap_buffer<T, G, S, I>::
+steal(contiguous_gap_buffer & other)
+{
+  if(other.is_inline()){
+    // The elements can't leave other's storage with it, so move them
+    size_type const n = other.size();
+    other.relocate_out(0, n, storage);
+    gap_begin = n;
+  }else{
+    storage = other.storage;
+    allocated = other.allocated;
+    gap_begin = other.gap_begin;
+    gap_end = other.gap_end;
+  }
+  cursor = other.cursor;
+
+  other.storage = other.local();
+  other.allocated = other.gap_end = I;
+  other.gap_begin = other.cursor = 0;
+}
+
+template<class T, class G, class S, std::size_t I>
+void
+contiguous_gap_buffer<T, G, S, I>::
+erase_range(size_type start, size_type finish)
+{
+  if(start == finish)
+    return;
+
+  // Absorb the range into whichever side of the gap is cheapest.  If the gap
+  // already lies within the range, no elements need to move at all.
+  if(gap_begin <= start){
+    move_gap(start);
+    destroy(storage + gap_end, storage + gap_end + (finish - start));
+    gap_end += finish - start;
+  }else if(gap_begin >= finish){
+    move_gap(finish);
+    destroy(storage + start, storage + finish);
+    gap_begin = start;
+  }else{
+    destroy(storage + start, storage + gap_begin);
+    destroy(storage + gap_end, storage + gap_end + (finish - gap_begin));
+    gap_end += finish - gap_begin;
+    gap_begin = start;
+  }
+
+  cursor -= std::min(finish, cursor) - std::min(start, cursor);
+  maybe_shrink();
+}
+
+template<class T, class G, class S, std::size_t I>
+void
+contiguous_gap_buffer<T, G, S, I>::
+insert_fill(size_type i, size_type n, const_reference e)
+{
+  if(n == 0)
+    return;
+  // e might live in this buffer, so take a copy before anything moves
+  value_type const element(e);
+  open_gap(i, n);
+  std::uninitialized_fill_n(storage + gap_begin, n, element);
+  gap_begin += n;
+  if(i <= cursor)
+    cursor += n;
+}
+
+template<class T, class G, class S, std::size_t I>
+void
+contiguous_gap_buffer<T, G, S, I>::
+insert_one(size_type i, value_type & e)
+{
+  open_gap(i, 1);
+  ::new(static_cast<void *>(storage + gap_begin)) T(::boost::move(e));
+  ++gap_begin;
+  if(i <= cursor)
+    ++cursor;
+}
+
+template<class T, class G, class S, std::size_t I>
+template<class TInteger>
+void
+contiguous_gap_buffer<T, G, S, I>::
+insert_dispatch(size_type i, TInteger n, TInteger e, boost::true_type)
+{
+  insert_fill(i, static_cast<size_type>(n), static_cast<value_type>(e));
+}
+
+template<class T, class G, class S, std::size_t I>
+template<class InputIterator>
+void
+contiguous_gap_buffer<T, G, S, I>::
+insert_dispatch(size_type i, InputIterator first, InputIterator last,
+                boost::false_type)
+{
+  insert_range(i, first, last,
+               typename std::iterator_traits<InputIterator>::
+               iterator_category());
+}
+
+template<class T, class G, class S, std::size_t I>
+template<class InputIterator>
+void
+contiguous_gap_buffer<T, G, S, I>::
+insert_range(size_type i, InputIterator first, InputIterator last,
+             std::input_iterator_tag)
+{
+  // We can't know the length ahead of time, so go one at a time
+  for(; first != last; ++first, ++i)
+    insert_fill(i, 1, *first);
+}
+
+template<class T, class G, class S, std::size_t I>
+template<class ForwardIterator>
+void
+contiguous_gap_buffer<T, G, S, I>::
+insert_range(size_type i, ForwardIterator first, ForwardIterator last,
+             std::forward_iterator_tag)
+{
+  size_type const n = std::distance(first, last);
+  if(n == 0)
+    return;
+  open_gap(i, n);
+  std::uninitialized_copy(first, last, storage + gap_begin);
+  gap_begin += n;
+  if(i <= cursor)
+    cursor += n;
+}
+
+
+template<class T, class G, class S, std::size_t I>
+void
+contiguous_gap_buffer<T, G, S, I>::
+apply(edit_batch<value_type> const & batch)
+{
+  size_type const n = size();
+  batch.validate(n);
+  if(batch.empty())
+    return;
+  size_type const fresh_size = n + batch.growth();
+  // Inline storage can't be rebuilt into itself, but a buffer which stays
+  // small enough to fit there costs little to edit one edit at a time
+  if(is_inline() && fresh_size <= I){
+    apply_each(batch);
+    return;
+  }
+
+  size_type capacity = allocated;
+  if(fresh_size <= I)
+    capacity = I;
+  else if(fresh_size > allocated)
+    capacity = std::max<size_type>(G::grow(allocated, fresh_size),
+                                   fresh_size);
+  else if(S::should_shrink(fresh_size, allocated))
+    capacity = std::max<size_type>(S::shrink_to(fresh_size), fresh_size);
+  T * const fresh = (fresh_size <= I) ?
+    this->local() : allocator_type().allocate(capacity);
+  size_type const gap = capacity - fresh_size;
+  size_type const split = batch.map(cursor);
+
+  // Copy the inserted elements in first, since that is all that can throw,
+  // and the old storage is still untouched
+  typedef typename edit_batch<value_type>::edit_list edit_list;
+  edit_list const & edits = batch.edits();
+  typename edit_list::const_iterator e = edits.begin();
+  difference_type shift = 0;
+  try{
+    for(; e != edits.end(); ++e){
+      copy_into(batch.inserted(*e).begin(), e->inserted, fresh,
+                e->position + shift, split, gap);
+      shift += static_cast<difference_type>(e->inserted) -
+        static_cast<difference_type>(e->erased);
+    }
+  }catch(...){
+    shift = 0;
+    for(typename edit_list::const_iterator d = edits.begin(); d != e; ++d){
+      size_type const out = d->position + shift;
+      size_type const head =
+        (out < split) ? std::min(d->inserted, split - out) : 0;
+      destroy(fresh + out, fresh + out + head);
+      destroy(fresh + out + head + gap, fresh + out + d->inserted + gap);
+      shift += static_cast<difference_type>(d->inserted) -
+        static_cast<difference_type>(d->erased);
+    }
+    if(fresh != this->local())
+      allocator_type().deallocate(fresh, capacity);
+    throw;
+  }
+
+  // Then move each of the old elements which survive, once, around them
+  shift = 0;
+  size_type at = 0;
+  for(e = edits.begin(); e != edits.end(); ++e){
+    relocate_into(at, e->position, fresh, at + shift, split, gap);
+    destroy_range(e->position, e->position + e->erased);
+    at = e->position + e->erased;
+    shift += static_cast<difference_type>(e->inserted) -
+      static_cast<difference_type>(e->erased);
+  }
+  relocate_into(at, n, fresh, at + shift, split, gap);
+
+  deallocate();
+  storage = fresh;
+  allocated = capacity;
+  gap_begin = split;
+  gap_end = split + gap;
+  cursor = split;
+}
+
+template<class T, class G, class S, std::size_t I>
+void
+contiguous_gap_buffer<T, G, S, I>::
+apply_each(edit_batch<value_type> const & batch)
+{
+  // Working backwards, the positions of the edits still to be made are not
+  // disturbed by those already made
+  typedef typename edit_batch<value_type>::edit_list edit_list;
+  edit_list const & edits = batch.edits();
+  for(typename edit_list::const_reverse_iterator e = edits.rbegin();
+      e != edits.rend(); ++e){
+    erase_range(e->position, e->position + e->erased);
+    typename edit_batch<value_type>::inserted_range const inserted =
+      batch.inserted(*e);
+    insert_dispatch(e->position, inserted.begin(), inserted.end(),
+                    boost::false_type());
+  }
+}
+
+
+template<class T, class G, class S, std::size_t I>
+template<class TSinglePassRange>
+typename contiguous_gap_buffer<T, G, S, I>::size_type
+contiguous_gap_buffer<T, G, S, I>::
+insert(TSinglePassRange const & rng)
+{
+  insert_dispatch(cursor, boost::begin(rng), boost::end(rng),
+                  boost::false_type());
+  return position();
+}
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::size_type
+contiguous_gap_buffer<T, G, S, I>::
+insert(value_type const & element)
+{
+  // element might live in this buffer, so take a copy before anything moves
+  value_type copy(element);
+  insert_one(cursor, copy);
+  return cursor;
+}
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::size_type
+contiguous_gap_buffer<T, G, S, I>::
+insert(BOOST_RV_REF(value_type) element)
+{
+  insert_one(cursor, element);
+  return cursor;
+}
+
+
+#if !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES) && \
+    !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+template<class T, class G, class S, std::size_t I>
+template<class... Args>
+typename contiguous_gap_buffer<T, G, S, I>::size_type
+contiguous_gap_buffer<T, G, S, I>::emplace(Args &&... args)
+{
+  value_type element(::boost::forward<Args>(args)...);
+  return insert(::boost::move(element));
+}
+
+template<class T, class G, class S, std::size_t I>
+template<class... Args>
+typename contiguous_gap_buffer<T, G, S, I>::iterator
+contiguous_gap_buffer<T, G, S, I>::emplace(iterator position,
+                                           Args &&... args)
+{
+  value_type element(::boost::forward<Args>(args)...);
+  return insert(position, ::boost::move(element));
+}
+#else
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::size_type
+contiguous_gap_buffer<T, G, S, I>::emplace()
+{
+  value_type element = value_type();
+  return insert(::boost::move(element));
+}
+
+template<class T, class G, class S, std::size_t I>
+template<class A1>
+typename contiguous_gap_buffer<T, G, S, I>::size_type
+contiguous_gap_buffer<T, G, S, I>::emplace(BOOST_FWD_REF(A1) a1)
+{
+  value_type element(::boost::forward<A1>(a1));
+  return insert(::boost::move(element));
+}
+
+template<class T, class G, class S, std::size_t I>
+template<class A1, class A2>
+typename contiguous_gap_buffer<T, G, S, I>::size_type
+contiguous_gap_buffer<T, G, S, I>::emplace(BOOST_FWD_REF(A1) a1,
+                                           BOOST_FWD_REF(A2) a2)
+{
+  value_type element(::boost::forward<A1>(a1), ::boost::forward<A2>(a2));
+  return insert(::boost::move(element));
+}
+
+template<class T, class G, class S, std::size_t I>
+template<class A1, class A2, class A3>
+typename contiguous_gap_buffer<T, G, S, I>::size_type
+contiguous_gap_buffer<T, G, S, I>::emplace(BOOST_FWD_REF(A1) a1,
+                                           BOOST_FWD_REF(A2) a2,
+                                           BOOST_FWD_REF(A3) a3)
+{
+  value_type element(::boost::forward<A1>(a1), ::boost::forward<A2>(a2),
+                     ::boost::forward<A3>(a3));
+  return insert(::boost::move(element));
+}
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::iterator
+contiguous_gap_buffer<T, G, S, I>::emplace(iterator position)
+{
+  value_type element = value_type();
+  return insert(position, ::boost::move(element));
+}
+
+template<class T, class G, class S, std::size_t I>
+template<class A1>
+typename contiguous_gap_buffer<T, G, S, I>::iterator
+contiguous_gap_buffer<T, G, S, I>::emplace(iterator position,
+                                           BOOST_FWD_REF(A1) a1)
+{
+  value_type element(::boost::forward<A1>(a1));
+  return insert(position, ::boost::move(element));
+}
+
+template<class T, class G, class S, std::size_t I>
+template<class A1, class A2>
+typename contiguous_gap_buffer<T, G, S, I>::iterator
+contiguous_gap_buffer<T, G, S, I>::emplace(iterator position,
+                                           BOOST_FWD_REF(A1) a1,
+                                           BOOST_FWD_REF(A2) a2)
+{
+  value_type element(::boost::forward<A1>(a1), ::boost::forward<A2>(a2));
+  return insert(position, ::boost::move(element));
+}
+
+template<class T, class G, class S, std::size_t I>
+template<class A1, class A2, class A3>
+typename contiguous_gap_buffer<T, G, S, I>::iterator
+contiguous_gap_buffer<T, G, S, I>::emplace(iterator position,
+                                           BOOST_FWD_REF(A1) a1,
+                                           BOOST_FWD_REF(A2) a2,
+                                           BOOST_FWD_REF(A3) a3)
+{
+  value_type element(::boost::forward<A1>(a1), ::boost::forward<A2>(a2),
+                     ::boost::forward<A3>(a3));
+  return insert(position, ::boost::move(element));
+}
+#endif
+
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::size_type
+contiguous_gap_buffer<T, G, S, I>::
+position() const
+{
+  return cursor;
+}
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::size_type
+contiguous_gap_buffer<T, G, S, I>::
+size() const
+{
+  return allocated - (gap_end - gap_begin);
+}
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::size_type
+contiguous_gap_buffer<T, G, S, I>::
+max_size() const
+{
+  return allocator_type().max_size();
+}
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::size_type
+contiguous_gap_buffer<T, G, S, I>::
+capacity() const
+{
+  return allocated;
+}
+
+template<class T, class G, class S, std::size_t I>
+bool
+contiguous_gap_buffer<T, G, S, I>::
+is_inline() const
+{
+  return I != 0 && storage == this->local();
+}
+
+template<class T, class G, class S, std::size_t I>
+bool
+contiguous_gap_buffer<T, G, S, I>::
+empty() const
+{
+  return size() == 0;
+}
+
+template<class T, class G, class S, std::size_t I>
+void
+contiguous_gap_buffer<T, G, S, I>::
+swap(contiguous_gap_buffer & other)
+{
+  if(is_inline() || other.is_inline()){
+    contiguous_gap_buffer temp( ::boost::move(other) );
+    other.steal(*this);
+    steal(temp);
+    return;
+  }
+  std::swap(storage,   other.storage);
+  std::swap(allocated, other.allocated);
+  std::swap(gap_begin, other.gap_begin);
+  std::swap(gap_end,   other.gap_end);
+  std::swap(cursor,    other.cursor);
+}
+
+
+template<class T, class G, class S, std::size_t I>
+void
+contiguous_gap_buffer<T, G, S, I>::
+advance(difference_type const d)
+{
+  cursor += d;
+}
+
+
+template<class T, class G, class S, std::size_t I>
+void
+contiguous_gap_buffer<T, G, S, I>::
+erase(difference_type const d)
+{
+  if(d < 0)
+    erase_range(cursor + d, cursor);
+  else
+    erase_range(cursor, cursor + d);
+}
+
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::iterator
+contiguous_gap_buffer<T, G, S, I>::
+here()
+{
+  return iterator(this, cursor);
+}
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::const_iterator
+contiguous_gap_buffer<T, G, S, I>::
+here() const
+{
+  return const_iterator(this, cursor);
+}
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::reverse_iterator
+contiguous_gap_buffer<T, G, S, I>::
+rhere()
+{
+  return reverse_iterator(here());
+}
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::const_reverse_iterator
+contiguous_gap_buffer<T, G, S, I>::
+rhere() const
+{
+  return const_reverse_iterator(here());
+}
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::iterator
+contiguous_gap_buffer<T, G, S, I>::
+begin()
+{
+  return iterator(this, 0);
+}
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::const_iterator
+contiguous_gap_buffer<T, G, S, I>::
+begin() const
+{
+  return const_iterator(this, 0);
+}
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::iterator
+contiguous_gap_buffer<T, G, S, I>::
+end()
+{
+  return iterator(this, size());
+}
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::const_iterator
+contiguous_gap_buffer<T, G, S, I>::
+end() const
+{
+  return const_iterator(this, size());
+}
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::const_segment_list
+contiguous_gap_buffer<T, G, S, I>::
+segments() const
+{
+  const_segment_list const rtn = {{
+      boost::make_iterator_range<T const *>(storage, storage + gap_begin),
+      boost::make_iterator_range<T const *>(storage + gap_end,
+                                            storage + allocated)
+    }};
+  return rtn;
+}
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::reverse_iterator
+contiguous_gap_buffer<T, G, S, I>::
+rbegin()
+{
+  return reverse_iterator(end());
+}
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::const_reverse_iterator
+contiguous_gap_buffer<T, G, S, I>::
+rbegin() const
+{
+  return const_reverse_iterator(end());
+}
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::reverse_iterator
+contiguous_gap_buffer<T, G, S, I>::
+rend()
+{
+  return reverse_iterator(begin());
+}
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::const_reverse_iterator
+contiguous_gap_buffer<T, G, S, I>::
+rend() const
+{
+  return const_reverse_iterator(begin());
+}
+
+
+template<class T, class G, class S, std::size_t I>
+contiguous_gap_buffer<T, G, S, I>::contiguous_gap_buffer()
+  : storage(this->local())
+  , allocated(I)
+  , gap_begin(0)
+  , gap_end(I)
+  , cursor(0)
+{}
+
+template<class T, class G, class S, std::size_t I>
+contiguous_gap_buffer<T, G, S, I>::
+contiguous_gap_buffer(contiguous_gap_buffer const & other)
+  : storage(this->local())
+  , allocated(I)
+  , gap_begin(0)
+  , gap_end(I)
+  , cursor(other.cursor)
+{
+  size_type const n = other.size();
+  if(n == 0)
+    return;
+
+  // Copies are laid out with the gap at the end, which is empty unless the
+  // elements fit inline; the first edit will open one
+  if(n > I){
+    storage = allocator_type().allocate(n);
+    allocated = gap_end = n;
+  }
+  T * const middle = std::uninitialized_copy(other.storage,
+                                             other.storage + other.gap_begin,
+                                             storage);
+  try{
+    std::uninitialized_copy(other.storage + other.gap_end,
+                            other.storage + other.allocated,
+                            middle);
+  }catch(...){
+    destroy(storage, middle);
+    deallocate();
+    throw;
+  }
+  gap_begin = n;
+}
+
+template<class T, class G, class S, std::size_t I>
+contiguous_gap_buffer<T, G, S, I>::
+contiguous_gap_buffer(BOOST_RV_REF(contiguous_gap_buffer) other)
+  : storage(this->local())
+  , allocated(I)
+  , gap_begin(0)
+  , gap_end(I)
+  , cursor(0)
+{
+  steal(other);
+}
+
+template<class T, class G, class S, std::size_t I>
+contiguous_gap_buffer<T, G, S, I>::
+contiguous_gap_buffer(size_type n, value_type e)
+  : storage(this->local())
+  , allocated(I)
+  , gap_begin(0)
+  , gap_end(I)
+  , cursor(0)
+{
+  insert_fill(0, n, e);
+}
+
+template<class T, class G, class S, std::size_t I>
+template<class InputIterator>
+contiguous_gap_buffer<T, G, S, I>::
+contiguous_gap_buffer(InputIterator const & i, InputIterator const & j)
+  : storage(this->local())
+  , allocated(I)
+  , gap_begin(0)
+  , gap_end(I)
+  , cursor(0)
+{
+  insert_dispatch(0, i, j, typename boost::is_integral<InputIterator>::type());
+}
+
+template<class T, class G, class S, std::size_t I>
+contiguous_gap_buffer<T, G, S, I>::~contiguous_gap_buffer()
+{
+  destroy(storage, storage + gap_begin);
+  destroy(storage + gap_end, storage + allocated);
+  deallocate();
+}
+
+template<class T, class G, class S, std::size_t I>
+contiguous_gap_buffer<T, G, S, I> &
+contiguous_gap_buffer<T, G, S, I>::
+operator=(BOOST_COPY_ASSIGN_REF(contiguous_gap_buffer) other)
+{
+  if(&other != this){
+    contiguous_gap_buffer copy(static_cast<contiguous_gap_buffer const &>(other));
+    swap(copy);
+  }
+  return *this;
+}
+
+template<class T, class G, class S, std::size_t I>
+contiguous_gap_buffer<T, G, S, I> &
+contiguous_gap_buffer<T, G, S, I>::
+operator=(BOOST_RV_REF(contiguous_gap_buffer) other)
+{
+  contiguous_gap_buffer moved( ::boost::move(other) );
+  swap(moved);
+  return *this;
+}
+
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::reference
+contiguous_gap_buffer<T, G, S, I>::front()
+{
+  return *element(0);
+}
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::const_reference
+contiguous_gap_buffer<T, G, S, I>::front() const
+{
+  return *element(0);
+}
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::iterator
+contiguous_gap_buffer<T, G, S, I>::insert(iterator position,
+                                          const_reference element)
+{
+  // element might live in this buffer, so take a copy before anything moves
+  value_type copy(element);
+  insert_one(position.idx, copy);
+  return position;
+}
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::iterator
+contiguous_gap_buffer<T, G, S, I>::insert(iterator position,
+                                          BOOST_RV_REF(value_type) element)
+{
+  insert_one(position.idx, element);
+  return position;
+}
+
+template<class T, class G, class S, std::size_t I>
+void
+contiguous_gap_buffer<T, G, S, I>::insert(iterator position, size_type n,
+                                          const_reference element)
+{
+  insert_fill(position.idx, n, element);
+}
+
+template<class T, class G, class S, std::size_t I>
+template<class InputIterator>
+void
+contiguous_gap_buffer<T, G, S, I>::insert(iterator position,
+                                          InputIterator const & i,
+                                          InputIterator const & j)
+{
+  insert_dispatch(position.idx, i, j,
+                  typename boost::is_integral<InputIterator>::type());
+}
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::iterator
+contiguous_gap_buffer<T, G, S, I>::erase(iterator position)
+{
+  erase_range(position.idx, position.idx + 1);
+  return position;
+}
+
+template<class T, class G, class S, std::size_t I>
+typename contiguous_gap_buffer<T, G, S, I>::iterator
+contiguous_gap_buffer<T, G, S, I>::erase(iterator start, iterator end)
+{
+  erase_range(start.idx, end.idx);
+  return start;
+}
+
+template<class T, class G, class S, std::size_t I>
+void
+contiguous_gap_buffer<T, G, S, I>::clear()
+{
+  erase_range(0, size());
+  cursor = 0;
+}
+
+template<class T, class G, class S, std::size_t I>
+void
+contiguous_gap_buffer<T, G, S, I>::resize(size_type n, value_type const & e)
+{
+  if(n < size())
+    erase_range(n, size());
+  else
+    insert_fill(size(), n - size(), e);
+}
+
+#define BINARY_CONTIGUOUS_BOOL_OPER(oper)                                   \
+  template<class T, class G, class S, std::size_t I>                        \
+  bool operator oper ( contiguous_gap_buffer<T, G, S, I> const & lhs,       \
+                       contiguous_gap_buffer<T, G, S, I> const & rhs)
+
+BINARY_CONTIGUOUS_BOOL_OPER( == )
+{
+  return segmented::equal(lhs, rhs);
+}
+
+BINARY_CONTIGUOUS_BOOL_OPER( < )
+{
+  return segmented::lexicographical_compare(lhs, rhs);
+}
+
+BINARY_CONTIGUOUS_BOOL_OPER( != ) { return !(lhs == rhs); }
+BINARY_CONTIGUOUS_BOOL_OPER( > )  { return  (rhs <  lhs); }
+BINARY_CONTIGUOUS_BOOL_OPER( <= ) { return !(rhs <  lhs); }
+BINARY_CONTIGUOUS_BOOL_OPER( >= ) { return !(lhs <  rhs); }
+
+
+#undef BINARY_CONTIGUOUS_BOOL_OPER
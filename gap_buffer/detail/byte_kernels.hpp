@@ -0,0 +1,307 @@
+#ifndef SEGMENTED_BYTE_KERNELS_HPP_INCLUDED_
+#define SEGMENTED_BYTE_KERNELS_HPP_INCLUDED_
+
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include <cstddef>
+#include <cstring>
+
+// The vector kernels are compiled for their instruction sets function by
+// function, so that the rest of the program need not be, and are only called
+// once the processor has been checked for them.  Define
+// SEGMENTED_NO_VECTOR_KERNELS to use only the portable ones.
+#if !defined(SEGMENTED_NO_VECTOR_KERNELS) &&                  \
+  (defined(__GNUC__) || defined(__clang__)) &&                \
+  (defined(__x86_64__) || defined(__i386__))
+#  define SEGMENTED_X86_KERNELS 1
+#  include <immintrin.h>
+#  define SEGMENTED_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+
+namespace segmented
+{
+namespace detail
+{
+  typedef unsigned char byte;
+
+  // ----- Portable kernels -----
+
+  // The offset of the first a in [p, p + n), or n if there is none
+  inline std::size_t find_byte_scalar(byte const * p, std::size_t n, byte a)
+  {
+    void const * const found = std::memchr(p, a, n);
+    return found ? static_cast<byte const *>(found) - p : n;
+  }
+
+  // The offset of the first a or b in [p, p + n), or n if there is none
+  inline std::size_t find_either_byte_scalar(byte const * p, std::size_t n,
+                                             byte a, byte b)
+  {
+    for(std::size_t i = 0; i < n; ++i)
+      if(p[i] == a || p[i] == b)
+        return i;
+    return n;
+  }
+
+  // The number of times a appears in [p, p + n)
+  inline std::size_t count_byte_scalar(byte const * p, std::size_t n, byte a)
+  {
+    std::size_t total = 0;
+    for(std::size_t i = 0; i < n; ++i)
+      total += (p[i] == a);
+    return total;
+  }
+
+  // The number of bytes at the start of [p, p + n) which are ASCII
+  inline std::size_t ascii_prefix_scalar(byte const * p, std::size_t n)
+  {
+    std::size_t i = 0;
+    while(i < n && p[i] < 0x80)
+      ++i;
+    return i;
+  }
+
+#ifdef SEGMENTED_X86_KERNELS
+  // ----- SSE2 kernels, 16 bytes at a time -----
+
+  SEGMENTED_TARGET("sse2")
+  inline std::size_t find_byte_sse2(byte const * p, std::size_t n, byte a)
+  {
+    __m128i const wanted = _mm_set1_epi8(static_cast<char>(a));
+    std::size_t i = 0;
+    for(; i + 16 <= n; i += 16){
+      __m128i const v =
+        _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + i));
+      int const mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, wanted));
+      if(mask)
+        return i + __builtin_ctz(mask);
+    }
+    return i + find_byte_scalar(p + i, n - i, a);
+  }
+
+  SEGMENTED_TARGET("sse2")
+  inline std::size_t find_either_byte_sse2(byte const * p, std::size_t n,
+                                           byte a, byte b)
+  {
+    __m128i const wanted_a = _mm_set1_epi8(static_cast<char>(a));
+    __m128i const wanted_b = _mm_set1_epi8(static_cast<char>(b));
+    std::size_t i = 0;
+    for(; i + 16 <= n; i += 16){
+      __m128i const v =
+        _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + i));
+      int const mask = _mm_movemask_epi8(
+        _mm_or_si128(_mm_cmpeq_epi8(v, wanted_a), _mm_cmpeq_epi8(v, wanted_b)));
+      if(mask)
+        return i + __builtin_ctz(mask);
+    }
+    return i + find_either_byte_scalar(p + i, n - i, a, b);
+  }
+
+  SEGMENTED_TARGET("sse2")
+  inline std::size_t count_byte_sse2(byte const * p, std::size_t n, byte a)
+  {
+    __m128i const wanted = _mm_set1_epi8(static_cast<char>(a));
+    std::size_t total = 0;
+    std::size_t i = 0;
+    for(; i + 16 <= n; i += 16){
+      __m128i const v =
+        _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + i));
+      total += __builtin_popcount(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(v, wanted)));
+    }
+    return total + count_byte_scalar(p + i, n - i, a);
+  }
+
+  SEGMENTED_TARGET("sse2")
+  inline std::size_t ascii_prefix_sse2(byte const * p, std::size_t n)
+  {
+    std::size_t i = 0;
+    for(; i + 16 <= n; i += 16){
+      __m128i const v =
+        _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + i));
+      // The sign bits are exactly the non-ASCII bytes
+      int const mask = _mm_movemask_epi8(v);
+      if(mask)
+        return i + __builtin_ctz(mask);
+    }
+    return i + ascii_prefix_scalar(p + i, n - i);
+  }
+
+  // ----- AVX2 kernels, 32 bytes at a time -----
+
+  SEGMENTED_TARGET("avx2")
+  inline std::size_t find_byte_avx2(byte const * p, std::size_t n, byte a)
+  {
+    __m256i const wanted = _mm256_set1_epi8(static_cast<char>(a));
+    std::size_t i = 0;
+    for(; i + 32 <= n; i += 32){
+      __m256i const v =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + i));
+      unsigned const mask =
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, wanted));
+      if(mask)
+        return i + __builtin_ctz(mask);
+    }
+    return i + find_byte_sse2(p + i, n - i, a);
+  }
+
+  SEGMENTED_TARGET("avx2")
+  inline std::size_t find_either_byte_avx2(byte const * p, std::size_t n,
+                                           byte a, byte b)
+  {
+    __m256i const wanted_a = _mm256_set1_epi8(static_cast<char>(a));
+    __m256i const wanted_b = _mm256_set1_epi8(static_cast<char>(b));
+    std::size_t i = 0;
+    for(; i + 32 <= n; i += 32){
+      __m256i const v =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + i));
+      unsigned const mask = _mm256_movemask_epi8(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, wanted_a),
+                        _mm256_cmpeq_epi8(v, wanted_b)));
+      if(mask)
+        return i + __builtin_ctz(mask);
+    }
+    return i + find_either_byte_sse2(p + i, n - i, a, b);
+  }
+
+  SEGMENTED_TARGET("avx2")
+  inline std::size_t count_byte_avx2(byte const * p, std::size_t n, byte a)
+  {
+    __m256i const wanted = _mm256_set1_epi8(static_cast<char>(a));
+    std::size_t total = 0;
+    std::size_t i = 0;
+    for(; i + 32 <= n; i += 32){
+      __m256i const v =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + i));
+      total += __builtin_popcount(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, wanted)));
+    }
+    return total + count_byte_sse2(p + i, n - i, a);
+  }
+
+  SEGMENTED_TARGET("avx2")
+  inline std::size_t ascii_prefix_avx2(byte const * p, std::size_t n)
+  {
+    std::size_t i = 0;
+    for(; i + 32 <= n; i += 32){
+      __m256i const v =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + i));
+      unsigned const mask = _mm256_movemask_epi8(v);
+      if(mask)
+        return i + __builtin_ctz(mask);
+    }
+    return i + ascii_prefix_sse2(p + i, n - i);
+  }
+#endif
+
+  // ----- Dispatch -----
+
+  // The instruction sets the kernels may use, best last
+  enum kernel_isa { isa_scalar, isa_sse2, isa_avx2 };
+
+  // The best instruction set this processor supports, looked up once
+  inline kernel_isa detect_kernel_isa()
+  {
+#ifdef SEGMENTED_X86_KERNELS
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+      return isa_avx2;
+    if(__builtin_cpu_supports("sse2"))
+      return isa_sse2;
+#endif
+    return isa_scalar;
+  }
+
+  inline kernel_isa best_kernel_isa()
+  {
+    static kernel_isa const isa = detect_kernel_isa();
+    return isa;
+  }
+
+  inline std::size_t find_byte(byte const * p, std::size_t n, byte a)
+  {
+#ifdef SEGMENTED_X86_KERNELS
+    switch(best_kernel_isa()){
+    case isa_avx2: return find_byte_avx2(p, n, a);
+    case isa_sse2: return find_byte_sse2(p, n, a);
+    default:       break;
+    }
+#endif
+    return find_byte_scalar(p, n, a);
+  }
+
+  inline std::size_t find_either_byte(byte const * p, std::size_t n,
+                                      byte a, byte b)
+  {
+#ifdef SEGMENTED_X86_KERNELS
+    switch(best_kernel_isa()){
+    case isa_avx2: return find_either_byte_avx2(p, n, a, b);
+    case isa_sse2: return find_either_byte_sse2(p, n, a, b);
+    default:       break;
+    }
+#endif
+    return find_either_byte_scalar(p, n, a, b);
+  }
+
+  inline std::size_t count_byte(byte const * p, std::size_t n, byte a)
+  {
+#ifdef SEGMENTED_X86_KERNELS
+    switch(best_kernel_isa()){
+    case isa_avx2: return count_byte_avx2(p, n, a);
+    case isa_sse2: return count_byte_sse2(p, n, a);
+    default:       break;
+    }
+#endif
+    return count_byte_scalar(p, n, a);
+  }
+
+  inline std::size_t ascii_prefix(byte const * p, std::size_t n)
+  {
+#ifdef SEGMENTED_X86_KERNELS
+    switch(best_kernel_isa()){
+    case isa_avx2: return ascii_prefix_avx2(p, n);
+    case isa_sse2: return ascii_prefix_sse2(p, n);
+    default:       break;
+    }
+#endif
+    return ascii_prefix_scalar(p, n);
+  }
+}
+}
+
+
+#undef SEGMENTED_TARGET
+#endif
@@ -0,0 +1,127 @@
+#ifndef SEGMENTED_BYTE_RUNS_HPP_INCLUDED_
+#define SEGMENTED_BYTE_RUNS_HPP_INCLUDED_
+
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include <boost/type_traits/integral_constant.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/type_traits/remove_cv.hpp>
+#include <boost/utility/enable_if.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <utility>
+
+
+namespace segmented
+{
+namespace detail
+{
+  // If T is one of the character types, which the byte kernels can search
+  template<class T>
+  struct is_byte
+    : boost::integral_constant<
+        bool,
+        boost::is_integral<typename boost::remove_cv<T>::type>::value &&
+        !boost::is_same<typename boost::remove_cv<T>::type, bool>::value &&
+        sizeof(T) == 1>
+  {};
+
+  // A contiguous block of bytes, and its length
+  typedef std::pair<unsigned char const *, std::size_t> byte_block;
+
+  /**
+     @brief Whether the elements of a range of Iterator are bytes which lie in
+     contiguous blocks of memory, and how to find those blocks.
+     @details Specializations derive from boost::true_type and provide
+     block(first, last), which returns the longest contiguous block of memory
+     at the start of [first, last).  Anything else is searched one element at a
+     time.
+  */
+  template<class Iterator, class Enable = void>
+  struct byte_runs
+    : boost::false_type
+  {};
+
+  // Pointers are a single block
+  template<class T>
+  struct byte_runs<T *, typename boost::enable_if<is_byte<T> >::type>
+    : boost::true_type
+  {
+    static byte_block block(T * first, T * last)
+    {
+      return byte_block(reinterpret_cast<unsigned char const *>(first),
+                        last - first);
+    }
+  };
+
+#if defined(__GLIBCXX__)
+  // The iterators of std::vector and std::basic_string are wrapped pointers
+  template<class T, class TContainer>
+  struct byte_runs<__gnu_cxx::__normal_iterator<T *, TContainer>,
+                   typename boost::enable_if<is_byte<T> >::type>
+    : boost::true_type
+  {
+    static byte_block block(__gnu_cxx::__normal_iterator<T *, TContainer> first,
+                            __gnu_cxx::__normal_iterator<T *, TContainer> last)
+    {
+      return byte_runs<T *>::block(first.base(), last.base());
+    }
+  };
+
+  // A std::deque keeps its elements in fixed-size blocks, and its iterators
+  // know where the current one ends
+  template<class T, class TRef, class TPtr>
+  struct byte_runs<std::_Deque_iterator<T, TRef, TPtr>,
+                   typename boost::enable_if<is_byte<T> >::type>
+    : boost::true_type
+  {
+    static byte_block block(std::_Deque_iterator<T, TRef, TPtr> first,
+                            std::_Deque_iterator<T, TRef, TPtr> last)
+    {
+      std::ptrdiff_t const in_block = first._M_last - first._M_cur;
+      std::ptrdiff_t const in_range = last - first;
+      return byte_block(reinterpret_cast<unsigned char const *>(first._M_cur),
+                        in_range < in_block ? in_range : in_block);
+    }
+  };
+#endif
+}
+}
+
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef INDEX_DETAIL_FENWICK_HPP_INCLUDED_
+#define INDEX_DETAIL_FENWICK_HPP_INCLUDED_
+
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include <cstddef>
+#include <vector>
+
+
+// Fenwick trees, which the observer indexes use to total their chunks.  The
+// trees are one-based: sums[i] totals the (i & -i) entries ending at i.
+namespace index_detail
+{
+  // Add delta to entry k
+  template<class TSize>
+  void fenwick_add(std::vector<TSize> & sums, std::size_t k, TSize delta)
+  {
+    for(++k; k < sums.size(); k += k & (0 - k))
+      sums[k] += delta;
+  }
+
+  // Return the total of the entries before k
+  template<class TSize>
+  TSize fenwick_prefix(std::vector<TSize> const & sums, std::size_t k)
+  {
+    TSize total = 0;
+    for(; k > 0; k -= k & (0 - k))
+      total += sums[k];
+    return total;
+  }
+
+  // Return the last entry k whose prefix is at most value, and set before to
+  // that prefix.  When value is less than the total, entry k is the one
+  // which takes the running total past value.
+  template<class TSize>
+  std::size_t fenwick_search(std::vector<TSize> const & sums, TSize value,
+                             TSize & before)
+  {
+    std::size_t const n = sums.size() - 1;
+    std::size_t step = 1;
+    while(step * 2 <= n)
+      step *= 2;
+    std::size_t k = 0;
+    before = 0;
+    for(; step > 0; step /= 2)
+      if(k + step <= n && before + sums[k + step] <= value){
+        k += step;
+        before += sums[k];
+      }
+    return k;
+  }
+}
+
+
+#endif
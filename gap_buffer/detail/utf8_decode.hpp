@@ -0,0 +1,265 @@
+#ifndef UTF8_DETAIL_DECODE_HPP_INCLUDED_
+#define UTF8_DETAIL_DECODE_HPP_INCLUDED_
+
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include "byte_kernels.hpp"
+
+#include <cstddef>
+#include <iterator>
+
+
+namespace utf8
+{
+namespace detail
+{
+  typedef unsigned char byte;
+
+  // Code points, and the number of bytes and UTF-16 code units they take
+  struct text_position
+  {
+    std::size_t bytes;
+    std::size_t points;
+    std::size_t units;
+    // How many of the code points were ill-formed sequences, each of which
+    // stands for one U+FFFD
+    std::size_t errors;
+  };
+
+  inline bool is_continuation(byte b)
+  {
+    return (b & 0xC0) == 0x80;
+  }
+
+  // Return the length of the sequence at the start of [p, p + available),
+  // and set valid if it is well-formed.  An ill-formed sequence is as long as
+  // its maximal subpart, following Unicode's recommended practice, so is
+  // always at least one byte.
+  inline std::size_t sequence_length(byte const * p, std::size_t available,
+                                     bool & valid)
+  {
+    byte const lead = p[0];
+    valid = false;
+    if(lead < 0x80){
+      valid = true;
+      return 1;
+    }
+    // The number of continuation bytes, and the range the first must lie in
+    std::size_t need;
+    byte low = 0x80;
+    byte high = 0xBF;
+    if(lead < 0xC2)
+      return 1;
+    else if(lead < 0xE0)
+      need = 1;
+    else if(lead < 0xF0){
+      need = 2;
+      if(lead == 0xE0)
+        low = 0xA0;
+      else if(lead == 0xED)
+        high = 0x9F;
+    }else if(lead < 0xF5){
+      need = 3;
+      if(lead == 0xF0)
+        low = 0x90;
+      else if(lead == 0xF4)
+        high = 0x8F;
+    }else
+      return 1;
+
+    std::size_t length = 1;
+    for(; length <= need; ++length){
+      if(length >= available || p[length] < low || p[length] > high)
+        return length;
+      low = 0x80;
+      high = 0xBF;
+    }
+    valid = true;
+    return length;
+  }
+
+  // Return the code point of the well-formed sequence [p, p + length)
+  inline unsigned long decode(byte const * p, std::size_t length)
+  {
+    switch(length){
+    case 1:  return p[0];
+    case 2:  return (p[0] & 0x1FUL) << 6 | (p[1] & 0x3F);
+    case 3:  return (p[0] & 0x0FUL) << 12 | (p[1] & 0x3FUL) << 6 |
+        (p[2] & 0x3F);
+    default: return (p[0] & 0x07UL) << 18 | (p[1] & 0x3FUL) << 12 |
+        (p[2] & 0x3FUL) << 6 | (p[3] & 0x3F);
+    }
+  }
+
+  /**
+     @brief Walk the sequences which begin in [p, p + n), reading at most up to
+     p + available, and return how much was walked.
+     @details The walk stops before the first sequence which would take it
+     past any of the limits.  Unless whole, that includes a sequence which
+     ends after limit.bytes, so that the walk never stops part way through
+     one; otherwise only a sequence beginning at or after limit.bytes stops
+     it, and the last one may overhang n.  Runs of ASCII are counted with the
+     vector kernels.
+  */
+  inline text_position walk(byte const * p, std::size_t n,
+                            std::size_t available, text_position const & limit,
+                            bool whole)
+  {
+    text_position at = { 0, 0, 0, 0 };
+    std::size_t const stop = n < limit.bytes ? n : limit.bytes;
+    while(at.bytes < stop && at.points < limit.points &&
+          at.units < limit.units){
+      std::size_t run =
+        segmented::detail::ascii_prefix(p + at.bytes, stop - at.bytes);
+      if(run > limit.points - at.points)
+        run = limit.points - at.points;
+      if(run > limit.units - at.units)
+        run = limit.units - at.units;
+      at.bytes += run;
+      at.points += run;
+      at.units += run;
+      if(run > 0)
+        continue;
+
+      bool valid;
+      std::size_t const length =
+        sequence_length(p + at.bytes, available - at.bytes, valid);
+      // Ill-formed sequences become U+FFFD, which is one code unit
+      std::size_t const units = (valid && length == 4) ? 2 : 1;
+      if(!whole && at.bytes + length > limit.bytes)
+        break;
+      if(at.units + units > limit.units)
+        break;
+      at.bytes += length;
+      ++at.points;
+      at.units += units;
+      at.errors += !valid;
+    }
+    return at;
+  }
+
+  // Decode the code point at i, which must not be end, step i past it, and
+  // set length to its number of bytes.  Ill-formed sequences decode to
+  // U+FFFD.
+  template<class Iterator>
+  unsigned long next_code_point(Iterator & i, Iterator const & end,
+                                std::size_t & length)
+  {
+    byte bytes[4];
+    std::size_t available = 0;
+    Iterator ahead = i;
+    for(; available < 4 && ahead != end; ++available, ++ahead)
+      bytes[available] = static_cast<byte>(*ahead);
+    bool valid;
+    length = sequence_length(bytes, available, valid);
+    std::advance(i, length);
+    return valid ? decode(bytes, length) : 0xFFFD;
+  }
+
+  // Step i back to the start of the code point before it, which must not be
+  // at begin, set length to its number of bytes, and return it
+  template<class Iterator>
+  unsigned long prior_code_point(Iterator & i, Iterator const & begin,
+                                 std::size_t & length)
+  {
+    Iterator start = i;
+    --start;
+    for(int back = 1; back < 4 && start != begin &&
+          is_continuation(static_cast<byte>(*start)); ++back)
+      --start;
+    Iterator ahead = start;
+    unsigned long const c = next_code_point(ahead, i, length);
+    if(ahead == i){
+      i = start;
+      return c;
+    }
+    // The bytes before i do not make one sequence ending at i, so the last of
+    // them is an ill-formed sequence of its own
+    --i;
+    length = 1;
+    return 0xFFFD;
+  }
+
+  // An approximation of the Grapheme_Cluster_Break property: combining
+  // marks, variation selectors, joiners, emoji modifiers and tags extend the
+  // cluster before them
+  inline bool is_extend(unsigned long c)
+  {
+    return (c >= 0x0300 && c <= 0x036F) || (c >= 0x0483 && c <= 0x0489) ||
+      (c >= 0x0591 && c <= 0x05BD) || (c >= 0x0610 && c <= 0x061A) ||
+      (c >= 0x064B && c <= 0x065F) || (c >= 0x0900 && c <= 0x0903) ||
+      (c >= 0x093A && c <= 0x094F) || (c >= 0x1AB0 && c <= 0x1AFF) ||
+      (c >= 0x1DC0 && c <= 0x1DFF) || c == 0x200C || c == 0x200D ||
+      (c >= 0x20D0 && c <= 0x20FF) || (c >= 0xFE00 && c <= 0xFE0F) ||
+      (c >= 0xFE20 && c <= 0xFE2F) || (c >= 0x1F3FB && c <= 0x1F3FF) ||
+      (c >= 0xE0020 && c <= 0xE007F) || (c >= 0xE0100 && c <= 0xE01EF);
+  }
+
+  inline bool is_control(unsigned long c)
+  {
+    return c < 0x20 || (c >= 0x7F && c <= 0x9F) || c == 0x2028 ||
+      c == 0x2029;
+  }
+
+  inline bool is_regional_indicator(unsigned long c)
+  {
+    return c >= 0x1F1E6 && c <= 0x1F1FF;
+  }
+
+  // Return if there is no grapheme cluster boundary between before and
+  // after.  prior_indicators is the number of regional indicators in a row
+  // which end with before.
+  inline bool joined(unsigned long before, unsigned long after,
+                     std::size_t prior_indicators)
+  {
+    if(before == '\r' && after == '\n')
+      return true;
+    if(is_control(before) || is_control(after))
+      return false;
+    if(is_extend(after))
+      return true;
+    // Anything after a zero width joiner continues the cluster, which is
+    // how emoji sequences are built
+    if(before == 0x200D)
+      return true;
+    // Flags are pairs of regional indicators
+    return is_regional_indicator(before) && is_regional_indicator(after) &&
+      prior_indicators % 2 == 1;
+  }
+}
+}
+
+
+#endif
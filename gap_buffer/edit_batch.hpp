@@ -0,0 +1,174 @@
+#ifndef EDIT_BATCH_HPP_INCLUDED_
+#define EDIT_BATCH_HPP_INCLUDED_
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include <boost/range/iterator_range.hpp>
+#include <cstddef>
+#include <vector>
+
+
+/**
+   @brief A set of edits to be applied to a buffer all at once
+   @details
+   An edit_batch records any number of edits, each of which erases some
+   elements at a position and inserts others in their place.  Every position
+   refers to the buffer as it was before any of the edits, as in a patch, so
+   the edits can be recorded in any order.  They are kept sorted by position;
+   edits at the same position keep the order they were recorded in.
+
+   Passing a batch to the apply() member of gap_buffer or
+   contiguous_gap_buffer makes all of its edits in one sweep over the buffer,
+   moving each element at most once, where making them one at a time through
+   iterators would move the elements between the edits again for every edit.
+
+   The edits of a batch must not overlap: each must begin at or after the end
+   of the elements erased by the one before it.
+
+   @tparam T The value_type of the buffers the batch will be applied to
+*/
+template<class T>
+class edit_batch
+{
+public:
+  /// The value_type of this batch
+  typedef T              value_type;
+  /// The size_type of this batch
+  typedef std::size_t    size_type;
+  /// The difference_type of this batch
+  typedef std::ptrdiff_t difference_type;
+
+  /// A single edit, replacing elements [position, position + erased)
+  struct edit
+  {
+    /// The index of the first element to erase, or to insert before
+    size_type position;
+    /// The number of elements to erase
+    size_type erased;
+    /// The start of the inserted elements amongst all those of the batch
+    size_type first;
+    /// The number of elements to insert
+    size_type inserted;
+  };
+
+  /// The sorted edits of a batch
+  typedef std::vector<edit> edit_list;
+  /// The elements one edit inserts
+  typedef boost::iterator_range<typename std::vector<T>::const_iterator>
+  inserted_range;
+
+  /// Construct an empty batch
+  edit_batch();
+
+  /// @name Recording Edits
+  //@{
+  /// Erase n elements starting at position
+  /// @note \b Complexity: O(1) amortized, if recorded in order
+  void erase(size_type position, size_type n);
+
+  /// Insert element before position
+  /// @note \b Complexity: O(1) amortized, if recorded in order
+  void insert(size_type position, value_type const & element);
+
+  /// Insert the range [i, j) before position
+  /// @note \b Complexity: O(std::distance(i, j)) amortized, if recorded in
+  ///       order
+  template<class InputIterator>
+  void insert(size_type position, InputIterator i, InputIterator j);
+
+  /// Replace the n elements starting at position with the range [i, j)
+  /// @note \b Complexity: O(std::distance(i, j)) amortized, if recorded in
+  ///       order
+  template<class InputIterator>
+  void replace(size_type position, size_type n,
+               InputIterator i, InputIterator j);
+
+  /// Forget every edit
+  /// @note \b Complexity: O(1)
+  void clear();
+  //@}
+
+  /// @name Inspecting Edits
+  //@{
+  /// Return if there are no edits
+  /// @note \b Complexity: O(1)
+  bool empty() const;
+
+  /// Return the number of edits
+  /// @note \b Complexity: O(1)
+  size_type size() const;
+
+  /// Return the edits, sorted by position
+  /// @note \b Complexity: O(1), or O(k log k) for k edits after edits were
+  ///       recorded out of order
+  edit_list const & edits() const;
+
+  /// Return the elements that e inserts
+  /// @note \b Complexity: O(1)
+  inserted_range inserted(edit const & e) const;
+
+  /// Return how much the edits change the size of a buffer
+  /// @note \b Complexity: O(1)
+  difference_type growth() const;
+
+  /// @brief Return where the element at index position will be once the edits
+  ///        are applied
+  /// @details This is where a buffer's cursor moves to: a cursor amongst
+  ///          erased elements moves to the start of the edit, and one at the
+  ///          position of an insertion moves past it.
+  /// @note \b Complexity: O(k), for k edits
+  size_type map(size_type position) const;
+
+  /// @brief Throw std::out_of_range if an edit reaches beyond size, or
+  ///        std::invalid_argument if two edits overlap
+  /// @note \b Complexity: O(k), for k edits
+  void validate(size_type size) const;
+  //@}
+
+private:
+  // Record an edit whose inserted elements were just added to elements
+  void record(size_type position, size_type erased, size_type first);
+
+  // Sorted lazily, so that edits recorded out of order cost nothing until
+  // they are read
+  mutable edit_list changes;
+  mutable bool      sorted;
+  std::vector<T>    elements;
+  difference_type   net;
+};
+
+
+#include "edit_batch.ipp"
+#endif
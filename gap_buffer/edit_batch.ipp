@@ -0,0 +1,199 @@
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+
+namespace edit_batch_detail
+{
+  // Order edits by position alone, so that a stable sort keeps the order of
+  // edits at the same position
+  template<class TEdit>
+  bool earlier(TEdit const & lhs, TEdit const & rhs)
+  {
+    return lhs.position < rhs.position;
+  }
+}
+
+
+template<class T>
+edit_batch<T>::edit_batch()
+  : sorted(true)
+  , net(0)
+{}
+
+template<class T>
+void
+edit_batch<T>::
+record(size_type position, size_type erased, size_type first)
+{
+  edit const e = { position, erased, first, elements.size() - first };
+  if(!changes.empty() && position < changes.back().position)
+    sorted = false;
+  changes.push_back(e);
+  net += static_cast<difference_type>(e.inserted) -
+    static_cast<difference_type>(erased);
+}
+
+template<class T>
+void
+edit_batch<T>::
+erase(size_type position, size_type n)
+{
+  record(position, n, elements.size());
+}
+
+template<class T>
+void
+edit_batch<T>::
+insert(size_type position, value_type const & element)
+{
+  size_type const first = elements.size();
+  elements.push_back(element);
+  record(position, 0, first);
+}
+
+template<class T>
+template<class InputIterator>
+void
+edit_batch<T>::
+insert(size_type position, InputIterator i, InputIterator j)
+{
+  replace(position, 0, i, j);
+}
+
+template<class T>
+template<class InputIterator>
+void
+edit_batch<T>::
+replace(size_type position, size_type n, InputIterator i, InputIterator j)
+{
+  size_type const first = elements.size();
+  elements.insert(elements.end(), i, j);
+  record(position, n, first);
+}
+
+template<class T>
+void
+edit_batch<T>::
+clear()
+{
+  changes.clear();
+  elements.clear();
+  sorted = true;
+  net = 0;
+}
+
+
+template<class T>
+bool
+edit_batch<T>::
+empty() const
+{
+  return changes.empty();
+}
+
+template<class T>
+typename edit_batch<T>::size_type
+edit_batch<T>::
+size() const
+{
+  return changes.size();
+}
+
+template<class T>
+typename edit_batch<T>::edit_list const &
+edit_batch<T>::
+edits() const
+{
+  if(!sorted){
+    std::stable_sort(changes.begin(), changes.end(),
+                     edit_batch_detail::earlier<edit>);
+    sorted = true;
+  }
+  return changes;
+}
+
+template<class T>
+typename edit_batch<T>::inserted_range
+edit_batch<T>::
+inserted(edit const & e) const
+{
+  typename std::vector<T>::const_iterator const first =
+    elements.begin() + e.first;
+  return inserted_range(first, first + e.inserted);
+}
+
+template<class T>
+typename edit_batch<T>::difference_type
+edit_batch<T>::
+growth() const
+{
+  return net;
+}
+
+template<class T>
+typename edit_batch<T>::size_type
+edit_batch<T>::
+map(size_type position) const
+{
+  edit_list const & list = edits();
+  difference_type shift = 0;
+  for(typename edit_list::const_iterator e = list.begin();
+      e != list.end() && e->position <= position; ++e){
+    if(position < e->position + e->erased)
+      return e->position + shift + e->inserted;
+    shift += static_cast<difference_type>(e->inserted) -
+      static_cast<difference_type>(e->erased);
+  }
+  return position + shift;
+}
+
+template<class T>
+void
+edit_batch<T>::
+validate(size_type size) const
+{
+  edit_list const & list = edits();
+  size_type reached = 0;
+  for(typename edit_list::const_iterator e = list.begin();
+      e != list.end(); ++e){
+    if(e->position < reached)
+      throw std::invalid_argument("edit_batch::validate");
+    reached = e->position + e->erased;
+    if(reached > size)
+      throw std::out_of_range("edit_batch::validate");
+  }
+}
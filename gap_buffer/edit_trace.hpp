@@ -0,0 +1,233 @@
+#ifndef EDIT_TRACE_HPP_INCLUDED_
+#define EDIT_TRACE_HPP_INCLUDED_
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_trivially_copyable.hpp>
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+/**
+   @brief A recorded sequence of edits, read back to be replayed on a buffer
+   @details
+   A trace is written by an edit_recorder attached to a gap_buffer, and can be
+   replayed on any buffer with the gap_buffer interface, such as another
+   gap_buffer, a contiguous_gap_buffer or a rope_buffer, to compare how they
+   cope with the way a real session edits.
+
+   The format is compact: a short header, then for each edit a byte naming the
+   operation, its positions and lengths as variable-length integers, and the
+   raw bytes of any inserted elements.  It is meant to be replayed on the kind
+   of machine which recorded it, so elements are written in its byte order.
+
+   Reading a trace checks that every edit is possible on the buffer the edits
+   before it leave behind, starting from an empty one, so a trace which has
+   been read can be replayed without further checks.
+
+   @tparam T The value_type of the buffers recorded and replayed.  It must be
+             trivially copyable.
+*/
+template<class T>
+class edit_trace
+{
+  BOOST_STATIC_ASSERT(boost::is_trivially_copyable<T>::value);
+public:
+  /// The size_type of this trace
+  typedef std::size_t size_type;
+
+  /// The kinds of edit a trace holds
+  enum operation
+  {
+    /// The buffer was constructed with elements, and a cursor
+    reset,
+    /// The cursor moved by a distance
+    advance,
+    /// Elements were inserted at the cursor
+    insert,
+    /// Elements were inserted elsewhere, through an iterator
+    insert_at,
+    /// Elements just before the cursor were erased
+    erase_before,
+    /// Elements just after the cursor were erased
+    erase_after,
+    /// Elements were erased elsewhere, through iterators
+    erase_at,
+    /// Every element was erased
+    clear,
+    /// The number of kinds of edit
+    operation_count
+  };
+
+  /// Construct an empty trace
+  edit_trace();
+
+  /// @brief Read every edit of a trace from in, which must hold the whole of
+  ///        one, and throw std::invalid_argument if it is malformed or holds
+  ///        elements of a different size
+  /// @note \b Complexity: O(n), for n the size of the trace
+  explicit edit_trace(std::istream & in);
+
+  /// Return the number of edits in the trace
+  /// @note \b Complexity: O(1)
+  size_type size() const;
+
+  /// Return the kind of the ith edit
+  /// @note \b Complexity: O(1)
+  operation op(size_type i) const;
+
+  /// Return the name of an operation, for reports
+  static char const * name(operation o);
+
+  /// @brief Make the ith edit on buffer, which must hold what the edits before
+  ///        it left behind
+  /// @note \b Complexity: The cost of that edit on TBuffer
+  template<class TBuffer>
+  void apply(TBuffer & buffer, size_type i) const;
+
+  /// Make every edit on buffer, which must begin empty
+  /// @note \b Complexity: The total cost of the edits on TBuffer
+  template<class TBuffer>
+  void apply(TBuffer & buffer) const;
+
+private:
+  // One edit
+  struct record
+  {
+    operation      op;
+    // The index the edit is made at, or where reset leaves the cursor
+    size_type      position;
+    // The number of elements inserted or erased
+    size_type      length;
+    // The distance the cursor moves
+    std::ptrdiff_t distance;
+    // Where the inserted elements begin in payload
+    size_type      offset;
+  };
+
+  // Every edit, in order
+  std::vector<record> records;
+  // The elements inserted by every edit, in order
+  std::vector<T>      payload;
+};
+
+
+/**
+   @brief A gap_buffer observer which records every edit to a trace
+   @details
+   Attach an edit_recorder to a gap_buffer by naming it as the buffer's
+   TObserver.  Every cursor move, insertion and erasure, including those made
+   by resize() and clear(), is appended to a trace held in memory, which
+   flush() writes out and forgets.  Flushing a long session now and then keeps
+   the memory it uses bounded; the pieces written form one trace, to be read
+   with edit_trace.
+
+   The recorder sees an edit's effect, not which member made it, so edits
+   which have the same effect are recorded alike.  An insertion through an
+   iterator at the cursor is recorded as an insertion at the cursor, an
+   erasure which ends or begins at the cursor as erase(dist), and an erasure
+   of every element as clear().  Replaying them has the same result.
+   Assigning or swapping the buffer is not recorded.
+
+   @tparam T The value_type of the gap_buffer being observed.  It must be
+             trivially copyable.
+*/
+template<class T>
+class edit_recorder
+{
+  BOOST_STATIC_ASSERT(boost::is_trivially_copyable<T>::value);
+public:
+  /// The size_type of this recorder
+  typedef std::size_t size_type;
+
+  /// Tell gap_buffer that this observer needs to hear about every edit
+  static bool const enabled = true;
+
+  /// Construct a recorder holding just the header of a trace
+  edit_recorder();
+
+  /// @name Observer Requirements
+  //@{
+  /// Record that [first, last) was inserted at index position
+  /// @note \b Complexity: O(std::distance(first, last))
+  template<class TBuffer, class TIterator>
+  void on_insert(TBuffer const & buffer, size_type position,
+                 TIterator first, TIterator last);
+  /// Record that [first, last), at index position, is about to be erased
+  /// @note \b Complexity: O(std::distance(first, last))
+  template<class TBuffer, class TIterator>
+  void on_erase(TBuffer const & buffer, size_type position,
+                TIterator first, TIterator last);
+  /// Record that the cursor moved by distance
+  /// @note \b Complexity: O(1)
+  template<class TBuffer>
+  void on_advance(TBuffer const & buffer, std::ptrdiff_t distance);
+  /// Record the elements and cursor the buffer was constructed with
+  /// @note \b Complexity: O(buffer.size())
+  template<class TBuffer>
+  void on_reset(TBuffer const & buffer);
+  //@}
+
+  /// Return the trace recorded since construction or the last flush()
+  /// @note \b Complexity: O(1)
+  std::string const & pending() const;
+
+  /// Write the trace recorded since construction or the last flush() to out,
+  /// and forget it
+  /// @note \b Complexity: O(pending().size())
+  void flush(std::ostream & out);
+
+  /// Return the number of edits recorded since construction
+  /// @note \b Complexity: O(1)
+  size_type record_count() const;
+
+private:
+  // The encoded edits not yet flushed
+  std::string trace;
+  size_type   records;
+
+  // Begin the record of an edit
+  void put_op(typename edit_trace<T>::operation op);
+  // Append the elements [first, last), and their number
+  template<class TIterator>
+  void put_elements(TIterator first, TIterator last);
+};
+
+
+#include "edit_trace.ipp"
+#endif
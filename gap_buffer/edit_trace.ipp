@@ -0,0 +1,412 @@
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <boost/next_prior.hpp>
+#include <boost/range/iterator_range.hpp>
+
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+
+template<class T>
+bool const edit_recorder<T>::enabled;
+
+
+namespace edit_trace_detail
+{
+  // The first bytes of every trace, then its version
+  char const magic[] = { 'g', 'b', 't', 'r' };
+  unsigned char const version = 1;
+
+  // Append n as a variable-length integer, seven bits at a time, low first
+  inline void put_size(std::string & out, std::size_t n)
+  {
+    for(; n >= 0x80; n >>= 7)
+      out += static_cast<char>((n & 0x7f) | 0x80);
+    out += static_cast<char>(n);
+  }
+
+  // Append d as a variable-length integer, with its sign in the lowest bit
+  inline void put_distance(std::string & out, std::ptrdiff_t d)
+  {
+    put_size(out, d < 0 ? (static_cast<std::size_t>(-(d + 1)) << 1) | 1
+                        : static_cast<std::size_t>(d) << 1);
+  }
+
+  // Reads the integers of a trace, throwing if it ends early
+  class trace_reader
+  {
+  public:
+    explicit trace_reader(std::string const & trace)
+      : in(trace)
+      , at(0)
+    {}
+
+    bool done() const
+    {
+      return at == in.size();
+    }
+
+    unsigned char byte()
+    {
+      need(1);
+      return static_cast<unsigned char>(in[at++]);
+    }
+
+    std::size_t size()
+    {
+      std::size_t n = 0;
+      for(unsigned shift = 0; ; shift += 7){
+        unsigned char const b = byte();
+        if(shift >= sizeof(std::size_t) * 8)
+          throw std::invalid_argument("edit_trace");
+        n |= static_cast<std::size_t>(b & 0x7f) << shift;
+        if(!(b & 0x80))
+          return n;
+      }
+    }
+
+    std::ptrdiff_t distance()
+    {
+      std::size_t const n = size();
+      return (n & 1) ? -static_cast<std::ptrdiff_t>(n >> 1) - 1
+                     : static_cast<std::ptrdiff_t>(n >> 1);
+    }
+
+    // Copy n raw bytes to out
+    void bytes(void * out, std::size_t n)
+    {
+      need(n);
+      std::memcpy(out, in.data() + at, n);
+      at += n;
+    }
+
+  private:
+    std::string const & in;
+    std::size_t         at;
+
+    void need(std::size_t n) const
+    {
+      if(in.size() - at < n)
+        throw std::invalid_argument("edit_trace");
+    }
+  };
+}
+
+
+template<class T>
+edit_trace<T>::edit_trace()
+{}
+
+template<class T>
+edit_trace<T>::edit_trace(std::istream & in)
+{
+  using namespace edit_trace_detail;
+  std::string const trace((std::istreambuf_iterator<char>(in)),
+                          std::istreambuf_iterator<char>());
+  trace_reader read(trace);
+  char header[sizeof(magic)];
+  read.bytes(header, sizeof(header));
+  if(std::memcmp(header, magic, sizeof(magic)) != 0 ||
+     read.byte() != version || read.size() != sizeof(T))
+    throw std::invalid_argument("edit_trace");
+
+  // Follow the size and cursor of the buffer, to check each edit is possible
+  size_type size = 0, cursor = 0;
+  while(!read.done()){
+    record r = { static_cast<operation>(read.byte()), 0, 0, 0, 0 };
+    if(r.op == insert_at || r.op == erase_at)
+      r.position = read.size();
+    if(r.op != advance && r.op != clear)
+      r.length = read.size();
+    if(r.op == reset || r.op == insert || r.op == insert_at){
+      if(r.length > trace.size() / sizeof(T))
+        throw std::invalid_argument("edit_trace");
+      r.offset = payload.size();
+      payload.resize(payload.size() + r.length);
+      if(r.length != 0)
+        read.bytes(&payload[r.offset], r.length * sizeof(T));
+    }
+
+    bool possible = true;
+    switch(r.op){
+    case reset:
+      r.position = read.size();
+      possible = r.position <= r.length;
+      size = r.length;
+      cursor = r.position;
+      break;
+    case advance:
+      r.distance = read.distance();
+      possible = r.distance < 0 ?
+        static_cast<size_type>(-(r.distance + 1)) < cursor :
+        static_cast<size_type>(r.distance) <= size - cursor;
+      cursor += r.distance;
+      break;
+    case insert:
+      size += r.length;
+      cursor += r.length;
+      break;
+    case insert_at:
+      possible = r.position <= size;
+      size += r.length;
+      if(r.position <= cursor)
+        cursor += r.length;
+      break;
+    case erase_before:
+      possible = r.length <= cursor;
+      size -= r.length;
+      cursor -= r.length;
+      break;
+    case erase_after:
+      possible = r.length <= size - cursor;
+      size -= r.length;
+      break;
+    case erase_at:
+      possible = r.position <= size && r.length <= size - r.position;
+      if(possible)
+        cursor -= std::min(r.position + r.length, cursor) -
+          std::min(r.position, cursor);
+      size -= r.length;
+      break;
+    case clear:
+      size = cursor = 0;
+      break;
+    default:
+      possible = false;
+      break;
+    }
+    if(!possible)
+      throw std::invalid_argument("edit_trace");
+    records.push_back(r);
+  }
+}
+
+template<class T>
+typename edit_trace<T>::size_type
+edit_trace<T>::size() const
+{
+  return records.size();
+}
+
+template<class T>
+typename edit_trace<T>::operation
+edit_trace<T>::op(size_type i) const
+{
+  return records[i].op;
+}
+
+template<class T>
+char const *
+edit_trace<T>::name(operation o)
+{
+  static char const * const names[operation_count] = {
+    "reset", "advance", "insert", "insert_at", "erase_before", "erase_after",
+    "erase_at", "clear"
+  };
+  return names[o];
+}
+
+template<class T>
+template<class TBuffer>
+void
+edit_trace<T>::apply(TBuffer & buffer, size_type i) const
+{
+  typedef typename TBuffer::iterator iterator;
+  typedef typename std::vector<T>::const_iterator payload_iterator;
+  record const & r = records[i];
+  payload_iterator const first = payload.begin() + r.offset;
+  payload_iterator const last = first + r.length;
+  switch(r.op){
+  case reset:
+    buffer.clear();
+    buffer.insert(boost::make_iterator_range(first, last));
+    buffer.advance(static_cast<std::ptrdiff_t>(r.position) -
+                   static_cast<std::ptrdiff_t>(buffer.position()));
+    break;
+  case advance:
+    buffer.advance(r.distance);
+    break;
+  case insert:
+    if(r.length == 1)
+      buffer.insert(*first);
+    else
+      buffer.insert(boost::make_iterator_range(first, last));
+    break;
+  case insert_at: {
+    iterator const at = boost::next(buffer.begin(), r.position);
+    if(r.length == 1)
+      buffer.insert(at, *first);
+    else
+      buffer.insert(at, first, last);
+    break;
+  }
+  case erase_before:
+    buffer.erase(-static_cast<std::ptrdiff_t>(r.length));
+    break;
+  case erase_after:
+    buffer.erase(static_cast<std::ptrdiff_t>(r.length));
+    break;
+  case erase_at: {
+    iterator const start = boost::next(buffer.begin(), r.position);
+    buffer.erase(start, boost::next(start, r.length));
+    break;
+  }
+  case clear:
+    buffer.clear();
+    break;
+  default:
+    break;
+  }
+}
+
+template<class T>
+template<class TBuffer>
+void
+edit_trace<T>::apply(TBuffer & buffer) const
+{
+  for(size_type i = 0; i != records.size(); ++i)
+    apply(buffer, i);
+}
+
+
+template<class T>
+edit_recorder<T>::edit_recorder()
+  : trace(edit_trace_detail::magic,
+          edit_trace_detail::magic + sizeof(edit_trace_detail::magic))
+  , records(0)
+{
+  trace += static_cast<char>(edit_trace_detail::version);
+  edit_trace_detail::put_size(trace, sizeof(T));
+}
+
+template<class T>
+template<class TBuffer, class TIterator>
+void
+edit_recorder<T>::on_insert(TBuffer const & buffer, size_type position,
+                            TIterator first, TIterator last)
+{
+  // Only an insertion at the cursor leaves it just past the new elements
+  size_type const n = std::distance(first, last);
+  if(buffer.position() == position + n){
+    put_op(edit_trace<T>::insert);
+  }else{
+    put_op(edit_trace<T>::insert_at);
+    edit_trace_detail::put_size(trace, position);
+  }
+  put_elements(first, last);
+}
+
+template<class T>
+template<class TBuffer, class TIterator>
+void
+edit_recorder<T>::on_erase(TBuffer const & buffer, size_type position,
+                           TIterator first, TIterator last)
+{
+  size_type const n = std::distance(first, last);
+  size_type const cursor = buffer.position();
+  if(position == 0 && n == buffer.size()){
+    put_op(edit_trace<T>::clear);
+    return;
+  }
+  if(position + n == cursor){
+    put_op(edit_trace<T>::erase_before);
+  }else if(position == cursor){
+    put_op(edit_trace<T>::erase_after);
+  }else{
+    put_op(edit_trace<T>::erase_at);
+    edit_trace_detail::put_size(trace, position);
+  }
+  edit_trace_detail::put_size(trace, n);
+}
+
+template<class T>
+template<class TBuffer>
+void
+edit_recorder<T>::on_advance(TBuffer const &, std::ptrdiff_t distance)
+{
+  put_op(edit_trace<T>::advance);
+  edit_trace_detail::put_distance(trace, distance);
+}
+
+template<class T>
+template<class TBuffer>
+void
+edit_recorder<T>::on_reset(TBuffer const & buffer)
+{
+  put_op(edit_trace<T>::reset);
+  put_elements(buffer.begin(), buffer.end());
+  edit_trace_detail::put_size(trace, buffer.position());
+}
+
+template<class T>
+std::string const &
+edit_recorder<T>::pending() const
+{
+  return trace;
+}
+
+template<class T>
+void
+edit_recorder<T>::flush(std::ostream & out)
+{
+  out.write(trace.data(), trace.size());
+  trace.clear();
+}
+
+template<class T>
+typename edit_recorder<T>::size_type
+edit_recorder<T>::record_count() const
+{
+  return records;
+}
+
+template<class T>
+void
+edit_recorder<T>::put_op(typename edit_trace<T>::operation op)
+{
+  trace += static_cast<char>(op);
+  ++records;
+}
+
+template<class T>
+template<class TIterator>
+void
+edit_recorder<T>::put_elements(TIterator first, TIterator last)
+{
+  edit_trace_detail::put_size(trace, std::distance(first, last));
+  for(; first != last; ++first){
+    T const element = *first;
+    trace.append(reinterpret_cast<char const *>(&element), sizeof(T));
+  }
+}
@@ -0,0 +1,264 @@
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+   Replays a trace of edits, recorded by an edit_recorder<char>, on each of the
+   buffers in this directory, and reports how long each took.  Build it with
+   optimization, e.g.
+
+     g++ -O2 -DNDEBUG -o edit_trace_replay edit_trace_replay.cpp
+
+   and run it as "edit_trace_replay [options] TRACE", or with --help for its
+   options.  For each buffer it reports the time of the whole replay, and for
+   each kind of edit their number, their mean time and the longest any one
+   took, since a rare slow edit is what a user notices.
+*/
+
+#include "gap_buffer.hpp"
+#include "contiguous_gap_buffer.hpp"
+#include "rope_buffer.hpp"
+#include "edit_trace.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/container/deque.hpp>
+
+#include <time.h>
+
+
+typedef edit_trace<char> trace_t;
+
+// Return the time of a monotonic clock, in seconds
+double now()
+{
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// Return the time one call of now() takes, to subtract from short edits
+double clock_overhead()
+{
+  int const calls = 10000;
+  double const begun = now();
+  for(int i = 0; i != calls; ++i)
+    now();
+  return (now() - begun) / calls;
+}
+
+/// The time a replay took, in seconds, in total and by kind of edit
+struct timing
+{
+  std::string backend;
+  double      total;
+  std::size_t count[trace_t::operation_count];
+  double      time[trace_t::operation_count];
+  double      longest[trace_t::operation_count];
+  std::size_t checksum;
+};
+
+// Return a hash of the elements of buffer, and of its cursor
+template<class TBuffer>
+std::size_t checksum(TBuffer const & buffer)
+{
+  std::size_t hash = 2166136261u ^ buffer.position();
+  for(typename TBuffer::const_iterator i = buffer.begin(), end = buffer.end();
+      i != end; ++i)
+    hash = (hash ^ static_cast<unsigned char>(*i)) * 16777619u;
+  return hash ^ buffer.size();
+}
+
+// Replay trace on a TBuffer repeat times: once timed as a whole, and then
+// timing each edit
+template<class TBuffer>
+void replay(char const * name, trace_t const & trace, int repeat,
+            double overhead, std::string const & filter,
+            std::vector<timing> & results)
+{
+  if(std::string(name).find(filter) == std::string::npos)
+    return;
+  timing t;
+  t.backend = name;
+  t.total = 0;
+  std::fill(t.count, t.count + trace_t::operation_count, 0);
+  std::fill(t.time, t.time + trace_t::operation_count, 0.0);
+  std::fill(t.longest, t.longest + trace_t::operation_count, 0.0);
+  for(int r = 0; r != repeat; ++r){
+    TBuffer whole;
+    double const begun = now();
+    trace.apply(whole);
+    t.total += now() - begun;
+    t.checksum = checksum(whole);
+
+    TBuffer each;
+    for(std::size_t i = 0; i != trace.size(); ++i){
+      trace_t::operation const op = trace.op(i);
+      double const start = now();
+      trace.apply(each, i);
+      double const took = std::max(0.0, now() - start - overhead);
+      ++t.count[op];
+      t.time[op] += took;
+      t.longest[op] = std::max(t.longest[op], took);
+    }
+  }
+  t.total /= repeat;
+  results.push_back(t);
+}
+
+void print_table(std::vector<timing> const & results, int repeat)
+{
+  for(std::size_t i = 0; i != results.size(); ++i){
+    timing const & t = results[i];
+    std::printf("%s: %.3f ms\n", t.backend.c_str(), t.total * 1e3);
+    for(int op = 0; op != trace_t::operation_count; ++op)
+      if(t.count[op] != 0)
+        std::printf("  %-13s %10lu edits %12.1f ns/edit %12.1f us longest\n",
+                    trace_t::name(static_cast<trace_t::operation>(op)),
+                    static_cast<unsigned long>(t.count[op] / repeat),
+                    t.time[op] * 1e9 / t.count[op], t.longest[op] * 1e6);
+  }
+}
+
+// Write results to the file at path as comma separated values, one row for
+// each buffer and kind of edit
+bool write_csv(std::string const & path, std::vector<timing> const & results,
+               int repeat)
+{
+  std::ofstream out(path.c_str());
+  out << "backend,operation,count,ns_per_op,longest_ns,total_ms\n";
+  for(std::size_t i = 0; i != results.size(); ++i){
+    timing const & t = results[i];
+    for(int op = 0; op != trace_t::operation_count; ++op)
+      if(t.count[op] != 0)
+        out << t.backend << ','
+            << trace_t::name(static_cast<trace_t::operation>(op)) << ','
+            << t.count[op] / repeat << ','
+            << t.time[op] * 1e9 / t.count[op] << ','
+            << t.longest[op] * 1e9 << ','
+            << t.total * 1e3 << '\n';
+  }
+  return static_cast<bool>(out.flush());
+}
+
+void usage(char const * program)
+{
+  std::cerr <<
+    "usage: " << program << " [options] TRACE\n"
+    "  --backend TEXT  only replay on buffers whose name contains TEXT\n"
+    "  --repeat N      replay N times on each buffer (default 1)\n"
+    "  --csv FILE      also write the results to FILE\n";
+}
+
+int main(int argc, char * argv[])
+{
+  std::string filter, csv, path;
+  int repeat = 1;
+  for(int i = 1; i < argc; ++i){
+    std::string const option = argv[i];
+    if(option == "--help"){
+      usage(argv[0]);
+      return 0;
+    }else if(option.compare(0, 2, "--") != 0 && path.empty()){
+      path = option;
+    }else if(i + 1 == argc){
+      usage(argv[0]);
+      return 1;
+    }else if(option == "--backend"){
+      filter = argv[++i];
+    }else if(option == "--repeat"){
+      repeat = std::max(1, std::atoi(argv[++i]));
+    }else if(option == "--csv"){
+      csv = argv[++i];
+    }else{
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if(path.empty()){
+    usage(argv[0]);
+    return 1;
+  }
+
+  std::ifstream in(path.c_str(), std::ios::binary);
+  if(!in){
+    std::cerr << "could not read " << path << '\n';
+    return 1;
+  }
+  trace_t trace;
+  try{
+    trace = trace_t(in);
+  }catch(std::invalid_argument const &){
+    std::cerr << path << " is not a trace of edits to characters\n";
+    return 1;
+  }
+
+  double const overhead = clock_overhead();
+  std::vector<timing> results;
+  replay<gap_buffer<std::deque<char> > >(
+    "gap_buffer<std::deque>", trace, repeat, overhead, filter, results);
+  replay<gap_buffer<boost::container::deque<char> > >(
+    "gap_buffer<boost::container::deque>", trace, repeat, overhead, filter,
+    results);
+  replay<gap_buffer<std::list<char> > >(
+    "gap_buffer<std::list>", trace, repeat, overhead, filter, results);
+  replay<gap_buffer<std::vector<char> > >(
+    "gap_buffer<std::vector>", trace, repeat, overhead, filter, results);
+  replay<contiguous_gap_buffer<char> >(
+    "contiguous_gap_buffer", trace, repeat, overhead, filter, results);
+  replay<rope_buffer<char> >(
+    "rope_buffer", trace, repeat, overhead, filter, results);
+  std::printf("%lu edits\n", static_cast<unsigned long>(trace.size()));
+  print_table(results, repeat);
+
+  // Every buffer must have ended up with the same elements and cursor
+  int status = 0;
+  for(std::size_t i = 1; i < results.size(); ++i)
+    if(results[i].checksum != results[0].checksum){
+      std::cerr << results[i].backend << " ended differently from "
+                << results[0].backend << '\n';
+      status = 1;
+    }
+
+  if(!csv.empty() && !write_csv(csv, results, repeat)){
+    std::cerr << "could not write " << csv << '\n';
+    status = 1;
+  }
+  return status;
+}
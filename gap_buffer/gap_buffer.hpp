@@ -34,13 +34,204 @@
 */
 
 
+#include <boost/array.hpp>
+#include <boost/mpl/if.hpp>
+#include <boost/range/iterator_range.hpp>
 #include <boost/utility/enable_if.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include <boost/type_traits/is_convertible.hpp>
 #include <boost/type_traits/is_same.hpp>
 #include <boost/concept/assert.hpp>
 #include <boost/concept_check.hpp>
+#include <boost/config.hpp>
 #include <boost/move/move.hpp>
+#include <cstddef>
 #include <iterator>
 
+#include "container_traits.hpp"
+#include "detail/concepts.hpp"
+#include "edit_batch.hpp"
+
+
+/**
+   @brief The default observer of a gap_buffer, which ignores every edit
+   @details
+   An observer is told about each change to the buffer it is attached to.  It
+   must provide the members below; each is called with the buffer itself, so
+   that the observer can inspect it.  on_insert is called after elements are
+   inserted, with the logical index of the first of them and their range.
+   on_erase is called before elements are erased, likewise.  on_advance is
+   called after the cursor of a buffer moves.  on_reset is called when a buffer
+   is constructed with elements, which the observer has not been told about.
+
+   Working out the index and range of an edit away from the cursor can cost
+   as much as O(n) for containers without random access iterators, so a
+   gap_buffer only does it, and calls these members, when the observer's
+   \a enabled constant is true.  With this observer the notifications compile
+   away completely.
+*/
+struct null_observer
+{
+  /// If a gap_buffer should tell this observer about its edits
+  static bool const enabled = false;
+
+  /// Called after [first, last) is inserted at index position
+  template<class TBuffer, class TIterator>
+  void on_insert(TBuffer const &, std::size_t, TIterator, TIterator) {}
+
+  /// Called before [first, last), which begins at index position, is erased
+  template<class TBuffer, class TIterator>
+  void on_erase(TBuffer const &, std::size_t, TIterator, TIterator) {}
+
+  /// Called after the cursor is moved by distance
+  template<class TBuffer>
+  void on_advance(TBuffer const &, std::ptrdiff_t) {}
+
+  /// Called after the buffer is constructed with elements
+  template<class TBuffer>
+  void on_reset(TBuffer const &) {}
+};
+
+
+/// The operations of gap_buffer, as told to a stats policy
+enum gap_operation
+{
+  /// Inserting one element at the cursor, with insert() or emplace()
+  gap_insert,
+  /// Inserting a range at the cursor
+  gap_insert_range,
+  /// Erasing elements either side of the cursor, with erase(difference_type)
+  gap_erase,
+  /// Inserting elements before an iterator
+  gap_insert_at,
+  /// Erasing the elements of an iterator range
+  gap_erase_at,
+  /// Moving the gap to the cursor, which only the inserts at the cursor do
+  gap_resolve,
+  /// The number of operations
+  gap_operation_count
+};
+
+/**
+   @brief The default stats policy of a gap_buffer, which counts nothing
+   @details
+   A stats policy is told what each edit costs the buffer it belongs to.  It
+   must provide the members below; each is called with the buffer itself, so
+   that the policy can inspect it.  on_resolve is called after the gap is moved
+   to the cursor on behalf of op, which relocated moved elements from one half
+   to the other.  on_edit is called after every change to the elements,
+   including construction with elements, assignment and swap.  on_begin and
+   on_end bracket each operation, so that a policy such as latency_stats can
+   time it.  Moving the gap is bracketed as gap_resolve, within the insert
+   which needed it.
+
+   As with observers, a gap_buffer only calls these members when the policy's
+   \a enabled constant is true, so with this policy they compile away
+   completely.  Unlike an observer, a policy belongs to its buffer: it is not
+   copied, moved or swapped with the elements.
+*/
+struct null_stats
+{
+  /// If a gap_buffer should tell this policy what its edits cost
+  static bool const enabled = false;
+
+  /// Called after moving the gap for op relocates moved elements
+  template<class TBuffer>
+  void on_resolve(TBuffer const &, gap_operation, std::size_t) {}
+
+  /// Called after every change to the elements
+  template<class TBuffer>
+  void on_edit(TBuffer const &) {}
+
+  /// Called as op begins
+  template<class TBuffer>
+  void on_begin(TBuffer const &, gap_operation) {}
+
+  /// Called as op ends, whether or not it succeeded
+  template<class TBuffer>
+  void on_end(TBuffer const &, gap_operation) {}
+};
+
+
+/// The storage of a gap_buffer, as reported by its memory_usage() member
+struct buffer_memory
+{
+  /// The bytes of the elements held
+  std::size_t       live;
+  /// The storage the half before the gap holds from its allocator
+  storage_footprint before;
+  /// The storage the half after the gap holds from its allocator
+  storage_footprint after;
+};
+
+
+namespace gap_detail
+{
+  // If the compact iterators of a gap_buffer of TContainer keep the block of
+  // a half they are in, rather than indexing the half every time
+  template<class TContainer>
+  struct caches_blocks
+    : boost::integral_constant<bool,
+                               indexing_traits<TContainer>::blocked &&
+                               !indexing_traits<TContainer>::cheap_index>
+  {};
+
+  // Counts the edits of a gap_buffer, so that an iterator can tell if the
+  // block it kept may have moved.  Without blocks, it takes up no space.
+  template<bool Counted>
+  class edit_counter
+  {
+  public:
+    std::size_t edits_made() const { return 0; }
+    void        count_edit()       {}
+  };
+
+  template<>
+  class edit_counter<true>
+  {
+  public:
+    edit_counter() : edits(0) {}
+    std::size_t edits_made() const { return edits; }
+    void        count_edit()       { ++edits; }
+  private:
+    std::size_t edits;
+  };
+
+  // The block of contiguous elements [first, last) an iterator last found,
+  // which starts at index start, and the edit count of its buffer then
+  template<class TValue, bool Cached>
+  struct block_cache
+  {
+    block_cache() {}
+    template<class UValue>
+    block_cache(block_cache<UValue, Cached> const &) {}
+  };
+
+  template<class TValue>
+  struct block_cache<TValue, true>
+  {
+    block_cache()
+      : first(0)
+      , last(0)
+      , start(0)
+      , edits(0)
+    {}
+
+    template<class UValue>
+    block_cache(block_cache<UValue, true> const & other)
+      : first(other.first)
+      , last(other.last)
+      , start(other.start)
+      , edits(other.edits)
+    {}
+
+    mutable TValue *    first;
+    mutable TValue *    last;
+    mutable std::size_t start;
+    mutable std::size_t edits;
+  };
+}
+
 
 /**
    @brief A gap buffer container adapter in C++
@@ -62,34 +253,68 @@
                       function correctly, desired performance characteristics
                       will only be met if it also models "Front Insertion
                       Sequence" and "Back Insertion Sequence".
+   @tparam TObserver  A type which is told about every edit, such as
+                      null_observer or undo_journal.  One is held by each
+                      gap_buffer, and takes no space if it is empty.
+   @tparam TStats     A type which is told what every edit costs, such as
+                      null_stats or buffer_stats.  Like the observer, it takes
+                      no space if it is empty.
 */
-template<class TContainer>
+template<class TContainer,
+         class TObserver = null_observer,
+         class TStats = null_stats>
 class gap_buffer
+  : private TObserver
+  , private TStats
+  , private gap_detail::edit_counter<
+      gap_detail::caches_blocks<TContainer>::value>
 {
 private:
   // Enable Boost.Move move-emulation (or actual move on C++11)
   BOOST_COPYABLE_AND_MOVABLE(gap_buffer)
 
-  // Check our requirements on TContainer
-  BOOST_CONCEPT_ASSERT(( boost::Mutable_ForwardContainer<    TContainer> ));
-  BOOST_CONCEPT_ASSERT(( boost::Mutable_ReversibleContainer< TContainer> ));
-  BOOST_CONCEPT_ASSERT(( boost::Mutable_Container<           TContainer> ));
-  BOOST_CONCEPT_ASSERT(( boost::Sequence<                    TContainer> ));
-
-  // This iterator template uses Boost.Iterator to produce the four iterator
-  // types for gap_buffer.  It manages the process of jumping from the end of
-  // the before container to the beginning of the after container, and vice
-  // versa.
+  // Check our requirements on TContainer, which the STL only states for
+  // copyable elements
+  typedef typename TContainer::value_type element_type;
+  BOOST_CONCEPT_ASSERT(( typename concept_detail::if_copyable<element_type,
+    boost::Mutable_ForwardContainer<TContainer> >::type ));
+  BOOST_CONCEPT_ASSERT(( typename concept_detail::if_copyable<element_type,
+    boost::Mutable_ReversibleContainer<TContainer> >::type ));
+  BOOST_CONCEPT_ASSERT(( typename concept_detail::if_copyable<element_type,
+    boost::Mutable_Container<TContainer> >::type ));
+  BOOST_CONCEPT_ASSERT(( typename concept_detail::if_copyable<element_type,
+    boost::Sequence<TContainer> >::type ));
+
+  // This iterator template uses Boost.Iterator to produce the four "wide"
+  // iterator types for gap_buffer.  It manages the process of jumping from the
+  // end of the before container to the beginning of the after container, and
+  // vice versa.
   template<class TUnderlying>
   struct iterator_impl;
   template<class TUnderlying, class TConstIter>
   struct nonconst_iterator_impl;
   template<class TUnderlying>
   struct const_iterator_impl;
+  // This iterator template stores only the buffer and a logical index, and
+  // for blocked containers the block it is in.  It is used when TContainer
+  // has random access and either cheap indexing or blocks, so that an index
+  // can be turned into an element of either half in O(1).
+  template<class TValue, class TBuffer>
+  class index_iterator_impl;
 
   typedef typename std::iterator_traits<typename TContainer::iterator>::
   iterator_category iterator_category;
 
+  // If the public iterators are index_iterator_impls
+  typedef boost::integral_constant<
+    bool,
+    boost::is_convertible<iterator_category,
+                          std::random_access_iterator_tag>::value &&
+    (indexing_traits<TContainer>::cheap_index ||
+     indexing_traits<TContainer>::blocked)> compact_iterators;
+  // If those iterators keep the block they are in
+  typedef gap_detail::caches_blocks<TContainer> cached_blocks;
+
   TContainer                           before;
   TContainer                           after;
   typename TContainer::difference_type offset;
@@ -110,6 +335,10 @@ public:
   typedef typename TContainer::size_type                   size_type;
   /// The difference_type of this container
   typedef typename TContainer::difference_type             difference_type;
+  /// The allocator_type of this container, which is that of both halves
+  typedef typename TContainer::allocator_type              allocator_type;
+  /// The type of each half, as with the container adapters of the STL
+  typedef TContainer                                       container_type;
 
   /// Return the number of elements in the gap_buffer
   /// @note \b Complexity: The same complexity as TContainer::size().  This
@@ -124,22 +353,75 @@ public:
   /// @note \b Complexity: Amortized O(1)
   bool empty() const;
 
+  /// Return the bytes of the elements held, and the storage each half holds
+  /// from its allocator to hold them, as storage_traits reports it
+  /// @note \b Complexity: The same complexity as TContainer::size()
+  buffer_memory memory_usage() const;
+
   /// Swap this gap_buffer with another
+  /// @note As with any container, unless TContainer propagates its allocator
+  ///       on swap, the two must have equal allocators
   /// @note \b Complexity: Amortized O(1)
   void swap(gap_buffer & other);
+
+  /// @brief Swap the elements of this gap_buffer with those of front and back,
+  ///        which become the halves before and after the gap, with the
+  ///        cursor between them
+  /// @details front and back are left holding the old halves, as they were
+  ///          stored, and the observer is told about the new elements as it
+  ///          is on construction.  This hands a gap_buffer elements built
+  ///          elsewhere, such as by buffer_snapshot::deserialize(), without
+  ///          copying them.
+  /// @note As with swap(), the allocators of the halves must be equal unless
+  ///       TContainer propagates them on swap
+  /// @note \b Complexity: Amortized O(1), plus that of the observer
+  void swap_halves(TContainer & front, TContainer & back);
+
+  /// Return a copy of the allocator both halves allocate through
+  /// @note \b Complexity: O(1)
+  allocator_type get_allocator() const;
   //@}
 
-  ///@name Iterator access
-  //@{
+private:
+  // The wide iterators are the public ones when TContainer lacks random
+  // access, and are used to make edits either way
   typedef const_iterator_impl<typename TContainer::const_iterator>
-  const_iterator;
-  typedef nonconst_iterator_impl<typename TContainer::iterator, const_iterator>
-  iterator;
+  wide_const_iterator;
+  typedef nonconst_iterator_impl<typename TContainer::iterator,
+                                 wide_const_iterator> wide_iterator;
   typedef const_iterator_impl<typename TContainer::const_reverse_iterator>
-  const_reverse_iterator;
+  wide_const_reverse_iterator;
   typedef nonconst_iterator_impl<
     typename TContainer::reverse_iterator,
-    const_reverse_iterator> reverse_iterator;
+    wide_const_reverse_iterator> wide_reverse_iterator;
+public:
+  ///@name Iterator access
+  //@{
+  /// @brief The iterator types of the gap_buffer
+  /// @details When TContainer has random access iterators and either cheap
+  ///          indexing or blocks, as described by indexing_traits, these
+  ///          hold the buffer and an index, and stay valid as positions across
+  ///          edits, like those of contiguous_gap_buffer.  For a blocked
+  ///          TContainer, they also keep the block they are in, which they
+  ///          find again once they leave it or the buffer is edited.
+  ///          Otherwise they hold iterators into both halves, and are
+  ///          invalidated as those are.
+  typedef typename boost::mpl::if_<
+    compact_iterators,
+    index_iterator_impl<value_type const, gap_buffer const>,
+    wide_const_iterator>::type const_iterator;
+  typedef typename boost::mpl::if_<
+    compact_iterators,
+    index_iterator_impl<value_type, gap_buffer>,
+    wide_iterator>::type iterator;
+  typedef typename boost::mpl::if_<
+    compact_iterators,
+    std::reverse_iterator<const_iterator>,
+    wide_const_reverse_iterator>::type const_reverse_iterator;
+  typedef typename boost::mpl::if_<
+    compact_iterators,
+    std::reverse_iterator<iterator>,
+    wide_reverse_iterator>::type reverse_iterator;
 
   /// Return the cursor position as an iterator
   /// @note \b Complexity: O(1)
@@ -183,6 +465,23 @@ public:
   const_reverse_iterator rend() const;
   //@}
 
+  /// @name Segments
+  //@{
+  /// @brief A range of the contiguous runs of a gap_buffer, in order
+  /// @details These are the before and after containers, either of which may
+  ///          be empty.  The runs are read-only, since writing through them
+  ///          would hide the edit from the observer.
+  typedef boost::array<
+    boost::iterator_range<typename TContainer::const_iterator>, 2>
+  const_segment_list;
+
+  /// @brief Return the runs of elements in this gap_buffer, for use by the
+  ///        algorithms in segmented_algorithms.hpp
+  /// @note The runs are invalidated by any edit or cursor movement
+  /// @note \b Complexity: O(1)
+  const_segment_list segments() const;
+  //@}
+
   /// @name Sequence Requirements
   //@{
   /// Default-construct an empty gap_buffer
@@ -208,6 +507,36 @@ public:
   template<class InputIterator>
   gap_buffer(InputIterator const & i, InputIterator const & j);
 
+  /// @brief Construct an empty gap_buffer whose halves allocate through
+  ///        alloc
+  /// @details Each constructor taking an allocator gives it to both halves.
+  /// Those without one use TContainer's own choice: a default-constructed
+  /// allocator, or for copies, whatever
+  /// allocator_traits::select_on_container_copy_construction picks.  Copy and
+  /// move assignment, and swap(), propagate allocators as TContainer does.
+  explicit gap_buffer(allocator_type const & alloc);
+
+  /// Copy-construct a gap_buffer whose halves allocate through alloc
+  /// @note \b Complexity: O(other.size())
+  gap_buffer(gap_buffer const & other, allocator_type const & alloc);
+
+  /// @brief Move-construct a gap_buffer whose halves allocate through alloc,
+  ///        moving the elements one at a time if other's allocator differs
+  /// @note Requires that TContainer be movable with an allocator
+  gap_buffer(BOOST_RV_REF(gap_buffer) other, allocator_type const & alloc);
+
+  /// @brief Fill-construct a gap_buffer with n copies of e and the cursor at
+  ///        the end, allocating through alloc
+  /// @note \b Complexity: O(n)
+  gap_buffer(size_type n, value_type e, allocator_type const & alloc);
+
+  /// @brief Construct a gap buffer whose contents are the range [i, j), with
+  ///        the cursor at the end, allocating through alloc
+  /// @note \b Complexity: O(std::distance(i, j))
+  template<class InputIterator>
+  gap_buffer(InputIterator const & i, InputIterator const & j,
+             allocator_type const & alloc);
+
   /// Retrieve the first element of the gap_buffer
   /// @note \b Complexity: O(1)
   reference       front();
@@ -215,31 +544,59 @@ public:
   /// @note \b Complexity: O(1)
   const_reference front() const;
 
+  /// Retrieve the element at index i
+  /// @note \b Complexity: O(1) if TContainer has random access iterators,
+  ///       otherwise O(i)
+  reference       operator[](size_type i);
+  /// Retrieve the element at index i
+  /// @note \b Complexity: O(1) if TContainer has random access iterators,
+  ///       otherwise O(i)
+  const_reference operator[](size_type i) const;
+
+  /// Retrieve the element at index i, throwing std::out_of_range if there is
+  /// no such element
+  /// @note \b Complexity: The same as operator[]
+  reference       at(size_type i);
+  /// Retrieve the element at index i, throwing std::out_of_range if there is
+  /// no such element
+  /// @note \b Complexity: The same as operator[]
+  const_reference at(size_type i) const;
+
   /// Insert element immediately following position.  If position is at or
-  /// before the cursor, advance the cursor one position.
-  /// @note \b Complexity: O(n)
+  /// before the cursor, advance the cursor one position.  The cursor is not
+  /// resolved, so no data moves between the halves.
+  /// @note \b Complexity: The same as TContainer::insert, which is at most O(n)
   iterator insert(iterator position, const_reference element);
 
+  /// Insert element immediately following position by moving it, as the
+  /// insert above does.  This also inserts elements which cannot be copied.
+  /// @note \b Complexity: The same as TContainer::insert, which is at most O(n)
+  iterator insert(iterator position, BOOST_RV_REF(value_type) element);
+
   /// Insert n copies of element immediately following position.  If position
-  /// is at or before the cursor, advance the cursor n positions.
-  /// @note \b Complexity: O(n)
+  /// is at or before the cursor, advance the cursor n positions.  The cursor is
+  /// not resolved, so no data moves between the halves.
+  /// @note \b Complexity: The same as TContainer::insert, which is at most O(n)
   void insert(iterator position, size_type n, const_reference element);
 
   /// Insert the range of elements [i,j) immediately following position. If
-  /// position is at or before the cursor, advance the cursor n positions.
-  /// @note \b Complexity: O(n)
+  /// position is at or before the cursor, advance the cursor n positions.  The
+  /// cursor is not resolved, so no data moves between the halves.
+  /// @note \b Complexity: The same as TContainer::insert, which is at most O(n)
   template<class InputIterator>
   void insert(iterator position, 
 	      InputIterator const & i, InputIterator const & j);
 
-  /// Erase the element at position.  If the cursor was at position, move it to
-  /// one spot earlier, unless *this is empty.
-  /// @note \b Complexity: O(n)
+  /// Erase the element at position.  If position was before the cursor, move
+  /// the cursor one spot earlier.  The cursor is not resolved, so no data moves
+  /// between the halves.
+  /// @note \b Complexity: The same as TContainer::erase, which is at most O(n)
   iterator erase(iterator position);
 
   /// Erase the elements in [start,end).  If the cursor was within this range,
-  /// move it to immediately before the range, unless *this is now empty.
-  /// @note \b Complexity: O(n)
+  /// move it to immediately before the range.  The cursor is not resolved, so
+  /// no data moves between the halves.
+  /// @note \b Complexity: The same as TContainer::erase, which is at most O(n)
   iterator erase(iterator start, iterator end);
 
   /// Remove all the elements in this and move the cursor to the beginning
@@ -274,13 +631,18 @@ public:
   /// @brief Remove data from this position.
   /// @details A positive value erases the given number of values from ahead of
   /// the cursor.  A negative value erases the absolute value of the given
-  /// number of cursors from behind the cursor.
-  /// @note \b Complexity: O(abs(dist))
+  /// number of cursors from behind the cursor.  The elements are erased from
+  /// whichever half they lie in, so no data moves between the halves.
+  /// @note \b Complexity: The same as TContainer::erase, which is at most O(n)
   void erase(difference_type const dist);
 
-  /// Insert an element at the cursor
+  /// Insert a copy of element at the cursor
   /// @note \b Complexity: O(1)
-  size_type insert(value_type const);
+  size_type insert(value_type const & element);
+
+  /// Insert element at the cursor by moving it
+  /// @note \b Complexity: O(1)
+  size_type insert(BOOST_RV_REF(value_type) element);
 
   /// @brief Insert a range of elements at the cursor
   /// @param range Any range of elements Boost.Range recognizes as a Single Pass
@@ -290,18 +652,168 @@ public:
   size_type insert(TSinglePassRange const & range);
   //@}
 
+  /// @name Emplacement
+  //@{
+#if !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES) && \
+    !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+  /// @brief Construct an element from args and insert it at the cursor
+  /// @details The element is constructed before anything in the buffer moves,
+  ///          so args may refer to elements of this buffer, and is then moved
+  ///          into place, which works with every TContainer.
+  /// @note \b Complexity: O(1)
+  template<class... Args>
+  size_type emplace(Args &&... args);
+
+  /// @brief Construct an element from args and insert it immediately following
+  ///        position, as insert(position, element) does
+  /// @note \b Complexity: The same as TContainer::insert, which is at most O(n)
+  template<class... Args>
+  iterator emplace(iterator position, Args &&... args);
+#else
+  // Without variadic templates, up to three arguments are forwarded
+  size_type emplace();
+  template<class A1>
+  size_type emplace(BOOST_FWD_REF(A1) a1);
+  template<class A1, class A2>
+  size_type emplace(BOOST_FWD_REF(A1) a1, BOOST_FWD_REF(A2) a2);
+  template<class A1, class A2, class A3>
+  size_type emplace(BOOST_FWD_REF(A1) a1, BOOST_FWD_REF(A2) a2,
+                    BOOST_FWD_REF(A3) a3);
+  iterator emplace(iterator position);
+  template<class A1>
+  iterator emplace(iterator position, BOOST_FWD_REF(A1) a1);
+  template<class A1, class A2>
+  iterator emplace(iterator position,
+                   BOOST_FWD_REF(A1) a1, BOOST_FWD_REF(A2) a2);
+  template<class A1, class A2, class A3>
+  iterator emplace(iterator position, BOOST_FWD_REF(A1) a1,
+                   BOOST_FWD_REF(A2) a2, BOOST_FWD_REF(A3) a3);
+#endif
+  //@}
+
+  /// @name Batches
+  //@{
+  /// @brief Make every edit of batch, whose positions refer to this buffer as
+  ///        it is now, leaving the cursor where batch.map() puts it
+  /// @details The buffer is rebuilt in new containers, in one pass over its
+  ///          elements, and the cursor is left on the gap.  If the observer
+  ///          is enabled, the edits are instead made one at a time, so that
+  ///          it is told about each of them.  If batch.validate() throws, the
+  ///          buffer is unchanged.
+  /// @note \b Complexity: O(n + the number of elements batch inserts), or
+  ///       O(n) per edit if the observer is enabled
+  void apply(edit_batch<value_type> const & batch);
+  //@}
+
+  /// @name Observation
+  //@{
+  /// The type of the observer told about each edit
+  typedef TObserver observer_type;
+
+  /// Access the observer of this gap_buffer
+  /// @note \b Complexity: O(1)
+  observer_type &       observer();
+  /// Access the observer of this gap_buffer
+  /// @note \b Complexity: O(1)
+  observer_type const & observer() const;
+
+  /// The type of the stats policy told what each edit costs
+  typedef TStats stats_type;
+
+  /// Access the stats policy of this gap_buffer
+  /// @note \b Complexity: O(1)
+  stats_type &       stats();
+  /// Access the stats policy of this gap_buffer
+  /// @note \b Complexity: O(1)
+  stats_type const & stats() const;
+  //@}
+
 private:
-  /// Actually move the data from one container to the other
-  void resolve_offset();
-  /// Actually move the data from one container to the other, taking an iterator
-  /// valid prior to the resolution and returning the equivalent iterator after
-  /// the resolution.
-  iterator resolve_offset(iterator i);
+  /// Actually move the data from one container to the other, on behalf of
+  /// cause
+  void resolve_offset(gap_operation cause);
+  /// Tell the stats policy about an edit.  Only calls it when TStats::enabled.
+  /// Also counts the edit, so that iterators forget the blocks they kept.
+  void edited();
+  /// Set [first, last) to the contiguous elements of buffer around index i,
+  /// and return the index of *first.  Only called when cached_blocks.
+  template<class TBuffer, class TPointer>
+  static size_type find_block(TBuffer & buffer, size_type i,
+                              TPointer & first, TPointer & last);
+  /// Tells the stats policy an operation begins, and that it ends with the
+  /// scope.  Only calls it when TStats::enabled.
+  class stats_scope;
+  /// Return the logical distance from the end of before to i, which is
+  /// negative for elements of before.  When offset is zero, only the sign of
+  /// the result is meaningful, which keeps this O(1) for the common case.
+  difference_type relative_to_gap(wide_iterator i) const;
+  /// Tell the observer about the range [first, last) which starts at index
+  /// position.  Only called when TObserver::enabled.
+  void notify_insert(size_type position,
+                     wide_iterator first, wide_iterator last);
+  void notify_erase(size_type position,
+                    wide_iterator first, wide_iterator last);
+
+  /// The wide iterators at the beginning, end and cursor
+  wide_iterator wide_begin();
+  wide_iterator wide_end();
+  wide_iterator wide_here();
+  /// Convert a public iterator to a wide one, and back
+  wide_iterator widen(iterator i);
+  wide_iterator widen(iterator i, boost::true_type);
+  wide_iterator widen(iterator i, boost::false_type);
+  iterator narrow(wide_iterator i);
+  iterator narrow(wide_iterator i, boost::true_type);
+  iterator narrow(wide_iterator i, boost::false_type);
+  /// The public iterators, for each kind
+  iterator begin(boost::true_type);
+  iterator begin(boost::false_type);
+  iterator end(boost::true_type);
+  iterator end(boost::false_type);
+  iterator here(boost::true_type);
+  iterator here(boost::false_type);
+  reverse_iterator rbegin(boost::true_type);
+  reverse_iterator rbegin(boost::false_type);
+  reverse_iterator rend(boost::true_type);
+  reverse_iterator rend(boost::false_type);
+  reverse_iterator rhere(boost::true_type);
+  reverse_iterator rhere(boost::false_type);
+
+  /// Make edits through wide iterators, as the public members do
+  wide_iterator insert_at(wide_iterator position, const_reference element);
+  wide_iterator insert_at(wide_iterator position,
+                          BOOST_RV_REF(value_type) element);
+  void insert_at(wide_iterator position, size_type n,
+                 const_reference element);
+  template<class InputIterator>
+  void insert_at(wide_iterator position,
+                 InputIterator const & i, InputIterator const & j);
+  wide_iterator erase_at(wide_iterator start, wide_iterator end);
+  /// The half an element inserted at position goes into, and where in it
+  TContainer & half_at(wide_iterator position,
+                       typename TContainer::iterator & location);
+  /// Account for the element just inserted at location, in before if
+  /// is_before, and tell the observer about it
+  wide_iterator inserted_at(typename TContainer::iterator location,
+                            bool is_before, bool moves_cursor);
+  /// Tell the observer about the element just inserted at the cursor, and
+  /// return the new position
+  size_type inserted_at_cursor();
+  /// Make the edits of batch one at a time, from last to first
+  void apply_each(edit_batch<value_type> const & batch);
+  /// Append the n elements of [first, last) to front until it holds room
+  /// more elements, and the rest to back
+  template<class TIterator>
+  static void append_split(TContainer & front, TContainer & back,
+                           size_type & room,
+                           TIterator first, TIterator last, size_type n);
 
 
   // Check our iterator's concepts
-  BOOST_CONCEPT_ASSERT((boost::Mutable_BidirectionalIterator<        iterator>));
-  BOOST_CONCEPT_ASSERT((boost::Mutable_BidirectionalIterator<reverse_iterator>));
+  BOOST_CONCEPT_ASSERT(( typename concept_detail::if_copyable<value_type,
+    boost::Mutable_BidirectionalIterator<iterator> >::type ));
+  BOOST_CONCEPT_ASSERT(( typename concept_detail::if_copyable<value_type,
+    boost::Mutable_BidirectionalIterator<reverse_iterator> >::type ));
   BOOST_CONCEPT_ASSERT((boost::BidirectionalIterator<          const_iterator>));
   BOOST_CONCEPT_ASSERT((boost::BidirectionalIterator<  const_reverse_iterator>));
 
@@ -311,30 +823,37 @@ private:
 //@{
 /// Test two gap_buffers for equality
 /// @note \b Complexity: O(n)
-template<class TCont>
-bool operator==(gap_buffer<TCont> const &, gap_buffer<TCont> const &);
+template<class TCont, class TObs, class TSt>
+bool operator==(gap_buffer<TCont, TObs, TSt> const &,
+                gap_buffer<TCont, TObs, TSt> const &);
 /// Test two gap_buffers for inequality
 /// @note \b Complexity: O(n)
-template<class TCont>
-bool operator!=(gap_buffer<TCont> const &, gap_buffer<TCont> const &);
+template<class TCont, class TObs, class TSt>
+bool operator!=(gap_buffer<TCont, TObs, TSt> const &,
+                gap_buffer<TCont, TObs, TSt> const &);
 /// Test if one gap_buffer is less than another
 /// @note \b Complexity: O(n)
-template<class TCont>
-bool operator<(gap_buffer<TCont> const &, gap_buffer<TCont> const &);
+template<class TCont, class TObs, class TSt>
+bool operator<(gap_buffer<TCont, TObs, TSt> const &,
+                gap_buffer<TCont, TObs, TSt> const &);
 /// Test if one gap_buffer is greater than another
 /// @note \b Complexity: O(n)
-template<class TCont>
-bool operator>(gap_buffer<TCont> const &, gap_buffer<TCont> const &);
+template<class TCont, class TObs, class TSt>
+bool operator>(gap_buffer<TCont, TObs, TSt> const &,
+                gap_buffer<TCont, TObs, TSt> const &);
 /// Test if one gap_buffer is less than or equal to another
 /// @note \b Complexity: O(n)
-template<class TCont>
-bool operator<=(gap_buffer<TCont> const &, gap_buffer<TCont> const &);
+template<class TCont, class TObs, class TSt>
+bool operator<=(gap_buffer<TCont, TObs, TSt> const &,
+                gap_buffer<TCont, TObs, TSt> const &);
 /// Test if one gap_buffer is greater than or equal to another
 /// @note \b Complexity: O(n)
-template<class TCont>
-bool operator>=(gap_buffer<TCont> const &, gap_buffer<TCont> const &);
+template<class TCont, class TObs, class TSt>
+bool operator>=(gap_buffer<TCont, TObs, TSt> const &,
+                gap_buffer<TCont, TObs, TSt> const &);
 //@}
 
 
+#include "segmented_algorithms.hpp"
 #include "gap_buffer.ipp"
 #endif
@@ -29,282 +29,727 @@
    DEALINGS IN THE SOFTWARE.
 */
 
+#include <boost/move/iterator.hpp>
+#include <boost/next_prior.hpp>
 #include <boost/range/begin.hpp>
 #include <boost/range/end.hpp>
 
 #include <algorithm>
+#include <stdexcept>
 
 // Pull in the iterator implementation
 
 #include "gap_buffer_iterators.ipp"
 #include <iostream>
 
-template<class TContainer>
+template<class TContainer, class TObserver, class TStats>
+class gap_buffer<TContainer, TObserver, TStats>::stats_scope
+{
+public:
+  stats_scope(gap_buffer & buffer, gap_operation op)
+    : buffer(buffer)
+    , op(op)
+  {
+    if(TStats::enabled)
+      buffer.stats().on_begin(buffer, op);
+  }
+
+  // Count the edit here as well as in edited(), in case the operation threw
+  // after moving elements
+  ~stats_scope()
+  {
+    buffer.count_edit();
+    if(TStats::enabled)
+      buffer.stats().on_end(buffer, op);
+  }
+
+private:
+  gap_buffer &        buffer;
+  gap_operation const op;
+};
+
+
+template<class TContainer, class TObserver, class TStats>
 void
-gap_buffer<TContainer>::
-resolve_offset()
+gap_buffer<TContainer, TObserver, TStats>::
+resolve_offset(gap_operation const cause)
 {
   if(offset == 0)
     return;
-  else if(offset < 0){
+  stats_scope const timing(*this, gap_resolve);
+  size_type const moved = (offset < 0 ? -offset : offset);
+  if(offset < 0){
     typename TContainer::iterator start_iter = before.end();
     std::advance(start_iter, offset);
-    after.insert(after.begin(), start_iter, before.end());
-    before.erase(start_iter, before.end());
+    relocate_tail(before, start_iter, after);
   }else{
     typename TContainer::iterator end_iter = after.begin();
     std::advance(end_iter, offset);
-    before.insert(before.end(), after.begin(), end_iter);
-    after.erase(after.begin(), end_iter);
+    relocate_head(after, end_iter, before);
   }
   offset = 0;
+  if(TStats::enabled)
+    stats().on_resolve(*this, cause, moved);
 }
 
-
-template<class TContainer>
-typename gap_buffer<TContainer>::iterator
-gap_buffer<TContainer>::
-resolve_offset(typename gap_buffer<TContainer>::iterator iter)
+template<class TContainer, class TObserver, class TStats>
+void
+gap_buffer<TContainer, TObserver, TStats>::
+edited()
 {
-  if(offset == 0)
-    return iter;
-
-  typename TContainer::iterator pos_iter = iter.location;
-  bool pos_before = iter.is_before;
+  this->count_edit();
+  if(TStats::enabled)
+    stats().on_edit(*this);
+}
 
-  if(offset < 0){
-    typename TContainer::iterator start_iter = before.end();
-    difference_type const iter_dist =
-      (pos_before ? std::distance(pos_iter, start_iter) : 0);
+template<class TContainer, class TObserver, class TStats>
+template<class TBuffer, class TPointer>
+typename gap_buffer<TContainer, TObserver, TStats>::size_type
+gap_buffer<TContainer, TObserver, TStats>::
+find_block(TBuffer & buffer, size_type i, TPointer & first, TPointer & last)
+{
+  size_type const split = buffer.before.size();
+  if(i < split)
+    return indexing_traits<TContainer>::block(buffer.before, i, first, last);
+  return split + indexing_traits<TContainer>::block(buffer.after, i - split,
+                                                    first, last);
+}
 
-    std::advance(start_iter, offset);
-    after.insert(after.begin(), start_iter, before.end());
-    before.erase(start_iter, before.end());
 
-    if(pos_before && iter_dist <= offset){
-      pos_iter = after.begin();
-      pos_before = false;
-      std::advance(pos_iter, offset - iter_dist);
-    }
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::difference_type
+gap_buffer<TContainer, TObserver, TStats>::
+relative_to_gap(wide_iterator i) const
+{
+  if(offset == 0)
+    return i.is_before ? -1 : (i.location == after.begin() ? 0 : 1);
+  else if(i.is_before)
+    return -std::distance(i.location, i.before_end);
+  else
+    return std::distance(i.after_begin, i.location);
+}
 
-    offset = 0;
-  }else{
-    typename TContainer::iterator end_iter = after.begin();
-    difference_type const iter_dist =
-      (pos_before ? 0 : std::distance(end_iter, pos_iter));
 
-    std::advance(end_iter, offset);
-    before.insert(before.end(), after.begin(), end_iter);
-    after.erase(after.begin(), end_iter);
-    if(!pos_before && iter_dist < offset){
-      pos_iter = before.end();
-      pos_before = true;
-      std::advance(pos_iter, -(-offset - iter_dist));
-    }
-
-    offset = 0;
-  }
+template<class TContainer, class TObserver, class TStats>
+void
+gap_buffer<TContainer, TObserver, TStats>::
+notify_insert(size_type position, wide_iterator first, wide_iterator last)
+{
+  observer().on_insert(*this, position,
+                       const_iterator(narrow(first)),
+                       const_iterator(narrow(last)));
+}
 
-  return iterator(pos_iter, pos_before, before.end(), after.begin());
+template<class TContainer, class TObserver, class TStats>
+void
+gap_buffer<TContainer, TObserver, TStats>::
+notify_erase(size_type position, wide_iterator first, wide_iterator last)
+{
+  observer().on_erase(*this, position,
+                      const_iterator(narrow(first)),
+                      const_iterator(narrow(last)));
 }
 
 
-template<class TContainer>
+template<class TContainer, class TObserver, class TStats>
 template<class TSinglePassCharRange>
-typename gap_buffer<TContainer>::size_type
-gap_buffer<TContainer>::
+typename gap_buffer<TContainer, TObserver, TStats>::size_type
+gap_buffer<TContainer, TObserver, TStats>::
 insert(TSinglePassCharRange const & rng)
 {
+  stats_scope const timing(*this, gap_insert_range);
   // We just resolve first, since pushing onto the end of before should be about
   // as efficient as we're going to get.
-  resolve_offset();
+  resolve_offset(gap_insert_range);
+  size_type const old_size = before.size();
   before.insert(before.end(), boost::begin(rng), boost::end(rng));
+  if(TObserver::enabled){
+    typename TContainer::iterator first = before.end();
+    std::advance(first,
+                 -static_cast<difference_type>(before.size() - old_size));
+    notify_insert(old_size,
+                  wide_iterator(first, true, before.end(), after.begin()),
+                  wide_here());
+  }
+  edited();
   return position();
 }
 
-template<class TContainer>
-typename gap_buffer<TContainer>::size_type
-gap_buffer<TContainer>::
-insert(value_type const c)
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::size_type
+gap_buffer<TContainer, TObserver, TStats>::
+insert(value_type const & element)
+{
+  stats_scope const timing(*this, gap_insert);
+  // Moving the gap would move element too, if it is one of ours, so copy it
+  // out first in that case
+  if(offset != 0){
+    value_type copy(element);
+    resolve_offset(gap_insert);
+    before.insert(before.end(), boost::move(copy));
+  }else{
+    before.insert(before.end(), element);
+  }
+  return inserted_at_cursor();
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::size_type
+gap_buffer<TContainer, TObserver, TStats>::
+insert(BOOST_RV_REF(value_type) element)
 {
+  stats_scope const timing(*this, gap_insert);
   // We just resolve first, since pushing onto the end of before should be about
   // as efficient as we're going to get.
-  resolve_offset();
-  before.insert(before.end(), c);
+  resolve_offset(gap_insert);
+  before.insert(before.end(), boost::move(element));
+  return inserted_at_cursor();
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::size_type
+gap_buffer<TContainer, TObserver, TStats>::
+inserted_at_cursor()
+{
+  if(TObserver::enabled){
+    typename TContainer::iterator first = before.end();
+    --first;
+    notify_insert(before.size() - 1,
+                  wide_iterator(first, true, before.end(), after.begin()),
+                  wide_here());
+  }
+  edited();
   return position();
 }
 
 
+#if !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES) && \
+    !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+template<class TContainer, class TObserver, class TStats>
+template<class... Args>
+typename gap_buffer<TContainer, TObserver, TStats>::size_type
+gap_buffer<TContainer, TObserver, TStats>::emplace(Args &&... args)
+{
+  value_type element(boost::forward<Args>(args)...);
+  return insert(boost::move(element));
+}
+
+template<class TContainer, class TObserver, class TStats>
+template<class... Args>
+typename gap_buffer<TContainer, TObserver, TStats>::iterator
+gap_buffer<TContainer, TObserver, TStats>::
+emplace(iterator position, Args &&... args)
+{
+  value_type element(boost::forward<Args>(args)...);
+  return insert(position, boost::move(element));
+}
+#else
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::size_type
+gap_buffer<TContainer, TObserver, TStats>::emplace()
+{
+  value_type element = value_type();
+  return insert(boost::move(element));
+}
+
+template<class TContainer, class TObserver, class TStats>
+template<class A1>
+typename gap_buffer<TContainer, TObserver, TStats>::size_type
+gap_buffer<TContainer, TObserver, TStats>::emplace(BOOST_FWD_REF(A1) a1)
+{
+  value_type element(boost::forward<A1>(a1));
+  return insert(boost::move(element));
+}
+
+template<class TContainer, class TObserver, class TStats>
+template<class A1, class A2>
+typename gap_buffer<TContainer, TObserver, TStats>::size_type
+gap_buffer<TContainer, TObserver, TStats>::
+emplace(BOOST_FWD_REF(A1) a1,
+        BOOST_FWD_REF(A2) a2)
+{
+  value_type element(boost::forward<A1>(a1), boost::forward<A2>(a2));
+  return insert(boost::move(element));
+}
+
+template<class TContainer, class TObserver, class TStats>
+template<class A1, class A2, class A3>
+typename gap_buffer<TContainer, TObserver, TStats>::size_type
+gap_buffer<TContainer, TObserver, TStats>::
+emplace(BOOST_FWD_REF(A1) a1,
+        BOOST_FWD_REF(A2) a2,
+        BOOST_FWD_REF(A3) a3)
+{
+  value_type element(boost::forward<A1>(a1), boost::forward<A2>(a2),
+                     boost::forward<A3>(a3));
+  return insert(boost::move(element));
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::iterator
+gap_buffer<TContainer, TObserver, TStats>::emplace(iterator position)
+{
+  value_type element = value_type();
+  return insert(position, boost::move(element));
+}
+
+template<class TContainer, class TObserver, class TStats>
+template<class A1>
+typename gap_buffer<TContainer, TObserver, TStats>::iterator
+gap_buffer<TContainer, TObserver, TStats>::
+emplace(iterator position,
+        BOOST_FWD_REF(A1) a1)
+{
+  value_type element(boost::forward<A1>(a1));
+  return insert(position, boost::move(element));
+}
+
+template<class TContainer, class TObserver, class TStats>
+template<class A1, class A2>
+typename gap_buffer<TContainer, TObserver, TStats>::iterator
+gap_buffer<TContainer, TObserver, TStats>::
+emplace(iterator position,
+        BOOST_FWD_REF(A1) a1,
+        BOOST_FWD_REF(A2) a2)
+{
+  value_type element(boost::forward<A1>(a1), boost::forward<A2>(a2));
+  return insert(position, boost::move(element));
+}
 
-template<class TContainer>
-typename gap_buffer<TContainer>::size_type
-gap_buffer<TContainer>::
+template<class TContainer, class TObserver, class TStats>
+template<class A1, class A2, class A3>
+typename gap_buffer<TContainer, TObserver, TStats>::iterator
+gap_buffer<TContainer, TObserver, TStats>::
+emplace(iterator position,
+        BOOST_FWD_REF(A1) a1,
+        BOOST_FWD_REF(A2) a2,
+        BOOST_FWD_REF(A3) a3)
+{
+  value_type element(boost::forward<A1>(a1), boost::forward<A2>(a2),
+                     boost::forward<A3>(a3));
+  return insert(position, boost::move(element));
+}
+#endif
+
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::size_type
+gap_buffer<TContainer, TObserver, TStats>::
 position() const
 {
   return before.size() + offset;
 }
 
-template<class TContainer>
-typename gap_buffer<TContainer>::size_type
-gap_buffer<TContainer>::
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::size_type
+gap_buffer<TContainer, TObserver, TStats>::
 size() const
 {
   return before.size() + after.size();
 }
 
-template<class TContainer>
-typename gap_buffer<TContainer>::size_type
-gap_buffer<TContainer>::
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::size_type
+gap_buffer<TContainer, TObserver, TStats>::
 max_size() const
 {
   return std::min(before.max_size(), after.max_size());
 }
 
-template<class TContainer>
+template<class TContainer, class TObserver, class TStats>
 bool
-gap_buffer<TContainer>::
+gap_buffer<TContainer, TObserver, TStats>::
 empty() const
 {
   return before.empty() && after.empty();
 }
 
-template<class TContainer>
+template<class TContainer, class TObserver, class TStats>
+buffer_memory
+gap_buffer<TContainer, TObserver, TStats>::
+memory_usage() const
+{
+  buffer_memory const rtn = {
+    size() * sizeof(value_type),
+    storage_traits<TContainer>::footprint(before),
+    storage_traits<TContainer>::footprint(after)
+  };
+  return rtn;
+}
+
+template<class TContainer, class TObserver, class TStats>
 void
-gap_buffer<TContainer>::
-swap(gap_buffer<TContainer> & other)
+gap_buffer<TContainer, TObserver, TStats>::
+swap(gap_buffer<TContainer, TObserver, TStats> & other)
 {
+  using std::swap;
+  swap(observer(), other.observer());
   other.before.swap(before);
   other.after.swap(after);
   std::swap(offset, other.offset);
+  edited();
+  other.edited();
 }
 
+template<class TContainer, class TObserver, class TStats>
+void
+gap_buffer<TContainer, TObserver, TStats>::
+swap_halves(TContainer & front, TContainer & back)
+{
+  before.swap(front);
+  after.swap(back);
+  offset = 0;
+  if(TObserver::enabled)
+    observer().on_reset(*this);
+  edited();
+}
+
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::allocator_type
+gap_buffer<TContainer, TObserver, TStats>::
+get_allocator() const
+{
+  return before.get_allocator();
+}
+
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::const_segment_list
+gap_buffer<TContainer, TObserver, TStats>::
+segments() const
+{
+  const_segment_list const rtn = {{
+      boost::make_iterator_range(before.begin(), before.end()),
+      boost::make_iterator_range(after.begin(), after.end())
+    }};
+  return rtn;
+}
+
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::observer_type &
+gap_buffer<TContainer, TObserver, TStats>::
+observer()
+{
+  return *this;
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::observer_type const &
+gap_buffer<TContainer, TObserver, TStats>::
+observer() const
+{
+  return *this;
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::stats_type &
+gap_buffer<TContainer, TObserver, TStats>::
+stats()
+{
+  return *this;
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::stats_type const &
+gap_buffer<TContainer, TObserver, TStats>::
+stats() const
+{
+  return *this;
+}
 
-template<class TContainer>
+
+template<class TContainer, class TObserver, class TStats>
 void
-gap_buffer<TContainer>::
-advance(typename gap_buffer<TContainer>::difference_type const d)
+gap_buffer<TContainer, TObserver, TStats>::
+advance(difference_type const d)
 {
   offset += d;
+  if(TObserver::enabled)
+    observer().on_advance(*this, d);
 }
 
 
-template<class TContainer>
+template<class TContainer, class TObserver, class TStats>
 void
-gap_buffer<TContainer>::
-erase(typename gap_buffer<TContainer>::difference_type const d)
+gap_buffer<TContainer, TObserver, TStats>::
+erase(difference_type const d)
 {
   if(d == 0)
     return;
+  stats_scope const timing(*this, gap_erase);
 
-  if( (offset <= 0) && (d < 0) ){ // C
-    after.insert(after.begin(), before.end() + offset, before.end());
-    before.erase(before.end() + (d + offset),
-                 before.end());
-  }else if( (offset >= 0) && (d > 0) ){ // F
-    before.insert(before.end(), after.begin(), after.begin() + offset);
-    after.erase(after.begin(), after.begin() + offset + d);
-  }else if( (offset < 0) && (d > 0) && (-offset <= d) ){ // B
-    before.erase(before.end() + offset, before.end());
-    after.erase(after.begin(), after.begin() + (offset + d));
-  }else if( (offset > 0) && (d < 0) && (offset <= -d) ){ // E
-    before.erase(before.end() + offset + d, before.end());
-    after.erase(after.begin(), after.begin() + offset);
-  }else if( (offset <= 0) && (d > 0) && (-offset > d) ){ // A
-    after.insert(after.begin(), before.end() + offset + d, before.end());
-    before.erase(before.end() + offset, before.end());
-  }else if( (offset > 0) && (d < 0) && (offset > -d) ){ // D
-    before.insert(before.end(), after.begin(), after.begin() + offset + d);
-    after.erase(after.begin(), after.begin() + offset);
+  if(TObserver::enabled){
+    wide_iterator first = wide_here(), last = first;
+    std::advance(d < 0 ? first : last, d);
+    notify_erase(position() + std::min<difference_type>(d, 0), first, last);
   }
-  offset = 0;
+
+  // The doomed range, relative to the end of before
+  difference_type const first = (d < 0 ? offset + d : offset);
+  difference_type const last  = (d < 0 ? offset     : offset + d);
+
+  difference_type erased_from_before = 0;
+  if(first < 0){
+    typename TContainer::iterator start = before.end(), finish = before.end();
+    std::advance(start, first);
+    std::advance(finish, std::min<difference_type>(last, 0));
+    erased_from_before = std::min<difference_type>(last, 0) - first;
+    before.erase(start, finish);
+  }
+  if(last > 0){
+    typename TContainer::iterator start = after.begin(), finish = after.begin();
+    std::advance(start, std::max<difference_type>(first, 0));
+    std::advance(finish, last);
+    after.erase(start, finish);
+  }
+
+  // Erasing behind the cursor pulls it back, and shrinking before pulls the
+  // gap back.  Keep the cursor where it logically belongs.
+  offset += std::min<difference_type>(d, 0) + erased_from_before;
+  edited();
 }
 
-template<class TContainer>
-typename gap_buffer<TContainer>::iterator
-gap_buffer<TContainer>::
-here()
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::wide_iterator
+gap_buffer<TContainer, TObserver, TStats>::
+wide_here()
 {
-  iterator rtn(after.begin(), false, before.end(), after.begin());
+  wide_iterator rtn(after.begin(), false, before.end(), after.begin());
   std::advance(rtn, offset);
   return rtn;
 }
 
-template<class TContainer>
-typename gap_buffer<TContainer>::const_iterator
-gap_buffer<TContainer>::
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::wide_iterator
+gap_buffer<TContainer, TObserver, TStats>::
+wide_begin()
+{
+  if(before.empty())
+    return wide_iterator(after.begin(), false, before.end(), after.begin());
+  else
+    return wide_iterator(before.begin(), true, before.end(), after.begin());
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::wide_iterator
+gap_buffer<TContainer, TObserver, TStats>::
+wide_end()
+{
+  return wide_iterator(after.end(), false, before.end(), after.begin());
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::wide_iterator
+gap_buffer<TContainer, TObserver, TStats>::
+widen(iterator i)
+{
+  return widen(i, compact_iterators());
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::wide_iterator
+gap_buffer<TContainer, TObserver, TStats>::
+widen(iterator i, boost::true_type)
+{
+  size_type const split = before.size();
+  if(i.idx < split)
+    return wide_iterator(before.begin() + i.idx, true,
+                         before.end(), after.begin());
+  else
+    return wide_iterator(after.begin() + (i.idx - split), false,
+                         before.end(), after.begin());
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::wide_iterator
+gap_buffer<TContainer, TObserver, TStats>::
+widen(iterator i, boost::false_type)
+{
+  return i;
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::iterator
+gap_buffer<TContainer, TObserver, TStats>::
+narrow(wide_iterator i)
+{
+  return narrow(i, compact_iterators());
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::iterator
+gap_buffer<TContainer, TObserver, TStats>::
+narrow(wide_iterator i, boost::true_type)
+{
+  return iterator(this, i.is_before ? i.location - before.begin() :
+                  before.size() + (i.location - after.begin()));
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::iterator
+gap_buffer<TContainer, TObserver, TStats>::
+narrow(wide_iterator i, boost::false_type)
+{
+  return i;
+}
+
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::iterator
+gap_buffer<TContainer, TObserver, TStats>::
+here()
+{
+  return here(compact_iterators());
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::iterator
+gap_buffer<TContainer, TObserver, TStats>::
+here(boost::true_type)
+{
+  return iterator(this, position());
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::iterator
+gap_buffer<TContainer, TObserver, TStats>::
+here(boost::false_type)
+{
+  return wide_here();
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::const_iterator
+gap_buffer<TContainer, TObserver, TStats>::
 here() const
 {
-  const_iterator rtn(after.begin(), false, before.end(), after.begin());
-  std::advance(rtn, offset);
-  return rtn;
+  return const_cast<gap_buffer<TContainer, TObserver, TStats>&>(*this).here();
 }
 
 
-template<class TContainer>
-typename gap_buffer<TContainer>::reverse_iterator
-gap_buffer<TContainer>::
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::reverse_iterator
+gap_buffer<TContainer, TObserver, TStats>::
 rhere()
 {
-  reverse_iterator rtn = after.empty() ?
-    reverse_iterator(before.rbegin(), false,
-                     after.rend(), before.rbegin()) :
-    reverse_iterator(after.rend()-1, true,
-                     after.rend(), before.rbegin());
+  return rhere(compact_iterators());
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::reverse_iterator
+gap_buffer<TContainer, TObserver, TStats>::
+rhere(boost::true_type)
+{
+  return reverse_iterator(here());
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::reverse_iterator
+gap_buffer<TContainer, TObserver, TStats>::
+rhere(boost::false_type)
+{
+  // Like reverse_iterator(here()), this names the element before the cursor
+  reverse_iterator rtn(before.rbegin(), false, after.rend(), before.rbegin());
   std::advance(rtn, -offset);
   return rtn;
 }
 
-template<class TContainer>
-typename gap_buffer<TContainer>::const_reverse_iterator
-gap_buffer<TContainer>::
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::const_reverse_iterator
+gap_buffer<TContainer, TObserver, TStats>::
 rhere() const
 {
-  return const_cast<gap_buffer<TContainer>&>(*this).rhere();
+  return const_cast<gap_buffer<TContainer, TObserver, TStats>&>(*this).rhere();
 }
 
 
-template<class TContainer>
-typename gap_buffer<TContainer>::iterator
-gap_buffer<TContainer>::
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::iterator
+gap_buffer<TContainer, TObserver, TStats>::
 begin()
 {
-  if(before.empty())
-    return iterator(after.begin(), false, before.end(), after.begin());
-  else
-    return iterator(before.begin(), true, before.end(), after.begin());
+  return begin(compact_iterators());
 }
 
-template<class TContainer>
-typename gap_buffer<TContainer>::const_iterator
-gap_buffer<TContainer>::
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::iterator
+gap_buffer<TContainer, TObserver, TStats>::
+begin(boost::true_type)
+{
+  return iterator(this, 0);
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::iterator
+gap_buffer<TContainer, TObserver, TStats>::
+begin(boost::false_type)
+{
+  return wide_begin();
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::const_iterator
+gap_buffer<TContainer, TObserver, TStats>::
 begin() const
 {
-  return const_cast<gap_buffer<TContainer>& >(*this).begin();
+  return const_cast<gap_buffer<TContainer, TObserver, TStats>& >(*this).begin();
 }
 
-template<class TContainer>
-typename gap_buffer<TContainer>::iterator
-gap_buffer<TContainer>::
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::iterator
+gap_buffer<TContainer, TObserver, TStats>::
 end()
 {
-  return iterator(after.end(), false, before.end(), after.begin());
+  return end(compact_iterators());
 }
 
-template<class TContainer>
-typename gap_buffer<TContainer>::const_iterator
-gap_buffer<TContainer>::
-end() const
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::iterator
+gap_buffer<TContainer, TObserver, TStats>::
+end(boost::true_type)
 {
-  return const_cast<gap_buffer<TContainer>& >(*this).end();
+  return iterator(this, size());
 }
 
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::iterator
+gap_buffer<TContainer, TObserver, TStats>::
+end(boost::false_type)
+{
+  return wide_end();
+}
 
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::const_iterator
+gap_buffer<TContainer, TObserver, TStats>::
+end() const
+{
+  return const_cast<gap_buffer<TContainer, TObserver, TStats>& >(*this).end();
+}
 
 
-template<class TContainer>
-typename gap_buffer<TContainer>::reverse_iterator
-gap_buffer<TContainer>::
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::reverse_iterator
+gap_buffer<TContainer, TObserver, TStats>::
 rbegin()
+{
+  return rbegin(compact_iterators());
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::reverse_iterator
+gap_buffer<TContainer, TObserver, TStats>::
+rbegin(boost::true_type)
+{
+  return reverse_iterator(end());
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::reverse_iterator
+gap_buffer<TContainer, TObserver, TStats>::
+rbegin(boost::false_type)
 {
   if(after.empty())
     return reverse_iterator(before.rbegin(), false, 
@@ -314,174 +759,427 @@ rbegin()
 			    after.rend(), before.rbegin());
 }
 
-template<class TContainer>
-typename gap_buffer<TContainer>::const_reverse_iterator
-gap_buffer<TContainer>::
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::const_reverse_iterator
+gap_buffer<TContainer, TObserver, TStats>::
 rbegin() const
 {
-  return const_cast<gap_buffer<TContainer>&>(*this).rbegin();
+  return const_cast<gap_buffer<TContainer, TObserver, TStats>&>(*this).rbegin();
 }
 
-template<class TContainer>
-typename gap_buffer<TContainer>::reverse_iterator
-gap_buffer<TContainer>::
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::reverse_iterator
+gap_buffer<TContainer, TObserver, TStats>::
 rend()
+{
+  return rend(compact_iterators());
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::reverse_iterator
+gap_buffer<TContainer, TObserver, TStats>::
+rend(boost::true_type)
+{
+  return reverse_iterator(begin());
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::reverse_iterator
+gap_buffer<TContainer, TObserver, TStats>::
+rend(boost::false_type)
 {
   return reverse_iterator(before.rend(), false, after.rend(), before.rbegin());
 }
 
-template<class TContainer>
-typename gap_buffer<TContainer>::const_reverse_iterator
-gap_buffer<TContainer>::
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::const_reverse_iterator
+gap_buffer<TContainer, TObserver, TStats>::
 rend() const
 {
-  return const_reverse_iterator(before.rend(), false, after.rend(), 
-				before.rbegin());
+  return const_cast<gap_buffer<TContainer, TObserver, TStats>&>(*this).rend();
 }
 
 
-template<class TContainer>
-gap_buffer<TContainer>::gap_buffer()
+template<class TContainer, class TObserver, class TStats>
+gap_buffer<TContainer, TObserver, TStats>::gap_buffer()
   : offset(0)
 {}
 
-template<class TContainer>
-gap_buffer<TContainer>::gap_buffer(gap_buffer const & other)
-  : before(other.before)
+template<class TContainer, class TObserver, class TStats>
+gap_buffer<TContainer, TObserver, TStats>::gap_buffer(gap_buffer const & other)
+  : TObserver(other.observer())
+  , before(other.before)
   , after(other.after)
   , offset(other.offset)
-{}
+{
+  edited();
+}
 
-template<class TContainer>
-gap_buffer<TContainer>::gap_buffer(BOOST_RV_REF(gap_buffer) other)
-  : before( ::boost::move(other.before) )
+template<class TContainer, class TObserver, class TStats>
+gap_buffer<TContainer, TObserver, TStats>::
+gap_buffer(BOOST_RV_REF(gap_buffer) other)
+  : TObserver( ::boost::move(other.observer()) )
+  , before( ::boost::move(other.before) )
   , after( ::boost::move(other.after) )
   , offset(other.offset)
-{}
+{
+  edited();
+}
 
-template<class TContainer>
-gap_buffer<TContainer> &
-gap_buffer<TContainer>::operator=(BOOST_COPY_ASSIGN_REF(gap_buffer) other)
+template<class TContainer, class TObserver, class TStats>
+gap_buffer<TContainer, TObserver, TStats> &
+gap_buffer<TContainer, TObserver, TStats>::
+operator=(BOOST_COPY_ASSIGN_REF(gap_buffer) other)
 {
+  observer() = other.observer();
   before = other.before;
   after = other.after;
   offset = other.offset;
+  edited();
   return *this;
 }
 
-template<class TContainer>
-gap_buffer<TContainer> &
-gap_buffer<TContainer>::operator=(BOOST_RV_REF(gap_buffer) other)
+template<class TContainer, class TObserver, class TStats>
+gap_buffer<TContainer, TObserver, TStats> &
+gap_buffer<TContainer, TObserver, TStats>::
+operator=(BOOST_RV_REF(gap_buffer) other)
 {
+  observer() = ::boost::move(other.observer());
   before = ::boost::move(other.before);
   after = ::boost::move(other.after);
   offset = other.offset;
+  edited();
   return *this;
 }
 
 
-template<class TContainer>
-gap_buffer<TContainer>::gap_buffer(size_type n, value_type e)
+template<class TContainer, class TObserver, class TStats>
+gap_buffer<TContainer, TObserver, TStats>::gap_buffer(size_type n, value_type e)
   : before(n, e)
   , offset(0)
-{}
+{
+  if(TObserver::enabled)
+    observer().on_reset(*this);
+  edited();
+}
 
-template<class TContainer>
+template<class TContainer, class TObserver, class TStats>
 template<class InputIterator>
-gap_buffer<TContainer>::gap_buffer(InputIterator const & i,
-                                   InputIterator const & j)
+gap_buffer<TContainer, TObserver, TStats>::
+gap_buffer(InputIterator const & i,
+           InputIterator const & j)
   : before(i, j)
   , offset(0)
+{
+  if(TObserver::enabled)
+    observer().on_reset(*this);
+  edited();
+}
+
+template<class TContainer, class TObserver, class TStats>
+gap_buffer<TContainer, TObserver, TStats>::
+gap_buffer(allocator_type const & alloc)
+  : before(alloc)
+  , after(alloc)
+  , offset(0)
 {}
 
-template<class TContainer>
-typename gap_buffer<TContainer>::reference
-gap_buffer<TContainer>::front()
+template<class TContainer, class TObserver, class TStats>
+gap_buffer<TContainer, TObserver, TStats>::
+gap_buffer(gap_buffer const & other,
+           allocator_type const & alloc)
+  : TObserver(other.observer())
+  , before(other.before, alloc)
+  , after(other.after, alloc)
+  , offset(other.offset)
+{
+  edited();
+}
+
+template<class TContainer, class TObserver, class TStats>
+gap_buffer<TContainer, TObserver, TStats>::
+gap_buffer(BOOST_RV_REF(gap_buffer) other,
+           allocator_type const & alloc)
+  : TObserver( ::boost::move(other.observer()) )
+  , before( ::boost::move(other.before), alloc )
+  , after( ::boost::move(other.after), alloc )
+  , offset(other.offset)
+{
+  edited();
+}
+
+template<class TContainer, class TObserver, class TStats>
+gap_buffer<TContainer, TObserver, TStats>::
+gap_buffer(size_type n, value_type e,
+           allocator_type const & alloc)
+  : before(n, e, alloc)
+  , after(alloc)
+  , offset(0)
+{
+  if(TObserver::enabled)
+    observer().on_reset(*this);
+  edited();
+}
+
+template<class TContainer, class TObserver, class TStats>
+template<class InputIterator>
+gap_buffer<TContainer, TObserver, TStats>::
+gap_buffer(InputIterator const & i,
+           InputIterator const & j,
+           allocator_type const & alloc)
+  : before(i, j, alloc)
+  , after(alloc)
+  , offset(0)
+{
+  if(TObserver::enabled)
+    observer().on_reset(*this);
+  edited();
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::reference
+gap_buffer<TContainer, TObserver, TStats>::front()
 {
   return !before.empty() ? before.front() : after.front();
 }
 
-template<class TContainer>
-typename gap_buffer<TContainer>::const_reference
-gap_buffer<TContainer>::front() const
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::const_reference
+gap_buffer<TContainer, TObserver, TStats>::front() const
 {
   return !before.empty() ? before.front() : after.front();
 }
 
-template<class TContainer>
-typename gap_buffer<TContainer>::iterator
-gap_buffer<TContainer>::insert(iterator position, const_reference element)
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::reference
+gap_buffer<TContainer, TObserver, TStats>::operator[](size_type i)
+{
+  size_type const split = before.size();
+  return i < split ?
+    *boost::next(before.begin(), i) : *boost::next(after.begin(), i - split);
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::const_reference
+gap_buffer<TContainer, TObserver, TStats>::operator[](size_type i) const
+{
+  size_type const split = before.size();
+  return i < split ?
+    *boost::next(before.begin(), i) : *boost::next(after.begin(), i - split);
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::reference
+gap_buffer<TContainer, TObserver, TStats>::at(size_type i)
+{
+  if(i >= size())
+    throw std::out_of_range("gap_buffer::at");
+  return (*this)[i];
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::const_reference
+gap_buffer<TContainer, TObserver, TStats>::at(size_type i) const
+{
+  if(i >= size())
+    throw std::out_of_range("gap_buffer::at");
+  return (*this)[i];
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::iterator
+gap_buffer<TContainer, TObserver, TStats>::
+insert(iterator position, const_reference element)
+{
+  stats_scope const timing(*this, gap_insert_at);
+  return narrow(insert_at(widen(position), element));
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::iterator
+gap_buffer<TContainer, TObserver, TStats>::
+insert(iterator position, BOOST_RV_REF(value_type) element)
+{
+  stats_scope const timing(*this, gap_insert_at);
+  return narrow(insert_at(widen(position), boost::move(element)));
+}
+
+template<class TContainer, class TObserver, class TStats>
+void
+gap_buffer<TContainer, TObserver, TStats>::
+insert(iterator position, size_type n,
+       const_reference element)
+{
+  stats_scope const timing(*this, gap_insert_at);
+  insert_at(widen(position), n, element);
+}
+
+template<class TContainer, class TObserver, class TStats>
+template<class InputIterator>
+void
+gap_buffer<TContainer, TObserver, TStats>::
+insert(iterator position,
+       InputIterator const & i,
+       InputIterator const & j)
+{
+  stats_scope const timing(*this, gap_insert_at);
+  insert_at(widen(position), i, j);
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::iterator
+gap_buffer<TContainer, TObserver, TStats>::erase(iterator position)
+{
+  iterator end = position;
+  ++end;
+  return erase(position, end);
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::iterator
+gap_buffer<TContainer, TObserver, TStats>::erase(iterator start, iterator end)
+{
+  stats_scope const timing(*this, gap_erase_at);
+  return narrow(erase_at(widen(start), widen(end)));
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::wide_iterator
+gap_buffer<TContainer, TObserver, TStats>::
+insert_at(wide_iterator position, const_reference element)
+{
+  bool const moves_cursor = relative_to_gap(position) <= offset;
+  typename TContainer::iterator location;
+  TContainer & half = half_at(position, location);
+  return inserted_at(half.insert(location, element),
+                     &half == &before, moves_cursor);
+}
+
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::wide_iterator
+gap_buffer<TContainer, TObserver, TStats>::
+insert_at(wide_iterator position, BOOST_RV_REF(value_type) element)
+{
+  bool const moves_cursor = relative_to_gap(position) <= offset;
+  typename TContainer::iterator location;
+  TContainer & half = half_at(position, location);
+  return inserted_at(half.insert(location, boost::move(element)),
+                     &half == &before, moves_cursor);
+}
+
+template<class TContainer, class TObserver, class TStats>
+TContainer &
+gap_buffer<TContainer, TObserver, TStats>::
+half_at(wide_iterator position, typename TContainer::iterator & location)
 {
-  position = resolve_offset(position);
-  typename TContainer::iterator iter;
-  bool is_before;
   if(position.location == after.begin()){
-    before.insert(before.end(), element);
-    iter = after.begin();
-    is_before = false;
-  }else if(position.is_before){
-    iter = before.insert(position.location, element);
-    is_before = true;
-  }else{
-    iter = after.insert(position.location, element);
-    is_before = false;
+    location = before.end();
+    return before;
   }
-  return iterator(iter, is_before, before.end(), after.begin());
+  location = position.location;
+  return position.is_before ? before : after;
 }
 
-template<class TContainer>
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::wide_iterator
+gap_buffer<TContainer, TObserver, TStats>::
+inserted_at(typename TContainer::iterator location, bool is_before,
+            bool moves_cursor)
+{
+  if(is_before && !moves_cursor)
+    --offset;
+  else if(!is_before && moves_cursor)
+    ++offset;
+
+  wide_iterator const rtn(location, is_before, before.end(), after.begin());
+  if(TObserver::enabled)
+    notify_insert(std::distance(wide_begin(), rtn), rtn, boost::next(rtn));
+  edited();
+  return rtn;
+}
+
+template<class TContainer, class TObserver, class TStats>
 void 
-gap_buffer<TContainer>::insert(iterator position, size_type n,
-                               const_reference element)
+gap_buffer<TContainer, TObserver, TStats>::
+insert_at(wide_iterator position,
+          size_type n,
+          const_reference element)
 {
-  position = resolve_offset(position);
-  if(position.location == after.begin())
-    before.insert(before.end(), n, element);
+  bool const moves_cursor = relative_to_gap(position) <= offset;
+  size_type const index =
+    TObserver::enabled ? std::distance(wide_begin(), position) : 0;
+  bool const is_before =
+    position.is_before || (position.location == after.begin());
+  if(!is_before)
+    after.insert(position.location, n, element);
   else if(position.is_before)
     before.insert(position.location, n, element);
   else
-    after.insert(position.location, n, element);
+    before.insert(before.end(), n, element);
+
+  if(is_before && !moves_cursor)
+    offset -= n;
+  else if(!is_before && moves_cursor)
+    offset += n;
+
+  if(TObserver::enabled){
+    wide_iterator first = wide_begin();
+    std::advance(first, index);
+    notify_insert(index, first, boost::next(first, n));
+  }
+  edited();
 }
 
-template<class TContainer>
+template<class TContainer, class TObserver, class TStats>
 template<class InputIterator>
 void
-gap_buffer<TContainer>::insert(iterator position,
-                               InputIterator const & i, InputIterator const & j)
+gap_buffer<TContainer, TObserver, TStats>::
+insert_at(wide_iterator position,
+          InputIterator const & i,
+          InputIterator const & j)
 {
-  position = resolve_offset(position);
-  if(position.location == after.begin())
-    before.insert(before.end(), i, j);
+  bool const moves_cursor = relative_to_gap(position) <= offset;
+  size_type const index =
+    TObserver::enabled ? std::distance(wide_begin(), position) : 0;
+  bool const is_before =
+    position.is_before || (position.location == after.begin());
+  // Single pass ranges can only be measured by watching a container grow
+  TContainer & target = (is_before ? before : after);
+  size_type const old_size = target.size();
+  if(!is_before)
+    after.insert(position.location, i, j);
   else if(position.is_before)
     before.insert(position.location, i, j);
   else
-    after.insert(position.location, i, j);
-}
+    before.insert(before.end(), i, j);
+  difference_type const n = target.size() - old_size;
 
-template<class TContainer>
-typename gap_buffer<TContainer>::iterator
-gap_buffer<TContainer>::erase(iterator position)
-{
-  position = resolve_offset(position);
-  bool is_before = position.is_before;
-  TContainer & to_erase_from = (is_before ? before : after);
-  typename TContainer::iterator iter = to_erase_from.erase(position.location);
+  if(is_before && !moves_cursor)
+    offset -= n;
+  else if(!is_before && moves_cursor)
+    offset += n;
 
-  if(iter == before.end()){
-    is_before = false;
-    iter = after.begin();
+  if(TObserver::enabled){
+    wide_iterator first = wide_begin();
+    std::advance(first, index);
+    notify_insert(index, first, boost::next(first, n));
   }
-  return iterator(iter, is_before, before.end(), after.begin());
+  edited();
 }
 
-template<class TContainer>
-typename gap_buffer<TContainer>::iterator
-gap_buffer<TContainer>::erase(iterator start, iterator end)
+template<class TContainer, class TObserver, class TStats>
+typename gap_buffer<TContainer, TObserver, TStats>::wide_iterator
+gap_buffer<TContainer, TObserver, TStats>::
+erase_at(wide_iterator start,
+         wide_iterator end)
 {
-  difference_type const diff = std::distance(start, end);
-  start = resolve_offset(start);
-  end = start;
-  std::advance(end, diff);
+  if(TObserver::enabled)
+    notify_erase(std::distance(wide_begin(), start), start, end);
+
+  // Measure the range against the cursor while the iterators are still valid
+  difference_type const erased_before_cursor = (offset == 0) ? 0 :
+    std::min(relative_to_gap(end), offset) -
+    std::min(relative_to_gap(start), offset);
 
   typename TContainer::iterator
     before_begin = (start.is_before ? start.location : before.end()   ),
@@ -489,75 +1187,146 @@ gap_buffer<TContainer>::erase(iterator start, iterator end)
     after_begin  = (start.is_before ? after.begin()  : start.location ),
     after_end    = (end.is_before   ? after.begin()  : end.location   );
 
-  bool const use_after =
-    (after_end != after.begin()) || 
-    ((before_end == before.end()) && (before_begin != before.end()));
-  
+  difference_type const erased_from_before =
+    (offset == 0) ? 0 : std::distance(before_begin, before_end);
+
   typename TContainer::iterator
     before_rtn = before.erase( before_begin, before_end ),
     after_rtn  = after. erase( after_begin,  after_end  );
 
-  return iterator((use_after ? after_rtn : before_rtn), use_after, 
-		  before.end(), after.begin());
+  // When offset is zero the cursor sits on the gap and follows it for free
+  offset += erased_from_before - erased_before_cursor;
+  edited();
+
+  return end.is_before ?
+    wide_iterator(before_rtn, true, before.end(), after.begin()) :
+    wide_iterator(after_rtn, false, before.end(), after.begin());
 }
 
-template<class TContainer>
+template<class TContainer, class TObserver, class TStats>
 void
-gap_buffer<TContainer>::clear()
+gap_buffer<TContainer, TObserver, TStats>::
+apply(edit_batch<value_type> const & batch)
 {
-  before.clear();
-  after.clear();
+  size_type const old_size = size();
+  batch.validate(old_size);
+  if(TObserver::enabled){
+    apply_each(batch);
+    return;
+  }
+
+  // Move the elements between the edits, and copy the inserted ones, into
+  // fresh halves, splitting them at the new cursor, and skip the erased ones
+  typedef typename edit_batch<value_type>::edit_list edit_list;
+  edit_list const & edits = batch.edits();
+  TContainer fresh_before(before.get_allocator());
+  TContainer fresh_after(after.get_allocator());
+  size_type room = batch.map(position());
+  iterator source = begin();
+  size_type at = 0;
+  for(typename edit_list::const_iterator e = edits.begin();
+      e != edits.end(); ++e){
+    iterator const stop = boost::next(source, e->position - at);
+    append_split(fresh_before, fresh_after, room,
+                 boost::make_move_iterator(source),
+                 boost::make_move_iterator(stop), e->position - at);
+    source = boost::next(stop, e->erased);
+    at = e->position + e->erased;
+    typename edit_batch<value_type>::inserted_range const inserted =
+      batch.inserted(*e);
+    append_split(fresh_before, fresh_after, room,
+                 inserted.begin(), inserted.end(), e->inserted);
+  }
+  append_split(fresh_before, fresh_after, room,
+               boost::make_move_iterator(source),
+               boost::make_move_iterator(end()), old_size - at);
+
+  before.swap(fresh_before);
+  after.swap(fresh_after);
   offset = 0;
+  edited();
 }
 
-
-template<class TContainer>
+template<class TContainer, class TObserver, class TStats>
 void
-gap_buffer<TContainer>::resize(size_type n, value_type const & e)
+gap_buffer<TContainer, TObserver, TStats>::
+apply_each(edit_batch<value_type> const & batch)
 {
-  resolve_offset();
-  if(n <= before.size() || after.empty()){
-    after.clear();
-    before.resize(n, e);
+  // Working backwards, the positions of the edits still to be made are not
+  // disturbed by those already made
+  typedef typename edit_batch<value_type>::edit_list edit_list;
+  edit_list const & edits = batch.edits();
+  for(typename edit_list::const_reverse_iterator e = edits.rbegin();
+      e != edits.rend(); ++e){
+    iterator start = begin();
+    std::advance(start, e->position);
+    if(e->erased != 0)
+      start = erase(start, boost::next(start, e->erased));
+    typename edit_batch<value_type>::inserted_range const inserted =
+      batch.inserted(*e);
+    if(e->inserted != 0)
+      insert(start, inserted.begin(), inserted.end());
   }
-  else
-    after.resize(n - before.size());
 }
 
-#define BINARY_BUFFER_BOOL_OPER(oper)				\
-  template<class TContainer>					\
-  bool operator oper ( gap_buffer<TContainer> const & lhs,	\
-		       gap_buffer<TContainer> const & rhs)
-
-BINARY_BUFFER_BOOL_OPER( == )
+template<class TContainer, class TObserver, class TStats>
+template<class TIterator>
+void
+gap_buffer<TContainer, TObserver, TStats>::
+append_split(TContainer & front, TContainer & back, size_type & room,
+             TIterator first, TIterator last, size_type n)
 {
-  return (lhs.size() == rhs.size()) && 
-    (std::mismatch(lhs.begin(), lhs.end(), rhs.begin()).first == lhs.end());
+  size_type const head = std::min(n, room);
+  TIterator const middle = boost::next(first, head);
+  front.insert(front.end(), first, middle);
+  back.insert(back.end(), middle, last);
+  room -= head;
 }
 
-BINARY_BUFFER_BOOL_OPER( < )
+template<class TContainer, class TObserver, class TStats>
+void
+gap_buffer<TContainer, TObserver, TStats>::clear()
 {
-  return std::lexicographical_compare(lhs.begin(), lhs.end(), 
-				      rhs.begin(), rhs.end());
+  if(TObserver::enabled)
+    notify_erase(0, wide_begin(), wide_end());
+  before.clear();
+  after.clear();
+  offset = 0;
+  edited();
 }
 
-BINARY_BUFFER_BOOL_OPER( <= )
+
+template<class TContainer, class TObserver, class TStats>
+void
+gap_buffer<TContainer, TObserver, TStats>::
+resize(size_type n, value_type const & e)
 {
-  typename gap_buffer<TContainer>::const_iterator const left_end =
-    ((lhs.size() > rhs.size()) ?
-     lhs.begin() + rhs.size()  :
-     lhs.end());
+  size_type const old_size = size();
+  if(n < old_size){
+    iterator start = begin();
+    std::advance(start, n);
+    erase(start, end());
+  }else
+    insert(end(), n - old_size, e);
+}
 
-  std::pair<typename gap_buffer<TContainer>::const_iterator,
-	    typename gap_buffer<TContainer>::const_iterator> rtn =
-    std::mismatch(lhs.begin(), left_end, rhs.begin());
+#define BINARY_BUFFER_BOOL_OPER(oper)					\
+  template<class TContainer, class TObserver, class TStats>		\
+  bool operator oper (							\
+    gap_buffer<TContainer, TObserver, TStats> const & lhs,		\
+    gap_buffer<TContainer, TObserver, TStats> const & rhs)
 
-  if(rtn.first == left_end)
-    return (lhs.size() <= rhs.size());
-  else
-    return (*rtn.first < *rtn.second);
+BINARY_BUFFER_BOOL_OPER( == )
+{
+  return segmented::equal(lhs, rhs);
+}
+
+BINARY_BUFFER_BOOL_OPER( < )
+{
+  return segmented::lexicographical_compare(lhs, rhs);
 }
 
+BINARY_BUFFER_BOOL_OPER( <= ) { return !(rhs < lhs); }
 BINARY_BUFFER_BOOL_OPER( != ) { return !(lhs == rhs); }
 BINARY_BUFFER_BOOL_OPER( > )  { return  (rhs <  lhs); }
 BINARY_BUFFER_BOOL_OPER( >= ) { return  (rhs <= lhs); }
@@ -0,0 +1,814 @@
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+   Benchmarks of the buffers in this directory, against a std::string and a
+   std::vector which are edited in place, over a few workloads of an editor.
+   Build it with optimization, e.g.
+
+     g++ -O2 -DNDEBUG -o gap_buffer_bench gap_buffer_bench.cpp
+
+   and run it with --help for its options.  For each buffer and workload it
+   reports the time, the bytes of elements copied or moved, the allocations
+   and, on Linux when perf events are permitted, hardware counters, each per
+   operation.  With --csv it also writes them to a file, one row each, to
+   compare against later runs.
+*/
+
+#include "gap_buffer.hpp"
+#include "contiguous_gap_buffer.hpp"
+#include "rope_buffer.hpp"
+#include "segmented_algorithms.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <boost/config.hpp>
+#include <boost/container/deque.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/range/begin.hpp>
+#include <boost/range/end.hpp>
+#include <boost/type_traits/is_same.hpp>
+
+#include <time.h>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+// ----- ----- ------ Accounting ----- ----- -----
+
+namespace
+{
+  // Calls to the global operator new since the program began
+  boost::uint64_t allocations = 0;
+  // Bytes asked of the global operator new since the program began
+  boost::uint64_t bytes_allocated = 0;
+  // Copies and assignments of a tally since the program began
+  boost::uint64_t tally_copies = 0;
+}
+
+#if __cplusplus >= 201103L
+#define BENCH_THROWS_BAD_ALLOC
+#else
+#define BENCH_THROWS_BAD_ALLOC throw(std::bad_alloc)
+#endif
+
+// Count every allocation of the program, whichever container makes it
+void * operator new(std::size_t n) BENCH_THROWS_BAD_ALLOC
+{
+  ++allocations;
+  bytes_allocated += n;
+  if(void * const p = std::malloc(n ? n : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+// Out of line, so that the compiler does not pair free with operator new
+BOOST_NOINLINE void operator delete(void * p) BOOST_NOEXCEPT_OR_NOTHROW
+{
+  std::free(p);
+}
+
+#if defined(__cpp_sized_deallocation)
+BOOST_NOINLINE void operator delete(void * p, std::size_t) BOOST_NOEXCEPT
+{
+  std::free(p);
+}
+#endif
+
+/**
+   @brief A character which counts its copies
+   @details
+   Every workload is run a second time, untimed, on buffers of tally, to count
+   the bytes each buffer copies or moves, including the copy of each inserted
+   element into place.  A tally is the size of a char, but is not trivially
+   copyable, so buffers relocate it with the same range inserts they use for
+   char, one element at a time rather than by memmove.
+*/
+struct tally
+{
+  tally(char c = 0)
+    : c(c)
+  {}
+
+  tally(tally const & other)
+    : c(other.c)
+  {
+    ++tally_copies;
+  }
+
+  tally & operator=(tally const & other)
+  {
+    c = other.c;
+    ++tally_copies;
+    return *this;
+  }
+
+  operator char() const
+  {
+    return c;
+  }
+
+  char c;
+};
+
+/**
+   @brief The hardware counters of the CPU, for the calling thread
+   @details
+   On Linux each counter is a perf event, which the kernel may refuse to open,
+   for example when perf_event_paranoid forbids it or under a hypervisor that
+   does not expose the counters.  Counters which could not be opened are
+   reported as unavailable, and elsewhere none are.
+*/
+class hardware_counters
+  : boost::noncopyable
+{
+public:
+  enum event { cycles, instructions, cache_misses, branch_misses, event_count };
+
+  hardware_counters();
+  ~hardware_counters();
+
+  /// Reset the counters to zero and start counting
+  void start();
+  /// Stop counting, keeping the counts since start()
+  void stop();
+
+  /// If e was counted between the last start() and stop()
+  bool available(event e) const;
+  /// The count of e between the last start() and stop()
+  boost::uint64_t value(event e) const;
+
+private:
+  // The perf event of each counter, or -1
+  int fds[event_count];
+  // The count of each counter, if it could be read
+  boost::uint64_t values[event_count];
+  // If the count of each counter could be read
+  bool counted[event_count];
+};
+
+hardware_counters::hardware_counters()
+{
+#if defined(__linux__)
+  static boost::uint64_t const configs[event_count] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES
+  };
+#endif
+  for(int e = 0; e != event_count; ++e){
+    values[e] = 0;
+    counted[e] = false;
+#if defined(__linux__)
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = configs[e];
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fds[e] = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1,
+                                      0));
+#else
+    fds[e] = -1;
+#endif
+  }
+}
+
+hardware_counters::~hardware_counters()
+{
+#if defined(__linux__)
+  for(int e = 0; e != event_count; ++e)
+    if(fds[e] != -1)
+      close(fds[e]);
+#endif
+}
+
+void hardware_counters::start()
+{
+#if defined(__linux__)
+  for(int e = 0; e != event_count; ++e)
+    if(fds[e] != -1){
+      ioctl(fds[e], PERF_EVENT_IOC_RESET, 0);
+      ioctl(fds[e], PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+void hardware_counters::stop()
+{
+  for(int e = 0; e != event_count; ++e){
+    counted[e] = false;
+#if defined(__linux__)
+    if(fds[e] != -1){
+      ioctl(fds[e], PERF_EVENT_IOC_DISABLE, 0);
+      counted[e] = read(fds[e], &values[e], sizeof(values[e])) ==
+        static_cast<ssize_t>(sizeof(values[e]));
+    }
+#endif
+  }
+}
+
+bool hardware_counters::available(event e) const
+{
+  return counted[e];
+}
+
+boost::uint64_t hardware_counters::value(event e) const
+{
+  return values[e];
+}
+
+// Return the time of a monotonic clock, in seconds
+double now()
+{
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+
+// ----- ----- ------ Buffers ----- ----- -----
+
+/**
+   A sequence with a cursor but no gap, as an editor without a gap buffer would
+   keep its text: every edit shifts all of the elements after it.
+*/
+template<class TSequence>
+struct naive_buffer
+{
+  typedef typename TSequence::value_type     value_type;
+  typedef typename TSequence::const_iterator const_iterator;
+
+  template<class InputIterator>
+  naive_buffer(InputIterator i, InputIterator j)
+    : elements(i, j)
+    , cursor(0)
+  {}
+
+  std::size_t size() const
+  {
+    return elements.size();
+  }
+
+  std::size_t position() const
+  {
+    return cursor;
+  }
+
+  const_iterator begin() const
+  {
+    return elements.begin();
+  }
+
+  const_iterator end() const
+  {
+    return elements.end();
+  }
+
+  void advance(std::ptrdiff_t dist)
+  {
+    cursor += dist;
+  }
+
+  std::size_t insert(value_type const & element)
+  {
+    elements.insert(elements.begin() + cursor, element);
+    return ++cursor;
+  }
+
+  template<class TRange>
+  std::size_t insert(TRange const & range)
+  {
+    elements.insert(elements.begin() + cursor,
+                    boost::begin(range), boost::end(range));
+    cursor += boost::end(range) - boost::begin(range);
+    return cursor;
+  }
+
+  void erase(std::ptrdiff_t dist)
+  {
+    if(dist < 0){
+      elements.erase(elements.begin() + (cursor + dist),
+                     elements.begin() + cursor);
+      cursor += dist;
+    }else{
+      elements.erase(elements.begin() + cursor,
+                     elements.begin() + (cursor + dist));
+    }
+  }
+
+  TSequence   elements;
+  std::size_t cursor;
+};
+
+// Each backend names the buffer which holds elements of type T
+
+template<class T>
+struct on_std_deque
+{
+  typedef gap_buffer<std::deque<T> > type;
+};
+
+template<class T>
+struct on_boost_deque
+{
+  typedef gap_buffer<boost::container::deque<T> > type;
+};
+
+template<class T>
+struct on_std_list
+{
+  typedef gap_buffer<std::list<T> > type;
+};
+
+template<class T>
+struct on_std_vector
+{
+  typedef gap_buffer<std::vector<T> > type;
+};
+
+template<class T>
+struct contiguous
+{
+  typedef contiguous_gap_buffer<T> type;
+};
+
+template<class T>
+struct rope
+{
+  typedef rope_buffer<T> type;
+};
+
+// A std::string can only hold characters, so its moves are not counted
+template<class T>
+struct naive_string
+{
+  typedef naive_buffer<std::string> type;
+};
+
+template<class T>
+struct naive_vector
+{
+  typedef naive_buffer<std::vector<T> > type;
+};
+
+// Return the index of the first needle in buffer, or its size
+template<class TBuffer>
+std::size_t find_text(TBuffer const & buffer, std::string const & needle)
+{
+  return segmented::search(buffer, needle);
+}
+
+template<class TSequence>
+std::size_t find_text(naive_buffer<TSequence> const & buffer,
+                      std::string const & needle)
+{
+  return std::search(buffer.begin(), buffer.end(),
+                     needle.begin(), needle.end()) - buffer.begin();
+}
+
+std::size_t find_text(naive_buffer<std::string> const & buffer,
+                      std::string const & needle)
+{
+  std::size_t const i = buffer.elements.find(needle);
+  return i == std::string::npos ? buffer.size() : i;
+}
+
+
+// ----- ----- ------ Workloads ----- ----- -----
+
+enum workload { typing, random_jumps, large_pastes, search, iteration,
+                workload_count };
+
+char const * const workload_names[workload_count] = {
+  "typing", "random_jumps", "large_pastes", "search", "iteration"
+};
+
+/**
+   @brief Everything a workload does, decided before any buffer runs it, so
+          that every buffer does exactly the same thing
+*/
+struct script
+{
+  // The text each buffer starts with
+  std::string                  document;
+  // The text of each paste
+  std::string                  clipboard;
+  // The text searched for, which the document is unlikely to contain
+  std::string                  needle;
+  // How many times the operation of the workload is done
+  std::size_t                  ops;
+  // A random number for each operation
+  std::vector<boost::uint32_t> random;
+};
+
+// Return a script of ops operations on a random document of size characters
+script make_script(std::size_t size, std::size_t ops,
+                   boost::random::mt19937 & rng)
+{
+  script s;
+  s.document.reserve(size);
+  for(std::size_t i = 0; i != size; ++i){
+    boost::uint32_t const r = rng();
+    s.document += (r % 60 == 0) ? '\n' :
+      (r % 6 == 0) ? ' ' : static_cast<char>('a' + (r >> 8) % 26);
+  }
+  for(std::size_t i = 0; i != 64 * 1024; ++i)
+    s.clipboard += static_cast<char>('A' + rng() % 26);
+  s.needle = "qzxjv jvzqx";
+  s.ops = ops;
+  for(std::size_t i = 0; i != ops; ++i)
+    s.random.push_back(static_cast<boost::uint32_t>(rng()));
+  return s;
+}
+
+// Move the cursor of buffer to index i
+template<class TBuffer>
+void jump(TBuffer & buffer, std::size_t i)
+{
+  buffer.advance(static_cast<std::ptrdiff_t>(i) -
+                 static_cast<std::ptrdiff_t>(buffer.position()));
+}
+
+// Move the cursor of buffer to its middle, and settle the gap there
+template<class TBuffer>
+void prepare(TBuffer & buffer)
+{
+  jump(buffer, buffer.size() / 2);
+  buffer.insert(typename TBuffer::value_type(' '));
+  buffer.erase(-1);
+}
+
+// Do the operations of w on buffer, pasting clipboard, and return a number
+// which depends on their results
+template<class TBuffer>
+std::size_t perform(workload w, TBuffer & buffer, script const & s,
+                    std::vector<typename TBuffer::value_type> const &
+                    clipboard)
+{
+  typedef typename TBuffer::value_type value_type;
+  TBuffer const & cbuffer = buffer;
+  std::size_t result = 0;
+  for(std::size_t i = 0; i != s.ops; ++i){
+    boost::uint32_t const r = s.random[i];
+    switch(w){
+    case typing:
+      // Keystrokes at the cursor, with a backspace in every eight, and a
+      // move to a nearby line every 64
+      if(i % 64 == 63){
+        std::size_t const line = buffer.position() + r % 161;
+        jump(buffer, std::min(line < 80 ? 0 : line - 80, buffer.size()));
+      }
+      if(i % 8 == 7){
+        if(buffer.position() != 0)
+          buffer.erase(-1);
+      }else{
+        buffer.insert(value_type(static_cast<char>('a' + r % 26)));
+      }
+      break;
+    case random_jumps:
+      // A keystroke anywhere in the buffer
+      jump(buffer, r % (buffer.size() + 1));
+      buffer.insert(value_type(static_cast<char>('a' + r % 26)));
+      break;
+    case large_pastes:
+      jump(buffer, r % (buffer.size() + 1));
+      buffer.insert(clipboard);
+      break;
+    case search:
+      result += find_text(cbuffer, s.needle);
+      break;
+    case iteration:
+      for(typename TBuffer::const_iterator j = cbuffer.begin(),
+            end = cbuffer.end(); j != end; ++j)
+        result += static_cast<unsigned char>(static_cast<char>(*j));
+      break;
+    default:
+      break;
+    }
+  }
+  return result + buffer.position();
+}
+
+// Return a hash of the elements of buffer, and of result
+template<class TBuffer>
+std::size_t checksum(TBuffer const & buffer, std::size_t result)
+{
+  std::size_t hash = 2166136261u ^ result;
+  for(typename TBuffer::const_iterator i = buffer.begin(), end = buffer.end();
+      i != end; ++i)
+    hash = (hash ^ static_cast<unsigned char>(static_cast<char>(*i))) *
+      16777619u;
+  return hash ^ buffer.size();
+}
+
+
+// ----- ----- ------ Measurement ----- ----- -----
+
+/**
+   The cost of a workload on one buffer.  Counts are totals over every
+   operation, and those that could not be measured are marked unknown.
+*/
+struct measurement
+{
+  std::string     backend;
+  workload        what;
+  std::size_t     size;
+  std::size_t     ops;
+  double          seconds;
+  boost::uint64_t allocations;
+  boost::uint64_t bytes_allocated;
+  bool            moves_known;
+  boost::uint64_t bytes_moved;
+  bool            counter_known[hardware_counters::event_count];
+  boost::uint64_t counter[hardware_counters::event_count];
+  std::size_t     checksum;
+};
+
+// Time the workload w on a TBuffer
+template<class TBuffer>
+void time_workload(workload w, script const & s, hardware_counters & counters,
+                   measurement & m)
+{
+  TBuffer buffer(s.document.begin(), s.document.end());
+  std::vector<typename TBuffer::value_type> const clipboard(
+    s.clipboard.begin(), s.clipboard.end());
+  prepare(buffer);
+  boost::uint64_t const allocations_before = allocations;
+  boost::uint64_t const bytes_before = bytes_allocated;
+  counters.start();
+  double const begun = now();
+  std::size_t const result = perform(w, buffer, s, clipboard);
+  m.seconds = now() - begun;
+  counters.stop();
+  m.allocations = allocations - allocations_before;
+  m.bytes_allocated = bytes_allocated - bytes_before;
+  for(int e = 0; e != hardware_counters::event_count; ++e){
+    hardware_counters::event const event =
+      static_cast<hardware_counters::event>(e);
+    m.counter_known[e] = counters.available(event);
+    m.counter[e] = counters.value(event);
+  }
+  m.checksum = checksum(buffer, result);
+}
+
+// Count the bytes the workload w copies or moves in a TBuffer, if it holds
+// tallies
+template<class TBuffer>
+void count_moves(workload w, script const & s, measurement & m)
+{
+  typedef typename TBuffer::value_type value_type;
+  m.moves_known = boost::is_same<value_type, tally>::value;
+  m.bytes_moved = 0;
+  if(!m.moves_known)
+    return;
+  TBuffer buffer(s.document.begin(), s.document.end());
+  std::vector<value_type> const clipboard(s.clipboard.begin(),
+                                          s.clipboard.end());
+  prepare(buffer);
+  tally_copies = 0;
+  perform(w, buffer, s, clipboard);
+  m.bytes_moved = tally_copies * sizeof(value_type);
+}
+
+/// Options given on the command line
+struct settings
+{
+  std::size_t size;
+  std::size_t ops;
+  boost::uint32_t seed;
+  std::string backend_filter;
+  std::string workload_filter;
+  std::string csv;
+};
+
+// Return how many times the operation of w is done, for ops keystrokes
+std::size_t ops_of(workload w, std::size_t ops)
+{
+  static std::size_t const divisors[workload_count] = { 1, 20, 1000, 500, 500 };
+  return std::max<std::size_t>(1, ops / divisors[w]);
+}
+
+// Measure every workload, that the settings select, on the buffers of
+// TBackend
+template<template<class> class TBackend>
+void run_backend(char const * name, settings const & options,
+                 std::vector<script> const & scripts,
+                 hardware_counters & counters,
+                 std::vector<measurement> & results)
+{
+  if(std::string(name).find(options.backend_filter) == std::string::npos)
+    return;
+  for(int i = 0; i != workload_count; ++i){
+    workload const w = static_cast<workload>(i);
+    if(std::string(workload_names[w]).find(options.workload_filter) ==
+       std::string::npos)
+      continue;
+    measurement m;
+    m.backend = name;
+    m.what = w;
+    m.size = options.size;
+    m.ops = scripts[w].ops;
+    time_workload<typename TBackend<char>::type>(w, scripts[w], counters, m);
+    count_moves<typename TBackend<tally>::type>(w, scripts[w], m);
+    results.push_back(m);
+  }
+}
+
+
+// ----- ----- ------ Reporting ----- ----- -----
+
+// Return total / ops as text, or unknown if it is not known
+std::string per_op(bool known, double total, std::size_t ops,
+                   char const * unknown = "-")
+{
+  if(!known)
+    return unknown;
+  char text[32];
+  std::sprintf(text, "%.2f", total / ops);
+  return text;
+}
+
+void print_table(std::vector<measurement> const & results)
+{
+  std::printf("%-36s %-13s %7s %12s %11s %9s %11s %11s %11s %9s %9s\n",
+              "backend", "workload", "ops", "ns/op", "moved B/op",
+              "allocs/op", "alloc B/op", "cycles/op", "instr/op",
+              "miss/op", "br miss/op");
+  for(std::size_t i = 0; i != results.size(); ++i){
+    measurement const & m = results[i];
+    std::printf("%-36s %-13s %7lu %12s %11s %9s %11s %11s %11s %9s %9s\n",
+                m.backend.c_str(), workload_names[m.what],
+                static_cast<unsigned long>(m.ops),
+                per_op(true, m.seconds * 1e9, m.ops).c_str(),
+                per_op(m.moves_known, m.bytes_moved, m.ops).c_str(),
+                per_op(true, m.allocations, m.ops).c_str(),
+                per_op(true, m.bytes_allocated, m.ops).c_str(),
+                per_op(m.counter_known[0], m.counter[0], m.ops).c_str(),
+                per_op(m.counter_known[1], m.counter[1], m.ops).c_str(),
+                per_op(m.counter_known[2], m.counter[2], m.ops).c_str(),
+                per_op(m.counter_known[3], m.counter[3], m.ops).c_str());
+  }
+}
+
+// Write results to the file at path as comma separated values, with unknown
+// values left empty
+bool write_csv(std::string const & path,
+               std::vector<measurement> const & results)
+{
+  std::ofstream out(path.c_str());
+  out << "backend,workload,size,ops,ns_per_op,bytes_moved_per_op,"
+    "allocations_per_op,bytes_allocated_per_op,cycles_per_op,"
+    "instructions_per_op,cache_misses_per_op,branch_misses_per_op\n";
+  for(std::size_t i = 0; i != results.size(); ++i){
+    measurement const & m = results[i];
+    out << m.backend << ',' << workload_names[m.what] << ',' << m.size << ','
+        << m.ops << ',' << per_op(true, m.seconds * 1e9, m.ops) << ','
+        << per_op(m.moves_known, m.bytes_moved, m.ops, "") << ','
+        << per_op(true, m.allocations, m.ops) << ','
+        << per_op(true, m.bytes_allocated, m.ops);
+    for(int e = 0; e != hardware_counters::event_count; ++e)
+      out << ',' << per_op(m.counter_known[e], m.counter[e], m.ops, "");
+    out << '\n';
+  }
+  return static_cast<bool>(out.flush());
+}
+
+void usage(char const * program)
+{
+  std::cerr <<
+    "usage: " << program << " [options]\n"
+    "  --size N         characters in the document (default 262144)\n"
+    "  --ops N          keystrokes typed; the other workloads do fewer,\n"
+    "                   larger operations in proportion (default 20000)\n"
+    "  --seed N         seed of the random document and edits (default 1)\n"
+    "  --backend TEXT   only run buffers whose name contains TEXT\n"
+    "  --workload TEXT  only run workloads whose name contains TEXT\n"
+    "  --csv FILE       also write the results to FILE\n";
+}
+
+int main(int argc, char * argv[])
+{
+  settings options;
+  options.size = 262144;
+  options.ops = 20000;
+  options.seed = 1;
+  for(int i = 1; i < argc; ++i){
+    std::string const option = argv[i];
+    if(option == "--help" || i + 1 == argc){
+      usage(argv[0]);
+      return option == "--help" ? 0 : 1;
+    }
+    char const * const value = argv[++i];
+    if(option == "--size")
+      options.size = std::strtoul(value, 0, 10);
+    else if(option == "--ops")
+      options.ops = std::strtoul(value, 0, 10);
+    else if(option == "--seed")
+      options.seed = static_cast<boost::uint32_t>(std::strtoul(value, 0, 10));
+    else if(option == "--backend")
+      options.backend_filter = value;
+    else if(option == "--workload")
+      options.workload_filter = value;
+    else if(option == "--csv")
+      options.csv = value;
+    else{
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  boost::random::mt19937 rng(options.seed);
+  std::vector<script> scripts;
+  for(int w = 0; w != workload_count; ++w)
+    scripts.push_back(make_script(options.size,
+                                  ops_of(static_cast<workload>(w),
+                                         options.ops), rng));
+
+  hardware_counters counters;
+  std::vector<measurement> results;
+  run_backend<on_std_deque>("gap_buffer<std::deque>", options, scripts,
+                            counters, results);
+  run_backend<on_boost_deque>("gap_buffer<boost::container::deque>", options,
+                              scripts, counters, results);
+  run_backend<on_std_list>("gap_buffer<std::list>", options, scripts,
+                           counters, results);
+  run_backend<on_std_vector>("gap_buffer<std::vector>", options, scripts,
+                             counters, results);
+  run_backend<contiguous>("contiguous_gap_buffer", options, scripts,
+                          counters, results);
+  run_backend<rope>("rope_buffer", options, scripts, counters, results);
+  run_backend<naive_string>("std::string", options, scripts, counters,
+                            results);
+  run_backend<naive_vector>("std::vector", options, scripts, counters,
+                            results);
+  print_table(results);
+
+  // Every buffer must have ended a workload with the same elements
+  int status = 0;
+  std::map<int, std::size_t> expected;
+  for(std::size_t i = 0; i != results.size(); ++i){
+    measurement const & m = results[i];
+    if(!expected.count(m.what))
+      expected[m.what] = m.checksum;
+    else if(expected[m.what] != m.checksum){
+      std::cerr << m.backend << " gave different results for "
+                << workload_names[m.what] << '\n';
+      status = 1;
+    }
+  }
+
+  if(!options.csv.empty() && !write_csv(options.csv, results)){
+    std::cerr << "could not write " << options.csv << '\n';
+    status = 1;
+  }
+  return status;
+}
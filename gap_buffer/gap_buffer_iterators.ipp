@@ -30,15 +30,17 @@
 */
 
 #include <boost/iterator/iterator_facade.hpp>
+#include <boost/type_traits/is_convertible.hpp>
+#include <boost/utility/enable_if.hpp>
 #include <iterator>
 
 
 /**
    @invariant !is_before && location == before_end
 */
-template<class TContainer>
+template<class TContainer, class TObserver, class TStats>
 template<class TUnderlying>
-struct gap_buffer<TContainer>::iterator_impl
+struct gap_buffer<TContainer, TObserver, TStats>::iterator_impl
 {
 public:
   iterator_impl(TUnderlying here,
@@ -133,9 +135,9 @@ protected:
   }
 };
 
-template<class TContainer>
+template<class TContainer, class TObserver, class TStats>
 template<class TUnderlying>
-struct gap_buffer<TContainer>::const_iterator_impl
+struct gap_buffer<TContainer, TObserver, TStats>::const_iterator_impl
   : private iterator_impl<TUnderlying>
   , public boost::iterator_facade<const_iterator_impl<TUnderlying>,
 				  typename std::iterator_traits<TUnderlying>::value_type,
@@ -153,7 +155,7 @@ public:
 private:
   // Grant access to Boost.Iterator
   friend class boost::iterator_core_access;
-  friend class gap_buffer<TContainer>;
+  friend class gap_buffer<TContainer, TObserver, TStats>;
 
   const_reference dereference() const
   {
@@ -161,9 +163,9 @@ private:
   }
 };
 
-template<class TContainer>
+template<class TContainer, class TObserver, class TStats>
 template<class TUnderlying, class TConstIter>
-struct gap_buffer<TContainer>::nonconst_iterator_impl
+struct gap_buffer<TContainer, TObserver, TStats>::nonconst_iterator_impl
   : private iterator_impl<TUnderlying>
   , boost::iterator_facade<nonconst_iterator_impl<TUnderlying, TConstIter>,
 			   typename std::iterator_traits<TUnderlying>::value_type,
@@ -186,10 +188,111 @@ public:
 private:
   // Grant access to Boost.Iterator
   friend class boost::iterator_core_access;
-  friend class gap_buffer<TContainer>;
+  friend class gap_buffer<TContainer, TObserver, TStats>;
 
   reference dereference() const
   {
     return *this->location;
   }
 };
+
+/**
+   @invariant buf == 0 || idx <= buf->size()
+*/
+template<class TContainer, class TObserver, class TStats>
+template<class TValue, class TBuffer>
+class gap_buffer<TContainer, TObserver, TStats>::index_iterator_impl
+  : public boost::iterator_facade<index_iterator_impl<TValue, TBuffer>,
+                                  TValue,
+                                  std::random_access_iterator_tag>
+  , private gap_detail::block_cache<TValue, cached_blocks::value>
+{
+  struct enabler {};
+  typedef gap_detail::block_cache<TValue, cached_blocks::value> cache;
+public:
+  index_iterator_impl()
+    : buf(0)
+    , idx(0)
+  {}
+
+  index_iterator_impl(TBuffer * buffer, std::size_t index)
+    : buf(buffer)
+    , idx(index)
+  {}
+
+  // Allow iterator to convert to const_iterator, but not the other way around
+  template<class UValue, class UBuffer>
+  index_iterator_impl(index_iterator_impl<UValue, UBuffer> const & other,
+                      typename boost::enable_if<
+                        boost::is_convertible<UValue *, TValue *>,
+                        enabler>::type = enabler())
+    : cache(other.kept())
+    , buf(other.buf)
+    , idx(other.idx)
+  {}
+
+private:
+  // Grant access to Boost.Iterator
+  friend class boost::iterator_core_access;
+  friend class gap_buffer<TContainer, TObserver, TStats>;
+  template<class, class> friend class index_iterator_impl;
+
+  // The buffer this iterator walks over
+  TBuffer *   buf;
+  // The logical index of the element this iterator refers to
+  std::size_t idx;
+
+  // The block this iterator kept, to hand to another
+  cache const & kept() const
+  {
+    return *this;
+  }
+
+  TValue & dereference() const
+  {
+    return dereference(cached_blocks());
+  }
+  TValue & dereference(boost::true_type) const
+  {
+    // Find the block again if idx has left it, or it may have moved
+    if(idx - this->start >= static_cast<std::size_t>(this->last - this->first)
+       || this->edits != buf->edits_made()){
+      this->start = find_block(*buf, idx, this->first, this->last);
+      this->edits = buf->edits_made();
+    }
+    return this->first[idx - this->start];
+  }
+  TValue & dereference(boost::false_type) const
+  {
+    return (*buf)[idx];
+  }
+  // Compare the iterator for equality, as a callback to Boost.Iterator
+  template<class UValue, class UBuffer>
+  bool equal(index_iterator_impl<UValue, UBuffer> const & other) const
+  {
+    return idx == other.idx;
+  }
+  // Increment the iterator, as a callback to Boost.Iterator
+  void increment()
+  {
+    ++idx;
+  }
+  // Decrement the iterator, as a callback to Boost.Iterator
+  void decrement()
+  {
+    --idx;
+  }
+  // Advance the iterator, as a callback to Boost.Iterator
+  void advance(std::ptrdiff_t n)
+  {
+    idx += n;
+  }
+  // Measure distance between to iterators as callback to Boost.Iterator
+  template<class UValue, class UBuffer>
+  std::ptrdiff_t
+  distance_to(index_iterator_impl<UValue, UBuffer> const & other) const
+  {
+    return static_cast<std::ptrdiff_t>(other.idx) -
+      static_cast<std::ptrdiff_t>(idx);
+  }
+};
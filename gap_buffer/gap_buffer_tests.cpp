@@ -37,14 +37,57 @@
 #include <boost/concept_check.hpp>
 
 #include "gap_buffer.hpp"
-
+#include "contiguous_gap_buffer.hpp"
+#include "small_gap_buffer.hpp"
+#include "rope_buffer.hpp"
+#include "concurrent_buffer.hpp"
+#include "multi_gap_buffer.hpp"
+#include "piece_table_buffer.hpp"
+#include "undo_journal.hpp"
+#include "edit_trace.hpp"
+#include "buffer_stats.hpp"
+#include "latency_stats.hpp"
+#include "line_index.hpp"
+#include "utf8_index.hpp"
+#include "buffer_io.hpp"
+#include "buffer_snapshot.hpp"
+#include "parallel_algorithms.hpp"
+#include "edit_batch.hpp"
+
+#include <algorithm>
+#include <cstdio>
 #include <deque>
+#include <fstream>
+#include <memory>
 #include <list>
+#include <sstream>
+#include <stdexcept>
 #include <vector>
 #include <iterator>
 #include <string>
 
+#include <boost/atomic.hpp>
 #include <boost/container/deque.hpp>
+#include <boost/container/pmr/deque.hpp>
+#include <boost/container/pmr/global_resource.hpp>
+#include <boost/container/pmr/monotonic_buffer_resource.hpp>
+#include <boost/container/pmr/unsynchronized_pool_resource.hpp>
+#include <boost/container/list.hpp>
+#include <boost/container/stable_vector.hpp>
+#include <boost/container/vector.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/mpl/list.hpp>
+#include <boost/next_prior.hpp>
+#include <boost/range/empty.hpp>
+#include <boost/range/size.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/system/system_error.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 // First, our static assertions
 struct Concept_Checks
@@ -80,6 +123,15 @@ BOOST_AUTO_TEST_SUITE(gap_buffer_tests)
 typedef gap_buffer<std::deque<char> > buffer_t;
 typedef gap_buffer<boost::container::deque<char> > buffer11_t;
 
+// The containers a gap_buffer is tested over, which between them relocate
+// elements by splicing and in bulk
+typedef boost::mpl::list<gap_buffer<std::deque<char> >,
+                         gap_buffer<std::vector<char> >,
+                         gap_buffer<std::list<char> >,
+                         gap_buffer<boost::container::deque<char> >,
+                         gap_buffer<boost::container::list<char> > >
+backends;
+
 
 template<class TIter>
 TIter advance_copy(TIter const & iter, size_t n)
@@ -220,21 +272,21 @@ typedef buffer_t::const_reverse_iterator   const_reverse_iterator;
 
 // ----- ----- ------ Constructors ----- ----- -----
 
-BOOST_AUTO_TEST_CASE(default_constructor)
+BOOST_AUTO_TEST_CASE_TEMPLATE(default_constructor, TBuffer, backends)
 {
-  buffer_t default_constructed;
+  TBuffer default_constructed;
   assert_properties_empty(default_constructed);
 }
 
-BOOST_AUTO_TEST_CASE(copy_constructor)
+BOOST_AUTO_TEST_CASE_TEMPLATE(copy_constructor, TBuffer, backends)
 {
-  buffer_t copied_value;
+  TBuffer copied_value;
   {
     copied_value.insert('x');
     assert_properties_size(copied_value, 1);
   }
 
-  buffer_t copy_constructed(copied_value);
+  TBuffer copy_constructed(copied_value);
   assert_properties_size(copy_constructed, 1);
   BOOST_CHECK_EQUAL( copy_constructed, copied_value );
   BOOST_CHECK( seq_eq(copy_constructed, copied_value) );
@@ -259,13 +311,13 @@ BOOST_AUTO_TEST_CASE(move_constructor)
 }
 
 
-BOOST_AUTO_TEST_CASE(fill_constructor)
+BOOST_AUTO_TEST_CASE_TEMPLATE(fill_constructor, TBuffer, backends)
 {
   size_t const first_len = 7;
-  buffer_t fill_constructed_1( first_len );
+  TBuffer fill_constructed_1( first_len );
   assert_properties_size( fill_constructed_1, first_len );
 
-  buffer_t fill_constructed_2( first_len, '\0');
+  TBuffer fill_constructed_2( first_len, '\0');
   assert_properties_size( fill_constructed_1, first_len );
   BOOST_CHECK_EQUAL( fill_constructed_1, fill_constructed_2 );
 
@@ -276,7 +328,7 @@ BOOST_AUTO_TEST_CASE(fill_constructor)
 
   size_t const third_len = 22;
   char const third_fill_val = 'v';
-  buffer_t fill_constructed_3( third_len, third_fill_val );
+  TBuffer fill_constructed_3( third_len, third_fill_val );
   assert_properties_size( fill_constructed_3, third_len );
   { // Demonstrate its equivalence to another container's fill constructor
     std::vector<char> other_cont(third_len, third_fill_val);
@@ -285,12 +337,12 @@ BOOST_AUTO_TEST_CASE(fill_constructor)
 
 }
 
-BOOST_AUTO_TEST_CASE(iter_pair_constructor)
+BOOST_AUTO_TEST_CASE_TEMPLATE(iter_pair_constructor, TBuffer, backends)
 {
   static size_t const first_len = 22;
   std::vector<char> other_cont(first_len, '\0');
 
-  buffer_t iterator_constructed(other_cont.begin(), other_cont.end());
+  TBuffer iterator_constructed(other_cont.begin(), other_cont.end());
   // Demonstrate that the data is all there
   BOOST_CHECK( seq_eq(iterator_constructed, other_cont) );
   assert_position_end( iterator_constructed );
@@ -305,9 +357,9 @@ BOOST_AUTO_TEST_CASE(iter_pair_constructor)
   actually of any use.
 */
 
-BOOST_AUTO_TEST_CASE(size)
+BOOST_AUTO_TEST_CASE_TEMPLATE(size, TBuffer, backends)
 {
-  buffer_t default_constructed;
+  TBuffer default_constructed;
 
   BOOST_CHECK_EQUAL( default_constructed.size(), 0 );
 
@@ -330,9 +382,9 @@ BOOST_AUTO_TEST_CASE(size)
   assert_properties_size( default_constructed, 3 );
 }
 
-BOOST_AUTO_TEST_CASE(empty)
+BOOST_AUTO_TEST_CASE_TEMPLATE(empty, TBuffer, backends)
 {
-  buffer_t buffer;
+  TBuffer buffer;
   assert_properties_empty( buffer );
 
   buffer.insert(buffer.end(), 1, '\n');
@@ -344,13 +396,13 @@ BOOST_AUTO_TEST_CASE(empty)
 
 
 // ----- ----- ------ Swapping ----- ----- -----
-BOOST_AUTO_TEST_CASE(swap)
+BOOST_AUTO_TEST_CASE_TEMPLATE(swap, TBuffer, backends)
 {
   std::string const strA("this is the first test buffer");
   std::string const strB("the second test buffer am I");
 
-  buffer_t bufferA(strA.begin(), strA.end());
-  buffer_t bufferB(strB.begin(), strB.end());
+  TBuffer bufferA(strA.begin(), strA.end());
+  TBuffer bufferB(strB.begin(), strB.end());
 
   bufferA.advance(-7);
   size_t const positionA = bufferA.position();
@@ -380,10 +432,10 @@ BOOST_AUTO_TEST_CASE(swap)
 
 
 // ----- ----- ------ Cursor Manipulation ----- ----- -----
-BOOST_AUTO_TEST_CASE(advance)
+BOOST_AUTO_TEST_CASE_TEMPLATE(advance, TBuffer, backends)
 {
   std::string const strA("this is the first test buffer");
-  buffer_t buffer(strA.begin(), strA.end());
+  TBuffer buffer(strA.begin(), strA.end());
 
   size_t const position_1 = buffer.position();
 
@@ -403,11 +455,36 @@ BOOST_AUTO_TEST_CASE(advance)
 }
 
 
-BOOST_AUTO_TEST_CASE(position)
+BOOST_AUTO_TEST_CASE_TEMPLATE(reverse_cursor, TBuffer, backends)
+{
+  std::string const str("abcdef");
+  TBuffer buffer(str.begin(), str.end());
+  TBuffer const & buf_const = buffer;
+
+  // rhere() is reverse_iterator(here()), naming the element before the
+  // cursor, whether or not the cursor has been resolved
+  buffer.advance(-3);
+  BOOST_CHECK_EQUAL( *buffer.rhere(), 'c' );
+  BOOST_CHECK_EQUAL( std::distance(buffer.rbegin(), buffer.rhere()), 3 );
+  buffer.insert('X');
+  BOOST_CHECK_EQUAL( *buffer.rhere(), 'X' );
+  BOOST_CHECK_EQUAL( *buf_const.rhere(), 'X' );
+  BOOST_CHECK_EQUAL( std::distance(buffer.rbegin(), buffer.rhere()), 3 );
+  buffer.advance(2);
+  BOOST_CHECK_EQUAL( *buffer.rhere(), 'e' );
+  BOOST_CHECK_EQUAL( std::distance(buffer.rbegin(), buffer.rhere()), 1 );
+
+  // At the start of the buffer, there is nothing before the cursor
+  buffer.advance(-6);
+  BOOST_CHECK( buffer.rhere() == buffer.rend() );
+}
+
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(position, TBuffer, backends)
 {
   std::string const strA("this is the first test buffer");
 
-  buffer_t buffer(strA.begin(), strA.end());
+  TBuffer buffer(strA.begin(), strA.end());
   assert_position_end( buffer );
   size_t base_position = buffer.size();
 
@@ -468,11 +545,12 @@ BOOST_AUTO_TEST_CASE(position)
     BOOST_CHECK_EQUAL(buffer.position(), base_position);
 
     // Assert that inserting data after the cursor does not
-    buffer.insert(buffer.here() + 1, 3, 'b');
+    buffer.insert(boost::next(buffer.here()), 3, 'b');
     BOOST_CHECK_EQUAL(buffer.position(), base_position);
-    buffer.insert(buffer.here() + 1, 'b');
+    buffer.insert(boost::next(buffer.here()), 'b');
     BOOST_CHECK_EQUAL(buffer.position(), base_position);
-    buffer.insert(buffer.here() + 1, insert_str.begin(), insert_str.end());
+    buffer.insert(boost::next(buffer.here()),
+                  insert_str.begin(), insert_str.end());
     BOOST_CHECK_EQUAL(buffer.position(), base_position);
 
     // Assert that inserting data before the cursor moves it
@@ -490,10 +568,10 @@ BOOST_AUTO_TEST_CASE(position)
   }
 }
 
-BOOST_AUTO_TEST_CASE(insert_elem_at_cursor)
+BOOST_AUTO_TEST_CASE_TEMPLATE(insert_elem_at_cursor, TBuffer, backends)
 {
   std::string const strA("this is the first test buffer");
-  buffer_t buffer(strA.begin(), strA.end());
+  TBuffer buffer(strA.begin(), strA.end());
   BOOST_CHECK_EQUAL(buffer.size(), strA.size() );
   buffer.advance(-10);
   BOOST_CHECK_EQUAL(buffer.size(), strA.size() );
@@ -510,10 +588,10 @@ BOOST_AUTO_TEST_CASE(insert_elem_at_cursor)
 }
 
 
-BOOST_AUTO_TEST_CASE(insert_range_at_cursor)
+BOOST_AUTO_TEST_CASE_TEMPLATE(insert_range_at_cursor, TBuffer, backends)
 {
   std::string const strA("this is the first test buffer");
-  buffer_t buffer(strA.begin(), strA.end());
+  TBuffer buffer(strA.begin(), strA.end());
   BOOST_CHECK_EQUAL(buffer.size(), strA.size() );
   buffer.advance(-10);
   BOOST_CHECK_EQUAL(buffer.size(), strA.size() );
@@ -532,10 +610,10 @@ BOOST_AUTO_TEST_CASE(insert_range_at_cursor)
 }
 
 
-BOOST_AUTO_TEST_CASE(erase_elem_at_cursor)
+BOOST_AUTO_TEST_CASE_TEMPLATE(erase_elem_at_cursor, TBuffer, backends)
 {
   std::string const strA("this is the first test buffer");
-  buffer_t buffer(strA.begin(), strA.end());
+  TBuffer buffer(strA.begin(), strA.end());
   BOOST_CHECK_EQUAL(buffer.size(), strA.size());
   buffer.advance(-10);
   BOOST_CHECK_EQUAL(buffer.size(), strA.size() );
@@ -552,16 +630,16 @@ BOOST_AUTO_TEST_CASE(erase_elem_at_cursor)
 }
 
 // ----- ----- ------ Operators ----- ----- -----
-BOOST_AUTO_TEST_CASE(compare_operators)
+BOOST_AUTO_TEST_CASE_TEMPLATE(compare_operators, TBuffer, backends)
 {
   std::string const strA("Something to compare against");
   std::string const strB("Something else to compare against");
   std::string const strC("HAHAHAHAHA");
 
-  buffer_t const bufferA(strA.begin(), strA.end());
-  buffer_t const bufferB(strB.begin(), strB.end());
-  buffer_t const bufferC(strC.begin(), strC.end());
-  buffer_t bufferD(strA.begin(), strA.end());
+  TBuffer const bufferA(strA.begin(), strA.end());
+  TBuffer const bufferB(strB.begin(), strB.end());
+  TBuffer const bufferC(strC.begin(), strC.end());
+  TBuffer bufferD(strA.begin(), strA.end());
 
   // Assert that two gap buffers always equal each other
   BOOST_CHECK( bufferA == bufferA );
@@ -665,14 +743,14 @@ BOOST_AUTO_TEST_CASE(compare_operators)
 		     (strA >= strC) );
 }
 
-BOOST_AUTO_TEST_CASE(assign_operator)
+BOOST_AUTO_TEST_CASE_TEMPLATE(assign_operator, TBuffer, backends)
 {
   std::string const strA("Something to compare against");
   std::string const strB("Something else to compare against");
 
-  buffer_t bufferA(strA.begin(), strA.end());
-  buffer_t bufferB(strB.begin(), strB.end());
-  buffer_t bufferC;
+  TBuffer bufferA(strA.begin(), strA.end());
+  TBuffer bufferB(strB.begin(), strB.end());
+  TBuffer bufferC;
 
   BOOST_CHECK( bufferA != bufferB );
   BOOST_CHECK( bufferA != bufferC );
@@ -798,14 +876,14 @@ BOOST_AUTO_TEST_CASE(iterator_comparisons)
   }
 }
 
-BOOST_AUTO_TEST_CASE(iterator_movement)
+BOOST_AUTO_TEST_CASE_TEMPLATE(iterator_movement, TBuffer, backends)
 {
   std::string const str("Some data to iterate over");
-  buffer_t buffer(str.begin(), str.end());
-  buffer_t const & cbuffer = buffer;
+  TBuffer buffer(str.begin(), str.end());
+  TBuffer const & cbuffer = buffer;
 
-  iterator iter = buffer.end();
-  const_iterator citer = cbuffer.end();
+  typename TBuffer::iterator iter = buffer.end();
+  typename TBuffer::const_iterator citer = cbuffer.end();
   BOOST_CHECK(  (iter == citer) );
 
   --iter;
@@ -817,17 +895,92 @@ BOOST_AUTO_TEST_CASE(iterator_movement)
   --iter;
   BOOST_CHECK_EQUAL(*iter, 'o');
 
-  BOOST_CHECK(  (iter == (citer-4)) );
-  citer = citer - 4;
+  BOOST_CHECK(  (iter == boost::prior(citer, 4)) );
+  citer = boost::prior(citer, 4);
   BOOST_CHECK(  (iter == citer) );
 }
 
+BOOST_AUTO_TEST_CASE(compact_iterator_size)
+{
+  typedef gap_buffer<std::vector<char> > vector_buffer_t;
+  typedef vector_buffer_t::iterator vector_iterator;
+
+  // With contiguous halves, an iterator is just the buffer and an index
+  BOOST_CHECK_EQUAL( sizeof(vector_iterator),
+                     sizeof(vector_buffer_t *) + sizeof(size_t) );
+  BOOST_CHECK_EQUAL( sizeof(vector_buffer_t::const_iterator),
+                     sizeof(vector_iterator) );
+  // and a deque's also keeps the block it is in, rather than an iterator into
+  // each half
+  BOOST_CHECK( sizeof(iterator) <= 6 * sizeof(void *) );
+  BOOST_CHECK( sizeof(buffer11_t::iterator) <= 6 * sizeof(void *) );
+  BOOST_CHECK_EQUAL( sizeof(const_iterator), sizeof(iterator) );
+}
+
+typedef boost::mpl::list<gap_buffer<std::vector<char> >,
+                         gap_buffer<std::deque<char> >,
+                         gap_buffer<boost::container::deque<char> > >
+compact_backends;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(compact_iterators, TBuffer, compact_backends)
+{
+  std::string str("Some data to iterate over");
+  TBuffer buffer(str.begin(), str.end());
+  buffer.advance(-8);
+  typename TBuffer::iterator const data = buffer.begin() + 5;
+  BOOST_CHECK_EQUAL( data - buffer.begin(), 5 );
+  BOOST_CHECK_EQUAL( *data, 'd' );
+
+  // Which stays at its index across edits on either side of the gap
+  buffer.insert('!');
+  buffer.erase(buffer.begin() + 20);
+  buffer.insert(buffer.begin(), 'x');
+  BOOST_CHECK_EQUAL( *data, ' ' );
+  BOOST_CHECK_EQUAL( *(data + 1), 'd' );
+  BOOST_CHECK( std::string(buffer.rbegin(), buffer.rend()) ==
+               "revo ta!reti ot atad emoSx" );
+  BOOST_CHECK_EQUAL( *buffer.here(), 'a' );
+  BOOST_CHECK_EQUAL( *buffer.rhere(), '!' );
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(compact_iterators_cross_blocks, TBuffer,
+                              compact_backends)
+{
+  // Enough elements for many blocks of a deque in each half
+  std::string str;
+  for(int i = 0; i != 20000; ++i)
+    str += static_cast<char>('a' + i % 26);
+  TBuffer buffer(str.begin(), str.end());
+  buffer.advance(-7000);
+  BOOST_CHECK( seq_eq(buffer, str) );
+  BOOST_CHECK( std::equal(str.rbegin(), str.rend(), buffer.rbegin()) );
+
+  // Each iterator keeps its block while it walks, but must find it again once
+  // an edit moves the elements under it
+  typename TBuffer::iterator walker = buffer.begin() + 12990;
+  typename TBuffer::const_iterator const reader = walker + 5;
+  BOOST_CHECK_EQUAL( *reader, str[12995] );
+  buffer.insert('!');
+  str.insert(str.begin() + 13000, '!');
+  for(int i = 0; i != 20; ++i, ++walker)
+    BOOST_CHECK_EQUAL( *walker, str[12990 + i] );
+  buffer.erase(buffer.begin(), buffer.begin() + 3);
+  str.erase(0, 3);
+  BOOST_CHECK_EQUAL( *reader, str[12995] );
+  BOOST_CHECK_EQUAL( walker[-3000], str[10010] );
+  *walker = '?';
+  str[13010] = '?';
+  BOOST_CHECK_EQUAL( *reader, str[12995] );
+  BOOST_CHECK( seq_eq(buffer, str) );
+  BOOST_CHECK( std::equal(buffer.begin(), buffer.end(), str.begin()) );
+}
+
 
 // ----- ----- ------ Inserting With Iterators ----- ----- -----
-BOOST_AUTO_TEST_CASE(insert_at_iter)
+BOOST_AUTO_TEST_CASE_TEMPLATE(insert_at_iter, TBuffer, backends)
 {
   std::string str("Some data to iterate over");
-  buffer_t buffer(str.begin(), str.end());
+  TBuffer buffer(str.begin(), str.end());
 
   buffer.advance(-13);
 
@@ -835,7 +988,7 @@ BOOST_AUTO_TEST_CASE(insert_at_iter)
     // Demonstrate that inserting data before the cursor works and does move
     // the cursor
     size_t const pos_before = buffer.position();
-    buffer_t::iterator insert_pos = buffer.here();
+    typename TBuffer::iterator insert_pos = buffer.here();
     --insert_pos;
     buffer.insert(insert_pos, 'Z');
     str.insert(str.begin() + 11, 'Z');
@@ -855,7 +1008,7 @@ BOOST_AUTO_TEST_CASE(insert_at_iter)
     // Demonstrate that inserting data after the cursor works and does not move
     // the cursor
     size_t const pos_before = buffer.position();
-    buffer.insert(buffer.here() + 1, 'X');
+    buffer.insert(boost::next(buffer.here()), 'X');
     str.insert(str.begin() + 15, 'X');
     BOOST_CHECK( seq_eq(buffer, str) );
     BOOST_CHECK_EQUAL( pos_before, buffer.position() );
@@ -863,10 +1016,10 @@ BOOST_AUTO_TEST_CASE(insert_at_iter)
 }
 
 
-BOOST_AUTO_TEST_CASE(insert_n_at_iter)
+BOOST_AUTO_TEST_CASE_TEMPLATE(insert_n_at_iter, TBuffer, backends)
 {
   std::string str("Some data to iterate over");
-  buffer_t buffer(str.begin(), str.end());
+  TBuffer buffer(str.begin(), str.end());
 
   buffer.advance(-13);
 
@@ -874,7 +1027,7 @@ BOOST_AUTO_TEST_CASE(insert_n_at_iter)
     // Demonstrate that inserting data before the cursor works and does move
     // the cursor
     size_t const pos_before = buffer.position();
-    buffer.insert(buffer.here()-1, 3, 'Z');
+    buffer.insert(boost::prior(buffer.here()), 3, 'Z');
     str.insert(str.begin() + 11, 3, 'Z');
     BOOST_CHECK( seq_eq(buffer, str) );
     BOOST_CHECK_EQUAL( pos_before + 3, buffer.position() );
@@ -892,7 +1045,7 @@ BOOST_AUTO_TEST_CASE(insert_n_at_iter)
     // Demonstrate that inserting data after the cursor works and does not move
     // the cursor
     size_t const pos_before = buffer.position();
-    buffer.insert(buffer.here() + 1, 1, 'X');
+    buffer.insert(boost::next(buffer.here()), 1, 'X');
     str.insert(str.begin() + 20, 1, 'X');
     BOOST_CHECK( seq_eq(buffer, str) );
     BOOST_CHECK_EQUAL( pos_before, buffer.position() );
@@ -907,10 +1060,10 @@ BOOST_AUTO_TEST_CASE(insert_n_at_iter)
 }
 
 
-BOOST_AUTO_TEST_CASE(insert_range_at_iter)
+BOOST_AUTO_TEST_CASE_TEMPLATE(insert_range_at_iter, TBuffer, backends)
 {
   std::string str("Some data to iterate over");
-  buffer_t buffer(str.begin(), str.end());
+  TBuffer buffer(str.begin(), str.end());
 
   buffer.advance(-13);
 
@@ -919,7 +1072,8 @@ BOOST_AUTO_TEST_CASE(insert_range_at_iter)
     // the cursor
     size_t const pos_before = buffer.position();
     std::string const insert_str("ZZZ");
-    buffer.insert(buffer.here()-1, insert_str.begin(), insert_str.end());
+    buffer.insert(boost::prior(buffer.here()),
+                  insert_str.begin(), insert_str.end());
     str.insert(str.begin() + 11, insert_str.begin(), insert_str.end());
     BOOST_CHECK( seq_eq(buffer, str) );
     BOOST_CHECK_EQUAL( pos_before + insert_str.size(), buffer.position() );
@@ -939,7 +1093,8 @@ BOOST_AUTO_TEST_CASE(insert_range_at_iter)
     // the cursor
     size_t const pos_before = buffer.position();
     std::string const insert_str("X");
-    buffer.insert(buffer.here() + 1, insert_str.begin(), insert_str.end());
+    buffer.insert(boost::next(buffer.here()),
+                  insert_str.begin(), insert_str.end());
     str.insert(str.begin() + 20, insert_str.begin(), insert_str.end());
     BOOST_CHECK( seq_eq(buffer, str) );
     BOOST_CHECK_EQUAL( pos_before, buffer.position() );
@@ -957,10 +1112,10 @@ BOOST_AUTO_TEST_CASE(insert_range_at_iter)
 
 
 // ----- ----- ------ Erasing With Iterators ----- ----- -----
-BOOST_AUTO_TEST_CASE(erase_elem_iter)
+BOOST_AUTO_TEST_CASE_TEMPLATE(erase_elem_iter, TBuffer, backends)
 {
   std::string str("Some data to iterate over");
-  buffer_t buffer(str.begin(), str.end());
+  TBuffer buffer(str.begin(), str.end());
   buffer.advance(-10);
   size_t position = buffer.position();
 
@@ -971,7 +1126,7 @@ BOOST_AUTO_TEST_CASE(erase_elem_iter)
   BOOST_CHECK_EQUAL( --position, buffer.position() );
 
   // Assert that erasing from right before the cursor does what we expect
-  buffer.erase(buffer.here()-1);
+  buffer.erase(boost::prior(buffer.here()));
   str.erase(str.begin() + (position - 1));
   BOOST_CHECK( seq_eq(buffer, str) );
   BOOST_CHECK_EQUAL( --position, buffer.position() );
@@ -983,13 +1138,13 @@ BOOST_AUTO_TEST_CASE(erase_elem_iter)
   BOOST_CHECK_EQUAL( position, buffer.position() );
 
   // Assert that erasing from after the cursor does what we expect
-  buffer.erase(buffer.here()+1);
+  buffer.erase(boost::next(buffer.here()));
   str.erase(str.begin() + position + 1);
   BOOST_CHECK( seq_eq(buffer, str) );
   BOOST_CHECK_EQUAL( position, buffer.position() );
 
   // Assert that erasing from the end does what we expect
-  buffer.erase(buffer.end()-1);
+  buffer.erase(boost::prior(buffer.end()));
   str.erase(str.end() - 1);
   BOOST_CHECK( seq_eq(buffer, str) );
   BOOST_CHECK_EQUAL( position, buffer.position() );
@@ -997,17 +1152,17 @@ BOOST_AUTO_TEST_CASE(erase_elem_iter)
 
 
 
-BOOST_AUTO_TEST_CASE(erase_range_iter)
+BOOST_AUTO_TEST_CASE_TEMPLATE(erase_range_iter, TBuffer, backends)
 {
   std::string str("Some data to iterate over");
-  buffer_t buffer(str.begin(), str.end());
+  TBuffer buffer(str.begin(), str.end());
   buffer.advance(-10);
   size_t position = buffer.position();
 
   // Assert that erasing across the gap works as expected and places the cursor
   // at the first element after the deleted ones
   {
-    buffer.erase(buffer.here()-1, buffer.here()+1);
+    buffer.erase(boost::prior(buffer.here()), boost::next(buffer.here()));
     str.erase(str.begin() + (position - 1), str.begin() + (position + 1));
     BOOST_CHECK( seq_eq( buffer, str ) );
     position -= 1;
@@ -1016,7 +1171,7 @@ BOOST_AUTO_TEST_CASE(erase_range_iter)
 
   // Assert that erasing before the gap works as expected and moves the cursor
   {
-    buffer.erase(buffer.begin(), buffer.begin()+2);
+    buffer.erase(buffer.begin(), boost::next(buffer.begin(), 2));
     str.erase(str.begin(), str.begin() + 2);
     BOOST_CHECK( seq_eq( buffer, str ) );
     position -= 2;
@@ -1025,7 +1180,7 @@ BOOST_AUTO_TEST_CASE(erase_range_iter)
 
   // Assert that erasing at the gap works as expected and does not move the gap
   {
-    buffer.erase(buffer.here(), buffer.here()+2);
+    buffer.erase(buffer.here(), boost::next(buffer.here(), 2));
     str.erase(str.begin() + position, str.begin() + position + 2);
     BOOST_CHECK( seq_eq( buffer, str ) );
     BOOST_CHECK_EQUAL(position, buffer.position());
@@ -1035,7 +1190,7 @@ BOOST_AUTO_TEST_CASE(erase_range_iter)
   // Assert that erasing after the gap works as expected and does not move the
   // cursor
   {
-    buffer.erase(buffer.end()-2, buffer.end());
+    buffer.erase(boost::prior(buffer.end(), 2), buffer.end());
     str.erase(str.end()-2, str.end());
     BOOST_CHECK( seq_eq( buffer, str ) );
     BOOST_CHECK_EQUAL(position, buffer.position());
@@ -1045,11 +1200,11 @@ BOOST_AUTO_TEST_CASE(erase_range_iter)
 
 // ----- ----- ------ Miscellaneous ----- ----- -----
 
-BOOST_AUTO_TEST_CASE(front)
+BOOST_AUTO_TEST_CASE_TEMPLATE(front, TBuffer, backends)
 {
   std::string str("Some data to iterate over");
-  buffer_t buffer(str.begin(), str.end());
-  buffer_t const & cbuffer = buffer;
+  TBuffer buffer(str.begin(), str.end());
+  TBuffer const & cbuffer = buffer;
 
   BOOST_CHECK_EQUAL(buffer.front(), str[0]);
   BOOST_CHECK_EQUAL(cbuffer.front(), buffer.front());
@@ -1061,10 +1216,32 @@ BOOST_AUTO_TEST_CASE(front)
   BOOST_CHECK_EQUAL(cbuffer.front(), buffer.front());
 }
 
-BOOST_AUTO_TEST_CASE(clear)
+BOOST_AUTO_TEST_CASE(element_access)
 {
   std::string str("Some data to iterate over");
   buffer_t buffer(str.begin(), str.end());
+  buffer.advance(-10);
+  buffer_t const & cbuffer = buffer;
+  gap_buffer<std::list<char> > list_buffer(str.begin(), str.end());
+  list_buffer.advance(-10);
+
+  for(size_t i = 0; i < str.size(); ++i){
+    BOOST_CHECK_EQUAL( buffer[i], str[i] );
+    BOOST_CHECK_EQUAL( cbuffer.at(i), str[i] );
+    BOOST_CHECK_EQUAL( list_buffer[i], str[i] );
+  }
+  BOOST_CHECK_THROW( buffer.at(str.size()), std::out_of_range );
+  BOOST_CHECK_THROW( list_buffer.at(str.size()), std::out_of_range );
+
+  buffer[0] = 's';
+  buffer.at(str.size() - 1) = 'R';
+  BOOST_CHECK( seq_eq(buffer, std::string("some data to iterate oveR")) );
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(clear, TBuffer, backends)
+{
+  std::string str("Some data to iterate over");
+  TBuffer buffer(str.begin(), str.end());
 
   BOOST_CHECK( seq_eq(str, buffer) );
 
@@ -1075,10 +1252,10 @@ BOOST_AUTO_TEST_CASE(clear)
   assert_properties_empty( buffer );
 }
 
-BOOST_AUTO_TEST_CASE(resize)
+BOOST_AUTO_TEST_CASE_TEMPLATE(resize, TBuffer, backends)
 {
   std::string str("Some data to iterate over");
-  buffer_t buffer(str.begin(), str.end());
+  TBuffer buffer(str.begin(), str.end());
   buffer.advance(-10);
   size_t position = buffer.position();
   BOOST_CHECK( seq_eq(str, buffer) );
@@ -1097,7 +1274,7 @@ BOOST_AUTO_TEST_CASE(resize)
     BOOST_CHECK_EQUAL(position, buffer.position());
     BOOST_CHECK(seq_eq(appended_str, buffer));
     BOOST_CHECK_EQUAL(*(buffer.begin()), 'S');
-    BOOST_CHECK_EQUAL(*(buffer.end()-1), '\0');
+    BOOST_CHECK_EQUAL(*boost::prior(buffer.end()), '\0');
   }
 
   // Assert that a shrinking resize shrinks
@@ -1109,7 +1286,7 @@ BOOST_AUTO_TEST_CASE(resize)
     BOOST_CHECK_EQUAL(position, buffer.position());
     BOOST_CHECK(seq_eq(shrunken_str, buffer));
     BOOST_CHECK_EQUAL(*(buffer.begin()), 'S');
-    BOOST_CHECK_EQUAL(*(buffer.end()-1), 'e');
+    BOOST_CHECK_EQUAL(*boost::prior(buffer.end()), 'e');
   }
 
 
@@ -1122,10 +1299,2845 @@ BOOST_AUTO_TEST_CASE(resize)
     BOOST_CHECK_EQUAL(position-2, buffer.position());
     BOOST_CHECK(seq_eq(shrunken_str, buffer));
     BOOST_CHECK_EQUAL(*(buffer.begin()), 'S');
-    BOOST_CHECK_EQUAL(*(buffer.end()-1), ' ');
+    BOOST_CHECK_EQUAL(*boost::prior(buffer.end()), ' ');
+  }
+
+}
+
+
+// ----- ----- ------ Deferred Cursor Resolution ----- ----- -----
+
+// An element type which counts its copies, to measure how much data an
+// operation moves
+struct counted
+{
+  static size_t copies;
+
+  counted(char v = '\0') : value(v) {}
+  counted(counted const & other) : value(other.value) { ++copies; }
+  counted & operator=(counted const & other)
+  {
+    value = other.value;
+    ++copies;
+    return *this;
+  }
+
+  char value;
+};
+size_t counted::copies = 0;
+
+bool operator==(counted const & lhs, counted const & rhs)
+{
+  return lhs.value == rhs.value;
+}
+
+bool operator<(counted const & lhs, counted const & rhs)
+{
+  return lhs.value < rhs.value;
+}
+
+std::ostream & operator<<(std::ostream & os, counted const & c)
+{
+  return os << c.value;
+}
+
+typedef gap_buffer<std::deque<counted> > counted_buffer_t;
+
+BOOST_AUTO_TEST_CASE(far_iterator_edits_do_not_move_gap)
+{
+  std::string str(10000, 'a');
+  counted_buffer_t buffer(str.begin(), str.end());
+
+  // Park the cursor near the front, far from where the gap physically is
+  buffer.advance(-9990);
+  size_t position = buffer.position();
+
+  counted::copies = 0;
+  buffer.insert(buffer.begin() + 5, counted('b'));
+  str.insert(5, 1, 'b');
+  BOOST_CHECK_LT( counted::copies, 100u );
+  BOOST_CHECK_EQUAL( ++position, buffer.position() );
+
+  counted::copies = 0;
+  buffer.insert(buffer.end() - 5, 3, counted('c'));
+  str.insert(str.size() - 5, 3, 'c');
+  BOOST_CHECK_LT( counted::copies, 100u );
+  BOOST_CHECK_EQUAL( position, buffer.position() );
+
+  counted::copies = 0;
+  buffer.erase(buffer.begin() + 3);
+  str.erase(3, 1);
+  BOOST_CHECK_LT( counted::copies, 100u );
+  BOOST_CHECK_EQUAL( --position, buffer.position() );
+
+  counted::copies = 0;
+  buffer.erase(buffer.end() - 20, buffer.end() - 10);
+  str.erase(str.size() - 20, 10);
+  BOOST_CHECK_LT( counted::copies, 100u );
+  BOOST_CHECK_EQUAL( position, buffer.position() );
+
+  BOOST_CHECK( seq_eq(buffer, str) );
+}
+
+BOOST_AUTO_TEST_CASE(far_cursor_erase_does_not_move_gap)
+{
+  std::string str(10000, 'a');
+  str[9] = 'x';
+  str[10] = 'y';
+  str[11] = 'z';
+  counted_buffer_t buffer(str.begin(), str.end());
+  buffer.advance(-9990);
+
+  counted::copies = 0;
+  buffer.erase(2);
+  str.erase(10, 2);
+  BOOST_CHECK_LT( counted::copies, 100u );
+  BOOST_CHECK_EQUAL( 10u, buffer.position() );
+
+  counted::copies = 0;
+  buffer.erase(-2);
+  str.erase(8, 2);
+  BOOST_CHECK_LT( counted::copies, 100u );
+  BOOST_CHECK_EQUAL( 8u, buffer.position() );
+  BOOST_CHECK( seq_eq(buffer, str) );
+
+  // The first insertion at the cursor is where the data finally moves
+  counted::copies = 0;
+  buffer.insert(counted('w'));
+  str.insert(8, 1, 'w');
+  BOOST_CHECK_GT( counted::copies, 9000u );
+  BOOST_CHECK_EQUAL( 9u, buffer.position() );
+  BOOST_CHECK( seq_eq(buffer, str) );
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(deferred_edits_keep_cursor, TBuffer, backends)
+{
+  // Every edit lands on the right side of an unresolved cursor
+  std::string str("0123456789abcdefghij");
+  TBuffer buffer(str.begin(), str.end());
+  buffer.advance(-15);
+  buffer.advance(4);
+  BOOST_REQUIRE_EQUAL( 9u, buffer.position() );
+
+  buffer.insert(buffer.here(), 'X');
+  str.insert(9, 1, 'X');
+  BOOST_CHECK( seq_eq(buffer, str) );
+  BOOST_CHECK_EQUAL( 10u, buffer.position() );
+  BOOST_CHECK_EQUAL( *buffer.here(), '9' );
+
+  buffer.erase(boost::prior(buffer.here(), 3), boost::next(buffer.here(), 3));
+  str.erase(7, 6);
+  BOOST_CHECK( seq_eq(buffer, str) );
+  BOOST_CHECK_EQUAL( 7u, buffer.position() );
+  BOOST_CHECK_EQUAL( *buffer.here(), 'c' );
+
+  buffer.advance(5);
+  buffer.erase(-9);
+  str.erase(3, 9);
+  BOOST_CHECK( seq_eq(buffer, str) );
+  BOOST_CHECK_EQUAL( 3u, buffer.position() );
+
+  buffer.resize(str.size() + 2, '!');
+  str.resize(str.size() + 2, '!');
+  BOOST_CHECK( seq_eq(buffer, str) );
+  BOOST_CHECK_EQUAL( 3u, buffer.position() );
+}
+
+
+// ----- ----- ------ Move Semantics ----- ----- -----
+
+// An element type which can only be moved, and counts its moves
+class token
+{
+  BOOST_MOVABLE_BUT_NOT_COPYABLE(token)
+public:
+  static size_t moves;
+
+  explicit token(int v = 0) : value(v) {}
+  token(int a, int b) : value(a * b) {}
+  token(BOOST_RV_REF(token) other) : value(other.value)
+  {
+    other.value = -1;
+    ++moves;
+  }
+  token & operator=(BOOST_RV_REF(token) other)
+  {
+    value = other.value;
+    other.value = -1;
+    ++moves;
+    return *this;
+  }
+
+  int value;
+};
+size_t token::moves = 0;
+
+bool operator==(token const & lhs, int rhs)
+{
+  return lhs.value == rhs;
+}
+
+// An element type which counts its copies and its moves apart
+class tracked
+{
+  BOOST_COPYABLE_AND_MOVABLE(tracked)
+public:
+  static size_t copies;
+  static size_t moves;
+
+  tracked(char v = '\0') : value(v) {}
+  tracked(tracked const & other) : value(other.value) { ++copies; }
+  tracked(BOOST_RV_REF(tracked) other) : value(other.value) { ++moves; }
+  tracked & operator=(BOOST_COPY_ASSIGN_REF(tracked) other)
+  {
+    value = other.value;
+    ++copies;
+    return *this;
+  }
+  tracked & operator=(BOOST_RV_REF(tracked) other)
+  {
+    value = other.value;
+    ++moves;
+    return *this;
+  }
+
+  char value;
+};
+size_t tracked::copies = 0;
+size_t tracked::moves = 0;
+
+bool operator==(tracked const & lhs, char rhs)
+{
+  return lhs.value == rhs;
+}
+
+template<class TBuffer>
+void check_move_only(TBuffer & buffer)
+{
+  std::vector<int> model;
+  for(int i = 0; i < 100; ++i){
+    token t(i);
+    buffer.insert(boost::move(t));
+    BOOST_CHECK_EQUAL( t.value, -1 );
+    model.push_back(i);
+  }
+  BOOST_CHECK( seq_eq(buffer, model) );
+
+  // Moving the cursor and editing there moves the elements in between
+  buffer.advance(-60);
+  buffer.emplace(6, 7);
+  model.insert(model.begin() + 40, 42);
+  buffer.emplace();
+  model.insert(model.begin() + 41, 0);
+  BOOST_CHECK_EQUAL( buffer.position(), 42u );
+  BOOST_CHECK( seq_eq(buffer, model) );
+
+  token t(-5);
+  buffer.insert(buffer.begin() + 3, boost::move(t));
+  model.insert(model.begin() + 3, -5);
+  buffer.emplace(buffer.end() - 2, 1000);
+  model.insert(model.end() - 2, 1000);
+  BOOST_CHECK_EQUAL( buffer.position(), 43u );
+  BOOST_CHECK( seq_eq(buffer, model) );
+
+  buffer.advance(30);
+  buffer.erase(-20);
+  model.erase(model.begin() + 53, model.begin() + 73);
+  buffer.erase(buffer.begin(), buffer.begin() + 5);
+  model.erase(model.begin(), model.begin() + 5);
+  buffer.emplace(99);
+  model.insert(model.begin() + 48, 99);
+  BOOST_CHECK_EQUAL( buffer.position(), 49u );
+  BOOST_CHECK( seq_eq(buffer, model) );
+}
+
+BOOST_AUTO_TEST_CASE(move_only_elements)
+{
+  gap_buffer<boost::container::deque<token> > buffer;
+  check_move_only(buffer);
+
+  contiguous_gap_buffer<token> contiguous;
+  check_move_only(contiguous);
+
+  // The buffers themselves still move
+  gap_buffer<boost::container::deque<token> > moved(boost::move(buffer));
+  BOOST_CHECK_EQUAL( moved.size(), 80u );
+  BOOST_CHECK( buffer.empty() );
+}
+
+BOOST_AUTO_TEST_CASE(gap_moves_elements)
+{
+  gap_buffer<boost::container::deque<token> > buffer;
+  for(int i = 0; i < 10000; ++i)
+    buffer.emplace(i);
+
+  // Resolving the cursor moves each element between the halves once
+  buffer.advance(-9990);
+  token::moves = 0;
+  buffer.emplace(-1);
+  BOOST_CHECK_GE( token::moves, 9990u );
+  BOOST_CHECK_LT( token::moves, 10100u );
+  BOOST_CHECK_EQUAL( buffer[10].value, -1 );
+  BOOST_CHECK_EQUAL( buffer[11].value, 10 );
+
+  // Elements the cursor passes over are moved, never copied
+  std::string str(10000, 'a');
+  gap_buffer<boost::container::deque<tracked> >
+    copyable(str.begin(), str.end());
+  copyable.advance(-9990);
+  tracked b('b');
+  tracked::copies = 0;
+  copyable.insert(boost::move(b));
+  str.insert(10, 1, 'b');
+  BOOST_CHECK_EQUAL( tracked::copies, 0u );
+
+  // A copy is taken only when inserting an lvalue
+  tracked const c('c');
+  copyable.advance(-5);
+  copyable.insert(c);
+  copyable.insert(copyable.end() - 1, c);
+  str.insert(6, 1, 'c');
+  str.insert(str.size() - 1, 1, 'c');
+  BOOST_CHECK_EQUAL( tracked::copies, 2u );
+  BOOST_CHECK( seq_eq(copyable, str) );
+
+  // Applying a batch copies only the elements it inserts
+  edit_batch<tracked> batch;
+  batch.erase(100, 50);
+  batch.insert(5000, c);
+  tracked::copies = 0;
+  copyable.apply(batch);
+  str.insert(5000, 1, 'c');
+  str.erase(100, 50);
+  BOOST_CHECK_EQUAL( tracked::copies, 1u );
+  BOOST_CHECK( seq_eq(copyable, str) );
+
+  contiguous_gap_buffer<tracked> contiguous(str.begin(), str.end());
+  tracked d('d');
+  tracked::copies = 0;
+  contiguous.advance(-5000);
+  contiguous.insert(boost::move(d));
+  contiguous.emplace(contiguous.begin(), 'e');
+  str.insert(str.size() - 5000, 1, 'd');
+  str.insert(0, 1, 'e');
+  BOOST_CHECK_EQUAL( tracked::copies, 0u );
+  BOOST_CHECK( seq_eq(contiguous, str) );
+}
+
+#if !defined(BOOST_NO_CXX11_SMART_PTR) && \
+    !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+BOOST_AUTO_TEST_CASE(unique_ptr_elements)
+{
+  gap_buffer<std::deque<std::unique_ptr<int> > > buffer;
+  for(int i = 0; i < 20; ++i)
+    buffer.insert(std::unique_ptr<int>(new int(i)));
+  buffer.advance(-10);
+  buffer.emplace(new int(100));
+  buffer.emplace(buffer.begin(), new int(200));
+  std::unique_ptr<int> p(new int(300));
+  buffer.insert(buffer.end(), std::move(p));
+  BOOST_CHECK( !p );
+
+  int const expected[] =
+    { 200, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 100,
+      10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 300 };
+  BOOST_REQUIRE_EQUAL( buffer.size(), 23u );
+  for(size_t i = 0; i < buffer.size(); ++i)
+    BOOST_CHECK_EQUAL( *buffer[i], expected[i] );
+  BOOST_CHECK_EQUAL( buffer.position(), 12u );
+
+  buffer.erase(buffer.begin() + 1, buffer.begin() + 11);
+  BOOST_CHECK_EQUAL( *buffer.front(), 200 );
+  BOOST_CHECK_EQUAL( *buffer.at(1), 100 );
+}
+#endif
+
+
+// ----- ----- ------ Allocators ----- ----- -----
+
+namespace pmr = boost::container::pmr;
+
+typedef gap_buffer<pmr::deque_of<char>::type> pmr_buffer_t;
+typedef pmr::polymorphic_allocator<char> pmr_allocator;
+
+// A memory resource which counts what it allocates, passing the work on
+struct counting_resource
+  : pmr::memory_resource
+{
+  explicit counting_resource(pmr::memory_resource * upstream)
+    : allocations(0)
+    , upstream(upstream)
+  {}
+
+  size_t allocations;
+  pmr::memory_resource * upstream;
+
+private:
+  void * do_allocate(size_t bytes, size_t alignment)
+  {
+    ++allocations;
+    return upstream->allocate(bytes, alignment);
+  }
+  void do_deallocate(void * p, size_t bytes, size_t alignment)
+  {
+    upstream->deallocate(p, bytes, alignment);
+  }
+  bool do_is_equal(pmr::memory_resource const & other) const BOOST_NOEXCEPT
+  {
+    return this == &other;
+  }
+};
+
+BOOST_AUTO_TEST_CASE(allocator_reaches_both_halves)
+{
+  // Anything allocated through the default resource went around the arena
+  counting_resource strays(pmr::new_delete_resource());
+  pmr::memory_resource * const previous = pmr::set_default_resource(&strays);
+
+  std::string const text("the quick brown fox jumps over the lazy dog");
+  {
+    counting_resource counted(pmr::new_delete_resource());
+    pmr::monotonic_buffer_resource arena(&counted);
+    pmr_buffer_t buffer(text.begin(), text.end(), pmr_allocator(&arena));
+    BOOST_CHECK( buffer.get_allocator().resource() == &arena );
+    buffer.advance(-20);
+    buffer.insert(std::string(5000, '-'));
+    buffer.erase(-5000);
+    buffer.advance(10);
+    buffer.insert('x');
+    buffer.erase(-1);
+    BOOST_CHECK( seq_eq(text, buffer) );
+
+    pmr_buffer_t empty((pmr_allocator(&arena)));
+    empty.insert(text);
+    pmr_buffer_t filled(3, 'a', pmr_allocator(&arena));
+    BOOST_CHECK_EQUAL( filled.size(), 3u );
+    BOOST_CHECK_EQUAL( strays.allocations, 0u );
+    BOOST_CHECK_GT( counted.allocations, 0u );
+  }
+
+  pmr::set_default_resource(previous);
+}
+
+BOOST_AUTO_TEST_CASE(allocator_propagation)
+{
+  std::string const text("the quick brown fox jumps over the lazy dog");
+  pmr::monotonic_buffer_resource arena;
+  pmr::unsynchronized_pool_resource pool;
+  pmr_buffer_t buffer(text.begin(), text.end(), pmr_allocator(&arena));
+  buffer.advance(-10);
+
+  // polymorphic_allocator does not follow copies, so a copy uses the default
+  // resource unless it is given one
+  pmr_buffer_t copy(buffer);
+  BOOST_CHECK( copy.get_allocator().resource() ==
+               pmr::get_default_resource() );
+  BOOST_CHECK( seq_eq(text, copy) );
+  BOOST_CHECK_EQUAL( copy.position(), buffer.position() );
+  pmr_buffer_t pooled(buffer, pmr_allocator(&pool));
+  BOOST_CHECK( pooled.get_allocator().resource() == &pool );
+  BOOST_CHECK( pooled == buffer );
+
+  // Nor assignments
+  pmr_buffer_t assigned((pmr_allocator(&pool)));
+  assigned = buffer;
+  BOOST_CHECK( assigned.get_allocator().resource() == &pool );
+  BOOST_CHECK( assigned == buffer );
+  assigned = boost::move(copy);
+  BOOST_CHECK( assigned.get_allocator().resource() == &pool );
+  BOOST_CHECK( seq_eq(text, assigned) );
+
+  // Moving onto another resource moves the elements one at a time
+  pmr_buffer_t moved(boost::move(pooled), pmr_allocator(&arena));
+  BOOST_CHECK( moved.get_allocator().resource() == &arena );
+  BOOST_CHECK( moved == buffer );
+
+  // Buffers sharing a resource may be swapped
+  moved.insert('!');
+  moved.swap(buffer);
+  BOOST_CHECK_EQUAL( buffer.size(), text.size() + 1 );
+  BOOST_CHECK( seq_eq(text, moved) );
+  BOOST_CHECK( buffer.get_allocator().resource() == &arena );
+}
+
+
+// ----- ----- ------ Contiguous Storage ----- ----- -----
+
+typedef contiguous_gap_buffer<char> contiguous_t;
+
+BOOST_AUTO_TEST_CASE(contiguous_properties)
+{
+  contiguous_t buffer;
+  assert_properties_empty(buffer);
+  BOOST_CHECK_EQUAL(buffer.capacity(), 0u);
+
+  std::string const str("Some data to iterate over");
+  contiguous_t filled(str.begin(), str.end());
+  assert_properties_size(filled, str.size());
+  assert_properties_nonempty(filled);
+  assert_position_end(filled);
+  BOOST_CHECK( seq_eq(filled, str) );
+
+  contiguous_t copied(filled);
+  BOOST_CHECK( copied == filled );
+  copied.insert('x');
+  BOOST_CHECK( copied != filled );
+  BOOST_CHECK( filled < copied );
+
+  contiguous_t moved( ::boost::move(copied) );
+  assert_properties_empty(copied);
+  BOOST_CHECK_EQUAL( moved.size(), str.size() + 1 );
+
+  contiguous_t fill(7, 'q');
+  BOOST_CHECK( seq_eq(fill, std::string(7, 'q')) );
+}
+
+BOOST_AUTO_TEST_CASE(contiguous_cursor_edits)
+{
+  std::string str("this is the first test buffer");
+  contiguous_t buffer(str.begin(), str.end());
+
+  // Moving the cursor does not touch the storage
+  buffer.advance(-10);
+  BOOST_CHECK_EQUAL( buffer.position(), str.size() - 10 );
+  BOOST_CHECK( buffer.here() == buffer.begin() + (str.size() - 10) );
+  BOOST_CHECK_EQUAL( *buffer.rhere(), 't' );
+
+  buffer.insert('T');
+  str.insert(str.size() - 10, "T");
+  BOOST_CHECK( seq_eq(buffer, str) );
+
+  buffer.insert(std::string("UV"));
+  str.insert(str.size() - 10, "UV");
+  BOOST_CHECK( seq_eq(buffer, str) );
+
+  buffer.erase(1);
+  str.erase(str.size() - 10, 1);
+  BOOST_CHECK( seq_eq(buffer, str) );
+
+  buffer.erase(-5);
+  str.erase(str.size() - 9 - 5, 5);
+  BOOST_CHECK( seq_eq(buffer, str) );
+  BOOST_CHECK_EQUAL( buffer.position(), str.size() - 9 );
+}
+
+BOOST_AUTO_TEST_CASE(contiguous_iterator_edits)
+{
+  std::string str("Some data to iterate over");
+  contiguous_t buffer(str.begin(), str.end());
+  buffer.advance(-13);
+  size_t position = buffer.position();
+
+  // Before the cursor moves it, at the cursor moves it, after does not
+  buffer.insert(buffer.here() - 1, 3, 'Z');
+  str.insert(position - 1, 3, 'Z');
+  position += 3;
+  BOOST_CHECK( seq_eq(buffer, str) );
+  BOOST_CHECK_EQUAL( position, buffer.position() );
+
+  contiguous_t::iterator inserted = buffer.insert(buffer.here(), 'Y');
+  str.insert(position, 1, 'Y');
+  BOOST_CHECK_EQUAL( *inserted, 'Y' );
+  position += 1;
+  BOOST_CHECK( seq_eq(buffer, str) );
+  BOOST_CHECK_EQUAL( position, buffer.position() );
+
+  std::string const tail("XX");
+  buffer.insert(buffer.here() + 1, tail.begin(), tail.end());
+  str.insert(position + 1, tail);
+  BOOST_CHECK( seq_eq(buffer, str) );
+  BOOST_CHECK_EQUAL( position, buffer.position() );
+
+  // Erasing across the cursor pulls it back to the start of the range
+  buffer.erase(buffer.here() - 2, buffer.here() + 2);
+  str.erase(position - 2, 4);
+  position -= 2;
+  BOOST_CHECK( seq_eq(buffer, str) );
+  BOOST_CHECK_EQUAL( position, buffer.position() );
+
+  buffer.erase(buffer.begin());
+  str.erase(0, 1);
+  BOOST_CHECK( seq_eq(buffer, str) );
+  BOOST_CHECK_EQUAL( --position, buffer.position() );
+
+  buffer.resize(str.size() + 2, '!');
+  str.resize(str.size() + 2, '!');
+  BOOST_CHECK( seq_eq(buffer, str) );
+
+  buffer.resize(4);
+  str.resize(4);
+  BOOST_CHECK( seq_eq(buffer, str) );
+  BOOST_CHECK_EQUAL( 4u, buffer.position() );
+
+  buffer.clear();
+  assert_properties_empty( buffer );
+}
+
+BOOST_AUTO_TEST_CASE(contiguous_nontrivial_elements)
+{
+  // std::string is not trivially copyable, so this exercises the element-wise
+  // relocation paths, including overlapping moves of the gap.
+  contiguous_gap_buffer<std::string> buffer;
+  std::vector<std::string> model;
+  for(int i = 0; i < 200; ++i){
+    std::string const value(1 + i % 17, static_cast<char>('a' + i % 26));
+    buffer.insert(value);
+    model.push_back(value);
+  }
+  BOOST_CHECK( seq_eq(buffer, model) );
+
+  buffer.advance(-150);
+  buffer.insert(std::string("middle"));
+  model.insert(model.begin() + 50, "middle");
+  BOOST_CHECK( seq_eq(buffer, model) );
+
+  buffer.advance(120);
+  buffer.erase(-3);
+  model.erase(model.begin() + 168, model.begin() + 171);
+  BOOST_CHECK( seq_eq(buffer, model) );
+
+  buffer.erase(buffer.begin() + 2, buffer.begin() + 190);
+  model.erase(model.begin() + 2, model.begin() + 190);
+  BOOST_CHECK( seq_eq(buffer, model) );
+}
+
+BOOST_AUTO_TEST_CASE(contiguous_gap_policies)
+{
+  typedef contiguous_gap_buffer<char, geometric_gap_growth<2, 1, 8>,
+                                no_gap_shrink> keep_t;
+  keep_t keep;
+  keep.insert('a');
+  BOOST_CHECK_EQUAL( keep.capacity(), 9u );
+  for(int i = 0; i < 8; ++i)
+    keep.insert('b');
+  BOOST_CHECK_EQUAL( keep.capacity(), 9u );
+  keep.insert('c');
+  BOOST_CHECK_EQUAL( keep.capacity(), 18u );
+  keep.clear();
+  BOOST_CHECK_EQUAL( keep.capacity(), 18u );
+
+  typedef contiguous_gap_buffer<char, geometric_gap_growth<2, 1, 8>,
+                                fractional_gap_shrink<4, 8> > shrink_t;
+  std::string const str(1000, 'z');
+  shrink_t shrink(str.begin(), str.end());
+  size_t const grown = shrink.capacity();
+  shrink.erase(-990);
+  BOOST_CHECK_LT( shrink.capacity(), grown );
+  BOOST_CHECK( seq_eq(shrink, std::string(10, 'z')) );
+}
+
+// Drive the buffer and a string through the same pseudo-random edit script
+template<class TBuffer>
+void run_edit_script(TBuffer & buffer, int steps)
+{
+  std::string model;
+  size_t cursor = 0;
+  unsigned state = 12345;
+  for(int step = 0; step < steps; ++step){
+    state = state * 1103515245u + 12345u;
+    unsigned const roll = (state >> 16) % 6;
+    size_t const size = model.size();
+    switch(roll){
+    case 0:
+      model.insert(cursor++, 1, static_cast<char>('a' + step % 26));
+      buffer.insert(static_cast<char>('a' + step % 26));
+      break;
+    case 1: {
+      std::ptrdiff_t const d = static_cast<std::ptrdiff_t>(state % 61) - 30;
+      if(static_cast<std::ptrdiff_t>(cursor) + d >= 0 && cursor + d <= size){
+        cursor += d;
+        buffer.advance(d);
+      }
+      break;
+    }
+    case 2:
+      if(cursor > 0){
+        model.erase(--cursor, 1);
+        buffer.erase(-1);
+      }
+      break;
+    case 3:
+      if(cursor < size){
+        model.erase(cursor, 1);
+        buffer.erase(1);
+      }
+      break;
+    case 4: {
+      size_t const at = size ? state % size : 0;
+      model.insert(at, 2, 'Q');
+      if(at <= cursor)
+        cursor += 2;
+      buffer.insert(boost::next(buffer.begin(), at), 2, 'Q');
+      break;
+    }
+    default:
+      if(size > 4){
+        size_t const at = state % (size - 4);
+        model.erase(at, 3);
+        cursor -= std::min(at + 3, cursor) - std::min(at, cursor);
+        buffer.erase(boost::next(buffer.begin(), at),
+                     boost::next(buffer.begin(), at + 3));
+      }
+      break;
+    }
+    BOOST_REQUIRE_EQUAL( cursor, buffer.position() );
+    BOOST_REQUIRE( seq_eq(model, buffer) );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(contiguous_edit_script)
+{
+  contiguous_t buffer;
+  run_edit_script(buffer, 2000);
+}
+
+
+// ----- ----- ------ Small Buffers ----- ----- -----
+
+// Return if buffer's elements live inside the buffer object itself
+template<class TBuffer>
+bool stored_inside(TBuffer const & buffer)
+{
+  char const * const first = reinterpret_cast<char const *>(&*buffer.begin());
+  char const * const object = reinterpret_cast<char const *>(&buffer);
+  return first >= object && first < object + sizeof(buffer);
+}
+
+BOOST_AUTO_TEST_CASE(small_inline_storage)
+{
+  small_gap_buffer<char, 16> buffer;
+  assert_properties_empty( buffer );
+  BOOST_CHECK( buffer.is_inline() );
+  BOOST_CHECK_EQUAL( buffer.capacity(), 16u );
+
+  std::string const text("sixteen elements");
+  buffer.insert(text);
+  BOOST_CHECK( buffer.is_inline() );
+  BOOST_CHECK( stored_inside(buffer) );
+  BOOST_CHECK_EQUAL( buffer.capacity(), 16u );
+  BOOST_CHECK( seq_eq(buffer, text) );
+
+  // One more spills to the heap, keeping the contents and cursor
+  buffer.advance(-8);
+  buffer.insert('!');
+  BOOST_CHECK( !buffer.is_inline() );
+  BOOST_CHECK( !stored_inside(buffer) );
+  BOOST_CHECK_GT( buffer.capacity(), 16u );
+  BOOST_CHECK_EQUAL( buffer.position(), 9u );
+  BOOST_CHECK( seq_eq(buffer, std::string("sixteen !elements")) );
+
+  // Shrinking back to fit returns to the inline storage
+  buffer.erase(buffer.begin() + 3, buffer.end());
+  BOOST_CHECK( buffer.is_inline() );
+  BOOST_CHECK( stored_inside(buffer) );
+  BOOST_CHECK_EQUAL( buffer.capacity(), 16u );
+  BOOST_CHECK_EQUAL( buffer.position(), 3u );
+  BOOST_CHECK( seq_eq(buffer, std::string("six")) );
+
+  // Without inline storage, nothing changes
+  BOOST_CHECK( !contiguous_t().is_inline() );
+  BOOST_CHECK_EQUAL( contiguous_t().capacity(), 0u );
+}
+
+BOOST_AUTO_TEST_CASE(small_copy_move_swap)
+{
+  // std::string is not trivially copyable, so elements held inline must be
+  // moved one by one
+  typedef small_gap_buffer<std::string, 4> small_t;
+  std::vector<std::string> few, many;
+  for(int i = 0; i < 3; ++i)
+    few.push_back(std::string(20, static_cast<char>('a' + i)));
+  for(int i = 0; i < 10; ++i)
+    many.push_back(std::string(20, static_cast<char>('k' + i)));
+
+  small_t inline_buffer(few.begin(), few.end());
+  small_t heap_buffer(many.begin(), many.end());
+  inline_buffer.advance(-1);
+  heap_buffer.advance(-4);
+  BOOST_REQUIRE( inline_buffer.is_inline() );
+  BOOST_REQUIRE( !heap_buffer.is_inline() );
+
+  small_t inline_copy(inline_buffer);
+  small_t heap_copy(heap_buffer);
+  BOOST_CHECK( inline_copy.is_inline() );
+  BOOST_CHECK( !heap_copy.is_inline() );
+  BOOST_CHECK( inline_copy == inline_buffer );
+  BOOST_CHECK( heap_copy == heap_buffer );
+  BOOST_CHECK_EQUAL( inline_copy.position(), 2u );
+  BOOST_CHECK_EQUAL( heap_copy.position(), 6u );
+
+  small_t moved( ::boost::move(inline_copy) );
+  BOOST_CHECK( moved.is_inline() );
+  BOOST_CHECK( seq_eq(moved, few) );
+  BOOST_CHECK_EQUAL( moved.position(), 2u );
+  assert_properties_empty( inline_copy );
+  BOOST_CHECK( inline_copy.is_inline() );
+
+  moved.swap(heap_copy);
+  BOOST_CHECK( !moved.is_inline() );
+  BOOST_CHECK( heap_copy.is_inline() );
+  BOOST_CHECK( seq_eq(moved, many) );
+  BOOST_CHECK( seq_eq(heap_copy, few) );
+  BOOST_CHECK_EQUAL( moved.position(), 6u );
+  BOOST_CHECK_EQUAL( heap_copy.position(), 2u );
+
+  heap_copy = ::boost::move(moved);
+  BOOST_CHECK( !heap_copy.is_inline() );
+  BOOST_CHECK( seq_eq(heap_copy, many) );
+  moved = inline_buffer;
+  BOOST_CHECK( moved.is_inline() );
+  BOOST_CHECK( seq_eq(moved, few) );
+}
+
+BOOST_AUTO_TEST_CASE(small_edit_script)
+{
+  // Small enough that the script crosses the inline capacity both ways
+  small_gap_buffer<char, 8, geometric_gap_growth<2, 1, 8>,
+                   fractional_gap_shrink<2, 8> > buffer;
+  run_edit_script(buffer, 2000);
+}
+
+
+// ----- ----- ------ Rope Storage ----- ----- -----
+
+// Tiny nodes, so that a few edits split and merge at every level
+typedef rope_buffer<char, 4, 4> rope_t;
+
+BOOST_AUTO_TEST_CASE(rope_properties)
+{
+  rope_t buffer;
+  BOOST_CHECK( buffer.empty() );
+  BOOST_CHECK_EQUAL( buffer.size(), 0u );
+  BOOST_CHECK( buffer.begin() == buffer.end() );
+
+  std::string const text("the quick brown fox jumps over the lazy dog");
+  rope_t filled(text.begin(), text.end());
+  BOOST_CHECK_EQUAL( filled.size(), text.size() );
+  BOOST_CHECK_EQUAL( filled.position(), text.size() );
+  BOOST_CHECK( seq_eq(text, filled) );
+  BOOST_CHECK( std::equal(text.rbegin(), text.rend(), filled.rbegin()) );
+
+  rope_t copy(filled);
+  BOOST_CHECK( copy == filled );
+  copy.front() = 'T';
+  BOOST_CHECK( copy != filled );
+  BOOST_CHECK( copy < filled );
+  BOOST_CHECK_EQUAL( filled.front(), 't' );
+
+  rope_t moved(boost::move(copy));
+  BOOST_CHECK( copy.empty() );
+  BOOST_CHECK_EQUAL( moved.front(), 'T' );
+
+  rope_t repeated(10, 'x');
+  BOOST_CHECK_EQUAL( std::string(repeated.begin(), repeated.end()),
+                     std::string(10, 'x') );
+}
+
+BOOST_AUTO_TEST_CASE(rope_random_access)
+{
+  std::string const text("abcdefghijklmnopqrstuvwxyz0123456789");
+  rope_t buffer(text.begin(), text.end());
+  for(size_t i = 0; i < text.size(); ++i){
+    BOOST_CHECK_EQUAL( buffer[i], text[i] );
+    BOOST_CHECK_EQUAL( buffer.at(i), text[i] );
+    BOOST_CHECK_EQUAL( *(buffer.begin() + i), text[i] );
   }
+  BOOST_CHECK_THROW( buffer.at(text.size()), std::out_of_range );
 
+  buffer[3] = 'D';
+  BOOST_CHECK_EQUAL( buffer.at(3), 'D' );
+  BOOST_CHECK_EQUAL( buffer.end() - buffer.begin(),
+                     static_cast<std::ptrdiff_t>(text.size()) );
 }
 
+BOOST_AUTO_TEST_CASE(rope_large_edits)
+{
+  // Paste and then cut a block much bigger than a node, in the middle
+  std::string model(50, '-');
+  rope_t buffer(model.begin(), model.end());
+  buffer.advance(-25);
+
+  std::string const paste(1000, '+');
+  buffer.insert(paste);
+  model.insert(25, paste);
+  BOOST_CHECK_EQUAL( buffer.position(), 1025u );
+  BOOST_CHECK( seq_eq(model, buffer) );
+
+  buffer.erase(buffer.begin() + 10, buffer.begin() + 1010);
+  model.erase(10, 1000);
+  BOOST_CHECK_EQUAL( buffer.position(), 25u );
+  BOOST_CHECK( seq_eq(model, buffer) );
+
+  buffer.resize(5);
+  BOOST_CHECK_EQUAL( buffer.position(), 5u );
+  BOOST_CHECK( seq_eq(model.substr(0, 5), buffer) );
+
+  buffer.clear();
+  BOOST_CHECK( buffer.empty() );
+  BOOST_CHECK_EQUAL( buffer.position(), 0u );
+}
+
+BOOST_AUTO_TEST_CASE(rope_edit_script)
+{
+  rope_t buffer;
+  run_edit_script(buffer, 2000);
+}
+
+BOOST_AUTO_TEST_CASE(rope_snapshots)
+{
+  std::string const text("the quick brown fox jumps over the lazy dog");
+  rope_t buffer(text.begin(), text.end());
+  rope_t const snapshot = buffer.snapshot();
+  BOOST_CHECK( snapshot == buffer );
+  BOOST_CHECK_EQUAL( snapshot.position(), buffer.position() );
+
+  // Every kind of edit to the live buffer leaves the snapshot alone
+  buffer.advance(-3);
+  buffer.insert(std::string("sleepy "));
+  buffer.erase(buffer.begin(), buffer.begin() + 4);
+  buffer[0] = 'Q';
+  *(buffer.begin() + 1) = 'U';
+  BOOST_CHECK( seq_eq(std::string("QUick brown fox jumps over the lazy "
+                                  "sleepy dog"), buffer) );
+  BOOST_CHECK( seq_eq(text, snapshot) );
+  BOOST_CHECK_EQUAL( snapshot.position(), text.size() );
+
+  // And copies of a snapshot can be edited without touching either
+  rope_t copy(snapshot);
+  copy.clear();
+  BOOST_CHECK( copy.empty() );
+  BOOST_CHECK( seq_eq(text, snapshot) );
+  BOOST_CHECK_EQUAL( buffer.size(), text.size() + 3 );
+}
+
+BOOST_AUTO_TEST_CASE(rope_iterators_see_writes)
+{
+  std::string const text("abcdefgh");
+  rope_t buffer(text.begin(), text.end());
+  rope_t const & cbuffer = buffer;
+  rope_t const snapshot = buffer.snapshot();
+
+  // A write through one iterator copies the shared chunk, which another
+  // iterator has cached, but that iterator sees the write all the same
+  rope_t::const_iterator const citer = cbuffer.begin();
+  BOOST_CHECK_EQUAL( *citer, 'a' );
+  *buffer.begin() = 'x';
+  BOOST_CHECK_EQUAL( buffer[0], 'x' );
+  BOOST_CHECK_EQUAL( *citer, 'x' );
+  BOOST_CHECK( seq_eq(text, snapshot) );
+}
+
+// The number of chunks of a which are shared with b
+size_t shared_chunks(rope_t const & a, rope_t const & b)
+{
+  rope_t::const_segment_list const runs_a = a.segments();
+  rope_t::const_segment_list const runs_b = b.segments();
+  size_t shared = 0;
+  for(size_t k = 0; k < runs_a.size(); ++k)
+    for(size_t j = 0; j < runs_b.size(); ++j)
+      if(runs_a[k].begin() == runs_b[j].begin())
+        ++shared;
+  return shared;
+}
+
+BOOST_AUTO_TEST_CASE(rope_reads_do_not_unshare)
+{
+  std::string model("a banana, a cabana and a bandana");
+  rope_t buffer(model.begin(), model.end());
+  rope_t const snapshot = buffer.snapshot();
+  size_t const chunks = buffer.segments().size();
+
+  // Reading through mutable iterators leaves every chunk shared
+  size_t count = 0;
+  for(rope_t::iterator i = buffer.begin(); i != buffer.end(); ++i)
+    count += (*i == 'a');
+  BOOST_CHECK_EQUAL( count, 13u );
+  BOOST_CHECK_EQUAL( shared_chunks(buffer, snapshot), chunks );
+
+  // Writes copy only the chunks they land in
+  rope_t::iterator const first = buffer.begin();
+  *first = 'A';
+  *(&*(first + 1)) = '_';
+  model[0] = 'A';
+  model[1] = '_';
+  BOOST_CHECK_EQUAL( shared_chunks(buffer, snapshot), chunks - 1 );
+  std::reverse(buffer.end() - 7, buffer.end());
+  std::reverse(model.end() - 7, model.end());
+  BOOST_CHECK( seq_eq(model, buffer) );
+  BOOST_CHECK( shared_chunks(buffer, snapshot) < chunks - 1 );
+  BOOST_CHECK( shared_chunks(buffer, snapshot) >= chunks - 3 );
+  BOOST_CHECK( seq_eq(std::string("a banana, a cabana and a bandana"),
+                      snapshot) );
+}
+
+BOOST_AUTO_TEST_CASE(rope_snapshot_script)
+{
+  // Snapshot a buffer as it is edited, and check every snapshot afterwards
+  rope_t buffer;
+  std::vector<std::pair<rope_t, std::string> > snapshots;
+  unsigned state = 2468;
+  for(int step = 0; step < 1500; ++step){
+    state = state * 1103515245u + 12345u;
+    size_t const size = buffer.size();
+    size_t const at = size ? state % size : 0;
+    switch((state >> 16) % 4){
+    case 0:
+      buffer.insert(std::string((state >> 8) % 9, 'a' + step % 26));
+      break;
+    case 1:
+      buffer.advance(static_cast<std::ptrdiff_t>(at) -
+                     static_cast<std::ptrdiff_t>(buffer.position()));
+      break;
+    case 2:
+      buffer.erase(buffer.begin() + at,
+                   buffer.begin() + std::min(size, at + (state >> 8) % 7));
+      break;
+    default:
+      if(size)
+        buffer[at] = '#';
+      break;
+    }
+    if(step % 25 == 0)
+      snapshots.push_back(std::make_pair(buffer.snapshot(),
+                                         std::string(buffer.begin(),
+                                                     buffer.end())));
+  }
+  for(size_t i = 0; i < snapshots.size(); ++i)
+    BOOST_REQUIRE( seq_eq(snapshots[i].second, snapshots[i].first) );
+}
+
+
+// ----- ----- ------ Concurrent Readers ----- ----- -----
+
+typedef concurrent_buffer<char, 8, 4> concurrent_t;
+
+BOOST_AUTO_TEST_CASE(concurrent_versions)
+{
+  std::string const str("first version");
+  concurrent_t buffer(str.begin(), str.end(), 2);
+  concurrent_t::reader first(buffer);
+  {
+    concurrent_t::view pinned(first);
+    buffer.writer().advance(-7);
+    buffer.writer().insert(std::string("published "));
+
+    // Edits are unseen until they are published, and a pinned version never
+    // changes, even once it is retired
+    BOOST_CHECK( seq_eq(*pinned, str) );
+    buffer.publish();
+    BOOST_CHECK( seq_eq(*pinned, str) );
+    BOOST_CHECK_EQUAL( pinned->position(), str.size() );
+    BOOST_CHECK_EQUAL( buffer.retired(), 1u );
+    buffer.reclaim();
+    BOOST_CHECK_EQUAL( buffer.retired(), 1u );
+  }
+  {
+    concurrent_t::view latest(first);
+    BOOST_CHECK( seq_eq(*latest, std::string("first published version")) );
+    BOOST_CHECK_EQUAL( latest->position(), 16u );
+  }
+
+  // Once no view can see them, retired versions are freed
+  buffer.writer().erase(-16);
+  buffer.publish();
+  BOOST_CHECK_EQUAL( buffer.retired(), 0u );
+
+  BOOST_CHECK_EQUAL( buffer.max_readers(), 2u );
+  concurrent_t::reader second(buffer);
+  BOOST_CHECK_THROW( concurrent_t::reader third(buffer), std::length_error );
+}
+
+// A reader which checks that every version it sees is the digits 0 to 9
+// repeated, with the cursor at the end, and never shorter than the last
+struct digit_reader
+{
+  digit_reader(concurrent_t & b, boost::atomic<bool> & d,
+               boost::atomic<size_t> & f)
+    : buffer(b)
+    , done(d)
+    , failures(f)
+  {}
+
+  void operator()() const
+  {
+    concurrent_t::reader r(buffer);
+    size_t last = 0;
+    while(!done.load()){
+      concurrent_t::view v(r);
+      size_t const n = v->size();
+      size_t i = 0;
+      for(concurrent_t::buffer_type::const_iterator c = v->begin();
+          c != v->end(); ++c, ++i)
+        if(*c != static_cast<char>('0' + i % 10))
+          ++failures;
+      if(n < last || v->position() != n)
+        ++failures;
+      last = n;
+    }
+  }
+
+  concurrent_t &          buffer;
+  boost::atomic<bool> &   done;
+  boost::atomic<size_t> & failures;
+};
+
+BOOST_AUTO_TEST_CASE(concurrent_readers)
+{
+  concurrent_t buffer(4);
+  boost::atomic<bool> done(false);
+  boost::atomic<size_t> failures(0);
+  boost::thread_group readers;
+  for(int k = 0; k < 3; ++k)
+    readers.create_thread(digit_reader(buffer, done, failures));
+
+  // Edit all over the buffer, only publishing when it is whole again
+  concurrent_t::buffer_type & writer = buffer.writer();
+  for(size_t step = 0; step < 3000; ++step){
+    size_t const n = writer.size();
+    writer.insert(static_cast<char>('0' + n % 10));
+    if(n > 20 && step % 3 == 0){
+      writer.advance(-15);
+      writer.erase(-5);
+      std::string patch;
+      for(size_t j = n - 19; j < n - 14; ++j)
+        patch += static_cast<char>('0' + j % 10);
+      writer.insert(patch);
+      writer.advance(15);
+    }
+    buffer.publish();
+  }
+  done.store(true);
+  readers.join_all();
+
+  BOOST_CHECK_EQUAL( failures.load(), 0u );
+  buffer.reclaim();
+  BOOST_CHECK_EQUAL( buffer.retired(), 0u );
+}
+
+// A reader which keeps copies and snapshots of the version it pins, checking
+// that each holds the same text
+struct copying_reader
+{
+  copying_reader(concurrent_t & b, std::string const & t,
+                 boost::atomic<size_t> & f)
+    : buffer(b)
+    , text(t)
+    , failures(f)
+  {}
+
+  void operator()() const
+  {
+    concurrent_t::reader r(buffer);
+    concurrent_t::view v(r);
+    for(int k = 0; k < 2000; ++k){
+      concurrent_t::buffer_type keep(*v);
+      concurrent_t::buffer_type snap(v->snapshot());
+      if(!seq_eq(keep, text) || !seq_eq(snap, text))
+        ++failures;
+    }
+  }
+
+  concurrent_t &          buffer;
+  std::string const &     text;
+  boost::atomic<size_t> & failures;
+};
+
+BOOST_AUTO_TEST_CASE(concurrent_copies)
+{
+  std::string const str("one version copied by every reader at once");
+  concurrent_t buffer(str.begin(), str.end(), 4);
+  boost::atomic<size_t> failures(0);
+  boost::thread_group readers;
+  for(int k = 0; k < 4; ++k)
+    readers.create_thread(copying_reader(buffer, str, failures));
+  readers.join_all();
+
+  BOOST_CHECK_EQUAL( failures.load(), 0u );
+  BOOST_CHECK( seq_eq(buffer.writer(), str) );
+}
+
+
+// ----- ----- ------ Multiple Cursors ----- ----- -----
+
+BOOST_AUTO_TEST_CASE(multi_cursor_edits)
+{
+  std::string const text("hello world");
+  multi_gap_buffer<std::deque<char> > buffer(text.begin(), text.end());
+  BOOST_CHECK_EQUAL( buffer.cursor_count(), 1u );
+  BOOST_CHECK_EQUAL( buffer.position(), text.size() );
+
+  buffer.advance(-6);
+  multi_gap_buffer<std::deque<char> >::cursor_id const second =
+    buffer.add_cursor(text.size());
+  BOOST_CHECK_EQUAL( buffer.cursor_count(), 2u );
+
+  // Typing at one cursor carries every later cursor along with it
+  buffer.insert(',');
+  BOOST_CHECK_EQUAL( buffer.position(), 6u );
+  BOOST_CHECK_EQUAL( buffer.position(second), 12u );
+  buffer.insert(second, std::string("!!"));
+  BOOST_CHECK_EQUAL( buffer.position(second), 14u );
+  BOOST_CHECK_EQUAL( buffer.position(), 6u );
+  BOOST_CHECK( seq_eq(std::string("hello, world!!"), buffer) );
+  BOOST_CHECK_EQUAL( *boost::prior(buffer.here(second)), '!' );
+
+  // Erasing behind a cursor pulls it and the ones after it back
+  buffer.erase(second, -1);
+  buffer.erase(-1);
+  BOOST_CHECK_EQUAL( buffer.position(), 5u );
+  BOOST_CHECK_EQUAL( buffer.position(second), 12u );
+  BOOST_CHECK( seq_eq(std::string("hello world!"), buffer) );
+
+  // Iterator edits move every cursor at or after them
+  buffer.insert(buffer.begin(), '>');
+  BOOST_CHECK_EQUAL( buffer.position(), 6u );
+  BOOST_CHECK_EQUAL( buffer.position(second), 13u );
+
+  buffer.remove_cursor(second);
+  BOOST_CHECK_EQUAL( buffer.cursor_count(), 1u );
+  BOOST_CHECK( seq_eq(std::string(">hello world!"), buffer) );
+}
+
+BOOST_AUTO_TEST_CASE(multi_alternating_sites_keep_gaps)
+{
+  typedef multi_gap_buffer<std::deque<counted>, 4, 16> multi_counted_t;
+  multi_counted_t buffer(1000, counted('.'));
+  buffer.advance(-900);
+  multi_counted_t::cursor_id const far = buffer.add_cursor(900);
+
+  // The first round pays to open a gap at each site
+  buffer.insert(counted('a'));
+  buffer.insert(far, counted('b'));
+  BOOST_CHECK_EQUAL( buffer.gap_count(), 2u );
+
+  // After that, alternating between them moves nothing but the new elements
+  counted::copies = 0;
+  for(int i = 0; i < 50; ++i){
+    buffer.insert(counted('a'));
+    buffer.insert(far, counted('b'));
+  }
+  BOOST_CHECK_LE( counted::copies, 2u * 2u * 50u );
+  BOOST_CHECK_EQUAL( buffer.gap_count(), 2u );
+  BOOST_CHECK_EQUAL( buffer.size(), 1102u );
+  BOOST_CHECK_EQUAL( buffer.position(), 151u );
+  BOOST_CHECK_EQUAL( buffer.position(far), 1002u );
+
+  // No more than MaxGaps gaps are ever opened
+  for(size_t i = 0; i < 8; ++i)
+    buffer.insert(buffer.add_cursor(i * 130), counted('c'));
+  BOOST_CHECK_LE( buffer.gap_count(), 4u );
+  BOOST_CHECK_EQUAL( buffer.size(), 1110u );
+}
+
+BOOST_AUTO_TEST_CASE(multi_edit_script)
+{
+  multi_gap_buffer<std::deque<char>, 4, 8> buffer;
+  run_edit_script(buffer, 2000);
+}
+
+
+// ----- ----- ------ Relocation ----- ----- -----
+
+BOOST_AUTO_TEST_CASE(relocation_categories)
+{
+  BOOST_CHECK(( boost::is_same<
+                container_traits<std::deque<char> >::relocation_category,
+                bulk_relocation_tag>::value ));
+  BOOST_CHECK(( boost::is_same<
+                container_traits<std::vector<char> >::relocation_category,
+                bulk_relocation_tag>::value ));
+  BOOST_CHECK(( boost::is_same<
+                container_traits<std::deque<std::string> >::
+                relocation_category,
+                move_relocation_tag>::value ));
+  BOOST_CHECK(( boost::is_same<
+                container_traits<std::list<std::string> >::
+                relocation_category,
+                splice_relocation_tag>::value ));
+  BOOST_CHECK(( boost::is_same<
+                container_traits<boost::container::list<char> >::
+                relocation_category,
+                splice_relocation_tag>::value ));
+}
+
+BOOST_AUTO_TEST_CASE(list_gap_moves_by_splicing)
+{
+  std::string str(10000, 'a');
+  gap_buffer<std::list<counted> > buffer(str.begin(), str.end());
+
+  // Resolving the cursor hands nodes from one half to the other
+  buffer.advance(-9990);
+  counted::copies = 0;
+  buffer.insert(counted('w'));
+  str.insert(10, 1, 'w');
+  BOOST_CHECK_LT( counted::copies, 10u );
+  BOOST_CHECK( seq_eq(buffer, str) );
+
+  buffer.advance(9000);
+  counted::copies = 0;
+  buffer.insert(counted('x'));
+  str.insert(9011, 1, 'x');
+  BOOST_CHECK_LT( counted::copies, 10u );
+  BOOST_CHECK_EQUAL( buffer.position(), 9012u );
+  BOOST_CHECK( seq_eq(buffer, str) );
+
+  // And so do the gaps of a multi_gap_buffer
+  multi_gap_buffer<std::list<char>, 4, 8> multi;
+  run_edit_script(multi, 2000);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(backend_edit_script, TBuffer, backends)
+{
+  TBuffer buffer;
+  run_edit_script(buffer, 2000);
+}
+
+
+// ----- ----- ------ Piece Table ----- ----- -----
+
+typedef piece_table_buffer<char> piece_table_t;
+
+// Write text to a new temporary file, and return its name
+std::string write_temporary(std::string const & text)
+{
+  char name[] = "/tmp/gap_buffer_tests_XXXXXX";
+  int const fd = ::mkstemp(name);
+  BOOST_REQUIRE( fd >= 0 );
+  BOOST_REQUIRE_EQUAL( ::write(fd, text.data(), text.size()),
+                       static_cast<ssize_t>(text.size()) );
+  ::close(fd);
+  return name;
+}
+
+BOOST_AUTO_TEST_CASE(piece_table_from_file)
+{
+  std::string const text("the quick brown fox jumps over the lazy dog");
+  std::string const name = write_temporary(text);
+  boost::shared_ptr<mapped_file const> file(new mapped_file(name));
+  // The mapping outlives the file's name
+  std::remove(name.c_str());
+
+  piece_table_t buffer(file);
+  BOOST_CHECK_EQUAL( buffer.size(), text.size() );
+  BOOST_CHECK_EQUAL( buffer.position(), 0u );
+  BOOST_CHECK_EQUAL( buffer.piece_count(), 1u );
+  BOOST_CHECK( seq_eq(text, buffer) );
+  // The elements are those of the mapping, not a copy of them
+  BOOST_CHECK_EQUAL( &buffer[4], file->data() + 4 );
+
+  buffer.advance(4);
+  buffer.erase(12);
+  buffer.insert(std::string("slow "));
+  buffer.insert(buffer.end(), '!');
+  BOOST_CHECK( seq_eq(std::string("the slow fox jumps over the lazy dog!"),
+                      buffer) );
+  BOOST_CHECK_EQUAL( buffer.position(), 9u );
+  BOOST_CHECK_EQUAL( buffer.piece_count(), 4u );
+  BOOST_CHECK_EQUAL( &buffer[20], file->data() + 27 );
+
+  // Copies share the file, but not their edits
+  piece_table_t copy(buffer);
+  copy.erase(copy.begin(), copy.begin() + 9);
+  BOOST_CHECK( copy != buffer );
+  BOOST_CHECK( seq_eq(std::string("fox jumps over the lazy dog!"), copy) );
+  BOOST_CHECK_EQUAL( buffer.size(), 37u );
+  BOOST_CHECK_EQUAL( file.use_count(), 3 );
+  buffer.clear();
+  BOOST_CHECK( buffer.empty() );
+  BOOST_CHECK_EQUAL( file.use_count(), 2 );
+
+  std::string const empty_name = write_temporary(std::string());
+  piece_table_t empty(boost::shared_ptr<mapped_file const>(
+                        new mapped_file(empty_name)));
+  std::remove(empty_name.c_str());
+  BOOST_CHECK( empty.empty() );
+  BOOST_CHECK( empty.segments().empty() );
+
+  BOOST_CHECK_THROW( mapped_file("/nonexistent/gap_buffer/file"),
+                     boost::system::system_error );
+}
+
+BOOST_AUTO_TEST_CASE(piece_table_pieces)
+{
+  std::string const text("abcdefghijklmnopqrstuvwxyz");
+  piece_table_t buffer(text.begin(), text.end());
+  BOOST_CHECK_EQUAL( buffer.piece_count(), 1u );
+  BOOST_CHECK_EQUAL( buffer.position(), text.size() );
+  for(size_t i = 0; i < text.size(); ++i)
+    BOOST_CHECK_EQUAL( *(buffer.begin() + i), text[i] );
+  BOOST_CHECK_THROW( buffer.at(text.size()), std::out_of_range );
+
+  // Typing carries on one piece
+  buffer.advance(-13);
+  for(char c = '0'; c <= '9'; ++c)
+    buffer.insert(c);
+  BOOST_CHECK_EQUAL( buffer.piece_count(), 3u );
+  BOOST_CHECK( seq_eq(std::string("abcdefghijklm0123456789nopqrstuvwxyz"),
+                      buffer) );
+
+  // Inserting part of the buffer into itself
+  buffer.insert(buffer.begin(), buffer.begin() + 13, buffer.begin() + 16);
+  BOOST_CHECK( seq_eq(std::string("012abcdefghijklm0123456789nopqrstuvwxyz"),
+                      buffer) );
+  BOOST_CHECK_EQUAL( buffer.position(), 26u );
+  BOOST_CHECK( std::equal(buffer.rbegin(), buffer.rend(),
+                          std::string("zyxwvutsrqpon9876543210mlkjihgfedcba"
+                                      "210").begin()) );
+
+  buffer.resize(5);
+  BOOST_CHECK( seq_eq(std::string("012ab"), buffer) );
+  buffer.resize(7, '?');
+  BOOST_CHECK( seq_eq(std::string("012ab??"), buffer) );
+  BOOST_CHECK_EQUAL( buffer.segments().size(), buffer.piece_count() );
+}
+
+BOOST_AUTO_TEST_CASE(piece_table_edit_script)
+{
+  piece_table_t buffer;
+  run_edit_script(buffer, 2000);
+}
+
+
+// ----- ----- ------ Undo Journal ----- ----- -----
+
+typedef gap_buffer<std::deque<char>, undo_journal<char> > journaled_t;
+
+BOOST_AUTO_TEST_CASE(undo_typing_runs)
+{
+  journaled_t buffer;
+  BOOST_CHECK( !buffer.observer().can_undo() );
+  buffer.insert('a');
+  buffer.insert('b');
+  buffer.insert(std::string("cd"));
+  BOOST_CHECK_EQUAL( buffer.observer().record_count(), 1u );
+
+  // Moving the cursor ends the run
+  buffer.advance(-2);
+  buffer.insert('X');
+  BOOST_CHECK_EQUAL( buffer.observer().record_count(), 2u );
+  BOOST_CHECK( seq_eq(std::string("abXcd"), buffer) );
+
+  // Without a checkpoint, both runs are one step
+  BOOST_CHECK( buffer.observer().undo(buffer) );
+  BOOST_CHECK( buffer.empty() );
+  BOOST_CHECK_EQUAL( buffer.position(), 0u );
+  BOOST_CHECK( !buffer.observer().undo(buffer) );
+
+  BOOST_CHECK( buffer.observer().redo(buffer) );
+  BOOST_CHECK( seq_eq(std::string("abXcd"), buffer) );
+  BOOST_CHECK_EQUAL( buffer.position(), 3u );
+  BOOST_CHECK( !buffer.observer().redo(buffer) );
+}
+
+BOOST_AUTO_TEST_CASE(undo_erase_runs)
+{
+  std::string const text("hello world");
+  journaled_t buffer(text.begin(), text.end());
+
+  // Backspacing coalesces into one record
+  buffer.erase(-1);
+  buffer.erase(-1);
+  buffer.erase(-2);
+  BOOST_CHECK_EQUAL( buffer.observer().record_count(), 1u );
+  buffer.observer().checkpoint();
+
+  // So does deleting forwards
+  buffer.advance(-7);
+  buffer.erase(1);
+  buffer.erase(2);
+  BOOST_CHECK_EQUAL( buffer.observer().record_count(), 2u );
+  BOOST_CHECK( seq_eq(std::string("lo w"), buffer) );
+
+  BOOST_CHECK( buffer.observer().undo(buffer) );
+  BOOST_CHECK( seq_eq(std::string("hello w"), buffer) );
+  BOOST_CHECK_EQUAL( buffer.position(), 0u );
+  BOOST_CHECK( buffer.observer().undo(buffer) );
+  BOOST_CHECK( seq_eq(text, buffer) );
+  BOOST_CHECK_EQUAL( buffer.position(), text.size() );
+
+  BOOST_CHECK( buffer.observer().redo(buffer) );
+  BOOST_CHECK( seq_eq(std::string("hello w"), buffer) );
+  BOOST_CHECK_EQUAL( buffer.position(), 7u );
+
+  // A fresh edit forgets what could have been redone
+  buffer.insert('!');
+  BOOST_CHECK( !buffer.observer().can_redo() );
+  BOOST_CHECK( buffer.observer().undo(buffer) );
+  BOOST_CHECK( seq_eq(std::string("hello w"), buffer) );
+}
+
+BOOST_AUTO_TEST_CASE(undo_memory_limit)
+{
+  journaled_t buffer;
+  buffer.observer() = undo_journal<char>(512);
+  for(int i = 0; i < 1000; ++i){
+    buffer.insert('a');
+    buffer.observer().checkpoint();
+    BOOST_REQUIRE_LE( buffer.observer().memory_usage(), 512u );
+  }
+
+  // Only the most recent steps can be undone, and undoing them is exact
+  size_t undone = 0;
+  while(buffer.observer().undo(buffer))
+    ++undone;
+  BOOST_CHECK_GT( undone, 0u );
+  BOOST_CHECK_LT( undone, 1000u );
+  BOOST_CHECK_EQUAL( buffer.size(), 1000u - undone );
+  BOOST_CHECK_EQUAL( buffer.position(), 1000u - undone );
+}
+
+BOOST_AUTO_TEST_CASE(undo_edit_script)
+{
+  // Check undo and redo against a history of whole copies of the text
+  journaled_t buffer;
+  std::vector<std::string> history(1);
+  size_t current = 0;
+  unsigned state = 54321;
+  for(int step = 0; step < 600; ++step){
+    state = state * 1103515245u + 12345u;
+    unsigned const roll = (state >> 16) % 8;
+    size_t const size = buffer.size();
+    if(roll == 0){
+      if(buffer.observer().undo(buffer))
+        --current;
+    }else if(roll == 1){
+      if(buffer.observer().redo(buffer))
+        ++current;
+    }else{
+      // A step of a few edits of every kind
+      bool changed = false;
+      for(unsigned edit = 0; edit <= (state >> 8) % 3; ++edit){
+        state = state * 1103515245u + 12345u;
+        size_t const at = size ? state % buffer.size() + 1 : 0;
+        switch((state >> 16) % 5){
+        case 0:
+          buffer.insert(static_cast<char>('a' + step % 26));
+          changed = true;
+          break;
+        case 1:
+          buffer.insert(std::string("xyz"));
+          changed = true;
+          break;
+        case 2:
+          if(buffer.position() > 0){
+            buffer.erase(-1);
+            changed = true;
+          }
+          break;
+        case 3:
+          buffer.advance(static_cast<std::ptrdiff_t>(std::min(at,
+                                                              buffer.size())) -
+                         static_cast<std::ptrdiff_t>(buffer.position()));
+          if(buffer.position() < buffer.size()){
+            buffer.erase(1);
+            changed = true;
+          }
+          break;
+        default:
+          buffer.insert(boost::next(buffer.begin(),
+                                    std::min(at, buffer.size())), 2, 'Q');
+          changed = true;
+          break;
+        }
+      }
+      buffer.observer().checkpoint();
+      if(changed){
+        history.resize(++current);
+        history.push_back(std::string(buffer.begin(), buffer.end()));
+      }
+    }
+    BOOST_REQUIRE( seq_eq(history[current], buffer) );
+  }
+}
+
+
+// ----- ----- ------ Edit Traces ----- ----- -----
+
+typedef gap_buffer<std::deque<char>, edit_recorder<char> > recorded_t;
+
+// Return the trace recorder has recorded
+edit_trace<char> read_trace(edit_recorder<char> & recorder)
+{
+  std::stringstream trace;
+  recorder.flush(trace);
+  return edit_trace<char>(trace);
+}
+
+BOOST_AUTO_TEST_CASE(trace_records_each_form)
+{
+  std::string const text("hello world");
+  recorded_t buffer(text.begin(), text.end());
+  buffer.advance(-6);
+  buffer.insert(',');
+  buffer.insert(boost::next(buffer.begin(), 1), 'E');
+  buffer.insert(buffer.here(), '!');
+  buffer.erase(-1);
+  buffer.erase(1);
+  buffer.erase(buffer.begin(), boost::next(buffer.begin()));
+  buffer.resize(12, '?');
+  buffer.resize(8);
+  BOOST_CHECK( seq_eq(std::string("Eello,wo"), buffer) );
+  buffer.clear();
+  BOOST_CHECK_EQUAL( buffer.observer().record_count(), 11u );
+
+  typedef edit_trace<char> trace_t;
+  trace_t const trace = read_trace(buffer.observer());
+  trace_t::operation const expected[] = {
+    trace_t::reset, trace_t::advance, trace_t::insert, trace_t::insert_at,
+    trace_t::insert, trace_t::erase_before, trace_t::erase_after,
+    trace_t::erase_at, trace_t::insert_at, trace_t::erase_at, trace_t::clear
+  };
+  BOOST_REQUIRE_EQUAL( trace.size(), 11u );
+  for(std::size_t i = 0; i != trace.size(); ++i)
+    BOOST_CHECK_EQUAL( trace.op(i), expected[i] );
+
+  // Replaying all but the last edit leaves what the buffer held before it
+  rope_t replayed;
+  for(std::size_t i = 0; i + 1 != trace.size(); ++i)
+    trace.apply(replayed, i);
+  BOOST_CHECK( seq_eq(std::string("Eello,wo"), replayed) );
+  BOOST_CHECK_EQUAL( replayed.position(), 6u );
+  trace.apply(replayed, trace.size() - 1);
+  BOOST_CHECK( replayed.empty() );
+}
+
+BOOST_AUTO_TEST_CASE(trace_replays_on_other_buffers)
+{
+  recorded_t buffer;
+  std::stringstream stream;
+  run_edit_script(buffer, 2000);
+  // A trace may be flushed in pieces
+  buffer.observer().flush(stream);
+  BOOST_CHECK_EQUAL( buffer.observer().pending().size(), 0u );
+  buffer.resize(buffer.size() / 2);
+  buffer.insert(std::string("tail"));
+  buffer.observer().flush(stream);
+  edit_trace<char> const trace(stream);
+  BOOST_CHECK_EQUAL( trace.size(), buffer.observer().record_count() );
+
+  gap_buffer<std::list<char> > listed;
+  trace.apply(listed);
+  BOOST_CHECK( seq_eq(buffer, listed) );
+  BOOST_CHECK_EQUAL( listed.position(), buffer.position() );
+
+  contiguous_t contiguous;
+  trace.apply(contiguous);
+  BOOST_CHECK( seq_eq(buffer, contiguous) );
+  BOOST_CHECK_EQUAL( contiguous.position(), buffer.position() );
+
+  rope_t rope;
+  trace.apply(rope);
+  BOOST_CHECK( seq_eq(buffer, rope) );
+  BOOST_CHECK_EQUAL( rope.position(), buffer.position() );
+}
+
+BOOST_AUTO_TEST_CASE(trace_rejects_malformed)
+{
+  recorded_t buffer;
+  buffer.insert(std::string("abc"));
+  buffer.erase(-2);
+  std::string const good = buffer.observer().pending();
+  std::istringstream whole(good);
+  BOOST_CHECK_EQUAL( edit_trace<char>(whole).size(), 2u );
+
+  // Cut short
+  std::istringstream cut(good.substr(0, good.size() - 1));
+  BOOST_CHECK_THROW( edit_trace<char> trace(cut), std::invalid_argument );
+  // Not a trace at all
+  std::istringstream other("hello world");
+  BOOST_CHECK_THROW( edit_trace<char> trace(other), std::invalid_argument );
+  // Of elements of another size
+  std::istringstream wide(good);
+  BOOST_CHECK_THROW( edit_trace<wchar_t> trace(wide), std::invalid_argument );
+  // Erasing more than the buffer holds
+  std::string impossible(good);
+  impossible[impossible.size() - 1] = 4;
+  std::istringstream past(impossible);
+  BOOST_CHECK_THROW( edit_trace<char> trace(past), std::invalid_argument );
+}
+
+
+// ----- ----- ------ Buffer Statistics ----- ----- -----
+
+BOOST_AUTO_TEST_CASE(stats_count_resolves)
+{
+  typedef gap_buffer<std::vector<char>, null_observer, buffer_stats> counted_t;
+  counted_t buffer;
+  buffer.insert(std::string("hello world"));
+  buffer.advance(-5);
+  buffer.insert('_');
+  buffer.advance(-2);
+  buffer.insert(std::string("ab"));
+  buffer.erase(1);
+  BOOST_CHECK( seq_eq(std::string("helloab_world"), buffer) );
+
+  buffer_stats const & stats = buffer.stats();
+  BOOST_CHECK_EQUAL( stats.resolves(gap_insert), 1u );
+  BOOST_CHECK_EQUAL( stats.elements_moved(gap_insert), 5u );
+  BOOST_CHECK_EQUAL( stats.resolves(gap_insert_range), 1u );
+  BOOST_CHECK_EQUAL( stats.elements_moved(gap_insert_range), 2u );
+  BOOST_CHECK_EQUAL( stats.peak_size(), 14u );
+  // Both halves had to allocate, once the gap moved
+  BOOST_CHECK_EQUAL( stats.allocations(before_half), 1u );
+  BOOST_CHECK_EQUAL( stats.bytes_allocated(before_half), 11u );
+  BOOST_CHECK( stats.allocations(after_half) >= 1u );
+  BOOST_CHECK( stats.bytes_allocated(after_half) >= 5u );
+
+  buffer_memory const memory = buffer.memory_usage();
+  BOOST_CHECK_EQUAL( memory.live, 13u );
+  BOOST_CHECK( memory.before.bytes + memory.after.bytes >= memory.live );
+
+  // Stats belong to their buffer, and are not copied with it, but a copy does count the storage it starts with
+  counted_t const copy(buffer);
+  BOOST_CHECK_EQUAL( copy.stats().resolves(gap_insert), 0u );
+  BOOST_CHECK_EQUAL( copy.stats().peak_size(), copy.size() );
+  BOOST_CHECK_EQUAL( copy.stats().allocations(before_half), 1u );
+  BOOST_CHECK_EQUAL( copy.stats().bytes_allocated(before_half), 7u );
+  BOOST_CHECK_EQUAL( copy.stats().allocations(after_half), 1u );
+  BOOST_CHECK_EQUAL( copy.stats().bytes_allocated(after_half), 6u );
+  counted_t temp(copy);
+  counted_t const moved(::boost::move(temp));
+  BOOST_CHECK_EQUAL( moved.stats().peak_size(), copy.size() );
+  buffer.stats().reset();
+  BOOST_CHECK_EQUAL( stats.resolves(gap_insert), 0u );
+  BOOST_CHECK_EQUAL( stats.allocations(before_half), 0u );
+  BOOST_CHECK_EQUAL( stats.peak_size(), 0u );
+}
+
+BOOST_AUTO_TEST_CASE(stats_see_through_splices)
+{
+  typedef gap_buffer<std::list<char>, null_observer, buffer_stats> counted_t;
+  counted_t buffer;
+  buffer.insert(std::string("abcdef"));
+  BOOST_CHECK_EQUAL( buffer.stats().allocations(before_half), 6u );
+  buffer.advance(-3);
+  buffer.insert('x');
+  BOOST_CHECK( seq_eq(std::string("abcxdef"), buffer) );
+  BOOST_CHECK_EQUAL( buffer.stats().elements_moved(gap_insert), 3u );
+  // Splicing the nodes across the gap allocates nothing
+  BOOST_CHECK_EQUAL( buffer.stats().allocations(before_half), 7u );
+  BOOST_CHECK_EQUAL( buffer.stats().allocations(after_half), 0u );
+}
+
+// Insert 1000 elements one at a time at the end of a new TCounted, and
+// return its stats
+template<class TCounted>
+buffer_stats count_inserts()
+{
+  TCounted buffer;
+  for(int i = 0; i < 1000; ++i)
+    buffer.insert('x');
+  return buffer.stats();
+}
+
+BOOST_AUTO_TEST_CASE(stats_only_count_measured_storage)
+{
+  // A deque allocates a block at a time
+  buffer_stats const blocks = count_inserts<
+    gap_buffer<boost::container::deque<char>, null_observer, buffer_stats> >();
+  BOOST_CHECK( blocks.allocations(before_half) >= 1u );
+  BOOST_CHECK( blocks.allocations(before_half) < 10u );
+  BOOST_CHECK( blocks.bytes_allocated(before_half) >= 1000u );
+  BOOST_CHECK( blocks.bytes_allocated(before_half) < 4000u );
+
+  // A vector reallocates geometrically
+  buffer_stats const grown = count_inserts<
+    gap_buffer<boost::container::vector<char>, null_observer, buffer_stats> >();
+  BOOST_CHECK( grown.allocations(before_half) >= 2u );
+  BOOST_CHECK( grown.allocations(before_half) < 30u );
+  BOOST_CHECK( grown.bytes_allocated(before_half) >= 1000u );
+
+  // A container whose storage_traits only guess counts no allocations
+  buffer_stats const guessed = count_inserts<
+    gap_buffer<boost::container::stable_vector<char>, null_observer,
+               buffer_stats> >();
+  BOOST_CHECK_EQUAL( guessed.allocations(before_half), 0u );
+  BOOST_CHECK_EQUAL( guessed.bytes_allocated(before_half), 0u );
+  BOOST_CHECK_EQUAL( guessed.peak_size(), 1000u );
+}
+
+BOOST_AUTO_TEST_CASE(stats_cost_nothing_by_default)
+{
+  typedef gap_buffer<std::vector<char> > buffer_t;
+  BOOST_CHECK_EQUAL( sizeof(buffer_t),
+                     2 * sizeof(std::vector<char>) + sizeof(std::ptrdiff_t) );
+  std::string const text(10000, 'a');
+  buffer_t const buffer(text.begin(), text.end());
+  buffer_memory const memory = buffer.memory_usage();
+  BOOST_CHECK_EQUAL( memory.live, 10000u );
+  BOOST_CHECK( memory.before.bytes >= memory.live );
+  BOOST_CHECK( memory.before.blocks >= 1u );
+}
+
+
+BOOST_AUTO_TEST_CASE(latency_histogram_buckets)
+{
+  latency_histogram histogram;
+  BOOST_CHECK_EQUAL( histogram.value_at_percentile(99), 0u );
+  for(latency_histogram::value_type i = 1; i <= 1000; ++i)
+    histogram.record(i);
+  histogram.record(5000000);
+  BOOST_CHECK_EQUAL( histogram.count(), 1001u );
+  BOOST_CHECK_EQUAL( histogram.min(), 1u );
+  BOOST_CHECK_EQUAL( histogram.max(), 5000000u );
+  // Small values are exact, and large ones within the width of their bucket
+  BOOST_CHECK_EQUAL( histogram.value_at_percentile(5), 51u );
+  latency_histogram::value_type const median =
+    histogram.value_at_percentile(50);
+  BOOST_CHECK( median >= 501u && median <= 501u + 501u / 32 );
+  // The one slow value is found, however rare
+  BOOST_CHECK_EQUAL( histogram.value_at_percentile(100), 5000000u );
+  BOOST_CHECK( histogram.value_at_percentile(99.9) <= 1000u + 1000u / 32 );
+
+  std::ostringstream text;
+  histogram.print(text);
+  BOOST_CHECK( text.str().find("Total count    =         1001") !=
+               std::string::npos );
+  histogram.reset();
+  BOOST_CHECK_EQUAL( histogram.count(), 0u );
+}
+
+BOOST_AUTO_TEST_CASE(latency_stats_time_each_operation)
+{
+  typedef gap_buffer<std::deque<char>, null_observer, latency_stats> timed_t;
+  timed_t buffer;
+  for(int i = 0; i != 100; ++i)
+    buffer.insert('a');
+  buffer.advance(-10);
+  buffer.insert(std::string("bc"));
+  buffer.erase(-1);
+  buffer.insert(buffer.begin(), 'd');
+  buffer.erase(buffer.begin());
+  BOOST_CHECK_EQUAL( buffer.size(), 101u );
+
+  latency_stats const & stats = buffer.stats();
+  BOOST_CHECK_EQUAL( stats.histogram(gap_insert, 0).count(), 100u );
+  BOOST_CHECK_EQUAL( stats.histogram(gap_insert_range, 0).count(), 1u );
+  // Only the insert which moved the gap had to resolve it
+  BOOST_CHECK_EQUAL( stats.histogram(gap_resolve, 0).count(), 1u );
+  BOOST_CHECK_EQUAL( stats.histogram(gap_erase, 0).count(), 1u );
+  BOOST_CHECK_EQUAL( stats.histogram(gap_insert_at, 0).count(), 1u );
+  BOOST_CHECK_EQUAL( stats.histogram(gap_erase_at).count(), 1u );
+  BOOST_CHECK_EQUAL( stats.histogram(gap_insert, 1).count(), 0u );
+
+  BOOST_CHECK_EQUAL( latency_stats::size_class(1023), 0u );
+  BOOST_CHECK_EQUAL( latency_stats::size_class(1024), 1u );
+  BOOST_CHECK_EQUAL( latency_stats::size_class(size_t(1) << 40),
+                     latency_stats::size_class_count - 1 );
+
+  std::ostringstream text;
+  stats.print(text);
+  BOOST_CHECK( text.str().find("insert_range") != std::string::npos );
+  BOOST_CHECK( text.str().find("<1024") != std::string::npos );
+}
+
+
+// ----- ----- ------ Line Index ----- ----- -----
+
+typedef gap_buffer<std::deque<char>, line_index<char> > indexed_t;
+
+// Check every query of the index against a scan of text
+void check_line_index(indexed_t const & buffer, std::string const & text)
+{
+  line_index<char> const & index = buffer.observer();
+  BOOST_REQUIRE_EQUAL( index.size(), text.size() );
+  std::vector<size_t> starts(1, 0);
+  for(size_t i = 0; i < text.size(); ++i)
+    if(text[i] == '\n')
+      starts.push_back(i + 1);
+  BOOST_REQUIRE_EQUAL( index.line_count(), starts.size() );
+  for(size_t line = 0; line < starts.size(); ++line)
+    BOOST_REQUIRE_EQUAL( index.line_start(line), starts[line] );
+  size_t const step = text.size() / 200 + 1;
+  for(size_t position = 0; position <= text.size(); position += step){
+    size_t const line =
+      std::upper_bound(starts.begin(), starts.end(), position) -
+      starts.begin() - 1;
+    BOOST_REQUIRE_EQUAL( index.line_of(position), line );
+    BOOST_REQUIRE_EQUAL( index.column_of(position), position - starts[line] );
+  }
+  BOOST_REQUIRE_EQUAL( index.line_of(text.size()), starts.size() - 1 );
+}
+
+BOOST_AUTO_TEST_CASE(line_index_edits)
+{
+  std::string text("first\nsecond\n\nfourth");
+  indexed_t buffer(text.begin(), text.end());
+  BOOST_CHECK_EQUAL( buffer.observer().line_count(), 4u );
+  BOOST_CHECK_EQUAL( buffer.observer().line_start(3), 14u );
+  BOOST_CHECK_EQUAL( buffer.observer().line_of(6), 1u );
+  BOOST_CHECK_EQUAL( buffer.observer().line_of(5), 0u );
+  BOOST_CHECK_EQUAL( buffer.observer().column_of(18), 4u );
+  check_line_index(buffer, text);
+
+  // Typing at the cursor
+  buffer.advance(-6);
+  buffer.insert(std::string("third\n"));
+  text.insert(text.size() - 6, "third\n");
+  check_line_index(buffer, text);
+  BOOST_CHECK_EQUAL( buffer.observer().line_of(buffer.position()), 4u );
+
+  // Erasing at the cursor and through iterators
+  buffer.erase(-1);
+  text.erase(buffer.position(), 1);
+  check_line_index(buffer, text);
+  buffer.erase(buffer.begin(), boost::next(buffer.begin(), 6));
+  text.erase(0, 6);
+  check_line_index(buffer, text);
+  buffer.insert(buffer.end(), 3, '\n');
+  text.append(3, '\n');
+  check_line_index(buffer, text);
+
+  buffer.clear();
+  BOOST_CHECK_EQUAL( buffer.observer().line_count(), 1u );
+  BOOST_CHECK_EQUAL( buffer.observer().line_of(0), 0u );
+}
+
+BOOST_AUTO_TEST_CASE(line_index_large_file)
+{
+  // Enough lines that the index is split into many chunks, which big edits
+  // then empty and merge
+  std::string text;
+  for(int line = 0; line < 5000; ++line)
+    text += std::string(line % 13, 'x') + "\n";
+  indexed_t buffer(text.begin(), text.end());
+  check_line_index(buffer, text);
+
+  unsigned state = 2024;
+  for(int step = 0; step < 300; ++step){
+    state = state * 1103515245u + 12345u;
+    size_t const at = text.empty() ? 0 : state % text.size();
+    if((state >> 16) % 3 == 0 && !text.empty()){
+      size_t const length = std::min<size_t>((state >> 8) % 4000,
+                                             text.size() - at);
+      buffer.erase(boost::next(buffer.begin(), at),
+                   boost::next(buffer.begin(), at + length));
+      text.erase(at, length);
+    }else{
+      std::string inserted;
+      for(unsigned n = (state >> 8) % 700; n > 0; --n)
+        inserted += (n % 5 == 0) ? '\n' : 'y';
+      buffer.insert(boost::next(buffer.begin(), at),
+                    inserted.begin(), inserted.end());
+      text.insert(at, inserted);
+    }
+    if(step % 10 == 0)
+      check_line_index(buffer, text);
+  }
+  check_line_index(buffer, text);
+}
+
+
+// ----- ----- ------ UTF-8 Index ----- ----- -----
+
+typedef gap_buffer<std::deque<char>, utf8_index<char> > utf8_t;
+
+// Check every conversion of the index against a scan of text, which must be
+// well-formed
+void check_utf8_index(utf8_t & buffer, std::string const & text)
+{
+  utf8_index<char> & index = buffer.observer();
+  std::vector<size_t> starts;
+  std::vector<size_t> units(1, 0);
+  for(size_t i = 0; i < text.size(); ++i)
+    if((static_cast<unsigned char>(text[i]) & 0xC0) != 0x80){
+      starts.push_back(i);
+      bool const astral = static_cast<unsigned char>(text[i]) >= 0xF0;
+      units.push_back(units.back() + (astral ? 2 : 1));
+    }
+  BOOST_REQUIRE_EQUAL( index.error_count(buffer), 0u );
+  BOOST_REQUIRE_EQUAL( index.code_points(buffer), starts.size() );
+  BOOST_REQUIRE_EQUAL( index.utf16_length(buffer), units.back() );
+  size_t const step = text.size() / 300 + 1;
+  for(size_t position = 0; position < text.size(); position += step){
+    size_t const point =
+      std::upper_bound(starts.begin(), starts.end(), position) -
+      starts.begin() - 1;
+    BOOST_REQUIRE_EQUAL( index.code_point_of(buffer, position), point );
+    BOOST_REQUIRE_EQUAL( index.utf16_of(buffer, position), units[point] );
+  }
+  for(size_t point = 0; point < starts.size(); point += step){
+    BOOST_REQUIRE_EQUAL( index.byte_of_code_point(buffer, point),
+                         starts[point] );
+    BOOST_REQUIRE_EQUAL( index.byte_of_utf16(buffer, units[point]),
+                         starts[point] );
+  }
+  BOOST_REQUIRE_EQUAL( index.code_point_of(buffer, text.size()),
+                       starts.size() );
+  BOOST_REQUIRE_EQUAL( index.byte_of_code_point(buffer, starts.size()),
+                       text.size() );
+}
+
+// Text drawing on every length of code point, starting from seed
+std::string mixed_utf8(unsigned seed, size_t points)
+{
+  static char const * const samples[] =
+    { "a", "Z", " ", "\xC3\xA9", "\xD0\x96", "\xE2\x82\xAC", "\xE4\xB8\xAD",
+      "\xF0\x9F\x98\x80", "\xF0\x90\x8D\x88" };
+  std::string text;
+  for(size_t n = 0; n < points; ++n){
+    seed = seed * 1103515245u + 12345u;
+    // Mostly ASCII, as most text is, to exercise the skipping of it
+    size_t const pick = (seed >> 16) % 16;
+    text += samples[pick < 8 ? pick % 3 : pick - 7];
+  }
+  return text;
+}
+
+BOOST_AUTO_TEST_CASE(utf8_index_conversions)
+{
+  std::string text("a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80z");
+  utf8_t buffer(text.begin(), text.end());
+  utf8_index<char> & index = buffer.observer();
+  BOOST_CHECK_EQUAL( index.code_points(buffer), 5u );
+  BOOST_CHECK_EQUAL( index.utf16_length(buffer), 6u );
+  BOOST_CHECK_EQUAL( index.code_point_of(buffer, 2), 1u );
+  BOOST_CHECK_EQUAL( index.code_point_of(buffer, 4), 2u );
+  BOOST_CHECK_EQUAL( index.utf16_of(buffer, 10), 5u );
+  BOOST_CHECK_EQUAL( index.byte_of_code_point(buffer, 3), 6u );
+  // The second half of a surrogate pair belongs to its code point
+  BOOST_CHECK_EQUAL( index.byte_of_utf16(buffer, 4), 6u );
+  BOOST_CHECK_EQUAL( index.byte_of_utf16(buffer, 5), 10u );
+  check_utf8_index(buffer, text);
+
+  text = mixed_utf8(5, 20000);
+  utf8_t large(text.begin(), text.end());
+  check_utf8_index(large, text);
+
+  buffer.clear();
+  BOOST_CHECK_EQUAL( index.code_points(buffer), 0u );
+  BOOST_CHECK_EQUAL( index.byte_of_utf16(buffer, 0), 0u );
+}
+
+BOOST_AUTO_TEST_CASE(utf8_index_edits)
+{
+  // Edits on code point boundaries, big enough to split, merge and empty the
+  // chunks of the index
+  std::string text = mixed_utf8(11, 4000);
+  utf8_t buffer(text.begin(), text.end());
+  check_utf8_index(buffer, text);
+
+  unsigned state = 99;
+  for(int step = 0; step < 300; ++step){
+    state = state * 1103515245u + 12345u;
+    size_t at = text.empty() ? 0 : state % text.size();
+    while(at > 0 && (static_cast<unsigned char>(text[at]) & 0xC0) == 0x80)
+      --at;
+    if((state >> 16) % 3 == 0 && !text.empty()){
+      size_t end = std::min<size_t>(at + (state >> 8) % 6000, text.size());
+      while(end < text.size() &&
+            (static_cast<unsigned char>(text[end]) & 0xC0) == 0x80)
+        ++end;
+      buffer.erase(boost::next(buffer.begin(), at),
+                   boost::next(buffer.begin(), end));
+      text.erase(at, end - at);
+    }else{
+      std::string const inserted = mixed_utf8(state, (state >> 8) % 1500);
+      buffer.insert(boost::next(buffer.begin(), at),
+                    inserted.begin(), inserted.end());
+      text.insert(at, inserted);
+    }
+    if(step % 10 == 0)
+      check_utf8_index(buffer, text);
+  }
+  check_utf8_index(buffer, text);
+
+  // Typing a code point a byte at a time leaves it whole in the end
+  buffer.advance(-static_cast<std::ptrdiff_t>(buffer.position()));
+  char const euro[] = "\xE2\x82\xAC";
+  for(int n = 0; n < 3; ++n)
+    buffer.insert(euro[n]);
+  text.insert(0, euro);
+  check_utf8_index(buffer, text);
+}
+
+BOOST_AUTO_TEST_CASE(utf8_index_errors)
+{
+  // A stray continuation, a truncated sequence, an overlong encoding and a
+  // surrogate, each counted as one replacement per maximal subpart
+  std::string const text("a\x80" "b\xE2\x82" "c\xC0\xAF" "d\xED\xA0\x80");
+  utf8_t buffer(text.begin(), text.end());
+  utf8_index<char> & index = buffer.observer();
+  BOOST_CHECK_EQUAL( index.error_count(buffer), 7u );
+  BOOST_CHECK_EQUAL( index.code_points(buffer), 11u );
+  BOOST_CHECK_EQUAL( index.code_point_of(buffer, 4), 3u );
+  BOOST_CHECK_EQUAL( index.byte_of_code_point(buffer, 4), 5u );
+  BOOST_CHECK( !utf8::is_valid(text.begin(), text.end()) );
+
+  // Completing the truncated sequence fixes it
+  buffer.insert(boost::next(buffer.begin(), 5), '\xAC');
+  BOOST_CHECK_EQUAL( index.error_count(buffer), 6u );
+  buffer.erase(boost::next(buffer.begin(), 7), buffer.end());
+  BOOST_CHECK_EQUAL( index.error_count(buffer), 1u );
+  buffer.erase(boost::next(buffer.begin(), 1));
+  BOOST_CHECK_EQUAL( index.error_count(buffer), 0u );
+  BOOST_CHECK( utf8::is_valid(buffer.begin(), buffer.end()) );
+  BOOST_CHECK( utf8::is_valid(text.begin(), text.begin()) );
+}
+
+BOOST_AUTO_TEST_CASE(utf8_cursor_movement)
+{
+  // e with a combining acute, a family joined by zero width joiners, two
+  // flags, and CR LF
+  std::string const text("xe\xCC\x81" "\xF0\x9F\x91\xA8\xE2\x80\x8D"
+                         "\xF0\x9F\x91\xA7" "\xF0\x9F\x87\xAB\xF0\x9F\x87\xB7"
+                         "\xF0\x9F\x87\xA9\xF0\x9F\x87\xAA" "\r\ny");
+  buffer_t buffer(text.begin(), text.end());
+  buffer.advance(-static_cast<std::ptrdiff_t>(buffer.position()));
+
+  utf8::advance_code_points(buffer, 2);
+  BOOST_CHECK_EQUAL( buffer.position(), 2u );
+  utf8::advance_code_points(buffer, 1);
+  BOOST_CHECK_EQUAL( buffer.position(), 4u );
+  utf8::advance_code_points(buffer, -3);
+  BOOST_CHECK_EQUAL( buffer.position(), 0u );
+
+  size_t const stops[] = { 0, 1, 4, 15, 23, 31, 33, 34 };
+  for(size_t n = 1; n < sizeof(stops) / sizeof(stops[0]); ++n){
+    utf8::advance_graphemes(buffer, 1);
+    BOOST_CHECK_EQUAL( buffer.position(), stops[n] );
+  }
+  utf8::advance_graphemes(buffer, 1);
+  BOOST_CHECK_EQUAL( buffer.position(), text.size() );
+  for(size_t n = sizeof(stops) / sizeof(stops[0]) - 1; n > 0; --n){
+    utf8::advance_graphemes(buffer, -1);
+    BOOST_CHECK_EQUAL( buffer.position(), stops[n - 1] );
+  }
+  utf8::advance_graphemes(buffer, -1);
+  BOOST_CHECK_EQUAL( buffer.position(), 0u );
+
+  // From between the two flags, each direction takes a whole flag
+  buffer.advance(23);
+  utf8::advance_graphemes(buffer, 1);
+  BOOST_CHECK_EQUAL( buffer.position(), 31u );
+  utf8::advance_graphemes(buffer, -2);
+  BOOST_CHECK_EQUAL( buffer.position(), 15u );
+  utf8::advance_code_points(buffer, -100);
+  BOOST_CHECK_EQUAL( buffer.position(), 0u );
+}
+
+
+// ----- ----- ------ Edit Batches ----- ----- -----
+
+BOOST_AUTO_TEST_CASE(edit_batch_recording)
+{
+  std::string const word("xyz");
+  edit_batch<char> batch;
+  BOOST_CHECK( batch.empty() );
+  batch.insert(8, word.begin(), word.end());
+  batch.erase(2, 3);
+  batch.insert(8, '!');
+  batch.replace(5, 1, word.begin(), word.begin() + 1);
+  BOOST_CHECK_EQUAL( batch.size(), 4u );
+  BOOST_CHECK_EQUAL( batch.growth(), 1 );
+
+  // Sorted by position, keeping the order of the two edits at 8
+  edit_batch<char>::edit_list const & edits = batch.edits();
+  BOOST_CHECK_EQUAL( edits[0].position, 2u );
+  BOOST_CHECK_EQUAL( edits[1].position, 5u );
+  BOOST_CHECK_EQUAL( edits[2].position, 8u );
+  BOOST_CHECK( seq_eq(batch.inserted(edits[2]), word) );
+  BOOST_CHECK( seq_eq(batch.inserted(edits[3]), std::string("!")) );
+
+  // Positions before, within, and after the edits
+  BOOST_CHECK_EQUAL( batch.map(1), 1u );
+  BOOST_CHECK_EQUAL( batch.map(3), 2u );
+  BOOST_CHECK_EQUAL( batch.map(5), 3u );
+  BOOST_CHECK_EQUAL( batch.map(7), 4u );
+  BOOST_CHECK_EQUAL( batch.map(8), 9u );
+  BOOST_CHECK_EQUAL( batch.map(9), 10u );
+
+  batch.validate(8);
+  BOOST_CHECK_THROW( batch.validate(7), std::out_of_range );
+  batch.erase(3, 1);
+  BOOST_CHECK_THROW( batch.validate(20), std::invalid_argument );
+  batch.clear();
+  BOOST_CHECK( batch.empty() );
+  BOOST_CHECK_EQUAL( batch.growth(), 0 );
+}
+
+// Build a pseudo-random batch of edits of text, recorded out of order, and
+// make them to text and cursor
+edit_batch<char> random_batch(std::string & text, size_t & cursor,
+                              unsigned seed)
+{
+  edit_batch<char> batch;
+  for(size_t at = seed % 7; at <= text.size(); at += 1 + seed % 23){
+    seed = seed * 1103515245u + 12345u;
+    size_t const erased = std::min<size_t>((seed >> 8) % 5, text.size() - at);
+    std::string const fresh((seed >> 12) % 4, "ab\ncd"[(seed >> 4) % 5]);
+    if(seed % 2)
+      batch.replace(at, erased, fresh.begin(), fresh.end());
+    else{
+      batch.erase(at, erased);
+      batch.insert(at + erased, fresh.begin(), fresh.end());
+    }
+    at += erased;
+  }
+  // Record it again backwards, which must not change anything
+  edit_batch<char> reversed;
+  edit_batch<char>::edit_list const & forward = batch.edits();
+  for(size_t i = forward.size(); i-- > 0; ){
+    edit_batch<char>::inserted_range const range =
+      batch.inserted(forward[i]);
+    reversed.replace(forward[i].position, forward[i].erased,
+                     range.begin(), range.end());
+  }
+  cursor = batch.map(cursor);
+  for(size_t i = forward.size(); i-- > 0; ){
+    edit_batch<char>::inserted_range const range =
+      batch.inserted(forward[i]);
+    std::string::iterator const first = text.begin() + forward[i].position;
+    text.replace(first, first + forward[i].erased, range.begin(), range.end());
+  }
+  return reversed;
+}
+
+// Apply a few batches to buffer, checking it against the text they make
+template<class TBuffer>
+void check_apply(TBuffer & buffer, std::string text)
+{
+  size_t cursor = buffer.position();
+  for(unsigned round = 0; round < 6; ++round){
+    edit_batch<char> const batch = random_batch(text, cursor, round * 7919);
+    buffer.apply(batch);
+    BOOST_REQUIRE( seq_eq(buffer, text) );
+    BOOST_REQUIRE_EQUAL( buffer.position(), cursor );
+  }
+
+  // A batch which does not fit leaves the buffer alone
+  edit_batch<char> overlong;
+  overlong.erase(text.size() - 1, 2);
+  BOOST_CHECK_THROW( buffer.apply(overlong), std::out_of_range );
+  BOOST_CHECK( seq_eq(buffer, text) );
+  BOOST_CHECK_EQUAL( buffer.position(), cursor );
+}
+
+BOOST_AUTO_TEST_CASE(apply_on_every_buffer)
+{
+  std::string text;
+  for(int line = 0; text.size() < 2000; ++line)
+    text += "line " + boost::lexical_cast<std::string>(line) + "\n";
+
+  buffer_t buffer(text.begin(), text.end());
+  buffer.advance(-700);
+  check_apply(buffer, text);
+  gap_buffer<std::list<char> > list_buffer(text.begin(), text.end());
+  list_buffer.advance(-300);
+  check_apply(list_buffer, text);
+  contiguous_t contiguous(text.begin(), text.end());
+  contiguous.advance(-1200);
+  check_apply(contiguous, text);
+  small_gap_buffer<char, 32> small(text.begin(), text.begin() + 30);
+  check_apply(small, text.substr(0, 30));
+
+  // Observers are told about each edit
+  indexed_t indexed(text.begin(), text.end());
+  indexed.advance(-900);
+  check_apply(indexed, text);
+  check_line_index(indexed, std::string(indexed.begin(), indexed.end()));
+}
+
+BOOST_AUTO_TEST_CASE(apply_nontrivial_elements)
+{
+  std::vector<std::string> model;
+  for(int i = 0; i < 50; ++i)
+    model.push_back(std::string(20, static_cast<char>('a' + i % 26)));
+  contiguous_gap_buffer<std::string> buffer(model.begin(), model.end());
+  buffer.advance(-25);
+
+  edit_batch<std::string> batch;
+  std::vector<std::string> const fresh(3, "fresh");
+  batch.replace(40, 5, fresh.begin(), fresh.end());
+  batch.erase(0, 10);
+  batch.insert(25, fresh.begin(), fresh.begin() + 1);
+  buffer.apply(batch);
+
+  model.erase(model.begin() + 40, model.begin() + 45);
+  model.insert(model.begin() + 40, fresh.begin(), fresh.end());
+  model.insert(model.begin() + 25, fresh[0]);
+  model.erase(model.begin(), model.begin() + 10);
+  BOOST_CHECK( seq_eq(buffer, model) );
+  BOOST_CHECK_EQUAL( buffer.position(), 16u );
+}
+
+
+// ----- ----- ------ Segmented Algorithms ----- ----- -----
+
+// Check the segmented algorithms on a buffer holding text, with its cursor
+// somewhere in the middle so that the text is split into several runs
+template<class TBuffer>
+void check_segmented_algorithms(TBuffer & buffer, std::string const & text)
+{
+  BOOST_REQUIRE( seq_eq(text, buffer) );
+  size_t total = 0;
+  typename TBuffer::const_segment_list const runs = buffer.segments();
+  for(typename TBuffer::const_segment_list::const_iterator r = runs.begin();
+      r != runs.end(); ++r)
+    total += boost::size(*r);
+  BOOST_CHECK_EQUAL( total, text.size() );
+
+  std::string copied;
+  segmented::copy(buffer, std::back_inserter(copied));
+  BOOST_CHECK_EQUAL( copied, text );
+
+  BOOST_CHECK_EQUAL( segmented::find(buffer, 'q'), text.find('q') );
+  BOOST_CHECK_EQUAL( segmented::find(buffer, 'z'), text.find('z') );
+  BOOST_CHECK_EQUAL( segmented::find(buffer, '#'), text.size() );
+  BOOST_CHECK_EQUAL( segmented::count(buffer, 'o'),
+                     size_t(std::count(text.begin(), text.end(), 'o')) );
+  BOOST_CHECK_EQUAL( segmented::count(buffer, '#'), 0u );
+
+  // Compare against a buffer of the same type laid out differently
+  TBuffer other(text.begin(), text.end());
+  BOOST_CHECK( segmented::equal(buffer, other) );
+  BOOST_CHECK_EQUAL( segmented::mismatch(buffer, other), text.size() );
+  BOOST_CHECK( buffer == other );
+  BOOST_CHECK( !(buffer < other) );
+  BOOST_CHECK( buffer <= other );
+
+  // Through erase and insert, since not every buffer can be written through
+  other.erase(boost::next(other.begin(), text.size() - 3));
+  other.insert(boost::next(other.begin(), text.size() - 3), '~');
+  BOOST_CHECK_EQUAL( segmented::mismatch(buffer, other), text.size() - 3 );
+  BOOST_CHECK( !segmented::equal(buffer, other) );
+  BOOST_CHECK( buffer != other );
+  BOOST_CHECK( buffer < other );
+  BOOST_CHECK( other > buffer );
+  BOOST_CHECK( other >= buffer );
+
+  // A proper prefix is smaller
+  other.advance(static_cast<std::ptrdiff_t>(text.size()) -
+                static_cast<std::ptrdiff_t>(other.position()));
+  other.erase(-3);
+  BOOST_CHECK_EQUAL( segmented::mismatch(buffer, other), text.size() - 3 );
+  BOOST_CHECK( !segmented::equal(buffer, other) );
+  BOOST_CHECK( other < buffer );
+  BOOST_CHECK( !segmented::lexicographical_compare(buffer, other) );
+}
+
+BOOST_AUTO_TEST_CASE(segmented_algorithms_on_every_buffer)
+{
+  std::string const text("the quick brown fox jumps over the lazy dog");
+
+  buffer_t buffer(text.begin(), text.end());
+  buffer.advance(-20);
+  buffer.insert('x');
+  buffer.erase(-1);
+  BOOST_CHECK_EQUAL( buffer.segments().size(), 2u );
+  check_segmented_algorithms(buffer, text);
+
+  contiguous_t contiguous(text.begin(), text.end());
+  contiguous.advance(-20);
+  contiguous.insert('x');
+  contiguous.erase(-1);
+  BOOST_CHECK( !boost::empty(contiguous.segments()[0]) );
+  BOOST_CHECK( !boost::empty(contiguous.segments()[1]) );
+  check_segmented_algorithms(contiguous, text);
+
+  rope_t rope(text.begin(), text.end());
+  rope.advance(-20);
+  rope.insert('x');
+  rope.erase(-1);
+  BOOST_CHECK_GT( rope.segments().size(), 2u );
+  check_segmented_algorithms(rope, text);
+
+  multi_gap_buffer<std::deque<char>, 4, 8> multi(text.begin(), text.end());
+  multi.advance(-30);
+  multi.insert(multi.add_cursor(30), 'x');
+  multi.erase(1, -1);
+  multi.insert('x');
+  multi.erase(-1);
+  BOOST_CHECK_GT( multi.segments().size(), 2u );
+  check_segmented_algorithms(multi, text);
+
+  piece_table_t pieces(text.begin(), text.end());
+  pieces.advance(-20);
+  pieces.insert('x');
+  pieces.erase(-1);
+  BOOST_CHECK_EQUAL( pieces.segments().size(), 2u );
+  check_segmented_algorithms(pieces, text);
+}
+
+BOOST_AUTO_TEST_CASE(segmented_algorithms_across_types)
+{
+  // Any two segmented buffers can be compared, whatever their runs
+  std::string const text("abcdefghijklmnopqrstuvwxyz");
+  rope_t rope(text.begin(), text.end());
+  contiguous_t contiguous(text.begin(), text.end());
+  contiguous.advance(-7);
+  buffer_t buffer(text.begin(), text.end());
+  buffer.advance(-13);
+  buffer.insert('-');
+
+  BOOST_CHECK( segmented::equal(rope, contiguous) );
+  BOOST_CHECK( !segmented::equal(rope, buffer) );
+  BOOST_CHECK_EQUAL( segmented::mismatch(contiguous, buffer), 13u );
+  BOOST_CHECK( segmented::lexicographical_compare(buffer, rope) );
+  BOOST_CHECK( !segmented::lexicographical_compare(rope, contiguous) );
+
+  // Empty buffers have no runs to walk
+  rope_t empty_rope;
+  buffer_t empty_buffer;
+  BOOST_CHECK( segmented::equal(empty_rope, empty_buffer) );
+  BOOST_CHECK( segmented::lexicographical_compare(empty_rope, rope) );
+  BOOST_CHECK_EQUAL( segmented::find(empty_rope, 'a'), 0u );
+}
+
+#ifdef SEGMENTED_X86_KERNELS
+BOOST_AUTO_TEST_CASE(byte_kernels_agree)
+{
+  // Every kernel must agree with the portable one at every length and
+  // alignment, including matches in the tails they finish one at a time
+  using namespace segmented::detail;
+  bool const avx2 = (best_kernel_isa() == isa_avx2);
+  std::vector<byte> data(200);
+  unsigned state = 777;
+  for(size_t i = 0; i < data.size(); ++i){
+    state = state * 1103515245u + 12345u;
+    data[i] = static_cast<byte>('a' + (state >> 16) % 20);
+  }
+  // A few bytes past ASCII, for ascii_prefix to stop at
+  for(size_t i = 45; i < data.size(); i += 51)
+    data[i] = 0xC3;
+  for(size_t start = 0; start < 33; ++start)
+    for(size_t n = 0; start + n <= data.size(); n += 7){
+      byte const * const p = &data[0] + start;
+      size_t const ascii = ascii_prefix_scalar(p, n);
+      BOOST_REQUIRE_EQUAL( ascii_prefix_sse2(p, n), ascii );
+      BOOST_REQUIRE_EQUAL( ascii_prefix(p, n), ascii );
+      if(avx2)
+        BOOST_REQUIRE_EQUAL( ascii_prefix_avx2(p, n), ascii );
+      for(byte a = 'a'; a <= 'u'; a += 5){
+        size_t const find = find_byte_scalar(p, n, a);
+        size_t const either = find_either_byte_scalar(p, n, a, 't');
+        size_t const count = count_byte_scalar(p, n, a);
+        BOOST_REQUIRE_EQUAL( find_byte_sse2(p, n, a), find );
+        BOOST_REQUIRE_EQUAL( find_either_byte_sse2(p, n, a, 't'), either );
+        BOOST_REQUIRE_EQUAL( count_byte_sse2(p, n, a), count );
+        BOOST_REQUIRE_EQUAL( find_byte(p, n, a), find );
+        BOOST_REQUIRE_EQUAL( find_either_byte(p, n, a, 't'), either );
+        BOOST_REQUIRE_EQUAL( count_byte(p, n, a), count );
+        if(avx2){
+          BOOST_REQUIRE_EQUAL( find_byte_avx2(p, n, a), find );
+          BOOST_REQUIRE_EQUAL( find_either_byte_avx2(p, n, a, 't'), either );
+          BOOST_REQUIRE_EQUAL( count_byte_avx2(p, n, a), count );
+        }
+      }
+    }
+}
+#endif
+
+// Lower-case the ASCII letters of text, to check the case-insensitive searches
+std::string ascii_lower(std::string text)
+{
+  for(size_t i = 0; i < text.size(); ++i)
+    if(text[i] >= 'A' && text[i] <= 'Z')
+      text[i] = static_cast<char>(text[i] - 'A' + 'a');
+  return text;
+}
+
+// Check the searches of a buffer holding text against std::string
+template<class TBuffer>
+void check_text_search(TBuffer const & buffer, std::string const & text)
+{
+  BOOST_REQUIRE( seq_eq(text, buffer) );
+  char const * const needles[] = {
+    "ERROR", "error", "Error 17", "warn", "#", "", "log line", "z",
+    "e", "17\nline", "never there"
+  };
+  for(size_t i = 0; i < sizeof(needles) / sizeof(needles[0]); ++i){
+    std::string const needle(needles[i]);
+    size_t const expected = text.find(needle);
+    BOOST_CHECK_EQUAL( segmented::search(buffer, needle),
+                       expected == std::string::npos ? text.size() : expected );
+    size_t const folded = ascii_lower(text).find(ascii_lower(needle));
+    BOOST_CHECK_EQUAL( segmented::search_ignore_case(buffer, needle),
+                       folded == std::string::npos ? text.size() : folded );
+  }
+  for(char c = ' '; c < 127; c += 3){
+    size_t const expected = text.find(c);
+    BOOST_CHECK_EQUAL( segmented::find(buffer, c),
+                       expected == std::string::npos ? text.size() : expected );
+    BOOST_CHECK_EQUAL( segmented::count(buffer, c),
+                       size_t(std::count(text.begin(), text.end(), c)) );
+    size_t const folded =
+      ascii_lower(text).find(ascii_lower(std::string(1, c))[0]);
+    BOOST_CHECK_EQUAL( segmented::find_ignore_case(buffer, c),
+                       folded == std::string::npos ? text.size() : folded );
+  }
+  // Values no char can hold are never found
+  BOOST_CHECK_EQUAL( segmented::find(buffer, 1000), text.size() );
+  BOOST_CHECK_EQUAL( segmented::count(buffer, 1000), 0u );
+}
+
+// Fill buffer with a log of many lines, with the cursor left in the middle of
+// the ERROR so that it straddles the gap, and return the text
+template<class TBuffer>
+std::string build_log(TBuffer & buffer)
+{
+  std::string text;
+  for(int line = 0; line < 300; ++line){
+    std::string entry("log line ");
+    entry += static_cast<char>('0' + line % 10);
+    entry += (line % 7 == 0) ? " warn: disk\n" : " ok\n";
+    text += entry;
+  }
+  text += "Error 17\nline";
+  text.insert(text.size() / 2, "an ERROR here\n");
+  buffer.insert(text);
+  buffer.advance(-static_cast<std::ptrdiff_t>(text.size() / 2) + 4);
+  buffer.insert('x');
+  buffer.erase(-1);
+  return text;
+}
+
+BOOST_AUTO_TEST_CASE(text_search_on_every_buffer)
+{
+  buffer_t deque_buffer;
+  std::string const text = build_log(deque_buffer);
+  check_text_search(deque_buffer, text);
+
+  gap_buffer<std::vector<char> > vector_buffer;
+  BOOST_CHECK_EQUAL( build_log(vector_buffer), text );
+  check_text_search(vector_buffer, text);
+
+  gap_buffer<std::list<char> > list_buffer;
+  BOOST_CHECK_EQUAL( build_log(list_buffer), text );
+  check_text_search(list_buffer, text);
+
+  contiguous_t contiguous;
+  BOOST_CHECK_EQUAL( build_log(contiguous), text );
+  check_text_search(contiguous, text);
+
+  rope_t rope;
+  BOOST_CHECK_EQUAL( build_log(rope), text );
+  check_text_search(rope, text);
+
+  multi_gap_buffer<std::deque<char>, 4, 8> multi;
+  BOOST_CHECK_EQUAL( build_log(multi), text );
+  multi.insert(multi.add_cursor(17), 'y');
+  multi.erase(1, -1);
+  check_text_search(multi, text);
+
+  piece_table_t pieces;
+  BOOST_CHECK_EQUAL( build_log(pieces), text );
+  check_text_search(pieces, text);
+}
+
+
+// ----- ----- ------ Snapshots ----- ----- -----
+
+BOOST_AUTO_TEST_CASE(snapshot_round_trips)
+{
+  std::string const text("the quick brown fox jumps over the lazy dog");
+  gap_buffer<std::deque<char> > buffer(text.begin(), text.end());
+  buffer.advance(-20);
+  buffer.insert('!');
+  // Leave the cursor away from the gap
+  buffer.advance(-5);
+  std::ostringstream out;
+  buffer_snapshot::serialize(buffer, out);
+  std::string const snapshot = out.str();
+  BOOST_CHECK_EQUAL( snapshot.size(), 40u + buffer.size() + 4u );
+
+  // Into a buffer over another container, with the same halves and cursor
+  gap_buffer<std::vector<char> > loaded(5, 'x');
+  std::istringstream in(snapshot);
+  buffer_snapshot::deserialize(in, loaded);
+  BOOST_CHECK( seq_eq(buffer, loaded) );
+  BOOST_CHECK_EQUAL( loaded.position(), buffer.position() );
+  BOOST_CHECK_EQUAL( boost::size(loaded.segments()[0]),
+                     boost::size(buffer.segments()[0]) );
+  loaded.insert('?');
+  buffer.insert('?');
+  BOOST_CHECK( seq_eq(buffer, loaded) );
+
+  // From memory, such as a mapped_file
+  std::vector<boost::uint32_t> wide;
+  for(boost::uint32_t i = 0; i != 100000; ++i)
+    wide.push_back(i * 2654435761u);
+  gap_buffer<std::list<boost::uint32_t> > numbers(wide.begin(), wide.end());
+  numbers.advance(-40000);
+  std::ostringstream numbers_out;
+  buffer_snapshot::serialize(numbers, numbers_out);
+  std::string const numbers_snapshot = numbers_out.str();
+  gap_buffer<std::deque<boost::uint32_t> > numbers_loaded;
+  buffer_snapshot::deserialize(numbers_snapshot.data(),
+                               numbers_snapshot.size(), numbers_loaded);
+  BOOST_CHECK( seq_eq(wide, numbers_loaded) );
+  BOOST_CHECK_EQUAL( numbers_loaded.position(), 60000u );
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_rejects_malformed)
+{
+  std::string const text("hello world");
+  gap_buffer<std::deque<char> > buffer(text.begin(), text.end());
+  std::ostringstream out;
+  buffer_snapshot::serialize(buffer, out);
+  std::string const good = out.str();
+  gap_buffer<std::vector<char> > loaded(3, 'x');
+
+  // A flipped bit in the elements fails the checksum
+  std::string corrupt(good);
+  corrupt[45] ^= 0x10;
+  BOOST_CHECK_THROW( buffer_snapshot::deserialize(corrupt.data(),
+                                                  corrupt.size(), loaded),
+                     std::invalid_argument );
+  // Cut short
+  std::istringstream cut(good.substr(0, good.size() - 1));
+  BOOST_CHECK_THROW( buffer_snapshot::deserialize(cut, loaded),
+                     std::invalid_argument );
+  // Of elements of another size
+  gap_buffer<std::vector<wchar_t> > wide;
+  BOOST_CHECK_THROW( buffer_snapshot::deserialize(good.data(), good.size(),
+                                                  wide),
+                     std::invalid_argument );
+  // Claiming more elements than it holds
+  std::string huge(good);
+  huge[23] = 0x7f;
+  BOOST_CHECK_THROW( buffer_snapshot::deserialize(huge.data(), huge.size(),
+                                                  loaded),
+                     std::invalid_argument );
+  // A failed load leaves the buffer as it was
+  BOOST_CHECK( seq_eq(std::string("xxx"), loaded) );
+  buffer_snapshot::deserialize(good.data(), good.size(), loaded);
+  BOOST_CHECK( seq_eq(text, loaded) );
+}
+
+
+// ----- ----- ------ Parallel Algorithms ----- ----- -----
+
+// Upper-case ASCII letters, for the parallel transform
+struct to_upper_ascii
+{
+  char operator()(char c) const
+  {
+    return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+  }
+};
+
+// Count the tasks run, and fail one of them
+struct failing_task
+{
+  explicit failing_task(boost::atomic<size_t> & runs) : runs(runs) {}
+  void operator()(size_t i) const
+  {
+    ++runs;
+    if(i == 5)
+      throw std::runtime_error("failing_task");
+  }
+  boost::atomic<size_t> & runs;
+};
+
+BOOST_AUTO_TEST_CASE(parallel_algorithms_match_sequential)
+{
+  // Several chunks in each half of the gap_buffer
+  std::string text(1500000, ' ');
+  unsigned seed = 1;
+  for(size_t i = 0; i != text.size(); ++i){
+    seed = seed * 1103515245u + 12345u;
+    text[i] = static_cast<char>('a' + (seed >> 16) % 26);
+  }
+  typedef gap_buffer<std::deque<char> > buffer_t;
+  buffer_t buffer(text.begin(), text.end());
+  buffer.advance(-700000);
+  buffer.insert('#');
+  text.insert(800000, 1, '#');
+  BOOST_REQUIRE( seq_eq(text, buffer) );
+
+  thread_pool pool(4);
+  BOOST_CHECK_EQUAL( pool.size(), 4u );
+  BOOST_CHECK_EQUAL( segmented::count(pool, buffer, 'e'),
+                     segmented::count(buffer, 'e') );
+  BOOST_CHECK_EQUAL( segmented::find(pool, buffer, '#'), 800000u );
+  BOOST_CHECK_EQUAL( segmented::find(pool, buffer, 'q'), text.find('q') );
+  BOOST_CHECK_EQUAL( segmented::find(pool, buffer, '!'), text.size() );
+
+  std::vector<char> out(buffer.size());
+  BOOST_CHECK( segmented::copy(pool, buffer, out.begin()) == out.end() );
+  BOOST_CHECK( std::equal(out.begin(), out.end(), text.begin()) );
+  std::string upper(text);
+  std::transform(upper.begin(), upper.end(), upper.begin(), to_upper_ascii());
+  segmented::transform(pool, buffer, out.begin(), to_upper_ascii());
+  BOOST_CHECK( std::equal(out.begin(), out.end(), upper.begin()) );
+
+  // Compare against a rope, whose runs are much shorter
+  rope_buffer<char> rope(text.begin(), text.end());
+  BOOST_CHECK( segmented::equal(pool, buffer, rope) );
+  BOOST_CHECK_EQUAL( segmented::mismatch(pool, buffer, rope), text.size() );
+  BOOST_CHECK( !segmented::lexicographical_compare(pool, buffer, rope) );
+  rope.erase(rope.begin() + 1200000);
+  rope.insert(rope.begin() + 1200000, '~');
+  BOOST_CHECK( !segmented::equal(pool, buffer, rope) );
+  BOOST_CHECK_EQUAL( segmented::mismatch(pool, buffer, rope), 1200000u );
+  BOOST_CHECK( segmented::lexicographical_compare(pool, buffer, rope) );
+  BOOST_CHECK( !segmented::lexicographical_compare(pool, rope, buffer) );
+  buffer.erase(buffer.begin() + 1200000, buffer.end());
+  BOOST_CHECK( segmented::lexicographical_compare(pool, buffer, rope) );
+}
+
+BOOST_AUTO_TEST_CASE(thread_pool_rethrows)
+{
+  thread_pool pool(3);
+  boost::atomic<size_t> runs(0);
+  failing_task task(runs);
+  // Enough tasks that the others cannot all be claimed while the failing one
+  // is descheduled
+  BOOST_CHECK_THROW( pool.run(10000000, task), std::runtime_error );
+  BOOST_CHECK( runs.load() < 10000000u );
+  // The pool carries on with the next job
+  runs.store(0);
+  failing_task later(runs);
+  BOOST_CHECK_NO_THROW( pool.run(3, later) );
+  BOOST_CHECK_NO_THROW( pool.run(5, later) );
+  BOOST_CHECK_EQUAL( runs.load(), 3u + 5u );
+}
+
+
+// ----- ----- ------ File Output ----- ----- -----
+
+// Return the contents of the file at path
+std::string read_file(std::string const & path)
+{
+  std::ifstream in(path.c_str(), std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+}
+
+// Save buffer over the file at path each way, and check what was written
+template<class TBuffer>
+void check_save(TBuffer const & buffer, std::string const & path,
+                std::string const & text)
+{
+  buffer_io::save(buffer, path);
+  BOOST_CHECK( read_file(path) == text );
+  buffer_io::save(buffer, path, buffer_io::save_atomically);
+  BOOST_CHECK( read_file(path) == text );
+}
+
+BOOST_AUTO_TEST_CASE(save_every_buffer)
+{
+  // Long enough to fill the staging area of runs which are not contiguous
+  std::string text;
+  for(int line = 0; text.size() < 200000; ++line)
+    text += "line " + boost::lexical_cast<std::string>(line) + "\n";
+  std::string const path = write_temporary(std::string());
+
+  buffer_t buffer(text.begin(), text.end());
+  buffer.advance(-70000);
+  int const fd = ::open(path.c_str(), O_WRONLY | O_TRUNC);
+  BOOST_REQUIRE( fd >= 0 );
+  BOOST_CHECK_EQUAL( buffer_io::write_to(buffer, fd), text.size() );
+  ::close(fd);
+  BOOST_CHECK( read_file(path) == text );
+  check_save(buffer, path, text);
+
+  gap_buffer<std::list<char> > list_buffer(text.begin(), text.end());
+  list_buffer.advance(-70000);
+  check_save(list_buffer, path, text);
+  gap_buffer<boost::container::deque<char> > other_deque(text.begin(),
+                                                          text.end());
+  check_save(other_deque, path, text);
+  contiguous_t contiguous(text.begin(), text.end());
+  contiguous.advance(-5);
+  check_save(contiguous, path, text);
+  rope_buffer<char> rope(text.begin(), text.end());
+  check_save(rope, path, text);
+  multi_gap_buffer<std::deque<char> > multi(text.begin(), text.end());
+  multi.insert(multi.add_cursor(100), 'x');
+  multi.erase(1, -1);
+  check_save(multi, path, text);
+  piece_table_t pieces(text.begin(), text.end());
+  check_save(pieces, path, text);
+
+  check_save(buffer_t(), path, std::string());
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(save_atomically_over_mapped_file)
+{
+  std::string const text("the quick brown fox jumps over the lazy dog\n");
+  std::string const path = write_temporary(text);
+  BOOST_REQUIRE_EQUAL( ::chmod(path.c_str(), 0640), 0 );
+
+  // The buffer keeps reading the old file while the new one replaces it
+  piece_table_t buffer(boost::shared_ptr<mapped_file const>(
+                         new mapped_file(path)));
+  buffer.advance(4);
+  buffer.erase(6);
+  buffer_io::save(buffer, path, buffer_io::save_atomically);
+  std::string const saved("the brown fox jumps over the lazy dog\n");
+  BOOST_CHECK( read_file(path) == saved );
+  BOOST_CHECK( seq_eq(saved, buffer) );
+
+  struct stat status;
+  BOOST_REQUIRE_EQUAL( ::stat(path.c_str(), &status), 0 );
+  BOOST_CHECK_EQUAL( status.st_mode & 0777, 0640u );
+
+  // Saving through a symbolic link replaces the file it names, not the link
+  std::string const link = path + ".link";
+  BOOST_REQUIRE_EQUAL( ::symlink(path.c_str(), link.c_str()), 0 );
+  buffer.insert(std::string("big "));
+  buffer_io::save(buffer, link, buffer_io::save_atomically);
+  BOOST_REQUIRE_EQUAL( ::lstat(link.c_str(), &status), 0 );
+  BOOST_CHECK( S_ISLNK(status.st_mode) );
+  BOOST_CHECK( read_file(path) ==
+               "the big brown fox jumps over the lazy dog\n" );
+  BOOST_REQUIRE_EQUAL( ::stat(path.c_str(), &status), 0 );
+  BOOST_CHECK_EQUAL( status.st_mode & 0777, 0640u );
+  std::remove(link.c_str());
+  std::remove(path.c_str());
+
+  BOOST_CHECK_THROW( buffer_io::save(buffer, "/nonexistent/gap_buffer/file",
+                                     buffer_io::save_atomically),
+                     boost::system::system_error );
+  BOOST_CHECK_THROW( buffer_io::save(buffer, "/nonexistent/gap_buffer/file"),
+                     boost::system::system_error );
+}
+
+
+// Saves a buffer atomically over one file, over and over, counting failures
+struct atomic_saver
+{
+  atomic_saver(buffer_t const & buffer, std::string const & path,
+               boost::atomic<size_t> & failures)
+    : buffer(buffer)
+    , path(path)
+    , failures(failures)
+  {}
+
+  void operator()() const
+  {
+    for(int i = 0; i < 50; ++i){
+      try{
+        buffer_io::save(buffer, path, buffer_io::save_atomically);
+      }catch(boost::system::system_error const &){
+        ++failures;
+      }
+    }
+  }
+
+  buffer_t const &        buffer;
+  std::string             path;
+  boost::atomic<size_t> & failures;
+};
+
+BOOST_AUTO_TEST_CASE(save_atomically_from_threads)
+{
+  std::string const text("saved by every thread at once\n");
+  std::string const path = write_temporary(std::string());
+  buffer_t const buffer(text.begin(), text.end());
+
+  // Each save needs a temporary file of its own beside path
+  boost::atomic<size_t> failures(0);
+  boost::thread_group savers;
+  for(int k = 0; k < 4; ++k)
+    savers.create_thread(atomic_saver(buffer, path, failures));
+  savers.join_all();
+  BOOST_CHECK_EQUAL( failures.load(), 0u );
+  BOOST_CHECK( read_file(path) == text );
+  std::remove(path.c_str());
+}
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,229 @@
+#ifndef LATENCY_STATS_HPP_INCLUDED_
+#define LATENCY_STATS_HPP_INCLUDED_
+
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include "gap_buffer.hpp"
+
+#include <boost/cstdint.hpp>
+
+#include <cstddef>
+#include <iosfwd>
+#include <map>
+#include <utility>
+#include <vector>
+
+
+/**
+   @brief A histogram of latencies, in buckets of logarithmically growing width
+   @details
+   Values are counted in the manner of an HDR histogram: those below 64 each
+   have their own bucket, and each doubling above that is split into 32
+   buckets, so every value is counted to within about 3% of itself however
+   large it is.  This keeps the rare slow value, which an average would hide,
+   for value_at_percentile() to find, in a fixed 15KiB of counts.
+*/
+class latency_histogram
+{
+public:
+  /// The type of the values counted
+  typedef boost::uint64_t value_type;
+
+  /// Construct an empty histogram
+  latency_histogram();
+
+  /// Count value
+  /// @note \b Complexity: O(1)
+  void record(value_type value);
+
+  /// Count the values counted by other as well
+  /// @note \b Complexity: O(1)
+  void merge(latency_histogram const & other);
+
+  /// Forget every value counted
+  /// @note \b Complexity: O(1)
+  void reset();
+
+  /// Return the number of values counted
+  /// @note \b Complexity: O(1)
+  value_type count() const;
+
+  /// Return the smallest and largest values counted, which are exact, or zero
+  /// if none have been
+  /// @note \b Complexity: O(1)
+  value_type min() const;
+  value_type max() const;
+
+  /// Return the mean of the values counted, which is exact, or zero if none
+  /// have been
+  /// @note \b Complexity: O(1)
+  double mean() const;
+
+  /// Return a value which percentile percent of the values counted are no
+  /// larger than, to within the width of its bucket
+  /// @param percentile A percentage, from 0 to 100
+  /// @note \b Complexity: O(1), as the number of buckets is fixed
+  value_type value_at_percentile(double percentile) const;
+
+  /// Write the distribution of the values counted to out, in the text format
+  /// HdrHistogram's tools read: a line for each bucket holding a value, with
+  /// the largest value of the bucket, the fraction of values no larger, and
+  /// their count, then a summary
+  /// @param scale Each value is divided by scale as it is written, so that
+  ///              nanoseconds can be written as microseconds
+  /// @note \b Complexity: O(1), as the number of buckets is fixed
+  void print(std::ostream & out, double scale = 1.0) const;
+
+private:
+  // The bits of each value kept exactly, and the buckets each doubling is
+  // split into
+  static unsigned const precision_bits = 5;
+  static std::size_t const half_count = std::size_t(1) << precision_bits;
+  static std::size_t const bucket_count =
+    (64 - precision_bits + 1) * half_count;
+
+  std::vector<value_type> counts;
+  value_type total;
+  value_type lowest;
+  value_type highest;
+  double     sum;
+  double     squares;
+
+  // The bucket value is counted in, and the largest value counted in bucket
+  static std::size_t bucket_of(value_type value);
+  static value_type largest_in(std::size_t bucket);
+};
+
+/**
+   @brief A gap_buffer stats policy which keeps a latency_histogram of each
+          operation, for buffers of each size
+   @details
+   Attach a latency_stats to a gap_buffer by naming it as the buffer's TStats.
+   It reads a monotonic clock as each operation begins and ends, and counts
+   how long it took, in nanoseconds, in the histogram for that operation and
+   the size the buffer was left at.  Sizes are grouped in classes, each four
+   times as large as the last, from under 1024 elements to 2^28 elements and
+   over, so that the rare insert which has to move the gap across a large
+   buffer stands out from the typing around it.
+
+   Only the histograms of operations which happen are allocated.  Reading the
+   clock twice costs tens of nanoseconds an operation, so it is meant for
+   profiling rather than for production.
+*/
+class latency_stats
+{
+public:
+  /// The size_type of these counts
+  typedef std::size_t size_type;
+
+  /// The number of classes of buffer size
+  static size_type const size_class_count = 11;
+
+  /// Tell gap_buffer that this policy needs to hear about every edit
+  static bool const enabled = true;
+
+  /// Construct with no operations counted
+  latency_stats();
+
+  /// @name Stats Policy Requirements
+  //@{
+  /// Moving the gap is timed by on_begin and on_end
+  /// @note \b Complexity: O(1)
+  template<class TBuffer>
+  void on_resolve(TBuffer const & buffer, gap_operation op, size_type moved);
+  /// Edits are timed by on_begin and on_end
+  /// @note \b Complexity: O(1)
+  template<class TBuffer>
+  void on_edit(TBuffer const & buffer);
+  /// Start timing op
+  /// @note \b Complexity: O(1)
+  template<class TBuffer>
+  void on_begin(TBuffer const & buffer, gap_operation op);
+  /// Count how long op took
+  /// @note \b Complexity: O(log n) in the number of histograms kept
+  template<class TBuffer>
+  void on_end(TBuffer const & buffer, gap_operation op);
+  //@}
+
+  /// @name Histograms
+  //@{
+  /// Return the histogram of op on buffers of size_class, which is empty if it
+  /// never happened
+  /// @note \b Complexity: O(log n) in the number of histograms kept
+  latency_histogram const & histogram(gap_operation op,
+                                      size_type size_class) const;
+  /// Return the histogram of op on buffers of any size
+  /// @note \b Complexity: O(n) in the number of histograms kept
+  latency_histogram histogram(gap_operation op) const;
+
+  /// Return the class of a buffer of size elements
+  /// @note \b Complexity: O(1)
+  static size_type size_class(size_type size);
+  /// Return the number of elements the buffers of size_class hold fewer than,
+  /// or zero for the last class, which has no limit
+  /// @note \b Complexity: O(1)
+  static size_type size_class_limit(size_type size_class);
+  /// Return the name of op, as written by print()
+  /// @note \b Complexity: O(1)
+  static char const * name(gap_operation op);
+
+  /// Write a line to out for each histogram, with its operation, the limit of
+  /// its size class, and its count, mean, median, 90th, 99th and 99.9th
+  /// percentiles and maximum, in nanoseconds
+  /// @note \b Complexity: O(n) in the number of histograms kept
+  void print(std::ostream & out) const;
+
+  /// Forget every operation counted
+  /// @note \b Complexity: O(n) in the number of histograms kept
+  void reset();
+  //@}
+
+private:
+  typedef std::pair<gap_operation, size_type> histogram_key;
+  typedef std::map<histogram_key, latency_histogram> histogram_map;
+
+  histogram_map histograms;
+  // When each operation in progress began.  An operation can begin within
+  // another, but never within itself.
+  boost::uint64_t started[gap_operation_count];
+
+  // Read the monotonic clock, in nanoseconds
+  static boost::uint64_t now();
+};
+
+
+#include "latency_stats.ipp"
+#endif
@@ -0,0 +1,356 @@
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+#include <string>
+
+#include <time.h>
+
+
+inline
+latency_histogram::latency_histogram()
+  : counts(bucket_count)
+  , total(0)
+  , lowest(0)
+  , highest(0)
+  , sum(0)
+  , squares(0)
+{}
+
+inline
+std::size_t
+latency_histogram::
+bucket_of(value_type const value)
+{
+  if(value < 2 * half_count)
+    return value;
+  // Find the highest bit set, and keep the precision_bits below it
+  unsigned top = 0;
+  for(unsigned step = 32; step != 0; step /= 2)
+    if((value >> (top + step)) != 0)
+      top += step;
+  unsigned const shift = top - precision_bits;
+  return shift * half_count + (value >> shift);
+}
+
+inline
+latency_histogram::value_type
+latency_histogram::
+largest_in(std::size_t const bucket)
+{
+  if(bucket < 2 * half_count)
+    return bucket;
+  std::size_t const shift = bucket / half_count - 1;
+  value_type const top = bucket - shift * half_count;
+  // The last bucket ends at the largest value, where this wraps to it
+  return ((top + 1) << shift) - 1;
+}
+
+inline
+void
+latency_histogram::
+record(value_type const value)
+{
+  ++counts[bucket_of(value)];
+  lowest = (total == 0 ? value : std::min(lowest, value));
+  highest = std::max(highest, value);
+  ++total;
+  sum += static_cast<double>(value);
+  squares += static_cast<double>(value) * static_cast<double>(value);
+}
+
+inline
+void
+latency_histogram::
+merge(latency_histogram const & other)
+{
+  if(other.total == 0)
+    return;
+  for(std::size_t i = 0; i != bucket_count; ++i)
+    counts[i] += other.counts[i];
+  lowest = (total == 0 ? other.lowest : std::min(lowest, other.lowest));
+  highest = std::max(highest, other.highest);
+  total += other.total;
+  sum += other.sum;
+  squares += other.squares;
+}
+
+inline
+void
+latency_histogram::
+reset()
+{
+  std::fill(counts.begin(), counts.end(), 0);
+  total = lowest = highest = 0;
+  sum = squares = 0;
+}
+
+inline
+latency_histogram::value_type
+latency_histogram::
+count() const
+{
+  return total;
+}
+
+inline
+latency_histogram::value_type
+latency_histogram::
+min() const
+{
+  return lowest;
+}
+
+inline
+latency_histogram::value_type
+latency_histogram::
+max() const
+{
+  return highest;
+}
+
+inline
+double
+latency_histogram::
+mean() const
+{
+  return total == 0 ? 0 : sum / static_cast<double>(total);
+}
+
+inline
+latency_histogram::value_type
+latency_histogram::
+value_at_percentile(double const percentile) const
+{
+  if(total == 0)
+    return 0;
+  if(percentile <= 0)
+    return lowest;
+  // The number of values which must be no larger than the one returned
+  double const wanted =
+    std::ceil(std::min(percentile, 100.0) / 100 * static_cast<double>(total));
+  value_type const rank = std::max<value_type>(
+    static_cast<value_type>(wanted), 1);
+  value_type seen = 0;
+  for(std::size_t i = 0; i != bucket_count; ++i){
+    seen += counts[i];
+    if(seen >= rank)
+      return std::min(largest_in(i), highest);
+  }
+  return highest;
+}
+
+inline
+void
+latency_histogram::
+print(std::ostream & out, double const scale) const
+{
+  std::ios_base::fmtflags const flags = out.flags();
+  std::streamsize const precision = out.precision();
+  out << std::fixed
+      << "       Value     Percentile TotalCount 1/(1-Percentile)\n\n";
+  value_type seen = 0;
+  for(std::size_t i = 0; i != bucket_count; ++i){
+    if(counts[i] == 0)
+      continue;
+    seen += counts[i];
+    double const fraction =
+      static_cast<double>(seen) / static_cast<double>(total);
+    double const value =
+      static_cast<double>(std::min(largest_in(i), highest)) / scale;
+    out << std::setprecision(3) << std::setw(12) << value << ' '
+        << std::setprecision(12) << std::setw(14) << fraction << ' '
+        << std::setw(10) << seen;
+    if(seen != total)
+      out << ' ' << std::setprecision(2) << std::setw(14)
+          << 1 / (1 - fraction);
+    out << '\n';
+  }
+  double const average = mean();
+  double const variance = total == 0 ? 0 :
+    std::max(squares / static_cast<double>(total) - average * average, 0.0);
+  out << std::setprecision(3)
+      << "#[Mean    = " << std::setw(12) << average / scale
+      << ", StdDeviation   = " << std::setw(12)
+      << std::sqrt(variance) / scale << "]\n"
+      << "#[Max     = " << std::setw(12)
+      << static_cast<double>(highest) / scale
+      << ", Total count    = " << std::setw(12) << total << "]\n";
+  out.flags(flags);
+  out.precision(precision);
+}
+
+
+inline
+latency_stats::latency_stats()
+{
+  std::fill(started, started + gap_operation_count, 0);
+}
+
+template<class TBuffer>
+void
+latency_stats::
+on_resolve(TBuffer const &, gap_operation, size_type)
+{}
+
+template<class TBuffer>
+void
+latency_stats::
+on_edit(TBuffer const &)
+{}
+
+template<class TBuffer>
+void
+latency_stats::
+on_begin(TBuffer const &, gap_operation const op)
+{
+  started[op] = now();
+}
+
+template<class TBuffer>
+void
+latency_stats::
+on_end(TBuffer const & buffer, gap_operation const op)
+{
+  boost::uint64_t const elapsed = now() - started[op];
+  histograms[histogram_key(op, size_class(buffer.size()))].record(elapsed);
+}
+
+inline
+latency_histogram const &
+latency_stats::
+histogram(gap_operation const op, size_type const size_class) const
+{
+  static latency_histogram const none;
+  histogram_map::const_iterator const found =
+    histograms.find(histogram_key(op, size_class));
+  return found == histograms.end() ? none : found->second;
+}
+
+inline
+latency_histogram
+latency_stats::
+histogram(gap_operation const op) const
+{
+  latency_histogram rtn;
+  for(histogram_map::const_iterator i = histograms.begin();
+      i != histograms.end(); ++i)
+    if(i->first.first == op)
+      rtn.merge(i->second);
+  return rtn;
+}
+
+inline
+latency_stats::size_type
+latency_stats::
+size_class(size_type const size)
+{
+  size_type rtn = 0;
+  while(rtn + 1 != size_class_count && size >= size_class_limit(rtn))
+    ++rtn;
+  return rtn;
+}
+
+inline
+latency_stats::size_type
+latency_stats::
+size_class_limit(size_type const size_class)
+{
+  if(size_class + 1 >= size_class_count)
+    return 0;
+  return size_type(1024) << (2 * size_class);
+}
+
+inline
+char const *
+latency_stats::
+name(gap_operation const op)
+{
+  static char const * const names[gap_operation_count] = {
+    "insert", "insert_range", "erase", "insert_at", "erase_at", "resolve"
+  };
+  return names[op];
+}
+
+inline
+void
+latency_stats::
+print(std::ostream & out) const
+{
+  out << std::left << std::setw(14) << "operation"
+      << std::right << std::setw(12) << "size"
+      << std::setw(10) << "count" << std::setw(10) << "mean"
+      << std::setw(10) << "p50" << std::setw(10) << "p90"
+      << std::setw(10) << "p99" << std::setw(10) << "p99.9"
+      << std::setw(12) << "max" << '\n';
+  for(histogram_map::const_iterator i = histograms.begin();
+      i != histograms.end(); ++i){
+    latency_histogram const & h = i->second;
+    // The last class is of the buffers at least the limit of the one before
+    size_type const limit = size_class_limit(i->first.second);
+    std::string const size = (limit != 0 ? "<" : ">=") +
+      boost::lexical_cast<std::string>(
+        limit != 0 ? limit : size_class_limit(i->first.second - 1));
+    out << std::left << std::setw(14) << name(i->first.first) << std::right
+        << std::setw(12) << size
+        << std::setw(10) << h.count()
+        << std::setw(10) << static_cast<boost::uint64_t>(h.mean() + 0.5)
+        << std::setw(10) << h.value_at_percentile(50)
+        << std::setw(10) << h.value_at_percentile(90)
+        << std::setw(10) << h.value_at_percentile(99)
+        << std::setw(10) << h.value_at_percentile(99.9)
+        << std::setw(12) << h.max() << '\n';
+  }
+}
+
+inline
+void
+latency_stats::
+reset()
+{
+  histograms.clear();
+}
+
+inline
+boost::uint64_t
+latency_stats::
+now()
+{
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return static_cast<boost::uint64_t>(t.tv_sec) * 1000000000u + t.tv_nsec;
+}
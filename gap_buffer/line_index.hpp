@@ -0,0 +1,166 @@
+#ifndef LINE_INDEX_HPP_INCLUDED_
+#define LINE_INDEX_HPP_INCLUDED_
+
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include <cstddef>
+#include <vector>
+
+
+/**
+   @brief A gap_buffer observer which keeps an index of where lines begin
+   @details
+   Attach a line_index to a gap_buffer by naming it as the buffer's TObserver.
+   It keeps the position of every newline, updating them as the buffer is
+   edited at its cursor or through iterators, so that converting between
+   positions and lines never has to scan the buffer.
+
+   The newlines are kept in chunks of a few hundred, each holding the offsets
+   of its newlines from the start of the chunk.  The lengths and newline counts
+   of the chunks are summed in Fenwick trees, so that the chunk holding a
+   position or a line is found in O(log n) time, and an edit only has to shift
+   the newlines of the one chunk it falls in.
+
+   Line numbers count from zero.  A newline belongs to the line it ends, and
+   a buffer of n newlines has n + 1 lines, the last of which may be empty.
+
+   @tparam T The value_type of the gap_buffer being observed
+*/
+template<class T>
+class line_index
+{
+public:
+  /// The size_type of this index
+  typedef std::size_t size_type;
+
+  /// Tell gap_buffer that this observer needs to hear about every edit
+  static bool const enabled = true;
+
+  /// Construct an index of an empty buffer
+  /// @param newline The element which ends a line
+  explicit line_index(T const & newline = T('\n'));
+
+  /// @name Observer Requirements
+  //@{
+  /// Index the newlines amongst [first, first + (last - first)), just
+  /// inserted at index position
+  /// @note \b Complexity: O(std::distance(first, last) + log n), plus the
+  ///       newlines in the chunk holding position
+  template<class TBuffer, class TIterator>
+  void on_insert(TBuffer const & buffer, size_type position,
+                 TIterator first, TIterator last);
+  /// Forget the newlines amongst [first, last), about to be erased from index
+  /// position
+  /// @note \b Complexity: O(std::distance(first, last) + log n), plus the
+  ///       newlines in the chunks holding [first, last)
+  template<class TBuffer, class TIterator>
+  void on_erase(TBuffer const & buffer, size_type position,
+                TIterator first, TIterator last);
+  /// Moving the cursor changes nothing
+  /// @note \b Complexity: O(1)
+  template<class TBuffer>
+  void on_advance(TBuffer const & buffer, std::ptrdiff_t distance);
+  /// Index the whole of buffer afresh
+  /// @note \b Complexity: O(n)
+  template<class TBuffer>
+  void on_reset(TBuffer const & buffer);
+  //@}
+
+  /// @name Lines
+  //@{
+  /// Return the number of lines, which is one more than the number of
+  /// newlines
+  /// @note \b Complexity: O(1)
+  size_type line_count() const;
+
+  /// Return the line holding the element at position, or the last line if
+  /// position is the size of the buffer
+  /// @note \b Complexity: O(log n)
+  size_type line_of(size_type position) const;
+
+  /// Return the position of the first element of line, which must be less
+  /// than line_count()
+  /// @note \b Complexity: O(log n)
+  size_type line_start(size_type line) const;
+
+  /// Return how far position is from the start of its line
+  /// @note \b Complexity: O(log n)
+  size_type column_of(size_type position) const;
+
+  /// Return the number of elements indexed, which is the size of the buffer
+  /// @note \b Complexity: O(1)
+  size_type size() const;
+  //@}
+
+private:
+  // The number of newlines a chunk is built with.  Chunks are split once they
+  // hold twice this many, and merged with a neighbour below a quarter of it.
+  static size_type const chunk_lines = 256;
+
+  // A run of the buffer, and the offsets of the newlines within it
+  struct chunk
+  {
+    size_type              length;
+    std::vector<size_type> breaks;
+  };
+
+  std::vector<chunk> chunks;
+  // Fenwick trees of the lengths of the chunks, and the number of newlines
+  // in each
+  std::vector<size_type> length_sums;
+  std::vector<size_type> break_sums;
+  size_type total_length;
+  size_type total_breaks;
+  T newline;
+
+  // Find the chunk holding the position-th element, or the count-th newline,
+  // and set before to the total of the chunks ahead of it
+  size_type chunk_at(size_type position, size_type & before) const;
+  size_type chunk_of_break(size_type count, size_type & before) const;
+  // Replace chunks [first, last) with chunks built from the offsets of
+  // breaks, which are counted from the start of chunk first, and length
+  void rebuild(size_type first, size_type last,
+               std::vector<size_type> const & breaks, size_type length);
+  // Recompute the Fenwick trees from the chunks
+  void resum();
+  // Split chunk k if it is too full, or, if merge, merge it with its
+  // neighbours if it is nearly empty.  Return if that changed the chunks.
+  bool tidy(size_type k, bool merge);
+};
+
+
+#include "line_index.ipp"
+#endif
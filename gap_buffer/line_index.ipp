@@ -0,0 +1,340 @@
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include "detail/fenwick.hpp"
+#include "segmented_algorithms.hpp"
+
+#include <boost/range/begin.hpp>
+#include <boost/range/end.hpp>
+#include <boost/range/iterator.hpp>
+
+#include <algorithm>
+#include <iterator>
+
+
+template<class T>
+bool const line_index<T>::enabled;
+
+template<class T>
+typename line_index<T>::size_type const line_index<T>::chunk_lines;
+
+
+template<class T>
+line_index<T>::line_index(T const & newline)
+  : chunks(1)
+  , total_length(0)
+  , total_breaks(0)
+  , newline(newline)
+{
+  chunks.front().length = 0;
+  resum();
+}
+
+
+template<class T>
+void
+line_index<T>::
+resum()
+{
+  length_sums.assign(chunks.size() + 1, 0);
+  break_sums.assign(chunks.size() + 1, 0);
+  for(size_type k = 0; k < chunks.size(); ++k){
+    index_detail::fenwick_add(length_sums, k, chunks[k].length);
+    index_detail::fenwick_add(break_sums, k,
+                              size_type(chunks[k].breaks.size()));
+  }
+}
+
+template<class T>
+typename line_index<T>::size_type
+line_index<T>::
+chunk_at(size_type position, size_type & before) const
+{
+  // Anything past the end belongs to the last chunk
+  if(position >= total_length){
+    before = total_length - chunks.back().length;
+    return chunks.size() - 1;
+  }
+  return index_detail::fenwick_search(length_sums, position, before);
+}
+
+template<class T>
+typename line_index<T>::size_type
+line_index<T>::
+chunk_of_break(size_type count, size_type & before) const
+{
+  return index_detail::fenwick_search(break_sums, count, before);
+}
+
+template<class T>
+void
+line_index<T>::
+rebuild(size_type first, size_type last,
+        std::vector<size_type> const & breaks, size_type length)
+{
+  // Share the newlines out evenly, so that every chunk but a lone one holds
+  // between chunk_lines and twice that.  Each cut is just after a newline,
+  // and the last chunk takes whatever follows the final cut.
+  size_type const pieces = std::max<size_type>(1, breaks.size() / chunk_lines);
+  std::vector<chunk> built(pieces);
+  size_type start = 0;
+  size_type b = 0;
+  for(size_type p = 0; p < pieces; ++p){
+    size_type const next = (p + 1 == pieces) ? breaks.size() :
+      (p + 1) * breaks.size() / pieces;
+    size_type const end = (p + 1 == pieces) ? length : breaks[next - 1] + 1;
+    for(; b < next; ++b)
+      built[p].breaks.push_back(breaks[b] - start);
+    built[p].length = end - start;
+    start = end;
+  }
+
+  chunks.erase(chunks.begin() + first, chunks.begin() + last);
+  chunks.insert(chunks.begin() + first, built.begin(), built.end());
+  resum();
+}
+
+template<class T>
+bool
+line_index<T>::
+tidy(size_type k, bool merge)
+{
+  chunk const & c = chunks[k];
+  bool const too_full = c.breaks.size() > 2 * chunk_lines;
+  bool const too_empty = merge && chunks.size() > 1 &&
+    (c.length == 0 || c.breaks.size() < chunk_lines / 4);
+  if(!too_full && !too_empty)
+    return false;
+
+  // Gather k and, when it is nearly empty, its neighbours, and cut them up
+  // into chunks afresh
+  size_type const first = (too_empty && k > 0) ? k - 1 : k;
+  size_type const last = (too_empty && k + 1 < chunks.size()) ? k + 2 : k + 1;
+  std::vector<size_type> breaks;
+  size_type length = 0;
+  for(size_type i = first; i < last; ++i){
+    for(size_type j = 0; j < chunks[i].breaks.size(); ++j)
+      breaks.push_back(length + chunks[i].breaks[j]);
+    length += chunks[i].length;
+  }
+  rebuild(first, last, breaks, length);
+  return true;
+}
+
+
+template<class T>
+template<class TBuffer, class TIterator>
+void
+line_index<T>::
+on_insert(TBuffer const &, size_type position,
+          TIterator first, TIterator last)
+{
+  if(first == last)
+    return;
+  std::vector<size_type> added;
+  size_type length = 0;
+  for(; first != last; ++first, ++length)
+    if(*first == newline)
+      added.push_back(length);
+
+  size_type before;
+  size_type const k = chunk_at(position, before);
+  chunk & c = chunks[k];
+  size_type const offset = position - before;
+
+  // Shift the newlines after the insertion, then slot in the new ones
+  std::vector<size_type>::iterator const split =
+    std::lower_bound(c.breaks.begin(), c.breaks.end(), offset);
+  for(std::vector<size_type>::iterator i = split; i != c.breaks.end(); ++i)
+    *i += length;
+  for(size_type i = 0; i < added.size(); ++i)
+    added[i] += offset;
+  c.breaks.insert(split, added.begin(), added.end());
+  c.length += length;
+  total_length += length;
+  total_breaks += added.size();
+
+  if(!tidy(k, false)){
+    index_detail::fenwick_add(length_sums, k, length);
+    index_detail::fenwick_add(break_sums, k, size_type(added.size()));
+  }
+}
+
+template<class T>
+template<class TBuffer, class TIterator>
+void
+line_index<T>::
+on_erase(TBuffer const &, size_type position,
+         TIterator first, TIterator last)
+{
+  size_type remaining = std::distance(first, last);
+  if(remaining == 0)
+    return;
+
+  size_type before;
+  size_type const first_chunk = chunk_at(position, before);
+  total_length -= remaining;
+  size_type offset = position - before;
+  size_type k = first_chunk;
+  for(; remaining > 0; ++k, offset = 0){
+    chunk & c = chunks[k];
+    size_type const taken = std::min(remaining, c.length - offset);
+    std::vector<size_type>::iterator const from =
+      std::lower_bound(c.breaks.begin(), c.breaks.end(), offset);
+    std::vector<size_type>::iterator const to =
+      std::lower_bound(from, c.breaks.end(), offset + taken);
+    for(std::vector<size_type>::iterator i = to; i != c.breaks.end(); ++i)
+      *i -= taken;
+    size_type const dropped = to - from;
+    c.breaks.erase(from, to);
+    c.length -= taken;
+    total_breaks -= dropped;
+    remaining -= taken;
+    if(k == first_chunk && remaining == 0){
+      // The common case of an erasure within one chunk
+      if(!tidy(k, true)){
+        index_detail::fenwick_add(length_sums, k, size_type(0) - taken);
+        index_detail::fenwick_add(break_sums, k, size_type(0) - dropped);
+      }
+      return;
+    }
+  }
+
+  // The erasure spanned several chunks, so drop the emptied ones and merge
+  // what is left at either end
+  size_type const last_chunk = k - 1;
+  std::vector<size_type> breaks;
+  size_type length = 0;
+  for(size_type i = first_chunk; i <= last_chunk; ++i){
+    for(size_type j = 0; j < chunks[i].breaks.size(); ++j)
+      breaks.push_back(length + chunks[i].breaks[j]);
+    length += chunks[i].length;
+  }
+  rebuild(first_chunk, last_chunk + 1, breaks, length);
+  tidy(first_chunk, true);
+}
+
+template<class T>
+template<class TBuffer>
+void
+line_index<T>::
+on_advance(TBuffer const &, std::ptrdiff_t)
+{}
+
+template<class T>
+template<class TBuffer>
+void
+line_index<T>::
+on_reset(TBuffer const & buffer)
+{
+  typedef typename TBuffer::const_segment_list segments_t;
+  typedef typename boost::range_iterator<segments_t const>::type segment_iter;
+  typedef typename boost::range_iterator<
+    typename boost::range_value<segments_t>::type const>::type   iterator;
+
+  // Scan the runs of the buffer with the search kernels
+  std::vector<size_type> breaks;
+  size_type length = 0;
+  segments_t const segments = buffer.segments();
+  for(segment_iter s = boost::begin(segments); s != boost::end(segments);
+      ++s){
+    iterator here = boost::begin(*s);
+    iterator const end = boost::end(*s);
+    while(true){
+      size_type const skipped = segmented::detail::run_find(here, end, newline);
+      std::advance(here, skipped);
+      length += skipped;
+      if(here == end)
+        break;
+      breaks.push_back(length);
+      ++here;
+      ++length;
+    }
+  }
+  total_length = length;
+  total_breaks = breaks.size();
+  rebuild(0, chunks.size(), breaks, length);
+}
+
+
+template<class T>
+typename line_index<T>::size_type
+line_index<T>::
+line_count() const
+{
+  return total_breaks + 1;
+}
+
+template<class T>
+typename line_index<T>::size_type
+line_index<T>::
+line_of(size_type position) const
+{
+  size_type before;
+  size_type const k = chunk_at(position, before);
+  chunk const & c = chunks[k];
+  // The line is the number of newlines ahead of position
+  return index_detail::fenwick_prefix(break_sums, k) +
+    (std::lower_bound(c.breaks.begin(), c.breaks.end(), position - before) -
+     c.breaks.begin());
+}
+
+template<class T>
+typename line_index<T>::size_type
+line_index<T>::
+line_start(size_type line) const
+{
+  if(line == 0)
+    return 0;
+  // Line n begins just after the n-th newline
+  size_type before;
+  size_type const k = chunk_of_break(line - 1, before);
+  return index_detail::fenwick_prefix(length_sums, k) +
+    chunks[k].breaks[line - 1 - before] + 1;
+}
+
+template<class T>
+typename line_index<T>::size_type
+line_index<T>::
+column_of(size_type position) const
+{
+  return position - line_start(line_of(position));
+}
+
+template<class T>
+typename line_index<T>::size_type
+line_index<T>::
+size() const
+{
+  return total_length;
+}
@@ -0,0 +1,88 @@
+#ifndef MAPPED_FILE_HPP_INCLUDED_
+#define MAPPED_FILE_HPP_INCLUDED_
+
+
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+#include <string>
+
+
+/**
+   @brief A read-only memory mapping of a whole file
+   @details
+   Constructing a mapped_file maps the file into memory without reading it.
+   Pages are read in by the operating system the first time they are touched,
+   so opening even a very large file is quick, and only the parts which are
+   looked at take up memory.  The mapping is released when the mapped_file is
+   destroyed.  Share one between buffers with a boost::shared_ptr.
+
+   The mapping is private, so changes made to the file while it is mapped may
+   or may not be seen through it.  Truncating the file while it is mapped will
+   make reading the lost pages fail with SIGBUS, as with any mapping.
+
+   This uses the POSIX mmap() interface.
+*/
+class mapped_file
+  : private boost::noncopyable
+{
+public:
+  /// @brief Map the file at path, throwing boost::system::system_error if it
+  ///        cannot be opened or mapped
+  /// @note \b Complexity: O(1)
+  explicit mapped_file(std::string const & path);
+
+  /// Unmap the file
+  ~mapped_file();
+
+  /// Return the first byte of the file, or 0 if it is empty
+  /// @note \b Complexity: O(1)
+  char const * data() const;
+
+  /// Return the length of the file in bytes
+  /// @note \b Complexity: O(1)
+  std::size_t size() const;
+
+private:
+  void *      address;
+  std::size_t length;
+};
+
+
+#include "mapped_file.ipp"
+#endif
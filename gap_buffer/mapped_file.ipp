@@ -0,0 +1,110 @@
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include <boost/system/error_code.hpp>
+#include <boost/system/system_error.hpp>
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace mapped_file_detail
+{
+  // Throw the error in errno, naming what failed
+  inline void fail(std::string const & what, std::string const & path)
+  {
+    throw boost::system::system_error(errno, boost::system::system_category(),
+                                      what + " " + path);
+  }
+}
+
+
+inline
+mapped_file::mapped_file(std::string const & path)
+  : address(0)
+  , length(0)
+{
+  int const fd = ::open(path.c_str(), O_RDONLY);
+  if(fd < 0)
+    mapped_file_detail::fail("open", path);
+
+  struct stat status;
+  if(::fstat(fd, &status) != 0){
+    int const error = errno;
+    ::close(fd);
+    errno = error;
+    mapped_file_detail::fail("stat", path);
+  }
+  length = static_cast<std::size_t>(status.st_size);
+
+  // mmap() refuses empty mappings, and an empty file needs none
+  if(length > 0){
+    address = ::mmap(0, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(address == MAP_FAILED){
+      int const error = errno;
+      ::close(fd);
+      errno = error;
+      address = 0;
+      mapped_file_detail::fail("mmap", path);
+    }
+  }
+  // The mapping keeps the file open by itself
+  ::close(fd);
+}
+
+inline
+mapped_file::~mapped_file()
+{
+  if(address)
+    ::munmap(address, length);
+}
+
+inline
+char const *
+mapped_file::
+data() const
+{
+  return static_cast<char const *>(address);
+}
+
+inline
+std::size_t
+mapped_file::
+size() const
+{
+  return length;
+}
@@ -0,0 +1,456 @@
+#ifndef MULTI_GAP_BUFFER_HPP_INCLUDED_
+#define MULTI_GAP_BUFFER_HPP_INCLUDED_
+
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include <boost/concept/assert.hpp>
+#include <boost/concept_check.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/move/move.hpp>
+#include <boost/range/iterator_range.hpp>
+#include <boost/type_traits/is_convertible.hpp>
+#include <boost/utility/enable_if.hpp>
+#include <cstddef>
+#include <iterator>
+#include <list>
+#include <vector>
+
+#include "container_traits.hpp"
+
+
+/**
+   @brief A gap buffer container adapter with several cursors and gaps
+   @details
+   This class template provides the interface of gap_buffer, but allows any
+   number of cursors and keeps up to MaxGaps gaps open at once.  The elements
+   are stored as a list of pieces, each of which is a pair of TContainers with a
+   gap between them, exactly as in gap_buffer.  An edit at a cursor is made at
+   whichever gap is nearest to it.  When that gap is more than SplitDistance
+   elements away and fewer than MaxGaps gaps are open, the piece holding it is
+   split in two at its gap, and the new piece's gap is moved to the edit
+   instead.  The old gap stays where it was, so edits which alternate between
+   two distant sites each find a gap waiting for them after the first round.
+
+   Cursors are only logical positions, so moving one never moves any elements;
+   the gaps follow the edits.  Cursor 0 always exists, and the single-cursor
+   members (position(), advance(), insert() and erase()) act on it, so a
+   multi_gap_buffer may be used anywhere a gap_buffer is.
+
+   A multi_gap_buffer is an STL container.  It models the STL concepts
+   Container, Forward Container, and Reversible Container.
+
+   @tparam TContainer    The underlying container type of each piece, with the
+                         same requirements as for gap_buffer
+   @tparam MaxGaps       The most gaps which will be kept open at once
+   @tparam SplitDistance The distance an edit must be from its nearest gap
+                         before a new gap is opened for it
+*/
+template<class TContainer,
+         std::size_t MaxGaps = 8,
+         std::size_t SplitDistance = 1024>
+class multi_gap_buffer
+{
+private:
+  // Enable Boost.Move move-emulation (or actual move on C++11)
+  BOOST_COPYABLE_AND_MOVABLE(multi_gap_buffer)
+
+  // Check our requirements on TContainer
+  BOOST_CONCEPT_ASSERT(( boost::Mutable_ForwardContainer<    TContainer> ));
+  BOOST_CONCEPT_ASSERT(( boost::Mutable_ReversibleContainer< TContainer> ));
+  BOOST_CONCEPT_ASSERT(( boost::Mutable_Container<           TContainer> ));
+  BOOST_CONCEPT_ASSERT(( boost::Sequence<                    TContainer> ));
+
+  // One gap, and the elements on either side of it up to the neighbouring gaps
+  struct piece
+  {
+    TContainer before;
+    TContainer after;
+  };
+  typedef std::list<piece> piece_list;
+
+  // This iterator template uses Boost.Iterator to produce the iterator types
+  // for multi_gap_buffer.  It walks the halves of each piece in turn.
+  template<class TValue, class TPieceIter, class TUnderlying>
+  class iterator_impl;
+
+  piece_list pieces;
+public:
+  /// @name Other Container requirements
+  //@{
+  /// The value_type of this container
+  typedef typename TContainer::value_type                  value_type;
+  /// value_type *
+  typedef typename TContainer::pointer                     pointer;
+  /// value_type const *
+  typedef typename TContainer::const_pointer               const_pointer;
+  /// value_type &
+  typedef typename TContainer::reference                   reference;
+  /// value_type const &
+  typedef typename TContainer::const_reference             const_reference;
+  /// The size_type of this container
+  typedef typename TContainer::size_type                   size_type;
+  /// The difference_type of this container
+  typedef typename TContainer::difference_type             difference_type;
+  /// Identifies one of the cursors of a multi_gap_buffer
+  typedef size_type                                        cursor_id;
+
+  /// Return the number of elements in the multi_gap_buffer
+  /// @note \b Complexity: O(gap_count()) times that of TContainer::size()
+  size_type size() const;
+
+  /// Return the maximum number of elements a multi_gap_buffer might hold
+  /// @note \b Complexity: Amortized O(1)
+  size_type max_size() const;
+
+  /// Return if the multi_gap_buffer is empty
+  /// @note \b Complexity: O(gap_count())
+  bool empty() const;
+
+  /// Swap this multi_gap_buffer with another
+  /// @note \b Complexity: O(1)
+  void swap(multi_gap_buffer & other);
+  //@}
+
+  ///@name Iterator access
+  //@{
+  typedef iterator_impl<value_type,
+                        typename piece_list::iterator,
+                        typename TContainer::iterator>             iterator;
+  typedef iterator_impl<value_type const,
+                        typename piece_list::const_iterator,
+                        typename TContainer::const_iterator> const_iterator;
+  typedef std::reverse_iterator<iterator>                  reverse_iterator;
+  typedef std::reverse_iterator<const_iterator>      const_reverse_iterator;
+
+  /// Return the position of cursor 0 as an iterator
+  /// @note \b Complexity: O(gap_count()) plus at most O(n) to advance within
+  ///       one piece, which is O(1) for random access TContainers
+  iterator here();
+  /// Return the position of cursor 0 as an iterator
+  /// @note \b Complexity: The same as here()
+  const_iterator here() const;
+  /// Return the position of cursor 0 as a reverse iterator
+  /// @note \b Complexity: The same as here()
+  reverse_iterator rhere();
+  /// Return the position of cursor 0 as a reverse iterator
+  /// @note \b Complexity: The same as here()
+  const_reverse_iterator rhere() const;
+
+  /// Get an iterator to the beginning of the multi_gap_buffer
+  /// @note \b Complexity: O(gap_count())
+  iterator begin();
+  /// Get an iterator to one element past the end of the multi_gap_buffer
+  /// @note \b Complexity: O(1)
+  iterator end();
+  /// Get a const iterator to the beginning of the multi_gap_buffer
+  /// @note \b Complexity: O(gap_count())
+  const_iterator begin() const;
+  /// Get a const iterator to one element past the end of the multi_gap_buffer
+  /// @note \b Complexity: O(1)
+  const_iterator end() const;
+
+  /// Get a reverse iterator to the beginning of the reversed multi_gap_buffer
+  /// @note \b Complexity: O(1)
+  reverse_iterator rbegin();
+  /// @brief Get a reverse iterator to one element past the end of the reversed
+  /// multi_gap_buffer
+  /// @note \b Complexity: O(gap_count())
+  reverse_iterator rend();
+  /// Get a const reverse iterator to the beginning of the reversed
+  /// multi_gap_buffer
+  /// @note \b Complexity: O(1)
+  const_reverse_iterator rbegin() const;
+  /// @brief Get a reverse const iterator to one element past the end of the
+  /// reversed multi_gap_buffer
+  /// @note \b Complexity: O(gap_count())
+  const_reverse_iterator rend() const;
+  //@}
+
+  /// @name Segments
+  //@{
+  /// @brief A range of the contiguous runs of a multi_gap_buffer, in order
+  /// @details These are the containers on either side of each gap, any of
+  ///          which may be empty.
+  typedef std::vector<
+    boost::iterator_range<typename TContainer::const_iterator> >
+  const_segment_list;
+
+  /// @brief Return the runs of elements in this multi_gap_buffer, for use by
+  ///        the algorithms in segmented_algorithms.hpp
+  /// @note The runs are invalidated by any edit or cursor movement
+  /// @note \b Complexity: O(gap_count())
+  const_segment_list segments() const;
+  //@}
+
+  /// @name Sequence Requirements
+  //@{
+  /// Default-construct an empty multi_gap_buffer with a single cursor
+  multi_gap_buffer();
+
+  /// Copy-construct a multi_gap_buffer, including its cursors
+  /// @note \b Complexity: O(other.size())
+  multi_gap_buffer(multi_gap_buffer const & other);
+
+  /// Move-construct a multi_gap_buffer, including its cursors
+  /// @note \b Complexity: O(1)
+  multi_gap_buffer(BOOST_RV_REF(multi_gap_buffer) other);
+
+  /// Fill-construct a multi_gap_buffer with n copies of e and cursor 0 at the
+  /// end
+  /// @note \b Complexity: O(n)
+  multi_gap_buffer(size_type n, value_type e = value_type());
+
+  /// @brief Construct a multi_gap_buffer whose contents are the range [i, j)
+  ///        with cursor 0 at the end
+  /// @tparam InputIterator A model of Input Iterator whose value_type is
+  ///                       convertible to value_type
+  /// @note \b Complexity: O(std::distance(i, j))
+  template<class InputIterator>
+  multi_gap_buffer(InputIterator const & i, InputIterator const & j);
+
+  /// Retrieve the first element of the multi_gap_buffer
+  /// @note \b Complexity: O(gap_count())
+  reference       front();
+  /// Retrieve the first element of the multi_gap_buffer
+  /// @note \b Complexity: O(gap_count())
+  const_reference front() const;
+
+  /// Insert element immediately before position.  Every cursor at or after
+  /// position advances one position.
+  /// @note \b Complexity: The same as insert(cursor_id, value_type), plus the
+  ///       cost of finding position's index
+  iterator insert(iterator position, const_reference element);
+
+  /// Insert n copies of element immediately before position.  Every cursor at
+  /// or after position advances n positions.
+  /// @note \b Complexity: The same as insert(iterator, const_reference), plus
+  ///       O(n)
+  void insert(iterator position, size_type n, const_reference element);
+
+  /// Insert the range of elements [i,j) immediately before position. Every
+  /// cursor at or after position advances by the length of the range.
+  /// @note \b Complexity: The same as insert(iterator, const_reference), plus
+  ///       O(std::distance(i, j))
+  template<class InputIterator>
+  void insert(iterator position,
+              InputIterator const & i, InputIterator const & j);
+
+  /// Erase the element at position.  Every cursor after position moves one
+  /// spot earlier.
+  /// @note \b Complexity: At most O(n), without moving any gap
+  iterator erase(iterator position);
+
+  /// Erase the elements in [start,end).  Every cursor within this range moves
+  /// to immediately before it, and every cursor after it moves back by its
+  /// length.
+  /// @note \b Complexity: At most O(n), without moving any gap
+  iterator erase(iterator start, iterator end);
+
+  /// Remove all the elements in this, closing every gap but one and moving
+  /// every cursor to the beginning
+  /// @note \b Complexity: O(n)
+  void clear();
+
+  /// Resize the multi_gap_buffer.  If the buffer is growing, pad the end with
+  /// copies of e.  If the buffer is shrinking, discard elements from the end.
+  /// @note \b Complexity: O(n)
+  void resize(size_type n, value_type const & e = value_type());
+
+  /// Assign one multi_gap_buffer to another
+  /// @note \b Complexity: O(n)
+  multi_gap_buffer & operator=(BOOST_COPY_ASSIGN_REF(multi_gap_buffer) other);
+
+  /// Move assign one multi_gap_buffer to another
+  /// @note \b Complexity: O(1)
+  multi_gap_buffer & operator=(BOOST_RV_REF(multi_gap_buffer) other);
+  //@}
+
+
+  /// @name Cursor Handling
+  //@{
+  /// Return the position of cursor 0
+  /// @note \b Complexity: O(1)
+  size_type position() const;
+
+  /// Move cursor 0
+  /// @note \b Complexity: O(1)
+  void advance(difference_type const dist);
+
+  /// @brief Remove data from the position of cursor 0.
+  /// @details A positive value erases the given number of values from ahead of
+  /// the cursor.  A negative value erases the absolute value of the given
+  /// number of cursors from behind the cursor.
+  /// @note \b Complexity: The same as erase(cursor_id, difference_type)
+  void erase(difference_type const dist);
+
+  /// Insert an element at cursor 0
+  /// @note \b Complexity: The same as insert(cursor_id, value_type)
+  size_type insert(value_type const);
+
+  /// @brief Insert a range of elements at cursor 0
+  /// @param range Any range of elements Boost.Range recognizes as a Single Pass
+  ///              Range.
+  /// @note \b Complexity: The same as insert(cursor_id, range)
+  template<class TSinglePassRange>
+  size_type insert(TSinglePassRange const & range);
+  //@}
+
+  /// @name Multiple Cursors
+  //@{
+  /// Add a cursor at position, and return its id
+  /// @note \b Complexity: Amortized O(1)
+  cursor_id add_cursor(size_type position);
+
+  /// Remove a cursor other than cursor 0.  The ids of the cursors added after
+  /// it are each reduced by one.
+  /// @note \b Complexity: O(cursor_count())
+  void remove_cursor(cursor_id id);
+
+  /// Return the number of cursors, including cursor 0
+  /// @note \b Complexity: O(1)
+  size_type cursor_count() const;
+
+  /// Return the number of gaps currently open
+  /// @note \b Complexity: O(gap_count())
+  size_type gap_count() const;
+
+  /// Return the position of cursor id
+  /// @note \b Complexity: O(1)
+  size_type position(cursor_id id) const;
+
+  /// Move cursor id
+  /// @note \b Complexity: O(1)
+  void advance(cursor_id id, difference_type const dist);
+
+  /// Return the position of cursor id as an iterator
+  /// @note \b Complexity: The same as here()
+  iterator here(cursor_id id);
+  /// Return the position of cursor id as an iterator
+  /// @note \b Complexity: The same as here()
+  const_iterator here(cursor_id id) const;
+
+  /// @brief Remove data from the position of cursor id, as for
+  ///        erase(difference_type)
+  /// @note \b Complexity: O(abs(dist)) for the elements removed, plus at most
+  ///       O(n) to close up the piece they were removed from.  No gap moves.
+  void erase(cursor_id id, difference_type const dist);
+
+  /// Insert an element at cursor id, advancing it and every cursor at or after
+  /// it.  Return the new position of cursor id.
+  /// @note \b Complexity: O(gap_count()) to find the nearest gap, plus the
+  ///       distance it must move, which is at most SplitDistance while fewer
+  ///       than MaxGaps gaps are open
+  size_type insert(cursor_id id, value_type const);
+
+  /// Insert a range of elements at cursor id, advancing it and every cursor at
+  /// or after it.  Return the new position of cursor id.
+  /// @note \b Complexity: The same as insert(cursor_id, value_type), plus
+  ///       O(boost::size(range))
+  template<class TSinglePassRange>
+  size_type insert(cursor_id id, TSinglePassRange const & range);
+  //@}
+
+private:
+  // The logical position of every cursor.  cursors[0] always exists.
+  std::vector<size_type> cursors;
+
+  // Find the piece whose gap is nearest to index i, and i's index within it
+  typename piece_list::iterator locate(size_type i, size_type & local);
+  // Make a gap at index i, opening a new one if the nearest is too far away,
+  // and return the piece it belongs to
+  typename piece_list::iterator open_gap(size_type i);
+  // Move the gap of p to local index local
+  static void move_gap(piece & p, size_type local);
+  // Return the index of an iterator
+  size_type index_of(const_iterator i) const;
+  // Return an iterator to index i
+  iterator iterator_at(size_type i);
+  const_iterator iterator_at(size_type i) const;
+
+  // Insert [first, last) at index i, and fix up the cursors
+  template<class InputIterator>
+  void insert_at(size_type i, InputIterator first, InputIterator last);
+  // Insert n copies of e at index i, and fix up the cursors
+  void insert_fill(size_type i, size_type n, value_type const & e);
+  // Advance every cursor at or after i by n
+  void shift_cursors(size_type i, size_type n);
+  // Erase logical [start, finish), and fix up the cursors
+  void erase_range(size_type start, size_type finish);
+
+  // Check our iterator's concepts
+  BOOST_CONCEPT_ASSERT((boost::Mutable_BidirectionalIterator<        iterator>));
+  BOOST_CONCEPT_ASSERT((boost::Mutable_BidirectionalIterator<reverse_iterator>));
+  BOOST_CONCEPT_ASSERT((boost::BidirectionalIterator<          const_iterator>));
+  BOOST_CONCEPT_ASSERT((boost::BidirectionalIterator<  const_reverse_iterator>));
+};
+
+///@name Comparisons
+//@{
+/// Test two multi_gap_buffers for equality
+/// @note \b Complexity: O(n)
+template<class TCont, std::size_t G, std::size_t D>
+bool operator==(multi_gap_buffer<TCont, G, D> const &,
+                multi_gap_buffer<TCont, G, D> const &);
+/// Test two multi_gap_buffers for inequality
+/// @note \b Complexity: O(n)
+template<class TCont, std::size_t G, std::size_t D>
+bool operator!=(multi_gap_buffer<TCont, G, D> const &,
+                multi_gap_buffer<TCont, G, D> const &);
+/// Test if one multi_gap_buffer is less than another
+/// @note \b Complexity: O(n)
+template<class TCont, std::size_t G, std::size_t D>
+bool operator<(multi_gap_buffer<TCont, G, D> const &,
+               multi_gap_buffer<TCont, G, D> const &);
+/// Test if one multi_gap_buffer is greater than another
+/// @note \b Complexity: O(n)
+template<class TCont, std::size_t G, std::size_t D>
+bool operator>(multi_gap_buffer<TCont, G, D> const &,
+               multi_gap_buffer<TCont, G, D> const &);
+/// Test if one multi_gap_buffer is less than or equal to another
+/// @note \b Complexity: O(n)
+template<class TCont, std::size_t G, std::size_t D>
+bool operator<=(multi_gap_buffer<TCont, G, D> const &,
+                multi_gap_buffer<TCont, G, D> const &);
+/// Test if one multi_gap_buffer is greater than or equal to another
+/// @note \b Complexity: O(n)
+template<class TCont, std::size_t G, std::size_t D>
+bool operator>=(multi_gap_buffer<TCont, G, D> const &,
+                multi_gap_buffer<TCont, G, D> const &);
+//@}
+
+
+#include "segmented_algorithms.hpp"
+#include "multi_gap_buffer.ipp"
+#endif
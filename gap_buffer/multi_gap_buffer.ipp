@@ -0,0 +1,810 @@
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <boost/next_prior.hpp>
+#include <boost/range/begin.hpp>
+#include <boost/range/end.hpp>
+
+#include <algorithm>
+
+
+/**
+   @invariant location is not the end of its half, unless it is the end of the
+              last piece's after
+*/
+template<class TContainer, std::size_t G, std::size_t D>
+template<class TValue, class TPieceIter, class TUnderlying>
+class multi_gap_buffer<TContainer, G, D>::iterator_impl
+  : public boost::iterator_facade<
+      iterator_impl<TValue, TPieceIter, TUnderlying>,
+      TValue,
+      std::bidirectional_iterator_tag>
+{
+  struct enabler {};
+public:
+  iterator_impl()
+    : is_after(false)
+  {}
+
+  iterator_impl(TPieceIter p, TPieceIter last, bool after, TUnderlying here)
+    : piece(p)
+    , last_piece(last)
+    , is_after(after)
+    , location(here)
+  {
+    normalize();
+  }
+
+  // Allow iterator to convert to const_iterator, but not the other way around
+  template<class UValue, class UPieceIter, class UUnderlying>
+  iterator_impl(iterator_impl<UValue, UPieceIter, UUnderlying> const & other,
+                typename boost::enable_if<
+                  boost::is_convertible<UValue *, TValue *>,
+                  enabler>::type = enabler())
+    : piece(other.piece)
+    , last_piece(other.last_piece)
+    , is_after(other.is_after)
+    , location(other.location)
+  {}
+
+private:
+  // Grant access to Boost.Iterator
+  friend class boost::iterator_core_access;
+  friend class multi_gap_buffer<TContainer, G, D>;
+  template<class, class, class> friend class iterator_impl;
+
+  // The piece location belongs to
+  TPieceIter  piece;
+  // The last piece of the buffer, whose after holds end()
+  TPieceIter  last_piece;
+  // If location belongs to the after half of piece
+  bool        is_after;
+  // The underlying iterator into one half of piece
+  TUnderlying location;
+
+  TUnderlying half_begin() const
+  {
+    return is_after ? piece->after.begin() : piece->before.begin();
+  }
+  TUnderlying half_end() const
+  {
+    return is_after ? piece->after.end() : piece->before.end();
+  }
+
+  void normalize()
+  {
+    while(location == half_end() && !(is_after && piece == last_piece)){
+      if(is_after){
+        ++piece;
+        is_after = false;
+      }else
+        is_after = true;
+      location = half_begin();
+    }
+  }
+
+  TValue & dereference() const
+  {
+    return *location;
+  }
+  // Compare the iterator for equality, as a callback to Boost.Iterator
+  template<class UValue, class UPieceIter, class UUnderlying>
+  bool equal(iterator_impl<UValue, UPieceIter, UUnderlying> const & other)
+    const
+  {
+    return piece == other.piece && is_after == other.is_after &&
+      location == other.location;
+  }
+  // Increment the iterator, as a callback to Boost.Iterator
+  void increment()
+  {
+    ++location;
+    normalize();
+  }
+  // Decrement the iterator, as a callback to Boost.Iterator
+  void decrement()
+  {
+    while(location == half_begin()){
+      if(is_after)
+        is_after = false;
+      else{
+        --piece;
+        is_after = true;
+      }
+      location = half_end();
+    }
+    --location;
+  }
+};
+
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::piece_list::iterator
+multi_gap_buffer<TContainer, G, D>::
+locate(size_type i, size_type & local)
+{
+  typename piece_list::iterator p = pieces.begin();
+  for(;;){
+    size_type const gap = p->before.size();
+    size_type const length = gap + p->after.size();
+    typename piece_list::iterator const next = boost::next(p);
+    if(i < length || next == pieces.end()){
+      local = i;
+      return p;
+    }
+    if(i == length){
+      // i sits between two pieces, so use whichever gap is closer
+      size_type const here_cost = length - gap;
+      size_type const next_cost = next->before.size();
+      if(here_cost <= next_cost){
+        local = i;
+        return p;
+      }
+      local = 0;
+      return next;
+    }
+    i -= length;
+    p = next;
+  }
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::piece_list::iterator
+multi_gap_buffer<TContainer, G, D>::
+open_gap(size_type i)
+{
+  size_type local;
+  typename piece_list::iterator p = locate(i, local);
+  size_type const gap = p->before.size();
+  size_type const distance = (local > gap) ? local - gap : gap - local;
+
+  if(distance > D && pieces.size() < G && gap != 0 && !p->after.empty()){
+    // Leave the old gap where it is, for whoever used it last, by splitting
+    // its piece there.  The edit then moves the gap of whichever half it's in.
+    // A gap at either end of its piece is already kept by the piece boundary.
+    typename piece_list::iterator const split =
+      pieces.insert(boost::next(p), piece());
+    split->after.swap(p->after);
+    if(local > gap){
+      p = split;
+      local -= gap;
+    }
+  }
+  move_gap(*p, local);
+  return p;
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+void
+multi_gap_buffer<TContainer, G, D>::
+move_gap(piece & p, size_type local)
+{
+  size_type const gap = p.before.size();
+  if(local < gap){
+    typename TContainer::iterator start_iter = p.before.begin();
+    std::advance(start_iter, local);
+    relocate_tail(p.before, start_iter, p.after);
+  }else if(local > gap){
+    typename TContainer::iterator end_iter = p.after.begin();
+    std::advance(end_iter, local - gap);
+    relocate_head(p.after, end_iter, p.before);
+  }
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::size_type
+multi_gap_buffer<TContainer, G, D>::
+index_of(const_iterator i) const
+{
+  size_type index = 0;
+  for(typename piece_list::const_iterator p = pieces.begin(); p != i.piece;
+      ++p)
+    index += p->before.size() + p->after.size();
+  if(i.is_after)
+    index += i.piece->before.size();
+  return index + std::distance(i.half_begin(), i.location);
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::iterator
+multi_gap_buffer<TContainer, G, D>::
+iterator_at(size_type i)
+{
+  typename piece_list::iterator const last = boost::prior(pieces.end());
+  for(typename piece_list::iterator p = pieces.begin(); ; ++p){
+    if(i < p->before.size()){
+      typename TContainer::iterator location = p->before.begin();
+      std::advance(location, i);
+      return iterator(p, last, false, location);
+    }
+    i -= p->before.size();
+    if(i < p->after.size() || p == last){
+      typename TContainer::iterator location = p->after.begin();
+      std::advance(location, i);
+      return iterator(p, last, true, location);
+    }
+    i -= p->after.size();
+  }
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::const_iterator
+multi_gap_buffer<TContainer, G, D>::
+iterator_at(size_type i) const
+{
+  return const_cast<multi_gap_buffer &>(*this).iterator_at(i);
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+template<class InputIterator>
+void
+multi_gap_buffer<TContainer, G, D>::
+insert_at(size_type i, InputIterator first, InputIterator last)
+{
+  TContainer & before = open_gap(i)->before;
+  size_type const old_size = before.size();
+  before.insert(before.end(), first, last);
+  shift_cursors(i, before.size() - old_size);
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+void
+multi_gap_buffer<TContainer, G, D>::
+insert_fill(size_type i, size_type n, value_type const & e)
+{
+  TContainer & before = open_gap(i)->before;
+  before.insert(before.end(), n, e);
+  shift_cursors(i, n);
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+void
+multi_gap_buffer<TContainer, G, D>::
+shift_cursors(size_type i, size_type n)
+{
+  for(size_type c = 0; c < cursors.size(); ++c)
+    if(cursors[c] >= i)
+      cursors[c] += n;
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+void
+multi_gap_buffer<TContainer, G, D>::
+erase_range(size_type start, size_type finish)
+{
+  size_type piece_start = 0;
+  typename piece_list::iterator p = pieces.begin();
+  while(p != pieces.end() && piece_start < finish){
+    size_type const gap = p->before.size();
+    size_type const piece_end = piece_start + gap + p->after.size();
+    if(piece_end > start){
+      // Erase from each half without moving the gap between them
+      size_type const first = std::max(start, piece_start) - piece_start;
+      size_type const last = std::min(finish, piece_end) - piece_start;
+      if(first < gap){
+        typename TContainer::iterator from = p->before.begin();
+        std::advance(from, first);
+        typename TContainer::iterator to = from;
+        std::advance(to, std::min(last, gap) - first);
+        p->before.erase(from, to);
+      }
+      if(last > gap){
+        typename TContainer::iterator from = p->after.begin();
+        std::advance(from, std::max(first, gap) - gap);
+        typename TContainer::iterator to = from;
+        std::advance(to, last - std::max(first, gap));
+        p->after.erase(from, to);
+      }
+    }
+    piece_start = piece_end;
+    // An empty piece's gap is no use to anyone, so close it
+    if(p->before.empty() && p->after.empty() && pieces.size() > 1)
+      p = pieces.erase(p);
+    else
+      ++p;
+  }
+
+  for(size_type c = 0; c < cursors.size(); ++c)
+    cursors[c] -= std::min(finish, cursors[c]) - std::min(start, cursors[c]);
+}
+
+
+template<class TContainer, std::size_t G, std::size_t D>
+template<class TSinglePassRange>
+typename multi_gap_buffer<TContainer, G, D>::size_type
+multi_gap_buffer<TContainer, G, D>::
+insert(TSinglePassRange const & rng)
+{
+  return insert(0, rng);
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::size_type
+multi_gap_buffer<TContainer, G, D>::
+insert(value_type const c)
+{
+  return insert(0, c);
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+template<class TSinglePassRange>
+typename multi_gap_buffer<TContainer, G, D>::size_type
+multi_gap_buffer<TContainer, G, D>::
+insert(cursor_id id, TSinglePassRange const & rng)
+{
+  insert_at(cursors[id], boost::begin(rng), boost::end(rng));
+  return cursors[id];
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::size_type
+multi_gap_buffer<TContainer, G, D>::
+insert(cursor_id id, value_type const c)
+{
+  insert_fill(cursors[id], 1, c);
+  return cursors[id];
+}
+
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::size_type
+multi_gap_buffer<TContainer, G, D>::
+position() const
+{
+  return cursors[0];
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::size_type
+multi_gap_buffer<TContainer, G, D>::
+position(cursor_id id) const
+{
+  return cursors[id];
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+void
+multi_gap_buffer<TContainer, G, D>::
+advance(difference_type const d)
+{
+  advance(0, d);
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+void
+multi_gap_buffer<TContainer, G, D>::
+advance(cursor_id id, difference_type const d)
+{
+  cursors[id] += d;
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+void
+multi_gap_buffer<TContainer, G, D>::
+erase(difference_type const d)
+{
+  erase(0, d);
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+void
+multi_gap_buffer<TContainer, G, D>::
+erase(cursor_id id, difference_type const d)
+{
+  if(d < 0)
+    erase_range(cursors[id] + d, cursors[id]);
+  else
+    erase_range(cursors[id], cursors[id] + d);
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::cursor_id
+multi_gap_buffer<TContainer, G, D>::
+add_cursor(size_type position)
+{
+  cursors.push_back(position);
+  return cursors.size() - 1;
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+void
+multi_gap_buffer<TContainer, G, D>::
+remove_cursor(cursor_id id)
+{
+  if(id != 0)
+    cursors.erase(cursors.begin() + id);
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::size_type
+multi_gap_buffer<TContainer, G, D>::
+cursor_count() const
+{
+  return cursors.size();
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::size_type
+multi_gap_buffer<TContainer, G, D>::
+gap_count() const
+{
+  return pieces.size();
+}
+
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::size_type
+multi_gap_buffer<TContainer, G, D>::
+size() const
+{
+  size_type total = 0;
+  for(typename piece_list::const_iterator p = pieces.begin();
+      p != pieces.end(); ++p)
+    total += p->before.size() + p->after.size();
+  return total;
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::size_type
+multi_gap_buffer<TContainer, G, D>::
+max_size() const
+{
+  return pieces.front().before.max_size();
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+bool
+multi_gap_buffer<TContainer, G, D>::
+empty() const
+{
+  for(typename piece_list::const_iterator p = pieces.begin();
+      p != pieces.end(); ++p)
+    if(!p->before.empty() || !p->after.empty())
+      return false;
+  return true;
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+void
+multi_gap_buffer<TContainer, G, D>::
+swap(multi_gap_buffer & other)
+{
+  pieces.swap(other.pieces);
+  cursors.swap(other.cursors);
+}
+
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::iterator
+multi_gap_buffer<TContainer, G, D>::
+here()
+{
+  return iterator_at(cursors[0]);
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::const_iterator
+multi_gap_buffer<TContainer, G, D>::
+here() const
+{
+  return iterator_at(cursors[0]);
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::iterator
+multi_gap_buffer<TContainer, G, D>::
+here(cursor_id id)
+{
+  return iterator_at(cursors[id]);
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::const_iterator
+multi_gap_buffer<TContainer, G, D>::
+here(cursor_id id) const
+{
+  return iterator_at(cursors[id]);
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::reverse_iterator
+multi_gap_buffer<TContainer, G, D>::
+rhere()
+{
+  return reverse_iterator(here());
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::const_reverse_iterator
+multi_gap_buffer<TContainer, G, D>::
+rhere() const
+{
+  return const_reverse_iterator(here());
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::iterator
+multi_gap_buffer<TContainer, G, D>::
+begin()
+{
+  return iterator(pieces.begin(), boost::prior(pieces.end()), false,
+                  pieces.front().before.begin());
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::const_iterator
+multi_gap_buffer<TContainer, G, D>::
+begin() const
+{
+  return const_cast<multi_gap_buffer &>(*this).begin();
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::iterator
+multi_gap_buffer<TContainer, G, D>::
+end()
+{
+  typename piece_list::iterator const last = boost::prior(pieces.end());
+  return iterator(last, last, true, last->after.end());
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::const_iterator
+multi_gap_buffer<TContainer, G, D>::
+end() const
+{
+  return const_cast<multi_gap_buffer &>(*this).end();
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::reverse_iterator
+multi_gap_buffer<TContainer, G, D>::
+rbegin()
+{
+  return reverse_iterator(end());
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::const_reverse_iterator
+multi_gap_buffer<TContainer, G, D>::
+rbegin() const
+{
+  return const_reverse_iterator(end());
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::reverse_iterator
+multi_gap_buffer<TContainer, G, D>::
+rend()
+{
+  return reverse_iterator(begin());
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::const_reverse_iterator
+multi_gap_buffer<TContainer, G, D>::
+rend() const
+{
+  return const_reverse_iterator(begin());
+}
+
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::const_segment_list
+multi_gap_buffer<TContainer, G, D>::
+segments() const
+{
+  const_segment_list runs;
+  runs.reserve(2 * pieces.size());
+  for(typename piece_list::const_iterator p = pieces.begin();
+      p != pieces.end(); ++p){
+    runs.push_back(boost::make_iterator_range(p->before.begin(),
+                                              p->before.end()));
+    runs.push_back(boost::make_iterator_range(p->after.begin(),
+                                              p->after.end()));
+  }
+  return runs;
+}
+
+
+template<class TContainer, std::size_t G, std::size_t D>
+multi_gap_buffer<TContainer, G, D>::multi_gap_buffer()
+  : pieces(1)
+  , cursors(1, 0)
+{}
+
+template<class TContainer, std::size_t G, std::size_t D>
+multi_gap_buffer<TContainer, G, D>::
+multi_gap_buffer(multi_gap_buffer const & other)
+  : pieces(other.pieces)
+  , cursors(other.cursors)
+{}
+
+template<class TContainer, std::size_t G, std::size_t D>
+multi_gap_buffer<TContainer, G, D>::
+multi_gap_buffer(BOOST_RV_REF(multi_gap_buffer) other)
+  : pieces(1)
+  , cursors(1, 0)
+{
+  swap(other);
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+multi_gap_buffer<TContainer, G, D>::
+multi_gap_buffer(size_type n, value_type e)
+  : pieces(1)
+  , cursors(1, n)
+{
+  pieces.front().before.insert(pieces.front().before.end(), n, e);
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+template<class InputIterator>
+multi_gap_buffer<TContainer, G, D>::
+multi_gap_buffer(InputIterator const & i, InputIterator const & j)
+  : pieces(1)
+  , cursors(1, 0)
+{
+  TContainer & before = pieces.front().before;
+  before.insert(before.end(), i, j);
+  cursors[0] = before.size();
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+multi_gap_buffer<TContainer, G, D> &
+multi_gap_buffer<TContainer, G, D>::
+operator=(BOOST_COPY_ASSIGN_REF(multi_gap_buffer) other)
+{
+  if(&other != this){
+    multi_gap_buffer copy(static_cast<multi_gap_buffer const &>(other));
+    swap(copy);
+  }
+  return *this;
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+multi_gap_buffer<TContainer, G, D> &
+multi_gap_buffer<TContainer, G, D>::
+operator=(BOOST_RV_REF(multi_gap_buffer) other)
+{
+  multi_gap_buffer moved( ::boost::move(other) );
+  swap(moved);
+  return *this;
+}
+
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::reference
+multi_gap_buffer<TContainer, G, D>::front()
+{
+  return *begin();
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::const_reference
+multi_gap_buffer<TContainer, G, D>::front() const
+{
+  return *begin();
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::iterator
+multi_gap_buffer<TContainer, G, D>::insert(iterator position,
+                                           const_reference element)
+{
+  size_type const i = index_of(position);
+  // element might live in this buffer, so take a copy before anything moves
+  value_type const copy(element);
+  insert_fill(i, 1, copy);
+  return iterator_at(i);
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+void
+multi_gap_buffer<TContainer, G, D>::insert(iterator position, size_type n,
+                                           const_reference element)
+{
+  size_type const i = index_of(position);
+  value_type const copy(element);
+  insert_fill(i, n, copy);
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+template<class InputIterator>
+void
+multi_gap_buffer<TContainer, G, D>::insert(iterator position,
+                                           InputIterator const & i,
+                                           InputIterator const & j)
+{
+  // TContainer::insert tells integers from iterators for us
+  insert_at(index_of(position), i, j);
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::iterator
+multi_gap_buffer<TContainer, G, D>::erase(iterator position)
+{
+  size_type const i = index_of(position);
+  erase_range(i, i + 1);
+  return iterator_at(i);
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+typename multi_gap_buffer<TContainer, G, D>::iterator
+multi_gap_buffer<TContainer, G, D>::erase(iterator start, iterator end)
+{
+  size_type const i = index_of(start);
+  erase_range(i, index_of(end));
+  return iterator_at(i);
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+void
+multi_gap_buffer<TContainer, G, D>::clear()
+{
+  pieces.assign(1, piece());
+  std::fill(cursors.begin(), cursors.end(), 0);
+}
+
+template<class TContainer, std::size_t G, std::size_t D>
+void
+multi_gap_buffer<TContainer, G, D>::resize(size_type n, value_type const & e)
+{
+  size_type const old_size = size();
+  if(n < old_size)
+    erase_range(n, old_size);
+  else
+    insert_fill(old_size, n - old_size, e);
+}
+
+#define BINARY_MULTI_GAP_BOOL_OPER(oper)                                  \
+  template<class TContainer, std::size_t G, std::size_t D>                \
+  bool operator oper ( multi_gap_buffer<TContainer, G, D> const & lhs,    \
+                       multi_gap_buffer<TContainer, G, D> const & rhs)
+
+BINARY_MULTI_GAP_BOOL_OPER( == )
+{
+  return segmented::equal(lhs, rhs);
+}
+
+BINARY_MULTI_GAP_BOOL_OPER( < )
+{
+  return segmented::lexicographical_compare(lhs, rhs);
+}
+
+BINARY_MULTI_GAP_BOOL_OPER( != ) { return !(lhs == rhs); }
+BINARY_MULTI_GAP_BOOL_OPER( > )  { return  (rhs <  lhs); }
+BINARY_MULTI_GAP_BOOL_OPER( <= ) { return !(rhs <  lhs); }
+BINARY_MULTI_GAP_BOOL_OPER( >= ) { return !(lhs <  rhs); }
+
+
+#undef BINARY_MULTI_GAP_BOOL_OPER
@@ -0,0 +1,132 @@
+#ifndef PARALLEL_ALGORITHMS_HPP_INCLUDED_
+#define PARALLEL_ALGORITHMS_HPP_INCLUDED_
+
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include "segmented_algorithms.hpp"
+#include "thread_pool.hpp"
+
+#include <cstddef>
+
+
+/**
+   @brief Algorithms which share the runs of very large buffers out between
+          the threads of a thread_pool
+   @details
+   These are the algorithms of segmented_algorithms.hpp, taking a thread_pool
+   as their first argument.  The runs of each buffer are cut into chunks of
+   256KiB of elements, small enough for each to stay in a core's cache as it
+   is worked on, and each thread of the pool works through whichever chunk is
+   next, with the same inner loops as the sequential algorithms.  Results are
+   exactly those of the sequential algorithms.
+
+   Splitting the work costs a pass over the runs, O(n) for a node-based
+   container but only O(n / chunk) for the others, and waking the pool costs a
+   few microseconds, so these only pay for buffers of millions of elements.  A
+   buffer of a single chunk is worked on by the calling thread alone.
+
+   The buffers may not be edited while they are read, and the elements of a
+   buffer must be safe to read from several threads at once, as those of the
+   standard containers are.
+
+   @tparam TSegmented Any type with a segments() member and a size() member,
+                      such as gap_buffer, contiguous_gap_buffer, rope_buffer or
+                      multi_gap_buffer
+*/
+namespace segmented
+{
+  /// Copy every element of buffer to [out, out + buffer.size()), and return
+  /// the end of the output
+  /// @tparam RandomAccessIterator A model of Random Access Iterator, which
+  ///                              the threads write through at once
+  /// @note \b Complexity: O(n / pool.size())
+  template<class TSegmented, class RandomAccessIterator>
+  RandomAccessIterator copy(thread_pool & pool, TSegmented const & buffer,
+                            RandomAccessIterator out);
+
+  /// Write function(e) for each element e of buffer to [out, out +
+  /// buffer.size()), in order, and return the end of the output
+  /// @details To change the elements of a buffer, such as to change the case
+  ///          of a whole buffer of text, transform them into a new one and
+  ///          swap it in, which also tells the buffer's observer about it.
+  /// @tparam RandomAccessIterator A model of Random Access Iterator, which
+  ///                              the threads write through at once
+  /// @tparam TFunction            A function object which is safe to call
+  ///                              from several threads at once
+  /// @note \b Complexity: O(n / pool.size()) calls of function
+  template<class TSegmented, class RandomAccessIterator, class TFunction>
+  RandomAccessIterator transform(thread_pool & pool, TSegmented const & buffer,
+                                 RandomAccessIterator out,
+                                 TFunction const & function);
+
+  /// Return the index of the first element of buffer equal to value, or
+  /// buffer.size() if there is none
+  /// @details Chunks after the first match found are skipped.
+  /// @note \b Complexity: O(n / pool.size())
+  template<class TSegmented, class T>
+  std::size_t find(thread_pool & pool, TSegmented const & buffer,
+                   T const & value);
+
+  /// Return the number of elements of buffer equal to value
+  /// @note \b Complexity: O(n / pool.size())
+  template<class TSegmented, class T>
+  std::size_t count(thread_pool & pool, TSegmented const & buffer,
+                    T const & value);
+
+  /// Return the index of the first element at which lhs and rhs differ, or
+  /// the smaller of their sizes if one is a prefix of the other
+  /// @note \b Complexity: O(n / pool.size())
+  template<class TSegmentedA, class TSegmentedB>
+  std::size_t mismatch(thread_pool & pool, TSegmentedA const & lhs,
+                       TSegmentedB const & rhs);
+
+  /// Return if lhs and rhs have the same size and elements
+  /// @note \b Complexity: O(1) if their sizes differ, otherwise
+  ///       O(n / pool.size())
+  template<class TSegmentedA, class TSegmentedB>
+  bool equal(thread_pool & pool, TSegmentedA const & lhs,
+             TSegmentedB const & rhs);
+
+  /// Return if lhs comes before rhs in lexicographical order
+  /// @note \b Complexity: O(n / pool.size())
+  template<class TSegmentedA, class TSegmentedB>
+  bool lexicographical_compare(thread_pool & pool, TSegmentedA const & lhs,
+                               TSegmentedB const & rhs);
+}
+
+
+#include "parallel_algorithms.ipp"
+#endif
@@ -0,0 +1,348 @@
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <boost/atomic.hpp>
+#include <boost/next_prior.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+
+namespace segmented
+{
+namespace detail
+{
+  // The bytes of elements in each chunk the parallel algorithms share out
+  std::size_t const chunk_bytes = 256 * 1024;
+
+  // The most elements of type T a chunk holds
+  template<class T>
+  std::size_t chunk_length()
+  {
+    return std::max<std::size_t>(chunk_bytes / sizeof(T), 1);
+  }
+
+  // A piece of one run of a buffer, and the index of its first element
+  template<class Iterator>
+  struct chunk
+  {
+    Iterator    first;
+    Iterator    last;
+    std::size_t length;
+    std::size_t index;
+  };
+
+  // Pieces of the runs of two buffers which hold the same indices
+  template<class IteratorA, class IteratorB>
+  struct chunk_pair
+  {
+    IteratorA   lhs;
+    IteratorB   rhs;
+    std::size_t length;
+    std::size_t index;
+  };
+
+  // The iterators of the runs of a buffer
+  template<class TSegmented>
+  struct run_iterator
+  {
+    typedef typename walker_of<TSegmented>::type::iterator type;
+  };
+
+  // Cut the runs of buffer into chunks
+  template<class TSegmented>
+  std::vector<chunk<typename run_iterator<TSegmented>::type> >
+  chunks_of(TSegmented const & buffer)
+  {
+    typedef typename run_iterator<TSegmented>::type iterator;
+    std::size_t const most =
+      chunk_length<typename std::iterator_traits<iterator>::value_type>();
+    std::vector<chunk<iterator> > rtn;
+    typename walker_of<TSegmented>::type runs(buffer.segments());
+    std::size_t index = 0;
+    while(!runs.done()){
+      chunk<iterator> piece;
+      piece.length = std::min(runs.available(), most);
+      piece.first = runs.here();
+      piece.last = boost::next(piece.first, piece.length);
+      piece.index = index;
+      rtn.push_back(piece);
+      runs.consume(piece.length);
+      index += piece.length;
+    }
+    return rtn;
+  }
+
+  // Cut the runs of lhs and rhs into chunks which hold the same indices of
+  // each, up to the end of the shorter
+  template<class TSegmentedA, class TSegmentedB>
+  std::vector<chunk_pair<typename run_iterator<TSegmentedA>::type,
+                         typename run_iterator<TSegmentedB>::type> >
+  chunk_pairs_of(TSegmentedA const & lhs, TSegmentedB const & rhs)
+  {
+    typedef typename run_iterator<TSegmentedA>::type iterator_a;
+    typedef typename run_iterator<TSegmentedB>::type iterator_b;
+    std::size_t const most =
+      chunk_length<typename std::iterator_traits<iterator_a>::value_type>();
+    std::vector<chunk_pair<iterator_a, iterator_b> > rtn;
+    typename walker_of<TSegmentedA>::type a(lhs.segments());
+    typename walker_of<TSegmentedB>::type b(rhs.segments());
+    std::size_t index = 0;
+    while(!a.done() && !b.done()){
+      chunk_pair<iterator_a, iterator_b> piece;
+      piece.length = std::min(std::min(a.available(), b.available()), most);
+      piece.lhs = a.here();
+      piece.rhs = b.here();
+      piece.index = index;
+      rtn.push_back(piece);
+      a.consume(piece.length);
+      b.consume(piece.length);
+      index += piece.length;
+    }
+    return rtn;
+  }
+
+  // Lower best to index, if index is lower
+  inline void lower_to(boost::atomic<std::size_t> & best, std::size_t index)
+  {
+    std::size_t seen = best.load();
+    while(index < seen && !best.compare_exchange_weak(seen, index))
+      ;
+  }
+
+  // The tasks each algorithm gives its thread_pool, one call for each chunk
+  template<class Iterator, class RandomAccessIterator>
+  struct copy_task
+  {
+    copy_task(std::vector<chunk<Iterator> > const & chunks,
+              RandomAccessIterator out)
+      : chunks(chunks)
+      , out(out)
+    {}
+    void operator()(std::size_t i) const
+    {
+      std::copy(chunks[i].first, chunks[i].last, out + chunks[i].index);
+    }
+    std::vector<chunk<Iterator> > const & chunks;
+    RandomAccessIterator                  out;
+  };
+
+  template<class Iterator, class RandomAccessIterator, class TFunction>
+  struct transform_task
+  {
+    transform_task(std::vector<chunk<Iterator> > const & chunks,
+                   RandomAccessIterator out, TFunction const & function)
+      : chunks(chunks)
+      , out(out)
+      , function(function)
+    {}
+    void operator()(std::size_t i) const
+    {
+      std::transform(chunks[i].first, chunks[i].last, out + chunks[i].index,
+                     function);
+    }
+    std::vector<chunk<Iterator> > const & chunks;
+    RandomAccessIterator                  out;
+    TFunction const &                     function;
+  };
+
+  template<class Iterator, class T>
+  struct find_task
+  {
+    find_task(std::vector<chunk<Iterator> > const & chunks, T const & value,
+              boost::atomic<std::size_t> & best)
+      : chunks(chunks)
+      , value(value)
+      , best(best)
+    {}
+    void operator()(std::size_t i) const
+    {
+      chunk<Iterator> const & piece = chunks[i];
+      // A match has already been found before this chunk
+      if(piece.index >= best.load())
+        return;
+      std::size_t const found = run_find(piece.first, piece.last, value);
+      if(found != piece.length)
+        lower_to(best, piece.index + found);
+    }
+    std::vector<chunk<Iterator> > const & chunks;
+    T const &                             value;
+    boost::atomic<std::size_t> &          best;
+  };
+
+  template<class Iterator, class T>
+  struct count_task
+  {
+    count_task(std::vector<chunk<Iterator> > const & chunks, T const & value,
+               std::vector<std::size_t> & counts)
+      : chunks(chunks)
+      , value(value)
+      , counts(counts)
+    {}
+    void operator()(std::size_t i) const
+    {
+      counts[i] = run_count(chunks[i].first, chunks[i].last, value);
+    }
+    std::vector<chunk<Iterator> > const & chunks;
+    T const &                             value;
+    std::vector<std::size_t> &            counts;
+  };
+
+  template<class IteratorA, class IteratorB>
+  struct mismatch_task
+  {
+    mismatch_task(std::vector<chunk_pair<IteratorA, IteratorB> > const & chunks,
+                  boost::atomic<std::size_t> & best)
+      : chunks(chunks)
+      , best(best)
+    {}
+    void operator()(std::size_t i) const
+    {
+      chunk_pair<IteratorA, IteratorB> const & piece = chunks[i];
+      if(piece.index >= best.load())
+        return;
+      std::size_t const same = run_mismatch(piece.lhs, piece.rhs,
+                                            piece.length);
+      if(same != piece.length)
+        lower_to(best, piece.index + same);
+    }
+    std::vector<chunk_pair<IteratorA, IteratorB> > const & chunks;
+    boost::atomic<std::size_t> &                           best;
+  };
+
+  // The index of the first element at which the chunks differ, or common if
+  // they do not
+  template<class IteratorA, class IteratorB>
+  std::size_t parallel_mismatch(
+    thread_pool & pool,
+    std::vector<chunk_pair<IteratorA, IteratorB> > const & chunks,
+    std::size_t common)
+  {
+    boost::atomic<std::size_t> best(common);
+    mismatch_task<IteratorA, IteratorB> task(chunks, best);
+    pool.run(chunks.size(), task);
+    return best.load();
+  }
+}
+
+
+template<class TSegmented, class RandomAccessIterator>
+RandomAccessIterator copy(thread_pool & pool, TSegmented const & buffer,
+                          RandomAccessIterator out)
+{
+  typedef typename detail::run_iterator<TSegmented>::type iterator;
+  std::vector<detail::chunk<iterator> > const chunks =
+    detail::chunks_of(buffer);
+  detail::copy_task<iterator, RandomAccessIterator> task(chunks, out);
+  pool.run(chunks.size(), task);
+  return out + buffer.size();
+}
+
+template<class TSegmented, class RandomAccessIterator, class TFunction>
+RandomAccessIterator transform(thread_pool & pool, TSegmented const & buffer,
+                               RandomAccessIterator out,
+                               TFunction const & function)
+{
+  typedef typename detail::run_iterator<TSegmented>::type iterator;
+  std::vector<detail::chunk<iterator> > const chunks =
+    detail::chunks_of(buffer);
+  detail::transform_task<iterator, RandomAccessIterator, TFunction>
+    task(chunks, out, function);
+  pool.run(chunks.size(), task);
+  return out + buffer.size();
+}
+
+template<class TSegmented, class T>
+std::size_t find(thread_pool & pool, TSegmented const & buffer,
+                 T const & value)
+{
+  typedef typename detail::run_iterator<TSegmented>::type iterator;
+  std::vector<detail::chunk<iterator> > const chunks =
+    detail::chunks_of(buffer);
+  boost::atomic<std::size_t> best(buffer.size());
+  detail::find_task<iterator, T> task(chunks, value, best);
+  pool.run(chunks.size(), task);
+  return best.load();
+}
+
+template<class TSegmented, class T>
+std::size_t count(thread_pool & pool, TSegmented const & buffer,
+                  T const & value)
+{
+  typedef typename detail::run_iterator<TSegmented>::type iterator;
+  std::vector<detail::chunk<iterator> > const chunks =
+    detail::chunks_of(buffer);
+  std::vector<std::size_t> counts(chunks.size());
+  detail::count_task<iterator, T> task(chunks, value, counts);
+  pool.run(chunks.size(), task);
+  std::size_t total = 0;
+  for(std::size_t i = 0; i != counts.size(); ++i)
+    total += counts[i];
+  return total;
+}
+
+template<class TSegmentedA, class TSegmentedB>
+std::size_t mismatch(thread_pool & pool, TSegmentedA const & lhs,
+                     TSegmentedB const & rhs)
+{
+  return detail::parallel_mismatch(pool, detail::chunk_pairs_of(lhs, rhs),
+                                   std::min<std::size_t>(lhs.size(),
+                                                         rhs.size()));
+}
+
+template<class TSegmentedA, class TSegmentedB>
+bool equal(thread_pool & pool, TSegmentedA const & lhs,
+           TSegmentedB const & rhs)
+{
+  return lhs.size() == rhs.size() && mismatch(pool, lhs, rhs) == lhs.size();
+}
+
+template<class TSegmentedA, class TSegmentedB>
+bool lexicographical_compare(thread_pool & pool, TSegmentedA const & lhs,
+                             TSegmentedB const & rhs)
+{
+  typedef typename detail::run_iterator<TSegmentedA>::type iterator_a;
+  typedef typename detail::run_iterator<TSegmentedB>::type iterator_b;
+  typedef std::vector<detail::chunk_pair<iterator_a, iterator_b> > chunk_list;
+  chunk_list const chunks = detail::chunk_pairs_of(lhs, rhs);
+  std::size_t const common = std::min<std::size_t>(lhs.size(), rhs.size());
+  std::size_t const differ = detail::parallel_mismatch(pool, chunks, common);
+  // Compare the first elements which differ, found in the chunk holding them
+  for(typename chunk_list::const_iterator c = chunks.begin();
+      c != chunks.end(); ++c)
+    if(differ < c->index + c->length)
+      return *boost::next(c->lhs, differ - c->index) <
+        *boost::next(c->rhs, differ - c->index);
+  return lhs.size() < rhs.size();
+}
+}
@@ -0,0 +1,396 @@
+#ifndef PIECE_TABLE_BUFFER_HPP_INCLUDED_
+#define PIECE_TABLE_BUFFER_HPP_INCLUDED_
+
+
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include "mapped_file.hpp"
+
+#include <boost/concept/assert.hpp>
+#include <boost/concept_check.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/move/move.hpp>
+#include <boost/range/iterator_range.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include <boost/type_traits/is_pod.hpp>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+
+/**
+   @brief A gap_buffer lookalike which edits a memory-mapped file in place
+   @details
+   This class template provides the interface of gap_buffer, but stores its
+   elements as a piece table: a list of pieces, each of which refers either to
+   a run of a read-only original, or to a run of an append-only buffer of
+   everything which has been inserted since.  An original given as a
+   mapped_file is never copied, so opening a file of any size takes constant
+   time, and only the pages which are read are ever loaded.  Edits split and
+   drop pieces, and append what they insert, but never move the elements of
+   the original.
+
+   Locating an index is a binary search of the pieces, and an edit updates
+   the pieces after it, so edits cost O(p) in the number of pieces p, which
+   grows by at most two with each edit.  Typing at one place extends the
+   same piece rather than adding new ones.
+
+   Elements are read-only through iterators and references, since they may
+   belong to the mapped file; change them by erasing and inserting.  Copies
+   share the mapped_file, but not the pieces or the inserted elements.
+
+   A piece_table_buffer is an STL container.  It models the STL concepts
+   Container, Forward Container, Reversible Container and Random Access
+   Container, with constant iterators.
+
+   @tparam T The element type, which must be a POD so that it may be read
+             straight out of the mapped file
+*/
+template<class T>
+class piece_table_buffer
+{
+private:
+  // Enable Boost.Move move-emulation (or actual move on C++11)
+  BOOST_COPYABLE_AND_MOVABLE(piece_table_buffer)
+
+  BOOST_STATIC_ASSERT(boost::is_pod<T>::value);
+
+  // A run of the original, or of the inserted elements
+  struct piece
+  {
+    bool        original;
+    std::size_t offset;
+    std::size_t length;
+  };
+
+  // This class uses Boost.Iterator to produce the iterator type for
+  // piece_table_buffer.  It stores a logical index and caches the piece that
+  // index was last found in.
+  class iterator_impl;
+
+  boost::shared_ptr<mapped_file const> file;
+  // The elements of the original, which may be in file
+  T const *                            source;
+  std::vector<T>                       added;
+  std::vector<piece>                   pieces;
+  // The index of the first element of each piece, and then of the end
+  std::vector<std::size_t>             starts;
+  std::size_t                          cursor;
+public:
+  /// @name Other Container requirements
+  //@{
+  /// The value_type of this container
+  typedef T                 value_type;
+  /// value_type const *, since the elements cannot be changed in place
+  typedef T const *         pointer;
+  /// value_type const *
+  typedef T const *         const_pointer;
+  /// value_type const &, since the elements cannot be changed in place
+  typedef T const &         reference;
+  /// value_type const &
+  typedef T const &         const_reference;
+  /// The size_type of this container
+  typedef std::size_t       size_type;
+  /// The difference_type of this container
+  typedef std::ptrdiff_t    difference_type;
+
+  /// Return the number of elements in the piece_table_buffer
+  /// @note \b Complexity: O(1)
+  size_type size() const;
+
+  /// Return the maximum number of elements a piece_table_buffer might hold
+  /// @note \b Complexity: O(1)
+  size_type max_size() const;
+
+  /// Return if the piece_table_buffer is empty
+  /// @note \b Complexity: O(1)
+  bool empty() const;
+
+  /// Swap this piece_table_buffer with another
+  /// @note \b Complexity: O(1)
+  void swap(piece_table_buffer & other);
+  //@}
+
+  ///@name Iterator access
+  //@{
+  typedef iterator_impl                                     const_iterator;
+  typedef const_iterator                                    iterator;
+  typedef std::reverse_iterator<const_iterator>       const_reverse_iterator;
+  typedef const_reverse_iterator                            reverse_iterator;
+
+  /// Return the cursor position as an iterator
+  /// @note \b Complexity: O(1)
+  const_iterator here() const;
+  /// Return the cursor position as a reverse iterator
+  /// @note \b Complexity: O(1)
+  const_reverse_iterator rhere() const;
+
+  /// Get an iterator to the beginning of the piece_table_buffer
+  /// @note \b Complexity: O(1)
+  const_iterator begin() const;
+  /// Get an iterator to one element past the end of the piece_table_buffer
+  /// @note \b Complexity: O(1)
+  const_iterator end() const;
+
+  /// Get a reverse iterator to the beginning of the reversed
+  /// piece_table_buffer
+  /// @note \b Complexity: O(1)
+  const_reverse_iterator rbegin() const;
+  /// @brief Get a reverse iterator to one element past the end of the
+  /// reversed piece_table_buffer
+  /// @note \b Complexity: O(1)
+  const_reverse_iterator rend() const;
+  //@}
+
+  /// @name Sequence Requirements
+  //@{
+  /// Default-construct an empty piece_table_buffer
+  piece_table_buffer();
+
+  /// @brief Construct a piece_table_buffer whose contents are those of file,
+  ///        read as elements of T, with the cursor at the beginning
+  /// @details Nothing is read from the file until it is needed.  Any bytes
+  /// past the last whole element are ignored.
+  /// @note \b Complexity: O(1)
+  explicit piece_table_buffer(boost::shared_ptr<mapped_file const> file);
+
+  /// Copy-construct a piece_table_buffer, sharing other's mapped_file
+  /// @note \b Complexity: O(p) plus the number of inserted elements
+  piece_table_buffer(piece_table_buffer const & other);
+
+  /// Move-construct a piece_table_buffer
+  /// @note \b Complexity: O(1)
+  piece_table_buffer(BOOST_RV_REF(piece_table_buffer) other);
+
+  /// Fill-construct a piece_table_buffer with n copies of e and the cursor at
+  /// the end
+  /// @note \b Complexity: O(n)
+  piece_table_buffer(size_type n, value_type e = value_type());
+
+  /// @brief Construct a piece_table_buffer whose contents are the range
+  ///        [i, j) with the cursor at the end
+  /// @tparam InputIterator A model of Input Iterator whose value_type is
+  ///                       convertible to value_type
+  /// @note \b Complexity: O(std::distance(i, j))
+  template<class InputIterator>
+  piece_table_buffer(InputIterator const & i, InputIterator const & j);
+
+  /// Retrieve the first element of the piece_table_buffer
+  /// @note \b Complexity: O(log p)
+  const_reference front() const;
+
+  /// Insert element immediately before position.  If position is at or
+  /// before the cursor, advance the cursor one position.
+  /// @note \b Complexity: O(p)
+  iterator insert(iterator position, const_reference element);
+
+  /// Insert n copies of element immediately before position.  If position
+  /// is at or before the cursor, advance the cursor n positions.
+  /// @note \b Complexity: O(n + p)
+  void insert(iterator position, size_type n, const_reference element);
+
+  /// Insert the range of elements [i,j) immediately before position. If
+  /// position is at or before the cursor, advance the cursor n positions.
+  /// @note \b Complexity: O(n + p)
+  template<class InputIterator>
+  void insert(iterator position,
+              InputIterator const & i, InputIterator const & j);
+
+  /// Erase the element at position.  If position was before the cursor, move
+  /// the cursor one spot earlier.
+  /// @note \b Complexity: O(p)
+  iterator erase(iterator position);
+
+  /// Erase the elements in [start,end).  If the cursor was within this range,
+  /// move it to immediately before the range.
+  /// @note \b Complexity: O(p), however many elements are erased
+  iterator erase(iterator start, iterator end);
+
+  /// Remove all the elements in this, releasing the mapped_file, and move the
+  /// cursor to the beginning
+  /// @note \b Complexity: O(1)
+  void clear();
+
+  /// Resize the piece_table_buffer.  If the buffer is growing, pad the end
+  /// with copies of e.  If the buffer is shrinking, discard elements from the
+  /// end.
+  /// @note \b Complexity: O(abs(n - size()) + p)
+  void resize(size_type n, value_type const & e = value_type());
+
+  /// Assign one piece_table_buffer to another, sharing other's mapped_file
+  /// @note \b Complexity: O(p) plus the number of inserted elements
+  piece_table_buffer &
+  operator=(BOOST_COPY_ASSIGN_REF(piece_table_buffer) other);
+
+  /// Move assign one piece_table_buffer to another
+  /// @note \b Complexity: O(1)
+  piece_table_buffer & operator=(BOOST_RV_REF(piece_table_buffer) other);
+  //@}
+
+  /// @name Random Access Container Requirements
+  //@{
+  /// Retrieve the element at index i
+  /// @note \b Complexity: O(log p)
+  const_reference operator[](size_type i) const;
+  /// Retrieve the element at index i, throwing std::out_of_range if there is
+  /// no such element
+  /// @note \b Complexity: O(log p)
+  const_reference at(size_type i) const;
+  //@}
+
+
+  /// @name Cursor Handling
+  //@{
+  /// Return the cursor position of the piece_table_buffer
+  /// @note \b Complexity: O(1)
+  size_type position() const;
+
+  /// Move the cursor position
+  /// @note \b Complexity: O(1)
+  void advance(difference_type const dist);
+
+  /// @brief Remove data from this position.
+  /// @details A positive value erases the given number of values from ahead of
+  /// the cursor.  A negative value erases the absolute value of the given
+  /// number of cursors from behind the cursor.
+  /// @note \b Complexity: O(p)
+  void erase(difference_type const dist);
+
+  /// Insert an element at the cursor
+  /// @note \b Complexity: The same as insert(iterator, const_reference)
+  size_type insert(value_type const);
+
+  /// @brief Insert a range of elements at the cursor
+  /// @param range Any range of elements Boost.Range recognizes as a Single Pass
+  ///              Range.
+  /// @note \b Complexity: O(boost::size(range) + p)
+  template<class TSinglePassRange>
+  size_type insert(TSinglePassRange const & range);
+  //@}
+
+  /// @name Pieces
+  //@{
+  /// Return the number of pieces the buffer is made of
+  /// @note \b Complexity: O(1)
+  size_type piece_count() const;
+  //@}
+
+  /// @name Segments
+  //@{
+  /// @brief A range of the contiguous runs of a piece_table_buffer, in order
+  /// @details These are the pieces of the buffer.
+  typedef std::vector<boost::iterator_range<T const *> > const_segment_list;
+
+  /// @brief Return the runs of elements in this piece_table_buffer, for use by
+  ///        the algorithms in segmented_algorithms.hpp
+  /// @note The runs are invalidated by any edit
+  /// @note \b Complexity: O(p)
+  const_segment_list segments() const;
+  //@}
+
+private:
+  // Return the first element of p
+  T const * data_of(piece const & p) const;
+  // Find the piece holding index i, which must be less than size()
+  size_type find_piece(size_type i) const;
+  // Split the piece holding index i so that a piece begins there, and return
+  // that piece, or piece_count() if i is size()
+  size_type split_at(size_type i);
+  // Recompute starts from piece k onwards
+  void restart(size_type k);
+
+  // Place the last count elements of added at index i, extending the piece
+  // before i if they continue it, then fix up the cursor
+  void refer(size_type i, size_type count);
+  // Erase logical [start, finish) and fix up the cursor
+  void erase_range(size_type start, size_type finish);
+
+  // Insert n copies of e at index i
+  void insert_fill(size_type i, size_type n, value_type const & e);
+
+  // Dispatch the range insertions on integral arguments and iterator category
+  template<class TInteger>
+  void insert_dispatch(size_type i, TInteger n, TInteger e,
+                       boost::true_type);
+  template<class InputIterator>
+  void insert_dispatch(size_type i, InputIterator first, InputIterator last,
+                       boost::false_type);
+  template<class InputIterator>
+  void insert_range(size_type i, InputIterator first, InputIterator last,
+                    std::input_iterator_tag);
+  template<class ForwardIterator>
+  void insert_range(size_type i, ForwardIterator first, ForwardIterator last,
+                    std::forward_iterator_tag);
+
+  // Check our iterator's concepts
+  BOOST_CONCEPT_ASSERT((boost::RandomAccessIterator<          const_iterator>));
+  BOOST_CONCEPT_ASSERT((boost::RandomAccessIterator<  const_reverse_iterator>));
+};
+
+///@name Comparisons
+//@{
+/// Test two piece_table_buffers for equality
+/// @note \b Complexity: O(n)
+template<class T>
+bool operator==(piece_table_buffer<T> const &, piece_table_buffer<T> const &);
+/// Test two piece_table_buffers for inequality
+/// @note \b Complexity: O(n)
+template<class T>
+bool operator!=(piece_table_buffer<T> const &, piece_table_buffer<T> const &);
+/// Test if one piece_table_buffer is less than another
+/// @note \b Complexity: O(n)
+template<class T>
+bool operator<(piece_table_buffer<T> const &, piece_table_buffer<T> const &);
+/// Test if one piece_table_buffer is greater than another
+/// @note \b Complexity: O(n)
+template<class T>
+bool operator>(piece_table_buffer<T> const &, piece_table_buffer<T> const &);
+/// Test if one piece_table_buffer is less than or equal to another
+/// @note \b Complexity: O(n)
+template<class T>
+bool operator<=(piece_table_buffer<T> const &, piece_table_buffer<T> const &);
+/// Test if one piece_table_buffer is greater than or equal to another
+/// @note \b Complexity: O(n)
+template<class T>
+bool operator>=(piece_table_buffer<T> const &, piece_table_buffer<T> const &);
+//@}
+
+
+#include "segmented_algorithms.hpp"
+#include "piece_table_buffer.ipp"
+#endif
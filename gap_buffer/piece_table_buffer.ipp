@@ -0,0 +1,618 @@
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include <boost/range/begin.hpp>
+#include <boost/range/end.hpp>
+#include <boost/type_traits/is_integral.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+
+template<class T>
+class piece_table_buffer<T>::iterator_impl
+  : public boost::iterator_facade<iterator_impl,
+                                  T const,
+                                  std::random_access_iterator_tag>
+{
+public:
+  iterator_impl()
+    : buf(0)
+    , idx(0)
+    , k(0)
+    , lo(0)
+    , hi(0)
+  {}
+
+  iterator_impl(piece_table_buffer const * buffer, std::size_t index)
+    : buf(buffer)
+    , idx(index)
+    , k(0)
+    , lo(0)
+    , hi(0)
+  {}
+
+private:
+  // Grant access to Boost.Iterator
+  friend class boost::iterator_core_access;
+  friend class piece_table_buffer<T>;
+
+  // The buffer this iterator walks over
+  piece_table_buffer const * buf;
+  // The logical index of the element this iterator refers to
+  std::size_t                idx;
+  // The piece idx was last found in, and the indices it covers, so that
+  // walking a piece is O(1).  Only the piece's number is kept, not where its
+  // elements are, so that inserting from the buffer into itself is safe.
+  mutable std::size_t        k;
+  mutable std::size_t        lo;
+  mutable std::size_t        hi;
+
+  T const & dereference() const
+  {
+    if(idx < lo || idx >= hi){
+      k = buf->find_piece(idx);
+      lo = buf->starts[k];
+      hi = buf->starts[k + 1];
+    }
+    return buf->data_of(buf->pieces[k])[idx - lo];
+  }
+  // Compare the iterator for equality, as a callback to Boost.Iterator
+  bool equal(iterator_impl const & other) const
+  {
+    return idx == other.idx;
+  }
+  // Increment the iterator, as a callback to Boost.Iterator
+  void increment()
+  {
+    ++idx;
+  }
+  // Decrement the iterator, as a callback to Boost.Iterator
+  void decrement()
+  {
+    --idx;
+  }
+  // Advance the iterator, as a callback to Boost.Iterator
+  void advance(std::ptrdiff_t n)
+  {
+    idx += n;
+  }
+  // Measure distance between to iterators as callback to Boost.Iterator
+  std::ptrdiff_t distance_to(iterator_impl const & other) const
+  {
+    return static_cast<std::ptrdiff_t>(other.idx) -
+      static_cast<std::ptrdiff_t>(idx);
+  }
+};
+
+
+template<class T>
+T const *
+piece_table_buffer<T>::
+data_of(piece const & p) const
+{
+  return (p.original ? source : &added[0]) + p.offset;
+}
+
+template<class T>
+typename piece_table_buffer<T>::size_type
+piece_table_buffer<T>::
+find_piece(size_type i) const
+{
+  // Pieces are never empty, so exactly one start is the last not past i
+  return std::upper_bound(starts.begin(), starts.end(), i) -
+    starts.begin() - 1;
+}
+
+template<class T>
+void
+piece_table_buffer<T>::
+restart(size_type k)
+{
+  starts.resize(pieces.size() + 1);
+  for(size_type j = std::max<size_type>(k, 1); j < starts.size(); ++j)
+    starts[j] = starts[j - 1] + pieces[j - 1].length;
+}
+
+template<class T>
+typename piece_table_buffer<T>::size_type
+piece_table_buffer<T>::
+split_at(size_type i)
+{
+  if(i == size())
+    return pieces.size();
+  size_type const k = find_piece(i);
+  size_type const into = i - starts[k];
+  if(into == 0)
+    return k;
+
+  piece tail = pieces[k];
+  tail.offset += into;
+  tail.length -= into;
+  pieces[k].length = into;
+  pieces.insert(pieces.begin() + k + 1, tail);
+  starts.insert(starts.begin() + k + 1, i);
+  return k + 1;
+}
+
+template<class T>
+void
+piece_table_buffer<T>::
+refer(size_type i, size_type count)
+{
+  if(count == 0)
+    return;
+  size_type const offset = added.size() - count;
+  size_type const k = split_at(i);
+  // Typing carries on the piece it typed last, rather than adding another
+  if(k > 0 && !pieces[k - 1].original &&
+     pieces[k - 1].offset + pieces[k - 1].length == offset){
+    pieces[k - 1].length += count;
+  }else{
+    piece const inserted = { false, offset, count };
+    pieces.insert(pieces.begin() + k, inserted);
+  }
+  restart(k);
+  if(i <= cursor)
+    cursor += count;
+}
+
+template<class T>
+void
+piece_table_buffer<T>::
+erase_range(size_type start, size_type finish)
+{
+  if(start >= finish)
+    return;
+  size_type const first = split_at(start);
+  size_type const last = split_at(finish);
+  pieces.erase(pieces.begin() + first, pieces.begin() + last);
+  restart(first);
+  cursor -= std::min(finish, cursor) - std::min(start, cursor);
+}
+
+template<class T>
+void
+piece_table_buffer<T>::
+insert_fill(size_type i, size_type n, value_type const & e)
+{
+  added.insert(added.end(), n, e);
+  refer(i, n);
+}
+
+template<class T>
+template<class TInteger>
+void
+piece_table_buffer<T>::
+insert_dispatch(size_type i, TInteger n, TInteger e, boost::true_type)
+{
+  insert_fill(i, static_cast<size_type>(n), static_cast<value_type>(e));
+}
+
+template<class T>
+template<class InputIterator>
+void
+piece_table_buffer<T>::
+insert_dispatch(size_type i, InputIterator first, InputIterator last,
+                boost::false_type)
+{
+  insert_range(i, first, last,
+               typename std::iterator_traits<InputIterator>::
+               iterator_category());
+}
+
+template<class T>
+template<class InputIterator>
+void
+piece_table_buffer<T>::
+insert_range(size_type i, InputIterator first, InputIterator last,
+             std::input_iterator_tag)
+{
+  size_type const before = added.size();
+  for(; first != last; ++first)
+    added.push_back(*first);
+  refer(i, added.size() - before);
+}
+
+template<class T>
+template<class ForwardIterator>
+void
+piece_table_buffer<T>::
+insert_range(size_type i, ForwardIterator first, ForwardIterator last,
+             std::forward_iterator_tag)
+{
+  // The pieces are left alone until the elements are copied, so the range
+  // may come from this buffer
+  size_type const before = added.size();
+  added.insert(added.end(), first, last);
+  refer(i, added.size() - before);
+}
+
+
+template<class T>
+template<class TSinglePassRange>
+typename piece_table_buffer<T>::size_type
+piece_table_buffer<T>::
+insert(TSinglePassRange const & rng)
+{
+  insert_dispatch(cursor, boost::begin(rng), boost::end(rng),
+                  boost::false_type());
+  return position();
+}
+
+template<class T>
+typename piece_table_buffer<T>::size_type
+piece_table_buffer<T>::
+insert(value_type const c)
+{
+  added.push_back(c);
+  refer(cursor, 1);
+  return position();
+}
+
+
+template<class T>
+typename piece_table_buffer<T>::size_type
+piece_table_buffer<T>::
+position() const
+{
+  return cursor;
+}
+
+template<class T>
+typename piece_table_buffer<T>::size_type
+piece_table_buffer<T>::
+size() const
+{
+  return starts.back();
+}
+
+template<class T>
+typename piece_table_buffer<T>::size_type
+piece_table_buffer<T>::
+max_size() const
+{
+  return std::allocator<T>().max_size();
+}
+
+template<class T>
+bool
+piece_table_buffer<T>::
+empty() const
+{
+  return size() == 0;
+}
+
+template<class T>
+void
+piece_table_buffer<T>::
+swap(piece_table_buffer & other)
+{
+  file.swap(other.file);
+  std::swap(source, other.source);
+  added.swap(other.added);
+  pieces.swap(other.pieces);
+  starts.swap(other.starts);
+  std::swap(cursor, other.cursor);
+}
+
+template<class T>
+typename piece_table_buffer<T>::size_type
+piece_table_buffer<T>::
+piece_count() const
+{
+  return pieces.size();
+}
+
+
+template<class T>
+typename piece_table_buffer<T>::const_segment_list
+piece_table_buffer<T>::
+segments() const
+{
+  const_segment_list runs;
+  runs.reserve(pieces.size());
+  for(size_type k = 0; k < pieces.size(); ++k){
+    T const * const first = data_of(pieces[k]);
+    runs.push_back(boost::make_iterator_range(first,
+                                              first + pieces[k].length));
+  }
+  return runs;
+}
+
+
+template<class T>
+void
+piece_table_buffer<T>::
+advance(difference_type const d)
+{
+  cursor += d;
+}
+
+
+template<class T>
+void
+piece_table_buffer<T>::
+erase(difference_type const d)
+{
+  if(d < 0)
+    erase_range(cursor + d, cursor);
+  else
+    erase_range(cursor, cursor + d);
+}
+
+
+template<class T>
+typename piece_table_buffer<T>::const_iterator
+piece_table_buffer<T>::
+here() const
+{
+  return const_iterator(this, cursor);
+}
+
+template<class T>
+typename piece_table_buffer<T>::const_reverse_iterator
+piece_table_buffer<T>::
+rhere() const
+{
+  return const_reverse_iterator(here());
+}
+
+template<class T>
+typename piece_table_buffer<T>::const_iterator
+piece_table_buffer<T>::
+begin() const
+{
+  return const_iterator(this, 0);
+}
+
+template<class T>
+typename piece_table_buffer<T>::const_iterator
+piece_table_buffer<T>::
+end() const
+{
+  return const_iterator(this, size());
+}
+
+template<class T>
+typename piece_table_buffer<T>::const_reverse_iterator
+piece_table_buffer<T>::
+rbegin() const
+{
+  return const_reverse_iterator(end());
+}
+
+template<class T>
+typename piece_table_buffer<T>::const_reverse_iterator
+piece_table_buffer<T>::
+rend() const
+{
+  return const_reverse_iterator(begin());
+}
+
+
+template<class T>
+piece_table_buffer<T>::piece_table_buffer()
+  : source(0)
+  , starts(1, 0)
+  , cursor(0)
+{}
+
+template<class T>
+piece_table_buffer<T>::
+piece_table_buffer(boost::shared_ptr<mapped_file const> mapping)
+  : file(mapping)
+  , source(reinterpret_cast<T const *>(mapping->data()))
+  , starts(1, 0)
+  , cursor(0)
+{
+  piece const whole = { true, 0, mapping->size() / sizeof(T) };
+  if(whole.length > 0){
+    pieces.push_back(whole);
+    restart(0);
+  }
+}
+
+template<class T>
+piece_table_buffer<T>::piece_table_buffer(piece_table_buffer const & other)
+  : file(other.file)
+  , source(other.source)
+  , added(other.added)
+  , pieces(other.pieces)
+  , starts(other.starts)
+  , cursor(other.cursor)
+{}
+
+template<class T>
+piece_table_buffer<T>::piece_table_buffer(BOOST_RV_REF(piece_table_buffer)
+                                          other)
+  : source(0)
+  , starts(1, 0)
+  , cursor(0)
+{
+  swap(other);
+}
+
+template<class T>
+piece_table_buffer<T>::piece_table_buffer(size_type n, value_type e)
+  : source(0)
+  , starts(1, 0)
+  , cursor(0)
+{
+  insert_fill(0, n, e);
+}
+
+template<class T>
+template<class InputIterator>
+piece_table_buffer<T>::piece_table_buffer(InputIterator const & i,
+                                          InputIterator const & j)
+  : source(0)
+  , starts(1, 0)
+  , cursor(0)
+{
+  insert_dispatch(0, i, j, typename boost::is_integral<InputIterator>::type());
+}
+
+template<class T>
+piece_table_buffer<T> &
+piece_table_buffer<T>::
+operator=(BOOST_COPY_ASSIGN_REF(piece_table_buffer) other)
+{
+  if(&other != this){
+    piece_table_buffer copy(static_cast<piece_table_buffer const &>(other));
+    swap(copy);
+  }
+  return *this;
+}
+
+template<class T>
+piece_table_buffer<T> &
+piece_table_buffer<T>::operator=(BOOST_RV_REF(piece_table_buffer) other)
+{
+  piece_table_buffer moved( ::boost::move(other) );
+  swap(moved);
+  return *this;
+}
+
+
+template<class T>
+typename piece_table_buffer<T>::const_reference
+piece_table_buffer<T>::front() const
+{
+  return (*this)[0];
+}
+
+template<class T>
+typename piece_table_buffer<T>::const_reference
+piece_table_buffer<T>::operator[](size_type i) const
+{
+  size_type const k = find_piece(i);
+  return data_of(pieces[k])[i - starts[k]];
+}
+
+template<class T>
+typename piece_table_buffer<T>::const_reference
+piece_table_buffer<T>::at(size_type i) const
+{
+  if(i >= size())
+    throw std::out_of_range("piece_table_buffer::at");
+  return (*this)[i];
+}
+
+template<class T>
+typename piece_table_buffer<T>::iterator
+piece_table_buffer<T>::insert(iterator position, const_reference element)
+{
+  // element might live in this buffer, and so move as added grows
+  value_type const copy(element);
+  added.push_back(copy);
+  refer(position.idx, 1);
+  return iterator(this, position.idx);
+}
+
+template<class T>
+void
+piece_table_buffer<T>::insert(iterator position, size_type n,
+                              const_reference element)
+{
+  value_type const copy(element);
+  insert_fill(position.idx, n, copy);
+}
+
+template<class T>
+template<class InputIterator>
+void
+piece_table_buffer<T>::insert(iterator position,
+                              InputIterator const & i, InputIterator const & j)
+{
+  insert_dispatch(position.idx, i, j,
+                  typename boost::is_integral<InputIterator>::type());
+}
+
+template<class T>
+typename piece_table_buffer<T>::iterator
+piece_table_buffer<T>::erase(iterator position)
+{
+  erase_range(position.idx, position.idx + 1);
+  return iterator(this, position.idx);
+}
+
+template<class T>
+typename piece_table_buffer<T>::iterator
+piece_table_buffer<T>::erase(iterator start, iterator end)
+{
+  erase_range(start.idx, end.idx);
+  return iterator(this, start.idx);
+}
+
+template<class T>
+void
+piece_table_buffer<T>::clear()
+{
+  piece_table_buffer empty;
+  swap(empty);
+}
+
+template<class T>
+void
+piece_table_buffer<T>::resize(size_type n, value_type const & e)
+{
+  if(n < size())
+    erase_range(n, size());
+  else
+    insert(end(), n - size(), e);
+}
+
+#define BINARY_PIECE_TABLE_BOOL_OPER(oper)                                  \
+  template<class T>                                                         \
+  bool operator oper ( piece_table_buffer<T> const & lhs,                   \
+                       piece_table_buffer<T> const & rhs)
+
+BINARY_PIECE_TABLE_BOOL_OPER( == )
+{
+  return segmented::equal(lhs, rhs);
+}
+
+BINARY_PIECE_TABLE_BOOL_OPER( < )
+{
+  return segmented::lexicographical_compare(lhs, rhs);
+}
+
+BINARY_PIECE_TABLE_BOOL_OPER( != ) { return !(lhs == rhs); }
+BINARY_PIECE_TABLE_BOOL_OPER( > )  { return  (rhs <  lhs); }
+BINARY_PIECE_TABLE_BOOL_OPER( <= ) { return !(rhs <  lhs); }
+BINARY_PIECE_TABLE_BOOL_OPER( >= ) { return !(lhs <  rhs); }
+
+
+#undef BINARY_PIECE_TABLE_BOOL_OPER
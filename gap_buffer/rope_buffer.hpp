@@ -0,0 +1,458 @@
+#ifndef ROPE_BUFFER_HPP_INCLUDED_
+#define ROPE_BUFFER_HPP_INCLUDED_
+
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include <boost/atomic.hpp>
+#include <boost/concept/assert.hpp>
+#include <boost/concept_check.hpp>
+#include <boost/container/static_vector.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/move/move.hpp>
+#include <boost/range/iterator_range.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include <boost/type_traits/is_convertible.hpp>
+#include <boost/utility/enable_if.hpp>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+
+/**
+   @brief A gap_buffer lookalike stored as a B-tree of chunks
+   @details
+   This class template provides the same interface as gap_buffer, but stores
+   its elements in a rope: a B-tree whose leaves are chunks of up to
+   LeafCapacity contiguous elements, and whose inner nodes record the number of
+   elements beneath them.  Those counts make locating any index O(log n), so
+   edits far from the cursor and jumps across the buffer cost the same as edits
+   at the cursor.  The cursor itself is only an index, so advance() and
+   position() are O(1).
+
+   Nodes are reference counted and shared between copies, so copying a
+   rope_buffer, or taking a snapshot() of it, is O(1).  An edit copies only
+   the nodes on the paths it changes, leaving every other copy as it was.
+   Since a shared node is never changed, one thread may read a snapshot while
+   another edits the buffer it was taken from, without any locking.
+
+   Reading through a mutable iterator copies nothing: it yields a proxy
+   reference, which copies the path to its element only if that is shared and
+   the proxy is assigned to or has its address taken.  operator[], at() and
+   front() on a non-const buffer return a plain reference, which may be
+   written through, so they copy the path to the element whenever it is
+   shared; read through a const buffer, or segments(), to scan a buffer without
+   unsharing it.  References obtained before a copy or snapshot must not be
+   used to modify the buffer after it.
+
+   A rope_buffer is an STL container.  It models the STL concepts Container,
+   Forward Container, Reversible Container and Random Access Container.
+
+   @tparam T            The element type
+   @tparam LeafCapacity The maximum number of elements in one chunk
+   @tparam Fanout       The maximum number of children of an inner node
+*/
+template<class T, std::size_t LeafCapacity = 512, std::size_t Fanout = 16>
+class rope_buffer
+{
+private:
+  // Enable Boost.Move move-emulation (or actual move on C++11)
+  BOOST_COPYABLE_AND_MOVABLE(rope_buffer)
+
+  BOOST_STATIC_ASSERT(LeafCapacity >= 2);
+  BOOST_STATIC_ASSERT(Fanout >= 3);
+
+  // The node types of the tree.  Nodes do not know their parents, so that a
+  // node may be shared between trees.
+  struct node;
+  struct leaf_node;
+  struct inner_node;
+  typedef std::vector<node *> node_list;
+
+  // This iterator template uses Boost.Iterator to produce the iterator types
+  // for rope_buffer.  It stores a logical index and caches the chunk that
+  // index was last found in.
+  template<class TValue, class TBuffer>
+  class iterator_impl;
+  // The reference a mutable iterator yields, which reads its element in place
+  // and copies the element's chunk only when it is written through
+  class element_reference;
+
+  node *              root;
+  std::size_t         cursor;
+  // The number of times this buffer has been copied or snapshotted, so that
+  // mutable iterators know when the chunk they cached may have become shared.
+  // Readers on several threads may copy one buffer at once, so it is atomic;
+  // it orders nothing, so relaxed operations suffice.
+  mutable boost::atomic<std::size_t> shares;
+  // The number of nodes unique() has copied, so that iterators know when the
+  // chunk they cached has been replaced by a write through another iterator.
+  // Only the thread which edits this buffer changes it.
+  std::size_t         copies;
+public:
+  /// @name Other Container requirements
+  //@{
+  /// The value_type of this container
+  typedef T                 value_type;
+  /// value_type *
+  typedef T *               pointer;
+  /// value_type const *
+  typedef T const *         const_pointer;
+  /// value_type &
+  typedef T &               reference;
+  /// value_type const &
+  typedef T const &         const_reference;
+  /// The size_type of this container
+  typedef std::size_t       size_type;
+  /// The difference_type of this container
+  typedef std::ptrdiff_t    difference_type;
+
+  /// Return the number of elements in the rope_buffer
+  /// @note \b Complexity: O(1)
+  size_type size() const;
+
+  /// Return the maximum number of elements a rope_buffer might hold
+  /// @note \b Complexity: O(1)
+  size_type max_size() const;
+
+  /// Return if the rope_buffer is empty
+  /// @note \b Complexity: O(1)
+  bool empty() const;
+
+  /// Swap this rope_buffer with another
+  /// @note \b Complexity: O(1)
+  void swap(rope_buffer & other);
+  //@}
+
+  ///@name Iterator access
+  //@{
+  typedef iterator_impl<T, rope_buffer>                   iterator;
+  typedef iterator_impl<T const, rope_buffer const> const_iterator;
+  typedef std::reverse_iterator<iterator>                   reverse_iterator;
+  typedef std::reverse_iterator<const_iterator>       const_reverse_iterator;
+
+  /// Return the cursor position as an iterator
+  /// @note \b Complexity: O(1)
+  iterator here();
+  /// Return the cursor position as an iterator
+  /// @note \b Complexity: O(1)
+  const_iterator here() const;
+  /// Return the cursor position as a reverse iterator
+  /// @note \b Complexity: O(1)
+  reverse_iterator rhere();
+  /// Return the cursor position as a reverse iterator
+  /// @note \b Complexity: O(1)
+  const_reverse_iterator rhere() const;
+
+  /// Get an iterator to the beginning of the rope_buffer
+  /// @note \b Complexity: O(1)
+  iterator begin();
+  /// Get an iterator to one element past the end of the rope_buffer
+  /// @note \b Complexity: O(1)
+  iterator end();
+  /// Get a const iterator to the beginning of the rope_buffer
+  /// @note \b Complexity: O(1)
+  const_iterator begin() const;
+  /// Get a const iterator to one element past the end of the rope_buffer
+  /// @note \b Complexity: O(1)
+  const_iterator end() const;
+
+  /// Get a reverse iterator to the beginning of the reversed rope_buffer
+  /// @note \b Complexity: O(1)
+  reverse_iterator rbegin();
+  /// @brief Get a reverse iterator to one element past the end of the reversed
+  /// rope_buffer
+  /// @note \b Complexity: O(1)
+  reverse_iterator rend();
+  /// Get a const reverse iterator to the beginning of the reversed rope_buffer
+  /// @note \b Complexity: O(1)
+  const_reverse_iterator rbegin() const;
+  /// @brief Get a reverse const iterator to one element past the end of the
+  /// reversed rope_buffer
+  /// @note \b Complexity: O(1)
+  const_reverse_iterator rend() const;
+  //@}
+
+  /// @name Sequence Requirements
+  //@{
+  /// Default-construct an empty rope_buffer without allocating
+  rope_buffer();
+
+  /// Copy-construct a rope_buffer, sharing other's nodes
+  /// @note \b Complexity: O(1)
+  rope_buffer(rope_buffer const & other);
+
+  /// Move-construct a rope_buffer
+  /// @note \b Complexity: O(1)
+  rope_buffer(BOOST_RV_REF(rope_buffer) other);
+
+  /// Fill-construct a rope_buffer with n copies of e and the cursor at the end
+  /// @note \b Complexity: O(n)
+  rope_buffer(size_type n, value_type e = value_type());
+
+  /// @brief Construct a rope_buffer whose contents are the range [i, j) with
+  ///        the cursor at the end
+  /// @tparam InputIterator A model of Input Iterator whose value_type is
+  ///                       convertible to value_type
+  /// @note \b Complexity: O(std::distance(i, j))
+  template<class InputIterator>
+  rope_buffer(InputIterator const & i, InputIterator const & j);
+
+  /// Release the tree, destroying whatever nodes no other copy shares
+  ~rope_buffer();
+
+  /// Retrieve the first element of the rope_buffer
+  /// @note \b Complexity: O(log n)
+  reference       front();
+  /// Retrieve the first element of the rope_buffer
+  /// @note \b Complexity: O(log n)
+  const_reference front() const;
+
+  /// Insert element immediately before position.  If position is at or
+  /// before the cursor, advance the cursor one position.
+  /// @note \b Complexity: O(log n)
+  iterator insert(iterator position, const_reference element);
+
+  /// Insert n copies of element immediately before position.  If position
+  /// is at or before the cursor, advance the cursor n positions.
+  /// @note \b Complexity: O(n + log size())
+  void insert(iterator position, size_type n, const_reference element);
+
+  /// Insert the range of elements [i,j) immediately before position. If
+  /// position is at or before the cursor, advance the cursor n positions.
+  /// @note \b Complexity: O(n + log size())
+  template<class InputIterator>
+  void insert(iterator position,
+              InputIterator const & i, InputIterator const & j);
+
+  /// Erase the element at position.  If position was before the cursor, move
+  /// the cursor one spot earlier.
+  /// @note \b Complexity: O(log n)
+  iterator erase(iterator position);
+
+  /// Erase the elements in [start,end).  If the cursor was within this range,
+  /// move it to immediately before the range.
+  /// @note \b Complexity: O(std::distance(start, end) + log n)
+  iterator erase(iterator start, iterator end);
+
+  /// Remove all the elements in this and move the cursor to the beginning
+  /// @note \b Complexity: O(n) if the nodes are not shared, otherwise O(1)
+  void clear();
+
+  /// Resize the rope_buffer.  If the buffer is growing, pad the end with copies
+  /// of e.  If the buffer is shrinking, discard elements from the end.
+  /// @note \b Complexity: O(abs(n - size()) + log n)
+  void resize(size_type n, value_type const & e = value_type());
+
+  /// Assign one rope_buffer to another, sharing other's nodes
+  /// @note \b Complexity: O(1), plus the cost of releasing this one's nodes
+  rope_buffer & operator=(BOOST_COPY_ASSIGN_REF(rope_buffer) other);
+
+  /// Move assign one rope_buffer to another
+  /// @note \b Complexity: O(1)
+  rope_buffer & operator=(BOOST_RV_REF(rope_buffer) other);
+  //@}
+
+  /// @name Random Access Container Requirements
+  //@{
+  /// Retrieve the element at index i, copying its chunk if it is shared
+  /// @note \b Complexity: O(log n)
+  reference       operator[](size_type i);
+  /// Retrieve the element at index i
+  /// @note \b Complexity: O(log n)
+  const_reference operator[](size_type i) const;
+  /// Retrieve the element at index i, copying its chunk if it is shared, or
+  /// throw std::out_of_range if there is no such element
+  /// @note \b Complexity: O(log n)
+  reference       at(size_type i);
+  /// Retrieve the element at index i, throwing std::out_of_range if there is
+  /// no such element
+  /// @note \b Complexity: O(log n)
+  const_reference at(size_type i) const;
+  //@}
+
+
+  /// @name Cursor Handling
+  //@{
+  /// Return the cursor position of the rope_buffer
+  /// @note \b Complexity: O(1)
+  size_type position() const;
+
+  /// Move the cursor position
+  /// @note \b Complexity: O(1)
+  void advance(difference_type const dist);
+
+  /// @brief Remove data from this position.
+  /// @details A positive value erases the given number of values from ahead of
+  /// the cursor.  A negative value erases the absolute value of the given
+  /// number of cursors from behind the cursor.
+  /// @note \b Complexity: O(abs(dist) + log n)
+  void erase(difference_type const dist);
+
+  /// Insert an element at the cursor
+  /// @note \b Complexity: O(log n)
+  size_type insert(value_type const);
+
+  /// @brief Insert a range of elements at the cursor
+  /// @param range Any range of elements Boost.Range recognizes as a Single Pass
+  ///              Range.
+  /// @note \b Complexity: O(boost::size(range) + log n)
+  template<class TSinglePassRange>
+  size_type insert(TSinglePassRange const & range);
+  //@}
+
+  /// @name Snapshots
+  //@{
+  /// @brief Return an unchanging copy of this buffer, including its cursor.
+  /// @details The copy shares every node with this buffer until one of them is
+  /// edited, and may be read by another thread while this one carries on
+  /// editing.  Only the thread which owns this buffer may call snapshot()
+  /// while it is being edited, but any number of threads may copy or snapshot
+  /// a buffer which nobody edits, such as a published version.
+  /// @note \b Complexity: O(1)
+  rope_buffer snapshot() const;
+  //@}
+
+  /// @name Segments
+  //@{
+  /// @brief A range of the contiguous runs of a rope_buffer, in order
+  /// @details These are the chunks of the buffer.  The runs are read-only,
+  ///          since a chunk may be shared with copies of this buffer.
+  typedef std::vector<boost::iterator_range<T const *> > const_segment_list;
+
+  /// @brief Return the runs of elements in this rope_buffer, for use by the
+  ///        algorithms in segmented_algorithms.hpp
+  /// @note The runs are invalidated by any edit
+  /// @note \b Complexity: O(n / LeafCapacity)
+  const_segment_list segments() const;
+  //@}
+
+private:
+  // Find the chunk holding index i, and the index its first element has
+  static leaf_node * find_leaf(node * n, size_type i, size_type & leaf_start);
+  // The same, also telling whether every node on the path is unshared, so
+  // that the chunk may be changed in place
+  static leaf_node * find_leaf(node * n, size_type i, size_type & leaf_start,
+                               bool & unshared);
+  // The same, copying every shared node on the path so the chunk may change
+  leaf_node * writable_leaf(size_type i, size_type & leaf_start);
+
+  // Append the chunks of the subtree n to runs, in order
+  static void collect_segments(node const * n, const_segment_list & runs);
+
+  // Take or drop a reference to a subtree, freeing it with the last one
+  static node * share(node * n);
+  static void   release(node * n);
+  // Replace the node in slot with an unshared copy unless it is unshared
+  // already, counting the copy, and return it
+  node * unique(node * & slot);
+
+  // Insert [first, first + n) at index i of the subtree in slot.  Any nodes
+  // which had to be split off to make room are appended to spill, in order,
+  // and belong after it in its parent.
+  template<class ForwardIterator>
+  void insert_into(node * & slot, size_type i, ForwardIterator first,
+                   size_type count, node_list & spill);
+  // Insert extra after child k of parent, splitting parent into spill if it
+  // overflows
+  static void adopt(inner_node * parent, size_type k, node_list & extra,
+                    node_list & spill);
+  // Erase [start, finish) from the subtree in slot
+  void erase_from(node * & slot, size_type start, size_type finish);
+  // Merge underfull neighbours amongst the children of n
+  void rebalance(inner_node * n);
+
+  // Insert at index i and fix up the cursor
+  template<class ForwardIterator>
+  void insert_at(size_type i, ForwardIterator first, size_type count);
+  // Erase logical [start, finish) and fix up the cursor
+  void erase_range(size_type start, size_type finish);
+
+  // Insert n copies of e at index i
+  void insert_fill(size_type i, size_type n, value_type const & e);
+
+  // Dispatch the range insertions on integral arguments and iterator category
+  template<class TInteger>
+  void insert_dispatch(size_type i, TInteger n, TInteger e,
+                       boost::true_type);
+  template<class InputIterator>
+  void insert_dispatch(size_type i, InputIterator first, InputIterator last,
+                       boost::false_type);
+  template<class InputIterator>
+  void insert_range(size_type i, InputIterator first, InputIterator last,
+                    std::input_iterator_tag);
+  template<class ForwardIterator>
+  void insert_range(size_type i, ForwardIterator first, ForwardIterator last,
+                    std::forward_iterator_tag);
+
+  // Check our iterator's concepts
+  BOOST_CONCEPT_ASSERT((boost::Mutable_RandomAccessIterator<        iterator>));
+  BOOST_CONCEPT_ASSERT((boost::Mutable_RandomAccessIterator<reverse_iterator>));
+  BOOST_CONCEPT_ASSERT((boost::RandomAccessIterator<          const_iterator>));
+  BOOST_CONCEPT_ASSERT((boost::RandomAccessIterator<  const_reverse_iterator>));
+};
+
+///@name Comparisons
+//@{
+/// Test two rope_buffers for equality
+/// @note \b Complexity: O(n)
+template<class T, std::size_t L, std::size_t F>
+bool operator==(rope_buffer<T, L, F> const &, rope_buffer<T, L, F> const &);
+/// Test two rope_buffers for inequality
+/// @note \b Complexity: O(n)
+template<class T, std::size_t L, std::size_t F>
+bool operator!=(rope_buffer<T, L, F> const &, rope_buffer<T, L, F> const &);
+/// Test if one rope_buffer is less than another
+/// @note \b Complexity: O(n)
+template<class T, std::size_t L, std::size_t F>
+bool operator<(rope_buffer<T, L, F> const &, rope_buffer<T, L, F> const &);
+/// Test if one rope_buffer is greater than another
+/// @note \b Complexity: O(n)
+template<class T, std::size_t L, std::size_t F>
+bool operator>(rope_buffer<T, L, F> const &, rope_buffer<T, L, F> const &);
+/// Test if one rope_buffer is less than or equal to another
+/// @note \b Complexity: O(n)
+template<class T, std::size_t L, std::size_t F>
+bool operator<=(rope_buffer<T, L, F> const &, rope_buffer<T, L, F> const &);
+/// Test if one rope_buffer is greater than or equal to another
+/// @note \b Complexity: O(n)
+template<class T, std::size_t L, std::size_t F>
+bool operator>=(rope_buffer<T, L, F> const &, rope_buffer<T, L, F> const &);
+//@}
+
+
+#include "segmented_algorithms.hpp"
+#include "rope_buffer.ipp"
+#endif
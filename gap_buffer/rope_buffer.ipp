@@ -0,0 +1,1130 @@
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <boost/atomic.hpp>
+#include <boost/move/iterator.hpp>
+#include <boost/mpl/if.hpp>
+#include <boost/range/begin.hpp>
+#include <boost/range/end.hpp>
+#include <boost/type_traits/is_const.hpp>
+#include <boost/type_traits/is_integral.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+
+template<class T, std::size_t L, std::size_t F>
+struct rope_buffer<T, L, F>::node
+{
+  explicit node(bool leaf)
+    : size(0)
+    , is_leaf(leaf)
+    , refs(1)
+  {}
+
+  // A copy of a node starts out unshared
+  node(node const & other)
+    : size(other.size)
+    , is_leaf(other.is_leaf)
+    , refs(1)
+  {}
+
+  // The number of elements in this subtree
+  std::size_t                size;
+  // Which of leaf_node or inner_node this really is
+  bool                       is_leaf;
+  // The number of trees and inner nodes which point at this node.  A node
+  // with more than one is never changed, only copied.
+  boost::atomic<std::size_t> refs;
+};
+
+template<class T, std::size_t L, std::size_t F>
+struct rope_buffer<T, L, F>::leaf_node
+  : rope_buffer<T, L, F>::node
+{
+  leaf_node()
+    : node(true)
+  {}
+
+  boost::container::static_vector<T, L> elements;
+};
+
+template<class T, std::size_t L, std::size_t F>
+struct rope_buffer<T, L, F>::inner_node
+  : rope_buffer<T, L, F>::node
+{
+  inner_node()
+    : node(false)
+  {}
+
+  boost::container::static_vector<node *, F> children;
+};
+
+
+/**
+   @invariant element is the element at idx, and lies in a chunk which may be
+              changed in place if writable is true
+*/
+template<class T, std::size_t L, std::size_t F>
+class rope_buffer<T, L, F>::element_reference
+{
+public:
+  element_reference(rope_buffer * buffer, std::size_t index, T * e,
+                    bool unshared)
+    : buf(buffer)
+    , idx(index)
+    , element(e)
+    , writable(unshared)
+  {}
+
+  operator T const &() const
+  {
+    return *element;
+  }
+
+  element_reference & operator=(T const & e)
+  {
+    *(&*this) = e;
+    return *this;
+  }
+
+  element_reference & operator=(element_reference const & other)
+  {
+    return *this = static_cast<T const &>(other);
+  }
+
+  // Taking the address allows writes through it, so copy the chunk first
+  T * operator&() const
+  {
+    if(!writable){
+      element = &(*buf)[idx];
+      writable = true;
+    }
+    return element;
+  }
+
+  friend void swap(element_reference a, element_reference b)
+  {
+    T const temp(a);
+    a = static_cast<T const &>(b);
+    b = temp;
+  }
+
+private:
+  // The buffer the element is in
+  rope_buffer *       buf;
+  // The logical index of the element
+  std::size_t         idx;
+  // The element, in a chunk which may still be shared
+  mutable T *         element;
+  // If element's chunk, and every node above it, is unshared
+  mutable bool        writable;
+};
+
+
+/**
+   @invariant leaf == 0 || leaf is the chunk holding [leaf_start,
+              leaf_start + leaf->size) as of the last time it was looked up,
+              and writable tells whether its path was unshared then
+*/
+template<class T, std::size_t L, std::size_t F>
+template<class TValue, class TBuffer>
+class rope_buffer<T, L, F>::iterator_impl
+  : public boost::iterator_facade<iterator_impl<TValue, TBuffer>,
+                                  TValue,
+                                  std::random_access_iterator_tag,
+                                  typename boost::mpl::if_<
+                                    boost::is_const<TValue>,
+                                    TValue &,
+                                    element_reference>::type>
+{
+  typedef typename boost::mpl::if_<boost::is_const<TValue>,
+                                   TValue &,
+                                   element_reference>::type reference_type;
+  struct enabler {};
+public:
+  iterator_impl()
+    : buf(0)
+    , idx(0)
+    , leaf(0)
+    , leaf_start(0)
+    , shares_seen(0)
+    , copies_seen(0)
+    , writable(false)
+  {}
+
+  iterator_impl(TBuffer * buffer, std::size_t index)
+    : buf(buffer)
+    , idx(index)
+    , leaf(0)
+    , leaf_start(0)
+    , shares_seen(0)
+    , copies_seen(0)
+    , writable(false)
+  {}
+
+  // Allow iterator to convert to const_iterator, but not the other way around
+  template<class UValue, class UBuffer>
+  iterator_impl(iterator_impl<UValue, UBuffer> const & other,
+                typename boost::enable_if<
+                  boost::is_convertible<UValue *, TValue *>,
+                  enabler>::type = enabler())
+    : buf(other.buf)
+    , idx(other.idx)
+    , leaf(other.leaf)
+    , leaf_start(other.leaf_start)
+    , shares_seen(other.shares_seen)
+    , copies_seen(other.copies_seen)
+    , writable(other.writable)
+  {}
+
+  // A pointer may be written through, so a mutable iterator's copies the chunk
+  TValue * operator->() const
+  {
+    return &dereference();
+  }
+
+private:
+  // Grant access to Boost.Iterator
+  friend class boost::iterator_core_access;
+  friend class rope_buffer<T, L, F>;
+  template<class, class> friend class iterator_impl;
+
+  // The buffer this iterator walks over
+  TBuffer *           buf;
+  // The logical index of the element this iterator refers to
+  std::size_t         idx;
+  // The chunk idx was last found in, so that walking a chunk is O(1)
+  mutable leaf_node * leaf;
+  // The logical index of the first element of leaf
+  mutable std::size_t leaf_start;
+  // The value of buf->shares when leaf was found.  Once the buffer has been
+  // shared, leaf may no longer be written in place.
+  mutable std::size_t shares_seen;
+  // The value of buf->copies when leaf was found.  Once a write through
+  // another iterator has copied a node, leaf may no longer be in the buffer.
+  mutable std::size_t copies_seen;
+  // If leaf and every node above it were unshared when leaf was found
+  mutable bool        writable;
+
+  reference_type dereference() const
+  {
+    if(!leaf || idx < leaf_start || idx >= leaf_start + leaf->size ||
+       shares_seen != buf->shares.load(boost::memory_order_relaxed) ||
+       copies_seen != buf->copies){
+      leaf = find_leaf(buf->root, idx, leaf_start, writable);
+      shares_seen = buf->shares.load(boost::memory_order_relaxed);
+      copies_seen = buf->copies;
+    }
+    return refer(buf, idx, &leaf->elements[idx - leaf_start], writable);
+  }
+  // Make the reference a const_iterator yields
+  static TValue & refer(rope_buffer const *, std::size_t, TValue * element,
+                        bool)
+  {
+    return *element;
+  }
+  // Make the reference a mutable iterator yields
+  static element_reference refer(rope_buffer * buffer, std::size_t index,
+                                 T * element, bool unshared)
+  {
+    return element_reference(buffer, index, element, unshared);
+  }
+  // Compare the iterator for equality, as a callback to Boost.Iterator
+  template<class UValue, class UBuffer>
+  bool equal(iterator_impl<UValue, UBuffer> const & other) const
+  {
+    return idx == other.idx;
+  }
+  // Increment the iterator, as a callback to Boost.Iterator
+  void increment()
+  {
+    ++idx;
+  }
+  // Decrement the iterator, as a callback to Boost.Iterator
+  void decrement()
+  {
+    --idx;
+  }
+  // Advance the iterator, as a callback to Boost.Iterator
+  void advance(std::ptrdiff_t n)
+  {
+    idx += n;
+  }
+  // Measure distance between to iterators as callback to Boost.Iterator
+  template<class UValue, class UBuffer>
+  std::ptrdiff_t distance_to(iterator_impl<UValue, UBuffer> const & other) const
+  {
+    return static_cast<std::ptrdiff_t>(other.idx) -
+      static_cast<std::ptrdiff_t>(idx);
+  }
+};
+
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::leaf_node *
+rope_buffer<T, L, F>::
+find_leaf(node * n, size_type i, size_type & leaf_start)
+{
+  bool unshared;
+  return find_leaf(n, i, leaf_start, unshared);
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::leaf_node *
+rope_buffer<T, L, F>::
+find_leaf(node * n, size_type i, size_type & leaf_start, bool & unshared)
+{
+  leaf_start = 0;
+  unshared = n->refs.load(boost::memory_order_acquire) == 1;
+  while(!n->is_leaf){
+    inner_node * const inner = static_cast<inner_node *>(n);
+    // The last child takes anything past the end, so that i may be size()
+    size_type k = 0;
+    while(k + 1 < inner->children.size() && i >= inner->children[k]->size){
+      i -= inner->children[k]->size;
+      leaf_start += inner->children[k]->size;
+      ++k;
+    }
+    n = inner->children[k];
+    unshared = unshared && n->refs.load(boost::memory_order_acquire) == 1;
+  }
+  return static_cast<leaf_node *>(n);
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::leaf_node *
+rope_buffer<T, L, F>::
+writable_leaf(size_type i, size_type & leaf_start)
+{
+  // The same walk as find_leaf, but copying every shared node on the way
+  leaf_start = 0;
+  node ** slot = &root;
+  while(!unique(*slot)->is_leaf){
+    inner_node * const inner = static_cast<inner_node *>(*slot);
+    size_type k = 0;
+    while(k + 1 < inner->children.size() && i >= inner->children[k]->size){
+      i -= inner->children[k]->size;
+      leaf_start += inner->children[k]->size;
+      ++k;
+    }
+    slot = &inner->children[k];
+  }
+  return static_cast<leaf_node *>(*slot);
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::node *
+rope_buffer<T, L, F>::
+share(node * n)
+{
+  if(n)
+    n->refs.fetch_add(1, boost::memory_order_relaxed);
+  return n;
+}
+
+template<class T, std::size_t L, std::size_t F>
+void
+rope_buffer<T, L, F>::
+release(node * n)
+{
+  // Whoever drops the last reference frees the node, on whatever thread
+  if(!n || n->refs.fetch_sub(1, boost::memory_order_acq_rel) != 1)
+    return;
+  if(n->is_leaf){
+    delete static_cast<leaf_node *>(n);
+  }else{
+    inner_node * const inner = static_cast<inner_node *>(n);
+    for(size_type k = 0; k < inner->children.size(); ++k)
+      release(inner->children[k]);
+    delete inner;
+  }
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::node *
+rope_buffer<T, L, F>::
+unique(node * & slot)
+{
+  // With only our reference, nobody else can gain one while we look
+  if(slot->refs.load(boost::memory_order_acquire) == 1)
+    return slot;
+
+  node * copy;
+  if(slot->is_leaf){
+    copy = new leaf_node(*static_cast<leaf_node const *>(slot));
+  }else{
+    inner_node * const inner =
+      new inner_node(*static_cast<inner_node const *>(slot));
+    for(size_type k = 0; k < inner->children.size(); ++k)
+      share(inner->children[k]);
+    copy = inner;
+  }
+  release(slot);
+  slot = copy;
+  ++copies;
+  return copy;
+}
+
+template<class T, std::size_t L, std::size_t F>
+template<class ForwardIterator>
+void
+rope_buffer<T, L, F>::
+insert_into(node * & slot, size_type i, ForwardIterator first,
+            size_type count, node_list & spill)
+{
+  node * const n = unique(slot);
+  n->size += count;
+
+  if(!n->is_leaf){
+    inner_node * const inner = static_cast<inner_node *>(n);
+    // Prefer appending to a child over prepending to the next one
+    size_type k = 0;
+    while(k + 1 < inner->children.size() && i > inner->children[k]->size){
+      i -= inner->children[k]->size;
+      ++k;
+    }
+    node_list extra;
+    insert_into(inner->children[k], i, first, count, extra);
+    if(!extra.empty())
+      adopt(inner, k, extra, spill);
+    return;
+  }
+
+  leaf_node * const leaf = static_cast<leaf_node *>(n);
+  ForwardIterator last = first;
+  std::advance(last, count);
+  if(leaf->elements.size() + count <= L){
+    leaf->elements.insert(leaf->elements.begin() + i, first, last);
+    return;
+  }
+
+  // Too much for one chunk, so lay the whole lot out again evenly across as
+  // many chunks as it takes
+  std::vector<T> all;
+  all.reserve(leaf->elements.size() + count);
+  all.insert(all.end(),
+             boost::make_move_iterator(leaf->elements.begin()),
+             boost::make_move_iterator(leaf->elements.begin() + i));
+  all.insert(all.end(), first, last);
+  all.insert(all.end(),
+             boost::make_move_iterator(leaf->elements.begin() + i),
+             boost::make_move_iterator(leaf->elements.end()));
+  leaf->elements.clear();
+
+  size_type const chunks = (all.size() + L - 1) / L;
+  typename std::vector<T>::iterator from = all.begin();
+  for(size_type c = 0; c < chunks; ++c){
+    size_type const take = all.size() / chunks + (c < all.size() % chunks);
+    leaf_node * const target = (c == 0) ? leaf : new leaf_node;
+    target->elements.insert(target->elements.end(),
+                            boost::make_move_iterator(from),
+                            boost::make_move_iterator(from + take));
+    target->size = take;
+    from += take;
+    if(c != 0)
+      spill.push_back(target);
+  }
+}
+
+template<class T, std::size_t L, std::size_t F>
+void
+rope_buffer<T, L, F>::
+adopt(inner_node * parent, size_type k, node_list & extra, node_list & spill)
+{
+  if(parent->children.size() + extra.size() <= F){
+    parent->children.insert(parent->children.begin() + k + 1,
+                            extra.begin(), extra.end());
+    return;
+  }
+
+  node_list kids(parent->children.begin(), parent->children.end());
+  kids.insert(kids.begin() + k + 1, extra.begin(), extra.end());
+  parent->children.clear();
+
+  size_type const groups = (kids.size() + F - 1) / F;
+  typename node_list::iterator from = kids.begin();
+  for(size_type g = 0; g < groups; ++g){
+    size_type const take = kids.size() / groups + (g < kids.size() % groups);
+    inner_node * const target = (g == 0) ? parent : new inner_node;
+    target->children.assign(from, from + take);
+    target->size = 0;
+    for(size_type c = 0; c < take; ++c, ++from)
+      target->size += (*from)->size;
+    if(g != 0)
+      spill.push_back(target);
+  }
+}
+
+template<class T, std::size_t L, std::size_t F>
+void
+rope_buffer<T, L, F>::
+erase_from(node * & slot, size_type start, size_type finish)
+{
+  node * const n = unique(slot);
+  n->size -= finish - start;
+
+  if(n->is_leaf){
+    leaf_node * const leaf = static_cast<leaf_node *>(n);
+    leaf->elements.erase(leaf->elements.begin() + start,
+                         leaf->elements.begin() + finish);
+    return;
+  }
+
+  inner_node * const inner = static_cast<inner_node *>(n);
+  size_type child_start = 0;
+  for(size_type k = 0; k < inner->children.size() && child_start < finish;
+      ++k){
+    node * & child = inner->children[k];
+    size_type const child_end = child_start + child->size;
+    if(start <= child_start && child_end <= finish){
+      // Drop whole subtrees without copying them, even if they're shared
+      release(child);
+      child = 0;
+    }else if(child_end > start)
+      erase_from(child,
+                 std::max(start, child_start) - child_start,
+                 std::min(finish, child_end) - child_start);
+    child_start = child_end;
+  }
+  rebalance(inner);
+}
+
+template<class T, std::size_t L, std::size_t F>
+void
+rope_buffer<T, L, F>::
+rebalance(inner_node * n)
+{
+  // Drop the children which were emptied entirely
+  for(size_type k = 0; k < n->children.size(); ){
+    if(!n->children[k] || n->children[k]->size == 0){
+      release(n->children[k]);
+      n->children.erase(n->children.begin() + k);
+    }else
+      ++k;
+  }
+
+  // Merge neighbours when one of them has fallen below half full and the pair
+  // fits in a single node.  Siblings are always at the same depth.  The right
+  // hand one may be shared, so its contents are copied rather than stolen.
+  for(size_type k = 0; k + 1 < n->children.size(); ){
+    node * const a = n->children[k];
+    node * const b = n->children[k + 1];
+    bool merged = false;
+    if(a->is_leaf){
+      leaf_node const * const lb = static_cast<leaf_node const *>(b);
+      if((a->size < L / 2 || b->size < L / 2) && a->size + b->size <= L){
+        leaf_node * const la = static_cast<leaf_node *>(unique(n->children[k]));
+        la->elements.insert(la->elements.end(),
+                            lb->elements.begin(), lb->elements.end());
+        la->size += lb->size;
+        merged = true;
+      }
+    }else{
+      inner_node const * const ib = static_cast<inner_node const *>(b);
+      size_type const na = static_cast<inner_node *>(a)->children.size();
+      size_type const nb = ib->children.size();
+      if((na < F / 2 || nb < F / 2) && na + nb <= F){
+        inner_node * const ia =
+          static_cast<inner_node *>(unique(n->children[k]));
+        for(size_type c = 0; c < nb; ++c)
+          ia->children.push_back(share(ib->children[c]));
+        ia->size += ib->size;
+        merged = true;
+      }
+    }
+    if(merged){
+      release(b);
+      n->children.erase(n->children.begin() + k + 1);
+    }else
+      ++k;
+  }
+}
+
+template<class T, std::size_t L, std::size_t F>
+template<class ForwardIterator>
+void
+rope_buffer<T, L, F>::
+insert_at(size_type i, ForwardIterator first, size_type count)
+{
+  if(count == 0)
+    return;
+  if(!root)
+    root = new leaf_node;
+
+  node_list spill;
+  insert_into(root, i, first, count, spill);
+
+  // Grow the tree upwards for as long as the root keeps splitting
+  while(!spill.empty()){
+    inner_node * const grown = new inner_node;
+    grown->children.push_back(root);
+    grown->size = root->size;
+    for(size_type s = 0; s < spill.size(); ++s)
+      grown->size += spill[s]->size;
+    root = grown;
+
+    node_list more;
+    adopt(grown, 0, spill, more);
+    spill.swap(more);
+  }
+
+  if(i <= cursor)
+    cursor += count;
+}
+
+template<class T, std::size_t L, std::size_t F>
+void
+rope_buffer<T, L, F>::
+erase_range(size_type start, size_type finish)
+{
+  if(start == finish)
+    return;
+
+  erase_from(root, start, finish);
+
+  // Shrink the tree downwards while the root has only one child.  erase_from
+  // left the root unshared, so its child can simply be handed over.
+  while(root && !root->is_leaf){
+    inner_node * const inner = static_cast<inner_node *>(root);
+    if(inner->children.size() > 1)
+      break;
+    root = inner->children.empty() ? 0 : inner->children.front();
+    inner->children.clear();
+    delete inner;
+  }
+  if(root && root->size == 0){
+    release(root);
+    root = 0;
+  }
+
+  cursor -= std::min(finish, cursor) - std::min(start, cursor);
+}
+
+template<class T, std::size_t L, std::size_t F>
+void
+rope_buffer<T, L, F>::
+insert_fill(size_type i, size_type remaining, value_type const & e)
+{
+  // Build at most one chunk's worth of copies and insert it repeatedly
+  std::vector<T> chunk(std::min<size_type>(remaining, L), e);
+  while(remaining){
+    size_type const take = std::min<size_type>(remaining, L);
+    insert_at(i, chunk.begin(), take);
+    i += take;
+    remaining -= take;
+  }
+}
+
+template<class T, std::size_t L, std::size_t F>
+template<class TInteger>
+void
+rope_buffer<T, L, F>::
+insert_dispatch(size_type i, TInteger n, TInteger e, boost::true_type)
+{
+  insert_fill(i, static_cast<size_type>(n), static_cast<value_type>(e));
+}
+
+template<class T, std::size_t L, std::size_t F>
+template<class InputIterator>
+void
+rope_buffer<T, L, F>::
+insert_dispatch(size_type i, InputIterator first, InputIterator last,
+                boost::false_type)
+{
+  insert_range(i, first, last,
+               typename std::iterator_traits<InputIterator>::
+               iterator_category());
+}
+
+template<class T, std::size_t L, std::size_t F>
+template<class InputIterator>
+void
+rope_buffer<T, L, F>::
+insert_range(size_type i, InputIterator first, InputIterator last,
+             std::input_iterator_tag)
+{
+  // We can't know the length ahead of time, so gather the range up first
+  std::vector<T> gathered(first, last);
+  insert_at(i, gathered.begin(), gathered.size());
+}
+
+template<class T, std::size_t L, std::size_t F>
+template<class ForwardIterator>
+void
+rope_buffer<T, L, F>::
+insert_range(size_type i, ForwardIterator first, ForwardIterator last,
+             std::forward_iterator_tag)
+{
+  insert_at(i, first, std::distance(first, last));
+}
+
+
+template<class T, std::size_t L, std::size_t F>
+template<class TSinglePassRange>
+typename rope_buffer<T, L, F>::size_type
+rope_buffer<T, L, F>::
+insert(TSinglePassRange const & rng)
+{
+  insert_dispatch(cursor, boost::begin(rng), boost::end(rng),
+                  boost::false_type());
+  return position();
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::size_type
+rope_buffer<T, L, F>::
+insert(value_type const c)
+{
+  insert_at(cursor, &c, 1);
+  return position();
+}
+
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::size_type
+rope_buffer<T, L, F>::
+position() const
+{
+  return cursor;
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::size_type
+rope_buffer<T, L, F>::
+size() const
+{
+  return root ? root->size : 0;
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::size_type
+rope_buffer<T, L, F>::
+max_size() const
+{
+  return std::allocator<T>().max_size();
+}
+
+template<class T, std::size_t L, std::size_t F>
+bool
+rope_buffer<T, L, F>::
+empty() const
+{
+  return size() == 0;
+}
+
+template<class T, std::size_t L, std::size_t F>
+void
+rope_buffer<T, L, F>::
+swap(rope_buffer & other)
+{
+  std::swap(root,   other.root);
+  std::swap(cursor, other.cursor);
+  // Both buffers' mutable iterators must look again
+  shares.fetch_add(1, boost::memory_order_relaxed);
+  other.shares.fetch_add(1, boost::memory_order_relaxed);
+}
+
+template<class T, std::size_t L, std::size_t F>
+rope_buffer<T, L, F>
+rope_buffer<T, L, F>::
+snapshot() const
+{
+  return rope_buffer(*this);
+}
+
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::const_segment_list
+rope_buffer<T, L, F>::
+segments() const
+{
+  const_segment_list runs;
+  if(root){
+    runs.reserve(size() / L + 1);
+    collect_segments(root, runs);
+  }
+  return runs;
+}
+
+template<class T, std::size_t L, std::size_t F>
+void
+rope_buffer<T, L, F>::
+collect_segments(node const * n, const_segment_list & runs)
+{
+  if(n->is_leaf){
+    leaf_node const * const leaf = static_cast<leaf_node const *>(n);
+    if(!leaf->elements.empty())
+      runs.push_back(boost::make_iterator_range(
+                       leaf->elements.data(),
+                       leaf->elements.data() + leaf->elements.size()));
+  }else{
+    inner_node const * const inner = static_cast<inner_node const *>(n);
+    for(std::size_t k = 0; k < inner->children.size(); ++k)
+      collect_segments(inner->children[k], runs);
+  }
+}
+
+
+template<class T, std::size_t L, std::size_t F>
+void
+rope_buffer<T, L, F>::
+advance(difference_type const d)
+{
+  cursor += d;
+}
+
+
+template<class T, std::size_t L, std::size_t F>
+void
+rope_buffer<T, L, F>::
+erase(difference_type const d)
+{
+  if(d < 0)
+    erase_range(cursor + d, cursor);
+  else
+    erase_range(cursor, cursor + d);
+}
+
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::iterator
+rope_buffer<T, L, F>::
+here()
+{
+  return iterator(this, cursor);
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::const_iterator
+rope_buffer<T, L, F>::
+here() const
+{
+  return const_iterator(this, cursor);
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::reverse_iterator
+rope_buffer<T, L, F>::
+rhere()
+{
+  return reverse_iterator(here());
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::const_reverse_iterator
+rope_buffer<T, L, F>::
+rhere() const
+{
+  return const_reverse_iterator(here());
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::iterator
+rope_buffer<T, L, F>::
+begin()
+{
+  return iterator(this, 0);
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::const_iterator
+rope_buffer<T, L, F>::
+begin() const
+{
+  return const_iterator(this, 0);
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::iterator
+rope_buffer<T, L, F>::
+end()
+{
+  return iterator(this, size());
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::const_iterator
+rope_buffer<T, L, F>::
+end() const
+{
+  return const_iterator(this, size());
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::reverse_iterator
+rope_buffer<T, L, F>::
+rbegin()
+{
+  return reverse_iterator(end());
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::const_reverse_iterator
+rope_buffer<T, L, F>::
+rbegin() const
+{
+  return const_reverse_iterator(end());
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::reverse_iterator
+rope_buffer<T, L, F>::
+rend()
+{
+  return reverse_iterator(begin());
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::const_reverse_iterator
+rope_buffer<T, L, F>::
+rend() const
+{
+  return const_reverse_iterator(begin());
+}
+
+
+template<class T, std::size_t L, std::size_t F>
+rope_buffer<T, L, F>::rope_buffer()
+  : root(0)
+  , cursor(0)
+  , shares(0)
+  , copies(0)
+{}
+
+template<class T, std::size_t L, std::size_t F>
+rope_buffer<T, L, F>::rope_buffer(rope_buffer const & other)
+  : root(share(other.root))
+  , cursor(other.cursor)
+  , shares(0)
+  , copies(0)
+{
+  other.shares.fetch_add(1, boost::memory_order_relaxed);
+}
+
+template<class T, std::size_t L, std::size_t F>
+rope_buffer<T, L, F>::rope_buffer(BOOST_RV_REF(rope_buffer) other)
+  : root(other.root)
+  , cursor(other.cursor)
+  , shares(0)
+  , copies(0)
+{
+  other.root = 0;
+  other.cursor = 0;
+}
+
+template<class T, std::size_t L, std::size_t F>
+rope_buffer<T, L, F>::rope_buffer(size_type n, value_type e)
+  : root(0)
+  , cursor(0)
+  , shares(0)
+  , copies(0)
+{
+  insert_fill(0, n, e);
+}
+
+template<class T, std::size_t L, std::size_t F>
+template<class InputIterator>
+rope_buffer<T, L, F>::rope_buffer(InputIterator const & i,
+                                  InputIterator const & j)
+  : root(0)
+  , cursor(0)
+  , shares(0)
+  , copies(0)
+{
+  insert_dispatch(0, i, j, typename boost::is_integral<InputIterator>::type());
+}
+
+template<class T, std::size_t L, std::size_t F>
+rope_buffer<T, L, F>::~rope_buffer()
+{
+  release(root);
+}
+
+template<class T, std::size_t L, std::size_t F>
+rope_buffer<T, L, F> &
+rope_buffer<T, L, F>::operator=(BOOST_COPY_ASSIGN_REF(rope_buffer) other)
+{
+  if(&other != this){
+    rope_buffer copy(static_cast<rope_buffer const &>(other));
+    swap(copy);
+  }
+  return *this;
+}
+
+template<class T, std::size_t L, std::size_t F>
+rope_buffer<T, L, F> &
+rope_buffer<T, L, F>::operator=(BOOST_RV_REF(rope_buffer) other)
+{
+  rope_buffer moved( ::boost::move(other) );
+  swap(moved);
+  return *this;
+}
+
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::reference
+rope_buffer<T, L, F>::front()
+{
+  return (*this)[0];
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::const_reference
+rope_buffer<T, L, F>::front() const
+{
+  return (*this)[0];
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::reference
+rope_buffer<T, L, F>::operator[](size_type i)
+{
+  size_type leaf_start;
+  leaf_node * const leaf = writable_leaf(i, leaf_start);
+  return leaf->elements[i - leaf_start];
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::const_reference
+rope_buffer<T, L, F>::operator[](size_type i) const
+{
+  size_type leaf_start;
+  leaf_node const * const leaf = find_leaf(root, i, leaf_start);
+  return leaf->elements[i - leaf_start];
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::reference
+rope_buffer<T, L, F>::at(size_type i)
+{
+  if(i >= size())
+    throw std::out_of_range("rope_buffer::at");
+  return (*this)[i];
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::const_reference
+rope_buffer<T, L, F>::at(size_type i) const
+{
+  if(i >= size())
+    throw std::out_of_range("rope_buffer::at");
+  return (*this)[i];
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::iterator
+rope_buffer<T, L, F>::insert(iterator position, const_reference element)
+{
+  // element might live in this buffer, so take a copy before the tree changes
+  value_type const copy(element);
+  insert_at(position.idx, &copy, 1);
+  return iterator(this, position.idx);
+}
+
+template<class T, std::size_t L, std::size_t F>
+void
+rope_buffer<T, L, F>::insert(iterator position, size_type n,
+                             const_reference element)
+{
+  value_type const copy(element);
+  insert_fill(position.idx, n, copy);
+}
+
+template<class T, std::size_t L, std::size_t F>
+template<class InputIterator>
+void
+rope_buffer<T, L, F>::insert(iterator position,
+                             InputIterator const & i, InputIterator const & j)
+{
+  insert_dispatch(position.idx, i, j,
+                  typename boost::is_integral<InputIterator>::type());
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::iterator
+rope_buffer<T, L, F>::erase(iterator position)
+{
+  erase_range(position.idx, position.idx + 1);
+  return iterator(this, position.idx);
+}
+
+template<class T, std::size_t L, std::size_t F>
+typename rope_buffer<T, L, F>::iterator
+rope_buffer<T, L, F>::erase(iterator start, iterator end)
+{
+  erase_range(start.idx, end.idx);
+  return iterator(this, start.idx);
+}
+
+template<class T, std::size_t L, std::size_t F>
+void
+rope_buffer<T, L, F>::clear()
+{
+  release(root);
+  root = 0;
+  cursor = 0;
+}
+
+template<class T, std::size_t L, std::size_t F>
+void
+rope_buffer<T, L, F>::resize(size_type n, value_type const & e)
+{
+  if(n < size())
+    erase_range(n, size());
+  else
+    insert(end(), n - size(), e);
+}
+
+#define BINARY_ROPE_BOOL_OPER(oper)                                         \
+  template<class T, std::size_t L, std::size_t F>                           \
+  bool operator oper ( rope_buffer<T, L, F> const & lhs,                    \
+                       rope_buffer<T, L, F> const & rhs)
+
+BINARY_ROPE_BOOL_OPER( == )
+{
+  return segmented::equal(lhs, rhs);
+}
+
+BINARY_ROPE_BOOL_OPER( < )
+{
+  return segmented::lexicographical_compare(lhs, rhs);
+}
+
+BINARY_ROPE_BOOL_OPER( != ) { return !(lhs == rhs); }
+BINARY_ROPE_BOOL_OPER( > )  { return  (rhs <  lhs); }
+BINARY_ROPE_BOOL_OPER( <= ) { return !(rhs <  lhs); }
+BINARY_ROPE_BOOL_OPER( >= ) { return !(lhs <  rhs); }
+
+
+#undef BINARY_ROPE_BOOL_OPER
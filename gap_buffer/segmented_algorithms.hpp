@@ -0,0 +1,131 @@
+#ifndef SEGMENTED_ALGORITHMS_HPP_INCLUDED_
+#define SEGMENTED_ALGORITHMS_HPP_INCLUDED_
+
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include <cstddef>
+
+
+/**
+   @brief Algorithms which work a segment at a time
+   @details
+   The buffers in this library store their elements in a few contiguous runs,
+   and their iterators have to check at every step whether they have reached
+   the end of one.  That check stops compilers from turning loops over them
+   into the tight, vectorized loops they produce for plain arrays.
+
+   Each buffer therefore offers a segments() member, which returns a Boost.Range
+   of its runs in order.  Each run is itself a range, over the underlying
+   container's iterators or plain pointers.  The algorithms here take such a
+   buffer and run the standard algorithm over each run in turn, so the inner
+   loops never see a gap.  Where two buffers are compared, the runs are walked
+   together in the largest pieces both allow, using memcmp for integral
+   elements stored contiguously.
+
+   Searching and counting character types use vector instructions where the
+   processor has them, on runs stored behind pointers or in the blocks of a
+   std::deque.
+
+   Positions are returned as indices, with size() standing for "not found".
+
+   @tparam TSegmented Any type with a segments() member and a size() member,
+                      such as gap_buffer, contiguous_gap_buffer, rope_buffer or
+                      multi_gap_buffer
+*/
+namespace segmented
+{
+  /// Copy every element of buffer to out, in order, and return the end of
+  /// the output
+  /// @note \b Complexity: O(n)
+  template<class TSegmented, class OutputIterator>
+  OutputIterator copy(TSegmented const & buffer, OutputIterator out);
+
+  /// Return the index of the first element of buffer equal to value, or
+  /// buffer.size() if there is none
+  /// @note \b Complexity: O(n)
+  template<class TSegmented, class T>
+  std::size_t find(TSegmented const & buffer, T const & value);
+
+  /// @brief Return the index at which needle first appears in buffer, or
+  ///        buffer.size() if it does not.  An empty needle is found at 0.
+  /// @details Matches may straddle the boundaries between runs.
+  /// @tparam TForwardRange A Forward Range whose elements compare with those
+  ///                       of buffer
+  /// @note \b Complexity: O(n * boost::size(needle)) in the worst case, and
+  ///       close to O(n) when the first element of needle is rare
+  template<class TSegmented, class TForwardRange>
+  std::size_t search(TSegmented const & buffer, TForwardRange const & needle);
+
+  /// @brief Return the index of the first element of a buffer of characters
+  ///        equal to value, ignoring the case of ASCII letters, or
+  ///        buffer.size() if there is none
+  /// @note \b Complexity: O(n)
+  template<class TSegmented>
+  std::size_t find_ignore_case(TSegmented const & buffer, char value);
+
+  /// @brief Return the index at which needle first appears in a buffer of
+  ///        characters, ignoring the case of ASCII letters, or buffer.size()
+  ///        if it does not
+  /// @note \b Complexity: The same as search()
+  template<class TSegmented, class TForwardRange>
+  std::size_t search_ignore_case(TSegmented const & buffer,
+                                 TForwardRange const & needle);
+
+  /// Return the number of elements of buffer equal to value
+  /// @note \b Complexity: O(n)
+  template<class TSegmented, class T>
+  std::size_t count(TSegmented const & buffer, T const & value);
+
+  /// Return the index of the first element at which lhs and rhs differ, or
+  /// the smaller of their sizes if one is a prefix of the other
+  /// @note \b Complexity: O(n)
+  template<class TSegmentedA, class TSegmentedB>
+  std::size_t mismatch(TSegmentedA const & lhs, TSegmentedB const & rhs);
+
+  /// Return if lhs and rhs have the same size and elements
+  /// @note \b Complexity: O(n)
+  template<class TSegmentedA, class TSegmentedB>
+  bool equal(TSegmentedA const & lhs, TSegmentedB const & rhs);
+
+  /// Return if lhs comes before rhs in lexicographical order
+  /// @note \b Complexity: O(n)
+  template<class TSegmentedA, class TSegmentedB>
+  bool lexicographical_compare(TSegmentedA const & lhs,
+                               TSegmentedB const & rhs);
+}
+
+
+#include "segmented_algorithms.ipp"
+#endif
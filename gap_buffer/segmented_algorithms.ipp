@@ -0,0 +1,440 @@
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "detail/byte_kernels.hpp"
+#include "detail/byte_runs.hpp"
+
+#include <boost/range/begin.hpp>
+#include <boost/range/end.hpp>
+#include <boost/range/iterator_range.hpp>
+#include <boost/range/iterator.hpp>
+#include <boost/range/size.hpp>
+#include <boost/range/value_type.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/remove_const.hpp>
+#include <boost/utility/enable_if.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+
+namespace segmented
+{
+namespace detail
+{
+  // Walks the elements of a range of ranges one contiguous run at a time
+  template<class TSegments>
+  class run_walker
+  {
+    typedef typename boost::range_iterator<TSegments const>::type segment_iter;
+    typedef typename boost::range_value<TSegments>::type          segment;
+  public:
+    typedef typename boost::range_iterator<segment const>::type   iterator;
+
+    explicit run_walker(TSegments const & s)
+      : segments(s)
+      , next(boost::begin(segments))
+      , remaining(0)
+    {
+      skip_empty();
+    }
+
+    // If every element has been walked over
+    bool done() const
+    {
+      return remaining == 0;
+    }
+    // The number of elements left in the current run
+    std::size_t available() const
+    {
+      return remaining;
+    }
+    // The first element left in the current run
+    iterator here() const
+    {
+      return location;
+    }
+    // Step over n elements of the current run
+    void consume(std::size_t n)
+    {
+      std::advance(location, n);
+      remaining -= n;
+      skip_empty();
+    }
+
+  private:
+    TSegments    segments;
+    segment_iter next;
+    iterator     location;
+    std::size_t  remaining;
+
+    void skip_empty()
+    {
+      while(remaining == 0 && next != boost::end(segments)){
+        location = boost::begin(*next);
+        remaining = std::distance(location, boost::end(*next));
+        ++next;
+      }
+    }
+  };
+
+  // The offset of the first difference between [a, a + n) and [b, b + n), or
+  // n if there is none
+  template<class IteratorA, class IteratorB>
+  std::size_t run_mismatch(IteratorA a, IteratorB b, std::size_t n)
+  {
+    IteratorA end = a;
+    std::advance(end, n);
+    // std::equal is usually the better optimized of the two, so try it first
+    if(std::equal(a, end, b))
+      return n;
+    return std::distance(a, std::mismatch(a, end, b).first);
+  }
+
+  // Integers have no padding and only one representation of each value, so
+  // their runs may be compared as raw memory
+  template<class T>
+  typename boost::enable_if<boost::is_integral<T>, std::size_t>::type
+  run_mismatch(T const * a, T const * b, std::size_t n)
+  {
+    if(std::memcmp(a, b, n * sizeof(T)) == 0)
+      return n;
+    return std::mismatch(a, a + n, b).first - a;
+  }
+
+  template<class T>
+  typename boost::enable_if<boost::is_integral<T>, std::size_t>::type
+  run_mismatch(T * a, T * b, std::size_t n)
+  {
+    return run_mismatch(static_cast<T const *>(a), static_cast<T const *>(b),
+                        n);
+  }
+
+  // Walk lhs and rhs forwards together until they differ or one runs out,
+  // and return the number of elements stepped over
+  template<class WalkerA, class WalkerB>
+  std::size_t walk_to_mismatch(WalkerA & lhs, WalkerB & rhs)
+  {
+    std::size_t index = 0;
+    while(!lhs.done() && !rhs.done()){
+      std::size_t const n = std::min(lhs.available(), rhs.available());
+      std::size_t const same = run_mismatch(lhs.here(), rhs.here(), n);
+      index += same;
+      lhs.consume(same);
+      rhs.consume(same);
+      if(same != n)
+        break;
+    }
+    return index;
+  }
+
+  // The offset of the first element of [first, last) equal to value, or
+  // std::distance(first, last) if there is none
+  template<class Iterator, class T>
+  typename boost::disable_if<byte_runs<Iterator>, std::size_t>::type
+  run_find(Iterator first, Iterator last, T const & value)
+  {
+    return std::distance(first, std::find(first, last, value));
+  }
+
+  template<class Iterator, class T>
+  typename boost::enable_if<byte_runs<Iterator>, std::size_t>::type
+  run_find(Iterator first, Iterator last, T const & value)
+  {
+    typedef typename std::iterator_traits<Iterator>::value_type element;
+    std::size_t offset = 0;
+    // A value no element can hold matches nothing
+    if(!(static_cast<element>(value) == value))
+      return std::distance(first, last);
+    while(first != last){
+      byte_block const block = byte_runs<Iterator>::block(first, last);
+      std::size_t const found = find_byte(block.first, block.second,
+                                          static_cast<element>(value));
+      offset += found;
+      if(found != block.second)
+        break;
+      std::advance(first, block.second);
+    }
+    return offset;
+  }
+
+  // The offset of the first element of [first, last) equal to a or b, or
+  // std::distance(first, last) if there is none
+  template<class Iterator>
+  typename boost::disable_if<byte_runs<Iterator>, std::size_t>::type
+  run_find_either(Iterator first, Iterator last, char a, char b)
+  {
+    std::size_t offset = 0;
+    for(; first != last && *first != a && *first != b; ++first)
+      ++offset;
+    return offset;
+  }
+
+  template<class Iterator>
+  typename boost::enable_if<byte_runs<Iterator>, std::size_t>::type
+  run_find_either(Iterator first, Iterator last, char a, char b)
+  {
+    std::size_t offset = 0;
+    while(first != last){
+      byte_block const block = byte_runs<Iterator>::block(first, last);
+      std::size_t const found = find_either_byte(block.first, block.second,
+                                                 a, b);
+      offset += found;
+      if(found != block.second)
+        break;
+      std::advance(first, block.second);
+    }
+    return offset;
+  }
+
+  // The number of elements of [first, last) equal to value
+  template<class Iterator, class T>
+  typename boost::disable_if<byte_runs<Iterator>, std::size_t>::type
+  run_count(Iterator first, Iterator last, T const & value)
+  {
+    return std::count(first, last, value);
+  }
+
+  template<class Iterator, class T>
+  typename boost::enable_if<byte_runs<Iterator>, std::size_t>::type
+  run_count(Iterator first, Iterator last, T const & value)
+  {
+    typedef typename std::iterator_traits<Iterator>::value_type element;
+    std::size_t total = 0;
+    if(!(static_cast<element>(value) == value))
+      return 0;
+    while(first != last){
+      byte_block const block = byte_runs<Iterator>::block(first, last);
+      total += count_byte(block.first, block.second,
+                          static_cast<element>(value));
+      std::advance(first, block.second);
+    }
+    return total;
+  }
+
+  // Matching for search(), element for element
+  struct exact_match
+  {
+    template<class Iterator, class T>
+    static std::size_t find(Iterator first, Iterator last, T const & value)
+    {
+      return run_find(first, last, value);
+    }
+    template<class A, class B>
+    static bool same(A const & a, B const & b)
+    {
+      return a == b;
+    }
+  };
+
+  // Matching for search_ignore_case(), folding ASCII letters to lower case
+  struct ascii_ignore_case
+  {
+    static char lower(char c)
+    {
+      return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+    static char upper(char c)
+    {
+      return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+    }
+    template<class Iterator>
+    static std::size_t find(Iterator first, Iterator last, char value)
+    {
+      if(lower(value) == upper(value))
+        return run_find(first, last, value);
+      return run_find_either(first, last, lower(value), upper(value));
+    }
+    static bool same(char a, char b)
+    {
+      return lower(a) == lower(b);
+    }
+  };
+
+  // Search the runs of buffer for needle, matching elements with TMatch
+  template<class TMatch, class TSegmented, class TForwardRange>
+  std::size_t search_runs(TSegmented const & buffer,
+                          TForwardRange const & needle)
+  {
+    typedef typename TSegmented::const_segment_list               segments_t;
+    typedef typename boost::range_iterator<segments_t const>::type segment_iter;
+    typedef typename boost::range_iterator<
+      typename boost::range_value<segments_t>::type const>::type   iterator;
+    typedef typename boost::range_iterator<TForwardRange const>::type
+      needle_iter;
+
+    needle_iter const needle_begin = boost::begin(needle);
+    needle_iter const needle_end = boost::end(needle);
+    if(needle_begin == needle_end)
+      return 0;
+
+    segments_t const segments = buffer.segments();
+    std::size_t index = 0;
+    for(segment_iter s = boost::begin(segments); s != boost::end(segments);
+        ++s){
+      iterator candidate = boost::begin(*s);
+      iterator const run_end = boost::end(*s);
+      while(true){
+        // Skip ahead to the next place the first element of needle matches
+        std::size_t const skipped =
+          TMatch::find(candidate, run_end, *needle_begin);
+        std::advance(candidate, skipped);
+        index += skipped;
+        if(candidate == run_end)
+          break;
+
+        // Compare the rest of needle, carrying on into later runs if need be
+        segment_iter in = s;
+        iterator here = candidate;
+        needle_iter n = needle_begin;
+        for(++here, ++n; n != needle_end; ++here, ++n){
+          while(here == boost::end(*in) && ++in != boost::end(segments))
+            here = boost::begin(*in);
+          if(in == boost::end(segments) || !TMatch::same(*here, *n))
+            break;
+        }
+        if(n == needle_end)
+          return index;
+        // Ran out of buffer, so no later candidate can match either
+        if(in == boost::end(segments))
+          return buffer.size();
+        ++candidate;
+        ++index;
+      }
+    }
+    return index;
+  }
+
+  // Make a walker over the segments of any buffer
+  template<class TSegmented>
+  struct walker_of
+  {
+    typedef run_walker<
+      typename boost::remove_const<
+        typename TSegmented::const_segment_list>::type> type;
+  };
+}
+
+
+template<class TSegmented, class OutputIterator>
+OutputIterator copy(TSegmented const & buffer, OutputIterator out)
+{
+  typename TSegmented::const_segment_list const segments = buffer.segments();
+  for(typename boost::range_iterator<
+        typename TSegmented::const_segment_list const>::type
+        s = boost::begin(segments); s != boost::end(segments); ++s)
+    out = std::copy(boost::begin(*s), boost::end(*s), out);
+  return out;
+}
+
+template<class TSegmented, class T>
+std::size_t find(TSegmented const & buffer, T const & value)
+{
+  typename TSegmented::const_segment_list const segments = buffer.segments();
+  std::size_t index = 0;
+  for(typename boost::range_iterator<
+        typename TSegmented::const_segment_list const>::type
+        s = boost::begin(segments); s != boost::end(segments); ++s){
+    std::size_t const found =
+      detail::run_find(boost::begin(*s), boost::end(*s), value);
+    index += found;
+    if(found != static_cast<std::size_t>(boost::size(*s)))
+      break;
+  }
+  return index;
+}
+
+template<class TSegmented, class TForwardRange>
+std::size_t search(TSegmented const & buffer, TForwardRange const & needle)
+{
+  return detail::search_runs<detail::exact_match>(buffer, needle);
+}
+
+template<class TSegmented>
+std::size_t find_ignore_case(TSegmented const & buffer, char value)
+{
+  return detail::search_runs<detail::ascii_ignore_case>(
+    buffer, boost::make_iterator_range(&value, &value + 1));
+}
+
+template<class TSegmented, class TForwardRange>
+std::size_t search_ignore_case(TSegmented const & buffer,
+                               TForwardRange const & needle)
+{
+  return detail::search_runs<detail::ascii_ignore_case>(buffer, needle);
+}
+
+template<class TSegmented, class T>
+std::size_t count(TSegmented const & buffer, T const & value)
+{
+  typename TSegmented::const_segment_list const segments = buffer.segments();
+  std::size_t total = 0;
+  for(typename boost::range_iterator<
+        typename TSegmented::const_segment_list const>::type
+        s = boost::begin(segments); s != boost::end(segments); ++s)
+    total += detail::run_count(boost::begin(*s), boost::end(*s), value);
+  return total;
+}
+
+template<class TSegmentedA, class TSegmentedB>
+std::size_t mismatch(TSegmentedA const & lhs, TSegmentedB const & rhs)
+{
+  typename detail::walker_of<TSegmentedA>::type left(lhs.segments());
+  typename detail::walker_of<TSegmentedB>::type right(rhs.segments());
+  return detail::walk_to_mismatch(left, right);
+}
+
+template<class TSegmentedA, class TSegmentedB>
+bool equal(TSegmentedA const & lhs, TSegmentedB const & rhs)
+{
+  if(lhs.size() != rhs.size())
+    return false;
+  typename detail::walker_of<TSegmentedA>::type left(lhs.segments());
+  typename detail::walker_of<TSegmentedB>::type right(rhs.segments());
+  detail::walk_to_mismatch(left, right);
+  return left.done();
+}
+
+template<class TSegmentedA, class TSegmentedB>
+bool lexicographical_compare(TSegmentedA const & lhs, TSegmentedB const & rhs)
+{
+  typename detail::walker_of<TSegmentedA>::type left(lhs.segments());
+  typename detail::walker_of<TSegmentedB>::type right(rhs.segments());
+  detail::walk_to_mismatch(left, right);
+  if(right.done())
+    return false;
+  if(left.done())
+    return true;
+  return *left.here() < *right.here();
+}
+}
@@ -0,0 +1,129 @@
+#ifndef SMALL_GAP_BUFFER_HPP_INCLUDED_
+#define SMALL_GAP_BUFFER_HPP_INCLUDED_
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include "contiguous_gap_buffer.hpp"
+
+#include <boost/move/move.hpp>
+#include <cstddef>
+
+
+/**
+   @brief A contiguous_gap_buffer which holds up to N elements without
+          allocating
+   @details
+   Most of the buffers an editor creates, such as the text of a search box, a
+   single line being edited or a register, are only ever a few dozen elements
+   long.  A small_gap_buffer keeps up to N elements, and its gap, inside the
+   object itself, and only allocates storage once it outgrows them, so such
+   buffers cost no trips to the allocator.
+
+   It is a contiguous_gap_buffer with an InlineCapacity of N, and has the same
+   interface.  Moving or swapping one which holds its elements inline moves
+   the elements, so N should stay small.
+
+   @tparam T       The element type
+   @tparam N       The number of elements to store without allocating
+   @tparam TGrowth The growth policy once the buffer outgrows N elements
+   @tparam TShrink The shrink policy for storage allocated by the buffer
+*/
+template<class T, std::size_t N,
+         class TGrowth = geometric_gap_growth<>,
+         class TShrink = fractional_gap_shrink<> >
+class small_gap_buffer
+  : public contiguous_gap_buffer<T, TGrowth, TShrink, N>
+{
+private:
+  // Enable Boost.Move move-emulation (or actual move on C++11)
+  BOOST_COPYABLE_AND_MOVABLE(small_gap_buffer)
+
+  typedef contiguous_gap_buffer<T, TGrowth, TShrink, N> base_type;
+public:
+  typedef typename base_type::value_type value_type;
+  typedef typename base_type::size_type  size_type;
+
+  /// Default-construct an empty small_gap_buffer without allocating
+  small_gap_buffer()
+  {}
+
+  /// Copy-construct a small_gap_buffer
+  /// @note \b Complexity: O(other.size())
+  small_gap_buffer(small_gap_buffer const & other)
+    : base_type(static_cast<base_type const &>(other))
+  {}
+
+  /// Move-construct a small_gap_buffer
+  /// @note \b Complexity: O(1), or O(other.size()) if other holds its elements
+  ///       inline
+  small_gap_buffer(BOOST_RV_REF(small_gap_buffer) other)
+    : base_type( ::boost::move(static_cast<base_type &>(other)) )
+  {}
+
+  /// @brief Fill-construct a small_gap_buffer with n copies of e and the
+  ///        cursor at the end
+  /// @note \b Complexity: O(n)
+  small_gap_buffer(size_type n, value_type e = value_type())
+    : base_type(n, e)
+  {}
+
+  /// @brief Construct a small_gap_buffer whose contents are the range [i, j)
+  ///        with the cursor at the end
+  /// @note \b Complexity: O(std::distance(i, j))
+  template<class InputIterator>
+  small_gap_buffer(InputIterator const & i, InputIterator const & j)
+    : base_type(i, j)
+  {}
+
+  /// Assign one small_gap_buffer to another
+  /// @note \b Complexity: O(n)
+  small_gap_buffer & operator=(BOOST_COPY_ASSIGN_REF(small_gap_buffer) other)
+  {
+    base_type::operator=(static_cast<base_type const &>(other));
+    return *this;
+  }
+
+  /// Move assign one small_gap_buffer to another
+  /// @note \b Complexity: O(1), or O(N) if either buffer holds its elements
+  ///       inline
+  small_gap_buffer & operator=(BOOST_RV_REF(small_gap_buffer) other)
+  {
+    base_type::operator=( ::boost::move(static_cast<base_type &>(other)) );
+    return *this;
+  }
+};
+
+
+#endif
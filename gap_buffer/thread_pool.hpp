@@ -0,0 +1,134 @@
+#ifndef THREAD_POOL_HPP_INCLUDED_
+#define THREAD_POOL_HPP_INCLUDED_
+
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include <boost/atomic.hpp>
+#include <boost/exception_ptr.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <cstddef>
+
+
+/**
+   @brief A fixed set of threads which share out the tasks of one job at a time
+   @details
+   run() hands a job of numbered tasks to the pool, and returns once every
+   task is done.  The calling thread works on the job too, alongside the
+   pool's own threads.  Each thread claims the next unclaimed task as soon as
+   it finishes its last, so a thread given slow tasks simply claims fewer of
+   them, and every thread stays busy until the job runs out.
+
+   The threads sleep between jobs.  One job runs at a time: run() may be
+   called from any thread, but waits for the job before it to finish.
+
+   This is what the parallel algorithms in parallel_algorithms.hpp run on.
+*/
+class thread_pool
+  : private boost::noncopyable
+{
+public:
+  /// @brief Construct a pool in which threads threads, counting the one
+  ///        calling run(), work on each job
+  /// @param threads The number of threads, or zero for as many as the
+  ///                processor runs at once
+  /// @note \b Complexity: O(threads)
+  explicit thread_pool(std::size_t threads = 0);
+
+  /// Stop and join the pool's threads.  No job may be running.
+  /// @note \b Complexity: O(threads)
+  ~thread_pool();
+
+  /// Return the number of threads which work on each job, counting the one
+  /// calling run()
+  /// @note \b Complexity: O(1)
+  std::size_t size() const;
+
+  /// @brief Call task(i) for each i in [0, tasks), from any of the threads,
+  ///        and return once every call has returned
+  /// @details task is shared by the threads, so it must be safe to call from
+  ///          several at once.  If a call throws, no more tasks are started,
+  ///          and the first exception is rethrown here once the others have
+  ///          finished.  A job of one task is run on the calling thread alone.
+  /// @tparam TTask A type callable as task(std::size_t)
+  /// @note \b Complexity: O(tasks / size()) calls of task, if they take
+  ///       equally long
+  template<class TTask>
+  void run(std::size_t tasks, TTask & task);
+
+private:
+  // The job being run, with its task erased to a function pointer
+  struct job
+  {
+    void (*          invoke)(void *, std::size_t);
+    void *           task;
+    std::size_t      tasks;
+    boost::atomic<std::size_t> next;
+    boost::exception_ptr       error;
+  };
+
+  // Call task(i) as task.invoke() does
+  template<class TTask>
+  static void invoke(void * task, std::size_t i);
+
+  // Run the tasks of a job on every thread, and rethrow its first exception
+  void run_job(void (* invoke)(void *, std::size_t), void * task,
+               std::size_t tasks);
+  // Claim and run the tasks of current until there are none left
+  void work();
+  // The body of each of the pool's threads
+  void serve();
+
+  boost::thread_group        threads;
+  // Held by run() for the whole of a job, so that jobs run one at a time
+  boost::mutex               running;
+  // Guards everything below
+  boost::mutex               lock;
+  boost::condition_variable  wake;
+  boost::condition_variable  idle;
+  job                        current;
+  // Counts the jobs started, so that a thread can tell a new one has begun
+  std::size_t                generation;
+  // The number of the pool's threads working on current
+  std::size_t                active;
+  bool                       stopping;
+};
+
+
+#include "thread_pool.ipp"
+#endif
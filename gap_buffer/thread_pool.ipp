@@ -0,0 +1,173 @@
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <boost/bind/bind.hpp>
+#include <boost/thread/lock_guard.hpp>
+
+
+inline
+thread_pool::thread_pool(std::size_t const threads)
+  : generation(0)
+  , active(0)
+  , stopping(false)
+{
+  current.invoke = 0;
+  current.task = 0;
+  current.tasks = 0;
+  current.next.store(0);
+  std::size_t count = threads;
+  if(count == 0)
+    count = boost::thread::hardware_concurrency();
+  // The thread calling run() is the first
+  for(std::size_t i = 1; i < count; ++i)
+    this->threads.create_thread(boost::bind(&thread_pool::serve, this));
+}
+
+inline
+thread_pool::~thread_pool()
+{
+  {
+    boost::lock_guard<boost::mutex> guard(lock);
+    stopping = true;
+  }
+  wake.notify_all();
+  threads.join_all();
+}
+
+inline
+std::size_t
+thread_pool::
+size() const
+{
+  return threads.size() + 1;
+}
+
+template<class TTask>
+void
+thread_pool::
+run(std::size_t const tasks, TTask & task)
+{
+  if(tasks == 1 || threads.size() == 0){
+    for(std::size_t i = 0; i != tasks; ++i)
+      task(i);
+    return;
+  }
+  if(tasks != 0)
+    run_job(&invoke<TTask>, &task, tasks);
+}
+
+template<class TTask>
+void
+thread_pool::
+invoke(void * const task, std::size_t const i)
+{
+  (*static_cast<TTask *>(task))(i);
+}
+
+inline
+void
+thread_pool::
+run_job(void (* const invoke)(void *, std::size_t), void * const task,
+        std::size_t const tasks)
+{
+  boost::lock_guard<boost::mutex> serial(running);
+  {
+    boost::lock_guard<boost::mutex> guard(lock);
+    current.invoke = invoke;
+    current.task = task;
+    current.tasks = tasks;
+    current.next.store(0);
+    ++generation;
+  }
+  wake.notify_all();
+  work();
+
+  boost::exception_ptr error;
+  {
+    // Every task has been claimed, so wait for those still running, and
+    // retire the job so that a thread waking late does not join it
+    boost::unique_lock<boost::mutex> guard(lock);
+    while(active != 0)
+      idle.wait(guard);
+    current.task = 0;
+    error = current.error;
+    current.error = boost::exception_ptr();
+  }
+  if(error)
+    boost::rethrow_exception(error);
+}
+
+inline
+void
+thread_pool::
+work()
+{
+  while(true){
+    std::size_t const i = current.next.fetch_add(1);
+    if(i >= current.tasks)
+      return;
+    try{
+      current.invoke(current.task, i);
+    }catch(...){
+      // Leave no task for anyone to claim, before anything which may block
+      current.next.store(current.tasks);
+      boost::lock_guard<boost::mutex> guard(lock);
+      if(!current.error)
+        current.error = boost::current_exception();
+    }
+  }
+}
+
+inline
+void
+thread_pool::
+serve()
+{
+  std::size_t seen = 0;
+  while(true){
+    {
+      boost::unique_lock<boost::mutex> guard(lock);
+      while(!stopping && generation == seen)
+        wake.wait(guard);
+      if(stopping)
+        return;
+      seen = generation;
+      if(current.task == 0)
+        continue;
+      ++active;
+    }
+    work();
+    boost::lock_guard<boost::mutex> guard(lock);
+    if(--active == 0)
+      idle.notify_all();
+  }
+}
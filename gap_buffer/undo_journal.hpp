@@ -0,0 +1,199 @@
+#ifndef UNDO_JOURNAL_HPP_INCLUDED_
+#define UNDO_JOURNAL_HPP_INCLUDED_
+
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include <cstddef>
+#include <deque>
+
+
+/**
+   @brief A gap_buffer observer which records edits so they can be undone
+   @details
+   Attach an undo_journal to a gap_buffer by naming it as the buffer's
+   TObserver, then call undo() and redo() with the buffer.  Each insertion or
+   erasure becomes a compact record of its position, its length and where the
+   cursor was, with the elements themselves kept together in one shared store.
+   Consecutive edits which continue one another, such as typing, backspacing
+   or deleting forwards at the cursor, are coalesced into a single record.
+   Moving the cursor ends the current run.
+
+   Records are undone and redone in steps.  A step runs from one checkpoint to
+   the next.  Call checkpoint() at the end of each user-visible command; one is
+   also made automatically after every checkpoint_interval records, which
+   bounds the work a single undo() or redo() has to replay.  Making an edit
+   after an undo discards whatever could have been redone.
+
+   The journal never holds more than about memory_limit bytes.  When a new
+   edit would exceed it, the oldest records are forgotten first.
+
+   @tparam T The value_type of the gap_buffer being observed
+*/
+template<class T>
+class undo_journal
+{
+public:
+  /// The size_type of this journal
+  typedef std::size_t size_type;
+
+  /// Tell gap_buffer that this observer needs to hear about every edit
+  static bool const enabled = true;
+
+  /// Construct an empty journal
+  /// @param memory_limit        The most bytes of records and elements to keep
+  /// @param checkpoint_interval The most records in one undo step
+  explicit undo_journal(size_type memory_limit = 1 << 22,
+                        size_type checkpoint_interval = 64);
+
+  /// @name Observer Requirements
+  //@{
+  /// Record that [first, last) was inserted at index position
+  /// @note \b Complexity: O(std::distance(first, last))
+  template<class TBuffer, class TIterator>
+  void on_insert(TBuffer const & buffer, size_type position,
+                 TIterator first, TIterator last);
+  /// Record that [first, last), at index position, is about to be erased
+  /// @note \b Complexity: O(std::distance(first, last)), plus the length of
+  ///       the run it is coalesced into when erasing backwards
+  template<class TBuffer, class TIterator>
+  void on_erase(TBuffer const & buffer, size_type position,
+                TIterator first, TIterator last);
+  /// End the current run when the cursor moves
+  /// @note \b Complexity: O(1)
+  template<class TBuffer>
+  void on_advance(TBuffer const & buffer, std::ptrdiff_t distance);
+  /// Forget every record, since the buffer was filled without them
+  /// @note \b Complexity: O(memory_usage())
+  template<class TBuffer>
+  void on_reset(TBuffer const & buffer);
+  //@}
+
+  /// @name Undo and Redo
+  //@{
+  /// End the current undo step, so the next edit begins a new one
+  /// @note \b Complexity: O(1)
+  void checkpoint();
+
+  /// @brief Undo the most recent step which has not been undone, restoring
+  ///        the cursor to where it was before it.  Return false if there was
+  ///        nothing to undo.
+  /// @note \b Complexity: The total length of the step's records, plus the
+  ///       cost of moving buffer's cursor to each of them
+  template<class TBuffer>
+  bool undo(TBuffer & buffer);
+
+  /// @brief Redo the most recently undone step, leaving the cursor where the
+  ///        edits themselves left it.  Return false if there was nothing to
+  ///        redo.
+  /// @note \b Complexity: The same as undo()
+  template<class TBuffer>
+  bool redo(TBuffer & buffer);
+
+  /// Return if there is anything to undo
+  /// @note \b Complexity: O(1)
+  bool can_undo() const;
+  /// Return if there is anything to redo
+  /// @note \b Complexity: O(1)
+  bool can_redo() const;
+
+  /// Forget every record
+  /// @note \b Complexity: O(memory_usage())
+  void clear();
+
+  /// Return the number of records held, which can be less than the number of
+  /// edits made because of coalescing
+  /// @note \b Complexity: O(1)
+  size_type record_count() const;
+
+  /// Return the approximate number of bytes held by the records and elements
+  /// @note \b Complexity: O(1)
+  size_type memory_usage() const;
+  //@}
+
+private:
+  // One coalesced insertion or erasure
+  struct record
+  {
+    // The index of the first element inserted or erased
+    size_type position;
+    // The number of elements inserted or erased
+    size_type length;
+    // Where this record's elements begin in payload, offset by payload_base
+    size_type offset;
+    // Where the cursor was before the edit
+    size_type cursor;
+    // If the elements were inserted, rather than erased
+    bool      inserted;
+    // If this record begins an undo step
+    bool      checkpoint;
+  };
+
+  // Every record, oldest first.  [0, applied) are done, the rest are undone.
+  std::deque<record> records;
+  // The elements of every record, in the same order
+  std::deque<T>      payload;
+  size_type          applied;
+  // The number of elements forgotten from the front of payload
+  size_type          payload_base;
+  // The number of records in the current undo step
+  size_type          step_length;
+  size_type          limit;
+  size_type          interval;
+  // If the next record must begin a new step
+  bool               step_ended;
+  // If the next edit may be coalesced into the latest record
+  bool               run_open;
+  // If the edits being observed are our own undos or redos
+  bool               replaying;
+
+  // Discard everything which could have been redone
+  void truncate();
+  // Start a new record for an edit at position, and return it
+  record & begin_record(size_type position, size_type cursor, bool inserted);
+  // Forget old records until memory_usage() fits within limit
+  void enforce_limit();
+
+  // Apply the inverse, or the original, of the edit r records
+  template<class TBuffer>
+  void revert(TBuffer & buffer, record const & r);
+  template<class TBuffer>
+  void replay(TBuffer & buffer, record const & r);
+  template<class TBuffer>
+  static void move_cursor(TBuffer & buffer, size_type position);
+};
+
+
+#include "undo_journal.ipp"
+#endif
@@ -0,0 +1,374 @@
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <boost/next_prior.hpp>
+#include <boost/range/iterator_range.hpp>
+
+#include <algorithm>
+
+
+template<class T>
+bool const undo_journal<T>::enabled;
+
+
+namespace undo_journal_detail
+{
+  // Clear a flag however the scope is left
+  class flag_guard
+  {
+  public:
+    explicit flag_guard(bool & f)
+      : flag(f)
+    {
+      flag = true;
+    }
+    ~flag_guard()
+    {
+      flag = false;
+    }
+  private:
+    bool & flag;
+  };
+}
+
+
+template<class T>
+undo_journal<T>::undo_journal(size_type memory_limit,
+                              size_type checkpoint_interval)
+  : applied(0)
+  , payload_base(0)
+  , step_length(0)
+  , limit(memory_limit)
+  , interval(checkpoint_interval)
+  , step_ended(true)
+  , run_open(false)
+  , replaying(false)
+{}
+
+
+template<class T>
+void
+undo_journal<T>::
+truncate()
+{
+  if(applied == records.size())
+    return;
+  payload.erase(payload.begin() + (records[applied].offset - payload_base),
+                payload.end());
+  records.erase(records.begin() + applied, records.end());
+}
+
+template<class T>
+typename undo_journal<T>::record &
+undo_journal<T>::
+begin_record(size_type position, size_type cursor, bool inserted)
+{
+  record r;
+  r.position = position;
+  r.length = 0;
+  r.offset = payload_base + payload.size();
+  r.cursor = cursor;
+  r.inserted = inserted;
+  r.checkpoint = step_ended || step_length >= interval;
+  if(r.checkpoint)
+    step_length = 0;
+  ++step_length;
+  step_ended = false;
+
+  records.push_back(r);
+  ++applied;
+  return records.back();
+}
+
+template<class T>
+void
+undo_journal<T>::
+enforce_limit()
+{
+  while(!records.empty() && memory_usage() > limit){
+    record const & oldest = records.front();
+    payload.erase(payload.begin(), payload.begin() + oldest.length);
+    payload_base += oldest.length;
+    records.pop_front();
+    --applied;
+    if(!records.empty())
+      records.front().checkpoint = true;
+  }
+  if(records.empty()){
+    // Everything we knew was forgotten, including the run being built
+    step_ended = true;
+    run_open = false;
+  }
+}
+
+
+template<class T>
+template<class TBuffer, class TIterator>
+void
+undo_journal<T>::
+on_insert(TBuffer const & buffer, size_type position,
+          TIterator first, TIterator last)
+{
+  if(replaying || first == last)
+    return;
+  truncate();
+
+  // Work out where the cursor was from where the insertion left it
+  size_type const length = std::distance(first, last);
+  size_type cursor = buffer.position();
+  if(cursor >= position + length)
+    cursor -= length;
+
+  // Typing at the cursor continues the latest run of typing
+  record * r = 0;
+  if(run_open && cursor == position){
+    record & latest = records.back();
+    if(latest.inserted && latest.cursor == latest.position &&
+       latest.position + latest.length == position)
+      r = &latest;
+  }
+  if(!r)
+    r = &begin_record(position, cursor, true);
+
+  payload.insert(payload.end(), first, last);
+  r->length += length;
+  run_open = true;
+  enforce_limit();
+}
+
+template<class T>
+template<class TBuffer, class TIterator>
+void
+undo_journal<T>::
+on_erase(TBuffer const & buffer, size_type position,
+         TIterator first, TIterator last)
+{
+  if(replaying || first == last)
+    return;
+  truncate();
+
+  size_type const length = std::distance(first, last);
+  size_type const cursor = buffer.position();
+
+  if(run_open && !records.back().inserted){
+    record & latest = records.back();
+    if(cursor == position && latest.cursor == latest.position &&
+       latest.position == position){
+      // Deleting forwards from where the latest deletion was
+      payload.insert(payload.end(), first, last);
+      latest.length += length;
+      enforce_limit();
+      return;
+    }
+    if(cursor == position + length &&
+       latest.cursor == latest.position + latest.length &&
+       latest.position == position + length){
+      // Backspacing over what lies before the latest deletion
+      payload.insert(payload.end() - latest.length, first, last);
+      latest.position = position;
+      latest.length += length;
+      enforce_limit();
+      return;
+    }
+  }
+
+  record & r = begin_record(position, cursor, false);
+  payload.insert(payload.end(), first, last);
+  r.length = length;
+  run_open = true;
+  enforce_limit();
+}
+
+template<class T>
+template<class TBuffer>
+void
+undo_journal<T>::
+on_advance(TBuffer const &, std::ptrdiff_t distance)
+{
+  if(!replaying && distance != 0)
+    run_open = false;
+}
+
+template<class T>
+template<class TBuffer>
+void
+undo_journal<T>::
+on_reset(TBuffer const &)
+{
+  clear();
+}
+
+
+template<class T>
+template<class TBuffer>
+void
+undo_journal<T>::
+move_cursor(TBuffer & buffer, size_type position)
+{
+  buffer.advance(static_cast<std::ptrdiff_t>(position) -
+                 static_cast<std::ptrdiff_t>(buffer.position()));
+}
+
+template<class T>
+template<class TBuffer>
+void
+undo_journal<T>::
+revert(TBuffer & buffer, record const & r)
+{
+  move_cursor(buffer, r.position);
+  if(r.inserted){
+    buffer.erase(static_cast<std::ptrdiff_t>(r.length));
+  }else{
+    typename std::deque<T>::const_iterator const first =
+      payload.begin() + (r.offset - payload_base);
+    buffer.insert(boost::make_iterator_range(first, first + r.length));
+  }
+  move_cursor(buffer, r.cursor);
+}
+
+template<class T>
+template<class TBuffer>
+void
+undo_journal<T>::
+replay(TBuffer & buffer, record const & r)
+{
+  move_cursor(buffer, r.position);
+  size_type cursor = r.cursor;
+  if(r.inserted){
+    typename std::deque<T>::const_iterator const first =
+      payload.begin() + (r.offset - payload_base);
+    buffer.insert(boost::make_iterator_range(first, first + r.length));
+    if(r.position <= cursor)
+      cursor += r.length;
+  }else{
+    buffer.erase(static_cast<std::ptrdiff_t>(r.length));
+    cursor -= std::min(r.position + r.length, cursor) -
+      std::min(r.position, cursor);
+  }
+  move_cursor(buffer, cursor);
+}
+
+template<class T>
+template<class TBuffer>
+bool
+undo_journal<T>::
+undo(TBuffer & buffer)
+{
+  if(applied == 0)
+    return false;
+
+  undo_journal_detail::flag_guard const guard(replaying);
+  do{
+    --applied;
+    revert(buffer, records[applied]);
+  }while(!records[applied].checkpoint);
+
+  step_ended = true;
+  run_open = false;
+  return true;
+}
+
+template<class T>
+template<class TBuffer>
+bool
+undo_journal<T>::
+redo(TBuffer & buffer)
+{
+  if(applied == records.size())
+    return false;
+
+  undo_journal_detail::flag_guard const guard(replaying);
+  do{
+    replay(buffer, records[applied]);
+    ++applied;
+  }while(applied != records.size() && !records[applied].checkpoint);
+
+  step_ended = true;
+  run_open = false;
+  return true;
+}
+
+
+template<class T>
+void
+undo_journal<T>::
+checkpoint()
+{
+  step_ended = true;
+  run_open = false;
+}
+
+template<class T>
+bool
+undo_journal<T>::
+can_undo() const
+{
+  return applied != 0;
+}
+
+template<class T>
+bool
+undo_journal<T>::
+can_redo() const
+{
+  return applied != records.size();
+}
+
+template<class T>
+void
+undo_journal<T>::
+clear()
+{
+  records.clear();
+  payload.clear();
+  applied = 0;
+  payload_base = 0;
+  step_length = 0;
+  step_ended = true;
+  run_open = false;
+}
+
+template<class T>
+typename undo_journal<T>::size_type
+undo_journal<T>::
+record_count() const
+{
+  return records.size();
+}
+
+template<class T>
+typename undo_journal<T>::size_type
+undo_journal<T>::
+memory_usage() const
+{
+  return records.size() * sizeof(record) + payload.size() * sizeof(T);
+}
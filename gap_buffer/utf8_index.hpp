@@ -0,0 +1,227 @@
+#ifndef UTF8_INDEX_HPP_INCLUDED_
+#define UTF8_INDEX_HPP_INCLUDED_
+
+
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include "detail/utf8_decode.hpp"
+
+#include <boost/static_assert.hpp>
+
+#include <cstddef>
+#include <set>
+#include <vector>
+
+
+/**
+   @brief A gap_buffer observer which maps between byte, code point and UTF-16
+   positions in UTF-8 text
+   @details
+   Attach a utf8_index to a gap_buffer of char by naming it as the buffer's
+   TObserver.  It splits the buffer into chunks of a few kilobytes, each
+   beginning on a code point, and keeps the number of bytes, code points and
+   UTF-16 code units in each, totalled in Fenwick trees.  Converting a
+   position finds its chunk in O(log n) time, then decodes no more than that
+   chunk.
+
+   Edits only adjust the byte lengths of the chunks they touch and mark them
+   for decoding again, which happens, a chunk at a time, at the next query.
+   Decoding doubles as validation.  Ill-formed sequences are counted by
+   error_count(), and are treated as one U+FFFD each, as Unicode recommends.
+   Runs of ASCII are skipped with vector instructions where the processor has
+   them.
+
+   The queries take the buffer, since they read the text of a chunk, and
+   are fastest when the buffer's iterators are random access.  A position in
+   the middle of a code point, or between the halves of a surrogate pair,
+   belongs to that code point.
+
+   @tparam T The value_type of the gap_buffer being observed, which must be a
+             single byte, such as char
+*/
+template<class T>
+class utf8_index
+{
+  BOOST_STATIC_ASSERT(sizeof(T) == 1);
+public:
+  /// The size_type of this index
+  typedef std::size_t size_type;
+
+  /// Tell gap_buffer that this observer needs to hear about every edit
+  static bool const enabled = true;
+
+  /// Construct an index of an empty buffer
+  utf8_index();
+
+  /// @name Observer Requirements
+  //@{
+  /// Note that [first, last) was inserted at index position
+  /// @note \b Complexity: O(std::distance(first, last) + log n)
+  template<class TBuffer, class TIterator>
+  void on_insert(TBuffer const & buffer, size_type position,
+                 TIterator first, TIterator last);
+  /// Note that [first, last), at index position, is about to be erased
+  /// @note \b Complexity: O(std::distance(first, last) + log n)
+  template<class TBuffer, class TIterator>
+  void on_erase(TBuffer const & buffer, size_type position,
+                TIterator first, TIterator last);
+  /// Moving the cursor changes nothing
+  /// @note \b Complexity: O(1)
+  template<class TBuffer>
+  void on_advance(TBuffer const & buffer, std::ptrdiff_t distance);
+  /// Index the whole of buffer afresh
+  /// @note \b Complexity: O(1), leaving O(n) work for the next query
+  template<class TBuffer>
+  void on_reset(TBuffer const & buffer);
+  //@}
+
+  /// @name Positions
+  /// Each query first decodes the chunks edited since the last one
+  //@{
+  /// Return the number of code points in buffer
+  /// @note \b Complexity: O(1)
+  template<class TBuffer>
+  size_type code_points(TBuffer const & buffer);
+  /// Return the number of UTF-16 code units buffer would take
+  /// @note \b Complexity: O(1)
+  template<class TBuffer>
+  size_type utf16_length(TBuffer const & buffer);
+  /// Return the number of ill-formed sequences in buffer
+  /// @note \b Complexity: O(1)
+  template<class TBuffer>
+  size_type error_count(TBuffer const & buffer);
+
+  /// Return the index of the code point holding the byte at position
+  /// @note \b Complexity: O(log n)
+  template<class TBuffer>
+  size_type code_point_of(TBuffer const & buffer, size_type position);
+  /// Return the position of the first byte of code point point
+  /// @note \b Complexity: O(log n)
+  template<class TBuffer>
+  size_type byte_of_code_point(TBuffer const & buffer, size_type point);
+  /// Return the UTF-16 offset of the code point holding the byte at position
+  /// @note \b Complexity: O(log n)
+  template<class TBuffer>
+  size_type utf16_of(TBuffer const & buffer, size_type position);
+  /// Return the position of the first byte of the code point holding UTF-16
+  /// code unit unit
+  /// @note \b Complexity: O(log n)
+  template<class TBuffer>
+  size_type byte_of_utf16(TBuffer const & buffer, size_type unit);
+  //@}
+
+private:
+  // The number of bytes a chunk is built with.  Chunks are split once they
+  // hold twice this many, and merged with a neighbour below a quarter of it.
+  static size_type const chunk_bytes = 2048;
+
+  // A run of the buffer beginning on a code point, and what it holds
+  struct chunk
+  {
+    size_type bytes;
+    size_type points;
+    size_type units;
+    size_type errors;
+  };
+
+  std::vector<chunk> chunks;
+  // Fenwick trees of the bytes, code points and code units of the chunks
+  std::vector<size_type> byte_sums;
+  std::vector<size_type> point_sums;
+  std::vector<size_type> unit_sums;
+  size_type total_bytes;
+  size_type total_errors;
+  // The chunks whose contents have changed since they were last decoded
+  std::set<size_type> stale;
+  // Room to copy a chunk into to decode it
+  std::vector<unsigned char> scratch;
+
+  // Find the chunk holding the position-th byte, and set before to the bytes
+  // ahead of it
+  size_type chunk_at(size_type position, size_type & before) const;
+  // Mark chunk k, and the one before it whose last code point may have run
+  // into it, for decoding
+  void touch(size_type k);
+  // Recompute the Fenwick trees from the chunks
+  void resum();
+  // Move count bytes from the front of the chunks after k onto the end of k
+  void extend(size_type k, size_type count);
+
+  // Decode the stale chunks, then split, merge or drop any which have grown
+  // too big or too small, until none are left stale
+  template<class TBuffer>
+  void refresh(TBuffer const & buffer);
+  // Decode chunk k, taking on the rest of its last code point if that
+  // carries on into the next chunk
+  template<class TBuffer>
+  void decode_chunk(TBuffer const & buffer, size_type k);
+  // Copy [position, position + count) of buffer into scratch
+  template<class TBuffer>
+  void copy_out(TBuffer const & buffer, size_type position, size_type count);
+  // Walk the code points of chunk k, which begins at byte start, up to limit
+  template<class TBuffer>
+  utf8::detail::text_position
+  walk_chunk(TBuffer const & buffer, size_type k, size_type start,
+             utf8::detail::text_position const & limit);
+};
+
+
+namespace utf8
+{
+  /// Return if [first, last) is well-formed UTF-8
+  /// @note \b Complexity: O(std::distance(first, last))
+  template<class InputIterator>
+  bool is_valid(InputIterator first, InputIterator last);
+
+  /// @brief Move the cursor of a buffer of UTF-8 by distance code points,
+  ///        stopping at either end
+  /// @note \b Complexity: O(abs(distance))
+  template<class TBuffer>
+  void advance_code_points(TBuffer & buffer, std::ptrdiff_t distance);
+
+  /// @brief Move the cursor of a buffer of UTF-8 by distance grapheme
+  ///        clusters, stopping at either end
+  /// @details Clusters follow the common rules of Unicode's text segmentation
+  /// algorithm: CR LF, combining marks and other extenders, zero width joiner
+  /// sequences, and pairs of regional indicators stay together.  Hangul
+  /// syllables and Indic conjuncts are not specially handled.
+  /// @note \b Complexity: O(abs(distance)), times the length of the clusters
+  template<class TBuffer>
+  void advance_graphemes(TBuffer & buffer, std::ptrdiff_t distance);
+}
+
+
+#include "utf8_index.ipp"
+#endif
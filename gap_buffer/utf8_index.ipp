@@ -0,0 +1,524 @@
+/*
+   This file is copyright (c) Patrick Moran 2011.  A license is granted to any
+   party to use this file according to the terms of the Boost Software License
+   version 1 as it appears below:
+
+
+   Boost Software License - Version 1.0 - August 17th, 2003
+
+   Permission is hereby granted, free of charge, to any person or organization
+   obtaining a copy of the software and accompanying documentation covered by
+   this license (the "Software") to use, reproduce, display, distribute,
+   execute, and transmit the Software, and to prepare derivative works of the
+   Software, and to permit third-parties to whom the Software is furnished to
+   do so, all subject to the following:
+
+   The copyright notices in the Software and this entire statement, including
+   the above license grant, this restriction and the following disclaimer,
+   must be included in all copies of the Software, in whole or in part, and
+   all derivative works of the Software, unless such copies or derivative
+   works are solely in the form of machine-executable object code generated by
+   a source language processor.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+   SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+   FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include "detail/fenwick.hpp"
+
+#include <boost/next_prior.hpp>
+#include <boost/range/begin.hpp>
+#include <boost/range/size.hpp>
+#include <boost/range/value_type.hpp>
+
+#include <algorithm>
+#include <iterator>
+
+
+template<class T>
+bool const utf8_index<T>::enabled;
+
+template<class T>
+typename utf8_index<T>::size_type const utf8_index<T>::chunk_bytes;
+
+
+template<class T>
+utf8_index<T>::utf8_index()
+  : chunks(1)
+  , total_bytes(0)
+  , total_errors(0)
+{
+  chunk const empty = { 0, 0, 0, 0 };
+  chunks.front() = empty;
+  resum();
+}
+
+
+template<class T>
+void
+utf8_index<T>::
+resum()
+{
+  byte_sums.assign(chunks.size() + 1, 0);
+  point_sums.assign(chunks.size() + 1, 0);
+  unit_sums.assign(chunks.size() + 1, 0);
+  for(size_type k = 0; k < chunks.size(); ++k){
+    index_detail::fenwick_add(byte_sums, k, chunks[k].bytes);
+    index_detail::fenwick_add(point_sums, k, chunks[k].points);
+    index_detail::fenwick_add(unit_sums, k, chunks[k].units);
+  }
+}
+
+template<class T>
+typename utf8_index<T>::size_type
+utf8_index<T>::
+chunk_at(size_type position, size_type & before) const
+{
+  // Anything past the end belongs to the last chunk
+  if(position >= total_bytes){
+    before = total_bytes - chunks.back().bytes;
+    return chunks.size() - 1;
+  }
+  return index_detail::fenwick_search(byte_sums, position, before);
+}
+
+template<class T>
+void
+utf8_index<T>::
+touch(size_type k)
+{
+  stale.insert(k);
+  if(k > 0)
+    stale.insert(k - 1);
+}
+
+template<class T>
+void
+utf8_index<T>::
+extend(size_type k, size_type count)
+{
+  for(size_type j = k + 1; count > 0; ++j){
+    size_type const taken = std::min(count, chunks[j].bytes);
+    chunks[j].bytes -= taken;
+    chunks[k].bytes += taken;
+    index_detail::fenwick_add(byte_sums, j, size_type(0) - taken);
+    index_detail::fenwick_add(byte_sums, k, taken);
+    stale.insert(j);
+    count -= taken;
+  }
+}
+
+
+template<class T>
+template<class TBuffer, class TIterator>
+void
+utf8_index<T>::
+on_insert(TBuffer const &, size_type position,
+          TIterator first, TIterator last)
+{
+  size_type const length = std::distance(first, last);
+  if(length == 0)
+    return;
+  size_type before;
+  size_type const k = chunk_at(position, before);
+  chunks[k].bytes += length;
+  index_detail::fenwick_add(byte_sums, k, length);
+  total_bytes += length;
+  touch(k);
+}
+
+template<class T>
+template<class TBuffer, class TIterator>
+void
+utf8_index<T>::
+on_erase(TBuffer const &, size_type position,
+         TIterator first, TIterator last)
+{
+  size_type remaining = std::distance(first, last);
+  if(remaining == 0)
+    return;
+  size_type before;
+  size_type k = chunk_at(position, before);
+  size_type offset = position - before;
+  total_bytes -= remaining;
+  for(; remaining > 0; ++k, offset = 0){
+    size_type const taken = std::min(remaining, chunks[k].bytes - offset);
+    chunks[k].bytes -= taken;
+    index_detail::fenwick_add(byte_sums, k, size_type(0) - taken);
+    touch(k);
+    remaining -= taken;
+  }
+}
+
+template<class T>
+template<class TBuffer>
+void
+utf8_index<T>::
+on_advance(TBuffer const &, std::ptrdiff_t)
+{}
+
+template<class T>
+template<class TBuffer>
+void
+utf8_index<T>::
+on_reset(TBuffer const & buffer)
+{
+  // Cut the buffer up by length alone, and leave the decoding, which will
+  // move the cuts onto code points, to the next query
+  total_bytes = buffer.size();
+  total_errors = 0;
+  chunks.assign(std::max<size_type>(1, (total_bytes + chunk_bytes - 1) /
+                                    chunk_bytes), chunk());
+  stale.clear();
+  for(size_type k = 0; k < chunks.size(); ++k){
+    chunk const fresh = { std::min<size_type>(chunk_bytes,
+                                              total_bytes - k * chunk_bytes),
+                          0, 0, 0 };
+    chunks[k] = fresh;
+    stale.insert(stale.end(), k);
+  }
+  resum();
+}
+
+
+template<class T>
+template<class TBuffer>
+void
+utf8_index<T>::
+copy_out(TBuffer const & buffer, size_type position, size_type count)
+{
+  // Copy run by run, so that the copies are of the underlying storage
+  typedef typename TBuffer::const_segment_list segment_list;
+  typedef typename boost::range_iterator<segment_list const>::type segment;
+  scratch.resize(count);
+  segment_list const runs = buffer.segments();
+  unsigned char * out = scratch.empty() ? 0 : &scratch[0];
+  for(segment run = boost::begin(runs); count > 0; ++run){
+    size_type const length = boost::size(*run);
+    if(position >= length){
+      position -= length;
+      continue;
+    }
+    size_type const taken = std::min(count, length - position);
+    typename boost::range_iterator<
+      typename boost::range_value<segment_list>::type const>::type const
+      first = boost::next(boost::begin(*run), position);
+    out = std::copy(first, boost::next(first, taken), out);
+    position = 0;
+    count -= taken;
+  }
+}
+
+template<class T>
+template<class TBuffer>
+void
+utf8_index<T>::
+decode_chunk(TBuffer const & buffer, size_type k)
+{
+  size_type const start = index_detail::fenwick_prefix(byte_sums, k);
+  size_type const length = chunks[k].bytes;
+  // Read far enough past the end for the longest sequence to finish
+  size_type const ahead = std::min<size_type>(3, total_bytes - start - length);
+  copy_out(buffer, start, length + ahead);
+
+  utf8::detail::text_position const limit =
+    { length, size_type(-1), size_type(-1), 0 };
+  utf8::detail::text_position const none = { 0, 0, 0, 0 };
+  utf8::detail::text_position const found = length == 0 ? none :
+    utf8::detail::walk(&scratch[0], length, length + ahead, limit, true);
+  if(found.bytes > length)
+    extend(k, found.bytes - length);
+
+  chunk & c = chunks[k];
+  index_detail::fenwick_add(point_sums, k, found.points - c.points);
+  index_detail::fenwick_add(unit_sums, k, found.units - c.units);
+  total_errors += found.errors - c.errors;
+  c.points = found.points;
+  c.units = found.units;
+  c.errors = found.errors;
+}
+
+template<class T>
+template<class TBuffer>
+void
+utf8_index<T>::
+refresh(TBuffer const & buffer)
+{
+  while(!stale.empty()){
+    bool untidy = false;
+    while(!stale.empty()){
+      size_type const k = *stale.begin();
+      stale.erase(stale.begin());
+      if(k >= chunks.size())
+        continue;
+      decode_chunk(buffer, k);
+      untidy = untidy || chunks[k].bytes > 2 * chunk_bytes ||
+        (chunks.size() > 1 && chunks[k].bytes < chunk_bytes / 4);
+    }
+    if(!untidy)
+      return;
+
+    // Drop empty chunks, fold small ones into the chunk before them, and cut
+    // big ones up, to be decoded again on the next time around
+    std::vector<chunk> tidied;
+    std::vector<bool> fresh;
+    for(size_type k = 0; k < chunks.size(); ++k){
+      chunk const & c = chunks[k];
+      if(c.bytes == 0)
+        continue;
+      if(c.bytes > 2 * chunk_bytes){
+        total_errors -= c.errors;
+        for(size_type cut = 0; cut < c.bytes; cut += chunk_bytes){
+          chunk const piece =
+            { std::min<size_type>(chunk_bytes, c.bytes - cut), 0, 0, 0 };
+          tidied.push_back(piece);
+          fresh.push_back(false);
+        }
+      }else if(c.bytes < chunk_bytes / 4 && !tidied.empty() &&
+               tidied.back().bytes + c.bytes <= 2 * chunk_bytes){
+        // Both begin on code points, so their totals simply add up
+        tidied.back().bytes += c.bytes;
+        tidied.back().points += c.points;
+        tidied.back().units += c.units;
+        tidied.back().errors += c.errors;
+      }else{
+        tidied.push_back(c);
+        fresh.push_back(true);
+      }
+    }
+    if(tidied.empty()){
+      chunk const empty = { 0, 0, 0, 0 };
+      tidied.push_back(empty);
+      fresh.push_back(true);
+    }
+    chunks.swap(tidied);
+    resum();
+    for(size_type k = 0; k < chunks.size(); ++k)
+      if(!fresh[k])
+        stale.insert(stale.end(), k);
+  }
+}
+
+template<class T>
+template<class TBuffer>
+utf8::detail::text_position
+utf8_index<T>::
+walk_chunk(TBuffer const & buffer, size_type k, size_type start,
+           utf8::detail::text_position const & limit)
+{
+  // Nothing past the last sequence beginning before limit.bytes is read
+  size_type const length = limit.bytes < chunks[k].bytes ?
+    std::min(chunks[k].bytes, limit.bytes + 3) : chunks[k].bytes;
+  copy_out(buffer, start, length);
+  if(length == 0){
+    utf8::detail::text_position const none = { 0, 0, 0, 0 };
+    return none;
+  }
+  return utf8::detail::walk(&scratch[0], length, length, limit, false);
+}
+
+
+template<class T>
+template<class TBuffer>
+typename utf8_index<T>::size_type
+utf8_index<T>::
+code_points(TBuffer const & buffer)
+{
+  refresh(buffer);
+  return index_detail::fenwick_prefix(point_sums, chunks.size());
+}
+
+template<class T>
+template<class TBuffer>
+typename utf8_index<T>::size_type
+utf8_index<T>::
+utf16_length(TBuffer const & buffer)
+{
+  refresh(buffer);
+  return index_detail::fenwick_prefix(unit_sums, chunks.size());
+}
+
+template<class T>
+template<class TBuffer>
+typename utf8_index<T>::size_type
+utf8_index<T>::
+error_count(TBuffer const & buffer)
+{
+  refresh(buffer);
+  return total_errors;
+}
+
+template<class T>
+template<class TBuffer>
+typename utf8_index<T>::size_type
+utf8_index<T>::
+code_point_of(TBuffer const & buffer, size_type position)
+{
+  refresh(buffer);
+  if(position >= total_bytes)
+    return index_detail::fenwick_prefix(point_sums, chunks.size());
+  size_type before;
+  size_type const k = chunk_at(position, before);
+  utf8::detail::text_position const limit =
+    { position - before, size_type(-1), size_type(-1), 0 };
+  return index_detail::fenwick_prefix(point_sums, k) +
+    walk_chunk(buffer, k, before, limit).points;
+}
+
+template<class T>
+template<class TBuffer>
+typename utf8_index<T>::size_type
+utf8_index<T>::
+utf16_of(TBuffer const & buffer, size_type position)
+{
+  refresh(buffer);
+  if(position >= total_bytes)
+    return index_detail::fenwick_prefix(unit_sums, chunks.size());
+  size_type before;
+  size_type const k = chunk_at(position, before);
+  utf8::detail::text_position const limit =
+    { position - before, size_type(-1), size_type(-1), 0 };
+  return index_detail::fenwick_prefix(unit_sums, k) +
+    walk_chunk(buffer, k, before, limit).units;
+}
+
+template<class T>
+template<class TBuffer>
+typename utf8_index<T>::size_type
+utf8_index<T>::
+byte_of_code_point(TBuffer const & buffer, size_type point)
+{
+  refresh(buffer);
+  if(point >= index_detail::fenwick_prefix(point_sums, chunks.size()))
+    return total_bytes;
+  size_type before;
+  size_type const k = index_detail::fenwick_search(point_sums, point, before);
+  size_type const start = index_detail::fenwick_prefix(byte_sums, k);
+  utf8::detail::text_position const limit =
+    { size_type(-1), point - before, size_type(-1), 0 };
+  return start + walk_chunk(buffer, k, start, limit).bytes;
+}
+
+template<class T>
+template<class TBuffer>
+typename utf8_index<T>::size_type
+utf8_index<T>::
+byte_of_utf16(TBuffer const & buffer, size_type unit)
+{
+  refresh(buffer);
+  if(unit >= index_detail::fenwick_prefix(unit_sums, chunks.size()))
+    return total_bytes;
+  size_type before;
+  size_type const k = index_detail::fenwick_search(unit_sums, unit, before);
+  size_type const start = index_detail::fenwick_prefix(byte_sums, k);
+  utf8::detail::text_position const limit =
+    { size_type(-1), size_type(-1), unit - before, 0 };
+  return start + walk_chunk(buffer, k, start, limit).bytes;
+}
+
+
+namespace utf8
+{
+namespace detail
+{
+  // Count the regional indicators in a row which end just before i
+  template<class Iterator>
+  std::size_t prior_indicators(Iterator i, Iterator const & begin)
+  {
+    std::size_t count = 0;
+    std::size_t length;
+    while(i != begin && is_regional_indicator(prior_code_point(i, begin,
+                                                               length)))
+      ++count;
+    return count;
+  }
+}
+
+template<class InputIterator>
+bool is_valid(InputIterator first, InputIterator last)
+{
+  std::vector<unsigned char> const bytes(first, last);
+  if(bytes.empty())
+    return true;
+  detail::text_position const limit =
+    { bytes.size(), std::size_t(-1), std::size_t(-1), 0 };
+  return detail::walk(&bytes[0], bytes.size(), bytes.size(), limit, true).
+    errors == 0;
+}
+
+template<class TBuffer>
+void advance_code_points(TBuffer & buffer, std::ptrdiff_t distance)
+{
+  typedef typename TBuffer::const_iterator iterator;
+  iterator const begin = buffer.begin();
+  iterator const end = buffer.end();
+  iterator i = buffer.here();
+  std::ptrdiff_t moved = 0;
+  std::size_t length;
+  for(; distance > 0 && i != end; --distance){
+    detail::next_code_point(i, end, length);
+    moved += length;
+  }
+  for(; distance < 0 && i != begin; ++distance){
+    detail::prior_code_point(i, begin, length);
+    moved -= length;
+  }
+  buffer.advance(moved);
+}
+
+template<class TBuffer>
+void advance_graphemes(TBuffer & buffer, std::ptrdiff_t distance)
+{
+  typedef typename TBuffer::const_iterator iterator;
+  iterator const begin = buffer.begin();
+  iterator const end = buffer.end();
+  iterator i = buffer.here();
+  std::ptrdiff_t moved = 0;
+  std::size_t length;
+
+  if(distance > 0){
+    std::size_t indicators = detail::prior_indicators(i, begin);
+    for(; distance > 0 && i != end; --distance){
+      unsigned long c = detail::next_code_point(i, end, length);
+      moved += length;
+      indicators = detail::is_regional_indicator(c) ? indicators + 1 : 0;
+      // Take in everything which joins on to the cluster
+      while(i != end){
+        iterator ahead = i;
+        unsigned long const next = detail::next_code_point(ahead, end, length);
+        if(!detail::joined(c, next, indicators))
+          break;
+        i = ahead;
+        moved += length;
+        c = next;
+        indicators = detail::is_regional_indicator(c) ? indicators + 1 : 0;
+      }
+    }
+  }
+
+  for(; distance < 0 && i != begin; ++distance){
+    unsigned long c = detail::prior_code_point(i, begin, length);
+    moved -= length;
+    while(i != begin){
+      iterator behind = i;
+      unsigned long const prior =
+        detail::prior_code_point(behind, begin, length);
+      std::size_t const indicators = detail::is_regional_indicator(prior) ?
+        1 + detail::prior_indicators(behind, begin) : 0;
+      if(!detail::joined(prior, c, indicators))
+        break;
+      i = behind;
+      moved -= length;
+      c = prior;
+    }
+  }
+  buffer.advance(moved);
+}
+}